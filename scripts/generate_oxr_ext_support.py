@@ -30,6 +30,7 @@ EXTENSIONS = (
     ['XR_EXTX_overlay'],
     ['XR_MNDX_egl_enable', 'XR_USE_PLATFORM_EGL', 'XR_USE_GRAPHICS_API_OPENGL'],
     ['XR_MNDX_ball_on_a_stick_controller'],
+    ['XR_MNDX_locate_spaces'],
     ['XR_EXT_hand_tracking']
 )
 
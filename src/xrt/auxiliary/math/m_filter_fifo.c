@@ -13,18 +13,137 @@
 #include <assert.h>
 
 
+/*
+ *
+ * Helpers.
+ *
+ */
+
+/*!
+ * Kahan compensated running sum, @p c holds the low order bits lost from
+ * @p sum so the true value is sum - c.
+ */
+struct kahan_sum
+{
+	double sum;
+	double c;
+};
+
+static inline void
+kahan_add(struct kahan_sum *k, double value)
+{
+	double y = value - k->c;
+	double t = k->sum + y;
+	k->c = (t - k->sum) - y;
+	k->sum = t;
+}
+
+/*!
+ * Difference between two running sums, keeps the compensation so prefix sums
+ * that have grown large still give precise windows.
+ */
+static inline double
+kahan_diff(const struct kahan_sum *a, const struct kahan_sum *b)
+{
+	return (a->sum - b->sum) - (a->c - b->c);
+}
+
+static size_t
+round_up_pow2(size_t num)
+{
+	size_t ret = 1;
+	while (ret < num) {
+		ret <<= 1;
+	}
+	return ret;
+}
+
+/*!
+ * Finds the window of pushes with timestamps in [start_ns, stop_ns], the
+ * timestamps are in push order so both ends are binary searches. Pushes
+ * numbered @p first to @p count - 1 are in the ring.
+ */
+static bool
+find_window(const uint64_t *timestamps_ns,
+            size_t mask,
+            uint64_t first,
+            uint64_t count,
+            uint64_t start_ns,
+            uint64_t stop_ns,
+            uint64_t *out_lo,
+            uint64_t *out_hi)
+{
+	if (start_ns > stop_ns) {
+		return false;
+	}
+
+	// First push with timestamp >= start_ns.
+	uint64_t lo = first, hi = count;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (timestamps_ns[mid & mask] < start_ns) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	uint64_t window_lo = lo;
+
+	// First push with timestamp > stop_ns.
+	hi = count;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (timestamps_ns[mid & mask] <= stop_ns) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == window_lo) {
+		return false;
+	}
+
+	*out_lo = window_lo;
+	*out_hi = lo - 1;
+
+	return true;
+}
+
+
 /*
  *
  * Filter fifo vec3_f32.
  *
  */
 
+/*!
+ * Sums of all samples pushed before a given one, the sums over any window
+ * of the ring are the difference of the prefixes at its ends.
+ */
+struct vec3_prefix
+{
+	struct kahan_sum sum[3];
+	struct kahan_sum sum_sq[3];
+};
+
 struct m_ff_vec3_f32
 {
+	//! Power of two.
 	size_t num;
-	size_t latest;
+	size_t mask;
+
+	//! Number of samples pushed, counting the initial ones, push n is in slot n & mask.
+	uint64_t count;
+
+	//! Sums of everything pushed so far.
+	struct vec3_prefix running;
+
 	struct xrt_vec3 *samples;
 	uint64_t *timestamps_ns;
+
+	//! Sums of everything pushed before the sample in the same slot.
+	struct vec3_prefix *prefixes;
 };
 
 
@@ -37,10 +156,17 @@ struct m_ff_vec3_f32
 static void
 vec3_f32_init(struct m_ff_vec3_f32 *ff, size_t num)
 {
+	num = round_up_pow2(num);
+
 	ff->samples = U_TYPED_ARRAY_CALLOC(struct xrt_vec3, num);
 	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
+	ff->prefixes = U_TYPED_ARRAY_CALLOC(struct vec3_prefix, num);
 	ff->num = num;
-	ff->latest = 0;
+	ff->mask = num - 1;
+
+	// Filled with zero samples at timepoint zero, their prefixes are all zero.
+	ff->count = num;
+	U_ZERO(&ff->running);
 }
 
 static void
@@ -56,8 +182,14 @@ vec3_f32_destroy(struct m_ff_vec3_f32 *ff)
 		ff->timestamps_ns = NULL;
 	}
 
+	if (ff->prefixes != NULL) {
+		free(ff->prefixes);
+		ff->prefixes = NULL;
+	}
+
 	ff->num = 0;
-	ff->latest = 0;
+	ff->mask = 0;
+	ff->count = 0;
 }
 
 
@@ -97,14 +229,21 @@ m_ff_vec3_f32_get_num(struct m_ff_vec3_f32 *ff)
 void
 m_ff_vec3_f32_push(struct m_ff_vec3_f32 *ff, const struct xrt_vec3 *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
+	assert(ff->timestamps_ns[(ff->count - 1) & ff->mask] <= timestamp_ns);
 
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
+	size_t i = ff->count & ff->mask;
 
 	ff->samples[i] = *sample;
 	ff->timestamps_ns[i] = timestamp_ns;
+	ff->prefixes[i] = ff->running;
+
+	const double v[3] = {sample->x, sample->y, sample->z};
+	for (int k = 0; k < 3; k++) {
+		kahan_add(&ff->running.sum[k], v[k]);
+		kahan_add(&ff->running.sum_sq[k], v[k] * v[k]);
+	}
+
+	ff->count++;
 }
 
 bool
@@ -114,7 +253,7 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
+	size_t pos = (ff->count - 1 - num) & ff->mask;
 	*out_sample = ff->samples[pos];
 	*out_timestamp_ns = ff->timestamps_ns[pos];
 
@@ -122,52 +261,59 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 }
 
 size_t
-m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average)
+m_ff_vec3_f32_filter_stats(struct m_ff_vec3_f32 *ff,
+                           uint64_t start_ns,
+                           uint64_t stop_ns,
+                           struct xrt_vec3 *out_mean,
+                           struct xrt_vec3 *out_variance)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
-	// Use double precision internally.
-	double x = 0, y = 0, z = 0;
+	struct xrt_vec3 zero = XRT_VEC3_ZERO;
+	uint64_t lo, hi;
 
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
+	if (!find_window(ff->timestamps_ns, ff->mask, ff->count - ff->num, ff->count, start_ns, stop_ns, &lo, &hi)) {
+		*out_mean = zero;
+		if (out_variance != NULL) {
+			*out_variance = zero;
+		}
+		return 0;
 	}
 
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
-
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
+	const struct vec3_prefix *p_lo = &ff->prefixes[lo & ff->mask];
+	const struct vec3_prefix *p_hi = &ff->prefixes[hi & ff->mask];
+	const struct xrt_vec3 *last = &ff->samples[hi & ff->mask];
+	const double v_hi[3] = {last->x, last->y, last->z};
+	double n = (double)(hi - lo + 1);
 
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
+	// Use double precision internally.
+	double mean[3], variance[3];
+	for (int k = 0; k < 3; k++) {
+		double sum = kahan_diff(&p_hi->sum[k], &p_lo->sum[k]) + v_hi[k];
+		double sum_sq = kahan_diff(&p_hi->sum_sq[k], &p_lo->sum_sq[k]) + v_hi[k] * v_hi[k];
+
+		mean[k] = sum / n;
+		variance[k] = sum_sq / n - mean[k] * mean[k];
+		if (variance[k] < 0.0) {
+			variance[k] = 0.0;
 		}
-
-		x += ff->samples[pos].x;
-		y += ff->samples[pos].y;
-		z += ff->samples[pos].z;
-		num_sampled++;
-		count++;
 	}
 
-	// Avoid division by zero.
-	if (num_sampled > 0) {
-		x /= num_sampled;
-		y /= num_sampled;
-		z /= num_sampled;
+	out_mean->x = (float)mean[0];
+	out_mean->y = (float)mean[1];
+	out_mean->z = (float)mean[2];
+
+	if (out_variance != NULL) {
+		out_variance->x = (float)variance[0];
+		out_variance->y = (float)variance[1];
+		out_variance->z = (float)variance[2];
 	}
 
-	out_average->x = (float)x;
-	out_average->y = (float)y;
-	out_average->z = (float)z;
+	return (size_t)(hi - lo + 1);
+}
 
-	return num_sampled;
+size_t
+m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average)
+{
+	return m_ff_vec3_f32_filter_stats(ff, start_ns, stop_ns, out_average, NULL);
 }
 
 
@@ -177,12 +323,29 @@ m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_
  *
  */
 
+struct f64_prefix
+{
+	struct kahan_sum sum;
+	struct kahan_sum sum_sq;
+};
+
 struct m_ff_f64
 {
+	//! Power of two.
 	size_t num;
-	size_t latest;
+	size_t mask;
+
+	//! Number of samples pushed, counting the initial ones, push n is in slot n & mask.
+	uint64_t count;
+
+	//! Sums of everything pushed so far.
+	struct f64_prefix running;
+
 	double *samples;
 	uint64_t *timestamps_ns;
+
+	//! Sums of everything pushed before the sample in the same slot.
+	struct f64_prefix *prefixes;
 };
 
 
@@ -195,10 +358,17 @@ struct m_ff_f64
 static void
 ff_f64_init(struct m_ff_f64 *ff, size_t num)
 {
+	num = round_up_pow2(num);
+
 	ff->samples = U_TYPED_ARRAY_CALLOC(double, num);
 	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
+	ff->prefixes = U_TYPED_ARRAY_CALLOC(struct f64_prefix, num);
 	ff->num = num;
-	ff->latest = 0;
+	ff->mask = num - 1;
+
+	// Filled with zero samples at timepoint zero, their prefixes are all zero.
+	ff->count = num;
+	U_ZERO(&ff->running);
 }
 
 static void
@@ -214,8 +384,14 @@ ff_f64_destroy(struct m_ff_f64 *ff)
 		ff->timestamps_ns = NULL;
 	}
 
+	if (ff->prefixes != NULL) {
+		free(ff->prefixes);
+		ff->prefixes = NULL;
+	}
+
 	ff->num = 0;
-	ff->latest = 0;
+	ff->mask = 0;
+	ff->count = 0;
 }
 
 
@@ -255,14 +431,18 @@ m_ff_f64_get_num(struct m_ff_f64 *ff)
 void
 m_ff_f64_push(struct m_ff_f64 *ff, const double *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
+	assert(ff->timestamps_ns[(ff->count - 1) & ff->mask] <= timestamp_ns);
 
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
+	size_t i = ff->count & ff->mask;
 
 	ff->samples[i] = *sample;
 	ff->timestamps_ns[i] = timestamp_ns;
+	ff->prefixes[i] = ff->running;
+
+	kahan_add(&ff->running.sum, *sample);
+	kahan_add(&ff->running.sum_sq, *sample * *sample);
+
+	ff->count++;
 }
 
 bool
@@ -272,7 +452,7 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
+	size_t pos = (ff->count - 1 - num) & ff->mask;
 	*out_sample = ff->samples[pos];
 	*out_timestamp_ns = ff->timestamps_ns[pos];
 
@@ -280,43 +460,40 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 }
 
 size_t
-m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average)
+m_ff_f64_filter_stats(
+    struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_mean, double *out_variance)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
-	double val = 0;
+	uint64_t lo, hi;
 
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
+	if (!find_window(ff->timestamps_ns, ff->mask, ff->count - ff->num, ff->count, start_ns, stop_ns, &lo, &hi)) {
+		*out_mean = 0;
+		if (out_variance != NULL) {
+			*out_variance = 0;
+		}
+		return 0;
 	}
 
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
+	const struct f64_prefix *p_lo = &ff->prefixes[lo & ff->mask];
+	const struct f64_prefix *p_hi = &ff->prefixes[hi & ff->mask];
+	double v_hi = ff->samples[hi & ff->mask];
+	double n = (double)(hi - lo + 1);
 
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
+	double sum = kahan_diff(&p_hi->sum, &p_lo->sum) + v_hi;
+	double sum_sq = kahan_diff(&p_hi->sum_sq, &p_lo->sum_sq) + v_hi * v_hi;
 
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
-		}
+	double mean = sum / n;
+	double variance = sum_sq / n - mean * mean;
 
-		val += ff->samples[pos];
-		num_sampled++;
-		count++;
+	*out_mean = mean;
+	if (out_variance != NULL) {
+		*out_variance = variance < 0.0 ? 0.0 : variance;
 	}
 
-	// Avoid division by zero.
-	if (num_sampled > 0) {
-		val /= num_sampled;
-	}
-
-	*out_average = val;
+	return (size_t)(hi - lo + 1);
+}
 
-	return num_sampled;
+size_t
+m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average)
+{
+	return m_ff_f64_filter_stats(ff, start_ns, stop_ns, out_average, NULL);
 }
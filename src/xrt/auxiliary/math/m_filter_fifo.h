@@ -20,8 +20,8 @@ struct m_ff_f64;
 struct m_ff_vec3_f32;
 
 /*!
- * Allocates a filter fifo tracking @p num samples and fills it with @p num
- * samples at timepoint zero.
+ * Allocates a filter fifo tracking @p num samples, rounded up to a power of
+ * two, and fills it with that many samples at timepoint zero.
  */
 void
 m_ff_vec3_f32_alloc(struct m_ff_vec3_f32 **ff_out, size_t num);
@@ -68,8 +68,22 @@ size_t
 m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average);
 
 /*!
- * Allocates a filter fifo tracking @p num samples and fills it with @p num
- * samples at timepoint zero.
+ * Like @ref m_ff_vec3_f32_filter but also gets the per axis variance of the
+ * samples, @p out_variance may be NULL.
+ *
+ * The fifo keeps running sums of the samples and their squares, so this is
+ * a binary search for the window and is independent of its length.
+ */
+size_t
+m_ff_vec3_f32_filter_stats(struct m_ff_vec3_f32 *ff,
+                           uint64_t start_ns,
+                           uint64_t stop_ns,
+                           struct xrt_vec3 *out_mean,
+                           struct xrt_vec3 *out_variance);
+
+/*!
+ * Allocates a filter fifo tracking @p num samples, rounded up to a power of
+ * two, and fills it with that many samples at timepoint zero.
  */
 void
 m_ff_f64_alloc(struct m_ff_f64 **ff_out, size_t num);
@@ -115,6 +129,16 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 size_t
 m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average);
 
+/*!
+ * Like @ref m_ff_f64_filter but also gets the variance of the samples,
+ * @p out_variance may be NULL.
+ *
+ * The fifo keeps running sums of the samples and their squares, so this is
+ * a binary search for the window and is independent of its length.
+ */
+size_t
+m_ff_f64_filter_stats(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_mean, double *out_variance);
+
 
 #ifdef __cplusplus
 }
@@ -158,5 +182,11 @@ public:
 	{
 		return m_ff_vec3_f32_filter(ff, start_ns, stop_ns, out_average);
 	}
+
+	inline size_t
+	filter_stats(uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_mean, struct xrt_vec3 *out_variance)
+	{
+		return m_ff_vec3_f32_filter_stats(ff, start_ns, stop_ns, out_mean, out_variance);
+	}
 };
 #endif
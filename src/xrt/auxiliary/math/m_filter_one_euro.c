@@ -194,8 +194,8 @@ m_filter_euro_vec3_run(struct m_filter_euro_vec3 *f, uint64_t ts, const struct x
 	if (!f->have_prev_y) {
 		/* First sample - no filtering yet */
 		f->prev_dy.x = 0;
-		f->prev_dy.x = 0;
-		f->prev_dy.x = 0;
+		f->prev_dy.y = 0;
+		f->prev_dy.z = 0;
 		f->prev_ts = ts;
 		f->prev_y = *in_y;
 		f->have_prev_y = true;
@@ -76,25 +76,33 @@ m_imu_3dof_add_vars(struct m_imu_3dof *f, void *root, const char *prefix)
 	u_var_add_bool(root, &f->gyro_bias.manually_fire, tmp);
 }
 
-static void
-gravity_correction(struct m_imu_3dof *f,
-                   uint64_t timestamp_ns,
-                   const struct xrt_vec3 *accel,
-                   const struct xrt_vec3 *gyro,
-                   double dt,
-                   float gyro_length)
+static uint64_t
+gravity_duration_ns(const struct m_imu_3dof *f)
 {
-	uint64_t dur_ns = 0;
 	if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_20MS) {
-		dur_ns = DUR_20MS_IN_NS;
-	} else if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_300MS) {
-		dur_ns = DUR_300MS_IN_NS;
-	} else {
-		return;
+		return DUR_20MS_IN_NS;
+	}
+	if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_300MS) {
+		return DUR_300MS_IN_NS;
+	}
+	return 0;
+}
+
+/*!
+ * Tracks if the device is level, and once it has been for long enough
+ * updates the tilt error from the mean of the world accelerometer fifo.
+ * Returns true if the error axis was changed.
+ */
+static bool
+gravity_update_error(struct m_imu_3dof *f, uint64_t timestamp_ns, const struct xrt_vec3 *accel, float gyro_length)
+{
+	uint64_t dur_ns = gravity_duration_ns(f);
+	if (dur_ns == 0) {
+		return false;
 	}
 
 	const float gravity_tolerance = .9f, gyro_tolerance = .1f;
-	const float min_tilt_error = 0.05f, max_tilt_error = 0.01f;
+	const float max_tilt_error = 0.01f;
 
 	/*
 	 * If the device is within tolerance levels, count this
@@ -113,67 +121,99 @@ gravity_correction(struct m_imu_3dof *f,
 	 * accelerometer filter queue (last n values) and use for correction.
 	 */
 	uint64_t level_ns = f->grav.level_timestamp_ns + dur_ns;
-	if (level_ns < timestamp_ns) {
-		// Reset the timepoint
-		f->grav.level_timestamp_ns = timestamp_ns;
+	if (level_ns >= timestamp_ns) {
+		return false;
+	}
 
-		struct xrt_vec3 accel_mean;
-		m_ff_vec3_f32_filter(f->word_accel_ff,      // Filter
-		                     timestamp_ns - dur_ns, // Start time
-		                     timestamp_ns,          // End time
-		                     &accel_mean);          // Results
-		if ((m_vec3_len(accel_mean) - 9.82f) < gravity_tolerance) {
-			/*
-			 * Calculate a cross product between what the device
-			 * thinks is up and what gravity indicates is down.
-			 * The values are optimized of what we would get out
-			 * from the cross product.
-			 */
-			struct xrt_vec3 tilt = {
-			    accel_mean.z,
-			    0,
-			    -accel_mean.x,
-			};
+	// Reset the timepoint
+	f->grav.level_timestamp_ns = timestamp_ns;
+
+	struct xrt_vec3 accel_mean;
+	m_ff_vec3_f32_filter(f->word_accel_ff,      // Filter
+	                     timestamp_ns - dur_ns, // Start time
+	                     timestamp_ns,          // End time
+	                     &accel_mean);          // Results
+	if ((m_vec3_len(accel_mean) - 9.82f) >= gravity_tolerance) {
+		return false;
+	}
 
-			tilt = m_vec3_normalize(tilt);
-			accel_mean = m_vec3_normalize(accel_mean);
+	/*
+	 * Calculate a cross product between what the device
+	 * thinks is up and what gravity indicates is down.
+	 * The values are optimized of what we would get out
+	 * from the cross product.
+	 */
+	struct xrt_vec3 tilt = {
+	    accel_mean.z,
+	    0,
+	    -accel_mean.x,
+	};
 
-			struct xrt_vec3 up = {0, 1.0f, 0};
-			float tilt_angle = m_vec3_angle(up, accel_mean);
+	tilt = m_vec3_normalize(tilt);
+	accel_mean = m_vec3_normalize(accel_mean);
 
-			if (tilt_angle > max_tilt_error) {
-				f->grav.error_angle = tilt_angle;
-				f->grav.error_axis = tilt;
-			}
-		}
+	struct xrt_vec3 up = {0, 1.0f, 0};
+	float tilt_angle = m_vec3_angle(up, accel_mean);
+
+	if (tilt_angle <= max_tilt_error) {
+		return false;
 	}
 
-	if (f->grav.error_angle > min_tilt_error) {
-		// Correct 180° over 5 seconds, when moving.
-		float max_radians = M_PI * dt / 5;
-		// Correct 180° over 60 seconds, when stationary.
-		float min_radians = M_PI * dt / 60;
-
-		/*
-		 * We're treating 0.5 * gyro_length as a unitless scale factor.
-		 * Tested in a headset, 0.5 felt nice.
-		 */
-		float correction_radians = 0.5 * gyro_length * max_radians;
-		// Clamp to the range [min_radians, max_radians]
-		correction_radians = fmaxf(min_radians, correction_radians);
-		correction_radians = fminf(max_radians, correction_radians);
-		// Do not exceed the remaining error to correct for
-		correction_radians = -fminf(correction_radians, f->grav.error_angle);
-
-		// Update how much is left.
-		f->grav.error_angle += correction_radians;
-
-		// Perform the correction.
-		struct xrt_quat corr_quat, old_orient;
-		math_quat_from_angle_vector(correction_radians, &f->grav.error_axis, &corr_quat);
-		old_orient = f->rot;
-		math_quat_rotate(&corr_quat, &old_orient, &f->rot);
+	f->grav.error_angle = tilt_angle;
+	f->grav.error_axis = tilt;
+
+	return true;
+}
+
+/*!
+ * How much of the tilt error to correct for this sample, a rotation around
+ * the error axis in world space. Takes it off the remaining error.
+ */
+static float
+gravity_correction_step(struct m_imu_3dof *f, double dt, float gyro_length)
+{
+	const float min_tilt_error = 0.05f;
+
+	if (gravity_duration_ns(f) == 0 || f->grav.error_angle <= min_tilt_error) {
+		return 0.0f;
 	}
+
+	// Correct 180° over 5 seconds, when moving.
+	float max_radians = M_PI * dt / 5;
+	// Correct 180° over 60 seconds, when stationary.
+	float min_radians = M_PI * dt / 60;
+
+	/*
+	 * We're treating 0.5 * gyro_length as a unitless scale factor.
+	 * Tested in a headset, 0.5 felt nice.
+	 */
+	float correction_radians = 0.5 * gyro_length * max_radians;
+	// Clamp to the range [min_radians, max_radians]
+	correction_radians = fmaxf(min_radians, correction_radians);
+	correction_radians = fminf(max_radians, correction_radians);
+	// Do not exceed the remaining error to correct for
+	correction_radians = -fminf(correction_radians, f->grav.error_angle);
+
+	// Update how much is left.
+	f->grav.error_angle += correction_radians;
+
+	return correction_radians;
+}
+
+/*!
+ * Rotate @p rot in world space, the gravity corrections are all applied here.
+ */
+static void
+gravity_apply(struct xrt_quat *rot, float angle, const struct xrt_vec3 *axis)
+{
+	if (angle == 0.0f) {
+		return;
+	}
+
+	struct xrt_quat corr_quat, old_orient;
+	math_quat_from_angle_vector(angle, axis, &corr_quat);
+	old_orient = *rot;
+	math_quat_rotate(&corr_quat, &old_orient, rot);
 }
 
 static void
@@ -202,58 +242,104 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro)
 {
+	m_imu_3dof_update_batch(f, &timestamp_ns, accel, gyro, 1);
+}
+
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        size_t count)
+{
+	size_t first = 0;
+
 	//! Skip the first sample.
-	if (f->state == M_IMU_3DOF_STATE_START) {
+	if (count > 0 && f->state == M_IMU_3DOF_STATE_START) {
 		f->state = M_IMU_3DOF_STATE_RUNNING;
-		f->last.timestamp_ns = timestamp_ns;
+		f->last.timestamp_ns = timestamps_ns[0];
+		first = 1;
+	}
+
+	if (first >= count) {
 		return;
 	}
 
-	// This code assumes all timestamps makes some forward progress.
-	assert(timestamp_ns >= f->last.timestamp_ns);
+	/*
+	 * Gyro integration multiplies on the right (body space) and gravity
+	 * correction on the left (world space), so the two commute: the new
+	 * orientation is C * rot * D, where D is the product of the per sample
+	 * rotations and C the gravity corrections. C only needs building when
+	 * the error axis changes, all corrections around the same axis add up
+	 * to one rotation by the summed angle.
+	 */
+	struct xrt_quat rot = f->rot;
+	struct xrt_quat grav_corr = XRT_QUAT_IDENTITY;
+	float grav_angle = 0.0f;
 
-	f->last.gyro = *gyro;
-	f->last.accel = *accel;
+	uint64_t last_ns = f->last.timestamp_ns;
+	double dt = 0.0;
 
-	struct xrt_vec3 world_accel = {0};
-	math_quat_rotate_vec3(&f->rot, accel, &world_accel);
+	for (size_t i = first; i < count; i++) {
+		uint64_t timestamp_ns = timestamps_ns[i];
+		const struct xrt_vec3 *accel = &accels[i];
+		const struct xrt_vec3 *gyro = &gyros[i];
 
-	uint64_t diff = timestamp_ns - f->last.timestamp_ns;
-	double dt = (double)diff / DUR_1S_IN_NS;
+		// This code assumes all timestamps makes some forward progress.
+		assert(timestamp_ns >= last_ns);
 
-	f->last.delta_ms = dt * 1000.0;
-	f->last.timestamp_ns = timestamp_ns;
+		dt = (double)(timestamp_ns - last_ns) / DUR_1S_IN_NS;
+		last_ns = timestamp_ns;
 
-	m_ff_vec3_f32_push(f->word_accel_ff, &world_accel, timestamp_ns);
-	m_ff_vec3_f32_push(f->gyro_ff, gyro, timestamp_ns);
+		// Leaves out this batch's gravity correction, at most a fraction of a degree.
+		struct xrt_vec3 world_accel = {0};
+		math_quat_rotate_vec3(&rot, accel, &world_accel);
 
-	struct xrt_vec3 gyro_biased = m_vec3_sub(*gyro, f->gyro_bias.value);
-	float gyro_biased_length = m_vec3_len(gyro_biased);
+		m_ff_vec3_f32_push(f->word_accel_ff, &world_accel, timestamp_ns);
+		m_ff_vec3_f32_push(f->gyro_ff, gyro, timestamp_ns);
 
-	if (gyro_biased_length > 0.0001f) {
+		struct xrt_vec3 gyro_biased = m_vec3_sub(*gyro, f->gyro_bias.value);
+		float gyro_biased_length = m_vec3_len(gyro_biased);
+
+		if (gyro_biased_length > 0.0001f) {
 #if 0
-		math_quat_integrate_velocity(&f->rot, gyro, dt, &f->rot);
+			math_quat_integrate_velocity(&rot, gyro, dt, &rot);
 #else
-		struct xrt_vec3 rot_axis = {
-		    gyro_biased.x / gyro_biased_length,
-		    gyro_biased.y / gyro_biased_length,
-		    gyro_biased.z / gyro_biased_length,
-		};
+			struct xrt_vec3 rot_axis = {
+			    gyro_biased.x / gyro_biased_length,
+			    gyro_biased.y / gyro_biased_length,
+			    gyro_biased.z / gyro_biased_length,
+			};
 
-		float rot_angle = gyro_biased_length * dt;
+			float rot_angle = gyro_biased_length * dt;
 
-		struct xrt_quat delta_orient;
-		math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
+			struct xrt_quat delta_orient;
+			math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
 
-		math_quat_rotate(&f->rot, &delta_orient, &f->rot);
+			math_quat_rotate(&rot, &delta_orient, &rot);
 #endif
+		}
+
+		// Gravity correction, flush what we have if the axis changes.
+		struct xrt_vec3 old_axis = f->grav.error_axis;
+		if (gravity_update_error(f, timestamp_ns, accel, gyro_biased_length)) {
+			gravity_apply(&grav_corr, grav_angle, &old_axis);
+			grav_angle = 0.0f;
+		}
+		grav_angle += gravity_correction_step(f, dt, gyro_biased_length);
 	}
 
-	// Gravity correction.
-	gravity_correction(f, timestamp_ns, accel, &gyro_biased, dt, gyro_biased_length);
+	gravity_apply(&grav_corr, grav_angle, &f->grav.error_axis);
+	math_quat_rotate(&grav_corr, &rot, &f->rot);
+
+	size_t last = count - 1;
+	f->last.gyro = gyros[last];
+	f->last.accel = accels[last];
+	f->last.delta_ms = dt * 1000.0;
+	f->last.timestamp_ns = last_ns;
 
 	// Gyro bias calculations.
-	gyro_biasing(f, timestamp_ns);
+	gyro_biasing(f, last_ns);
 
 	/*
 	 * Mitigate drift due to floating point
@@ -82,6 +82,22 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro);
 
+/*!
+ * Update with several samples at once, in increasing timestamp order, as
+ * delivered by IMUs that pack more than one sample per report.
+ *
+ * The same as calling @ref m_imu_3dof_update for each sample, except that
+ * gravity correction is applied and the gyro bias sampled once per batch.
+ * Also the accelerometer samples for the gravity filter are rotated without
+ * the batch's own correction, so the results differ a tiny amount.
+ */
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        size_t count);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,178 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  C pose math library, inline versions of the hot functions in m_api.h
+ *         and batch versions for things like hand joints.
+ *
+ * @see xrt_pose
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "m_quat.h"
+#include "m_vec3.h"
+
+#include <stddef.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define M_POSE_HAVE_SSE 1
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Same as @ref math_pose_transform_point.
+ */
+static inline struct xrt_vec3
+m_pose_transform_point(struct xrt_pose transform, struct xrt_vec3 point)
+{
+	return m_vec3_add(m_quat_rotate_vec3(transform.orientation, point), transform.position);
+}
+
+/*!
+ * Same as @ref math_pose_transform, @p pose is in the space of @p transform.
+ */
+static inline struct xrt_pose
+m_pose_transform(struct xrt_pose transform, struct xrt_pose pose)
+{
+	struct xrt_pose ret;
+	ret.orientation = m_quat_mul(transform.orientation, pose.orientation);
+	ret.position = m_pose_transform_point(transform, pose.position);
+	return ret;
+}
+
+/*!
+ * Same as @ref math_pose_invert for poses with unit quaternions.
+ */
+static inline struct xrt_pose
+m_pose_invert(struct xrt_pose pose)
+{
+	struct xrt_pose ret;
+	ret.orientation = m_quat_conjugate(pose.orientation);
+	ret.position = m_vec3_mul_scalar(m_quat_rotate_vec3(ret.orientation, pose.position), -1.0f);
+	return ret;
+}
+
+#ifdef M_POSE_HAVE_SSE
+/*!
+ * Four poses at a time, one pose per lane.
+ */
+static inline void
+m_pose_transform_4_sse(const struct xrt_pose *transform, const struct xrt_pose *poses, struct xrt_pose *out_poses)
+{
+	const struct xrt_pose *p = poses;
+
+	// The transform is the same for all lanes.
+	const __m128 ax = _mm_set1_ps(transform->orientation.x);
+	const __m128 ay = _mm_set1_ps(transform->orientation.y);
+	const __m128 az = _mm_set1_ps(transform->orientation.z);
+	const __m128 aw = _mm_set1_ps(transform->orientation.w);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	const __m128 bx = _mm_set_ps(p[3].orientation.x, p[2].orientation.x, p[1].orientation.x, p[0].orientation.x);
+	const __m128 by = _mm_set_ps(p[3].orientation.y, p[2].orientation.y, p[1].orientation.y, p[0].orientation.y);
+	const __m128 bz = _mm_set_ps(p[3].orientation.z, p[2].orientation.z, p[1].orientation.z, p[0].orientation.z);
+	const __m128 bw = _mm_set_ps(p[3].orientation.w, p[2].orientation.w, p[1].orientation.w, p[0].orientation.w);
+	const __m128 px = _mm_set_ps(p[3].position.x, p[2].position.x, p[1].position.x, p[0].position.x);
+	const __m128 py = _mm_set_ps(p[3].position.y, p[2].position.y, p[1].position.y, p[0].position.y);
+	const __m128 pz = _mm_set_ps(p[3].position.z, p[2].position.z, p[1].position.z, p[0].position.z);
+
+	// Orientation, transform * pose.
+	__m128 ox = _mm_add_ps(_mm_mul_ps(aw, bx), _mm_mul_ps(ax, bw));
+	ox = _mm_add_ps(ox, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+	__m128 oy = _mm_sub_ps(_mm_mul_ps(aw, by), _mm_mul_ps(ax, bz));
+	oy = _mm_add_ps(oy, _mm_add_ps(_mm_mul_ps(ay, bw), _mm_mul_ps(az, bx)));
+	__m128 oz = _mm_add_ps(_mm_mul_ps(aw, bz), _mm_mul_ps(ax, by));
+	oz = _mm_add_ps(oz, _mm_sub_ps(_mm_mul_ps(az, bw), _mm_mul_ps(ay, bx)));
+	__m128 ow = _mm_sub_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx));
+	ow = _mm_sub_ps(ow, _mm_add_ps(_mm_mul_ps(ay, by), _mm_mul_ps(az, bz)));
+
+	// Position, t = 2 * cross(a.xyz, p), p + a.w * t + cross(a.xyz, t) + a.position.
+	__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(ay, pz), _mm_mul_ps(az, py)));
+	__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(az, px), _mm_mul_ps(ax, pz)));
+	__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(ax, py), _mm_mul_ps(ay, px)));
+
+	__m128 rx = _mm_add_ps(px, _mm_mul_ps(aw, tx));
+	rx = _mm_add_ps(rx, _mm_sub_ps(_mm_mul_ps(ay, tz), _mm_mul_ps(az, ty)));
+	rx = _mm_add_ps(rx, _mm_set1_ps(transform->position.x));
+	__m128 ry = _mm_add_ps(py, _mm_mul_ps(aw, ty));
+	ry = _mm_add_ps(ry, _mm_sub_ps(_mm_mul_ps(az, tx), _mm_mul_ps(ax, tz)));
+	ry = _mm_add_ps(ry, _mm_set1_ps(transform->position.y));
+	__m128 rz = _mm_add_ps(pz, _mm_mul_ps(aw, tz));
+	rz = _mm_add_ps(rz, _mm_sub_ps(_mm_mul_ps(ax, ty), _mm_mul_ps(ay, tx)));
+	rz = _mm_add_ps(rz, _mm_set1_ps(transform->position.z));
+
+	float lanes[7][4];
+	_mm_storeu_ps(lanes[0], ox);
+	_mm_storeu_ps(lanes[1], oy);
+	_mm_storeu_ps(lanes[2], oz);
+	_mm_storeu_ps(lanes[3], ow);
+	_mm_storeu_ps(lanes[4], rx);
+	_mm_storeu_ps(lanes[5], ry);
+	_mm_storeu_ps(lanes[6], rz);
+
+	for (int i = 0; i < 4; i++) {
+		out_poses[i].orientation.x = lanes[0][i];
+		out_poses[i].orientation.y = lanes[1][i];
+		out_poses[i].orientation.z = lanes[2][i];
+		out_poses[i].orientation.w = lanes[3][i];
+		out_poses[i].position.x = lanes[4][i];
+		out_poses[i].position.y = lanes[5][i];
+		out_poses[i].position.z = lanes[6][i];
+	}
+}
+#endif
+
+/*!
+ * Transforms @p count poses with the same @p transform, like all of the
+ * joints of a hand into the space of the app. @p poses and @p out_poses may
+ * be the same array.
+ */
+static inline void
+m_pose_transform_many(const struct xrt_pose *transform,
+                      const struct xrt_pose *poses,
+                      struct xrt_pose *out_poses,
+                      size_t count)
+{
+	size_t i = 0;
+
+#ifdef M_POSE_HAVE_SSE
+	for (; i + 4 <= count; i += 4) {
+		m_pose_transform_4_sse(transform, &poses[i], &out_poses[i]);
+	}
+#endif
+
+	for (; i < count; i++) {
+		out_poses[i] = m_pose_transform(*transform, poses[i]);
+	}
+}
+
+/*!
+ * Walks a chain of poses, each of @p locals is in the space of the one
+ * before it and the first is in the space of @p base, like the joints of a
+ * finger. @p locals and @p out_poses may be the same array.
+ */
+static inline void
+m_pose_chain(const struct xrt_pose *base, const struct xrt_pose *locals, struct xrt_pose *out_poses, size_t count)
+{
+	struct xrt_pose current = *base;
+
+	for (size_t i = 0; i < count; i++) {
+		current = m_pose_transform(current, locals[i]);
+		out_poses[i] = current;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  C quat math library, inline versions of the hot functions in m_api.h.
+ *
+ * @see xrt_quat
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "m_mathinclude.h"
+#include "m_vec3.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Same as @ref math_quat_rotate, the rotation @p r followed by @p l.
+ */
+static inline struct xrt_quat
+m_quat_mul(struct xrt_quat l, struct xrt_quat r)
+{
+	struct xrt_quat ret = {
+	    l.w * r.x + l.x * r.w + l.y * r.z - l.z * r.y,
+	    l.w * r.y - l.x * r.z + l.y * r.w + l.z * r.x,
+	    l.w * r.z + l.x * r.y - l.y * r.x + l.z * r.w,
+	    l.w * r.w - l.x * r.x - l.y * r.y - l.z * r.z,
+	};
+	return ret;
+}
+
+/*!
+ * The inverse of a unit quaternion.
+ */
+static inline struct xrt_quat
+m_quat_conjugate(struct xrt_quat q)
+{
+	struct xrt_quat ret = {-q.x, -q.y, -q.z, q.w};
+	return ret;
+}
+
+static inline float
+m_quat_len_sqrd(struct xrt_quat q)
+{
+	return q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+}
+
+static inline struct xrt_quat
+m_quat_normalize(struct xrt_quat q)
+{
+	float inv = 1.0f / sqrtf(m_quat_len_sqrd(q));
+	struct xrt_quat ret = {q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+	return ret;
+}
+
+/*!
+ * Same as @ref math_quat_rotate_vec3 for unit quaternions, uses the two cross
+ * products form instead of building the rotation matrix.
+ */
+static inline struct xrt_vec3
+m_quat_rotate_vec3(struct xrt_quat q, struct xrt_vec3 v)
+{
+	struct xrt_vec3 u = {q.x, q.y, q.z};
+	struct xrt_vec3 t = m_vec3_mul_scalar(m_vec3_cross(u, v), 2.0f);
+	return m_vec3_add(m_vec3_add(v, m_vec3_mul_scalar(t, q.w)), m_vec3_cross(u, t));
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,293 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free history of timestamped space relations.
+ * @ingroup aux_math
+ */
+
+#include "math/m_api.h"
+#include "math/m_vec3.h"
+#include "math/m_predict.h"
+#include "math/m_relation_history.h"
+
+#include "util/u_time.h"
+
+#include <atomic>
+#include <assert.h>
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * One slot in the ring, the generation is a seqlock that also says which push
+ * the slot holds: 2n + 1 while push n is writing it, 2n + 2 once it is done.
+ */
+struct relation_history_entry
+{
+	std::atomic<uint64_t> generation;
+	uint64_t timestamp;
+	struct xrt_space_relation relation;
+};
+
+struct m_relation_history
+{
+	//! Number of relations ever pushed, push n lives in entries[n % capacity].
+	std::atomic<uint64_t> count;
+
+	//! Pushes before this were dropped by m_relation_history_clear.
+	std::atomic<uint64_t> first;
+
+	//! Only touched by the writer.
+	uint64_t last_timestamp;
+
+	struct relation_history_entry entries[M_RELATION_HISTORY_CAPACITY];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+/*!
+ * Copies out push @p n, returns false if the writer has touched the slot
+ * since, in which case the caller starts over.
+ */
+static bool
+read_entry(const struct m_relation_history *rh, uint64_t n, uint64_t *out_ts, struct xrt_space_relation *out_rel)
+{
+	const struct relation_history_entry &e = rh->entries[n % M_RELATION_HISTORY_CAPACITY];
+	const uint64_t expected = 2 * n + 2;
+
+	if (e.generation.load(std::memory_order_acquire) != expected) {
+		return false;
+	}
+
+	*out_ts = e.timestamp;
+	*out_rel = e.relation;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return e.generation.load(std::memory_order_relaxed) == expected;
+}
+
+static void
+interpolate(const struct xrt_space_relation *a,
+            const struct xrt_space_relation *b,
+            float t,
+            struct xrt_space_relation *out_rel)
+{
+	out_rel->relation_flags = (enum xrt_space_relation_flags)(a->relation_flags & b->relation_flags);
+
+	math_quat_slerp(&a->pose.orientation, &b->pose.orientation, t, &out_rel->pose.orientation);
+	out_rel->pose.position = m_vec3_lerp(a->pose.position, b->pose.position, t);
+	out_rel->linear_velocity = m_vec3_lerp(a->linear_velocity, b->linear_velocity, t);
+	out_rel->angular_velocity = m_vec3_lerp(a->angular_velocity, b->angular_velocity, t);
+}
+
+static void
+predict(const struct xrt_space_relation *rel, uint64_t from_ns, uint64_t to_ns, struct xrt_space_relation *out_rel)
+{
+	double delta_s = time_ns_to_s((int64_t)to_ns - (int64_t)from_ns);
+	m_predict_relation(rel, delta_s, out_rel);
+}
+
+/*!
+ * One attempt at a lookup, returns false if it raced with the writer.
+ */
+static bool
+try_get(const struct m_relation_history *rh,
+        uint64_t at_ns,
+        enum m_relation_history_result *out_result,
+        struct xrt_space_relation *out_rel)
+{
+	uint64_t count = rh->count.load(std::memory_order_acquire);
+	uint64_t first = rh->first.load(std::memory_order_acquire);
+
+	// The slot after the newest might be being overwritten right now.
+	uint64_t oldest = count >= M_RELATION_HISTORY_CAPACITY ? count - (M_RELATION_HISTORY_CAPACITY - 1) : 0;
+	if (first > oldest) {
+		oldest = first;
+	}
+
+	if (count <= oldest) {
+		struct xrt_space_relation zero = XRT_SPACE_RELATION_ZERO;
+		*out_result = M_RELATION_HISTORY_RESULT_INVALID;
+		*out_rel = zero;
+		return true;
+	}
+
+	uint64_t hi = count - 1;
+	uint64_t hi_ts;
+	struct xrt_space_relation hi_rel;
+	if (!read_entry(rh, hi, &hi_ts, &hi_rel)) {
+		return false;
+	}
+
+	if (at_ns >= hi_ts) {
+		if (at_ns == hi_ts) {
+			*out_result = M_RELATION_HISTORY_RESULT_EXACT;
+			*out_rel = hi_rel;
+		} else {
+			*out_result = M_RELATION_HISTORY_RESULT_PREDICTED;
+			predict(&hi_rel, hi_ts, at_ns, out_rel);
+		}
+		return true;
+	}
+
+	uint64_t lo = oldest;
+	uint64_t lo_ts;
+	struct xrt_space_relation lo_rel;
+	if (!read_entry(rh, lo, &lo_ts, &lo_rel)) {
+		return false;
+	}
+
+	if (at_ns <= lo_ts) {
+		if (at_ns == lo_ts) {
+			*out_result = M_RELATION_HISTORY_RESULT_EXACT;
+			*out_rel = lo_rel;
+		} else {
+			*out_result = M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+			predict(&lo_rel, lo_ts, at_ns, out_rel);
+		}
+		return true;
+	}
+
+	// Timestamps are strictly increasing, so binary search for lo_ts < at_ns < hi_ts.
+	while (hi - lo > 1) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		uint64_t mid_ts;
+		struct xrt_space_relation mid_rel;
+		if (!read_entry(rh, mid, &mid_ts, &mid_rel)) {
+			return false;
+		}
+
+		if (mid_ts == at_ns) {
+			*out_result = M_RELATION_HISTORY_RESULT_EXACT;
+			*out_rel = mid_rel;
+			return true;
+		}
+
+		if (mid_ts < at_ns) {
+			lo = mid;
+			lo_ts = mid_ts;
+			lo_rel = mid_rel;
+		} else {
+			hi = mid;
+			hi_ts = mid_ts;
+			hi_rel = mid_rel;
+		}
+	}
+
+	float t = (float)((double)(at_ns - lo_ts) / (double)(hi_ts - lo_ts));
+	*out_result = M_RELATION_HISTORY_RESULT_INTERPOLATED;
+	interpolate(&lo_rel, &hi_rel, t, out_rel);
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" void
+m_relation_history_create(struct m_relation_history **rh_ptr)
+{
+	assert(rh_ptr != NULL);
+
+	*rh_ptr = new m_relation_history();
+}
+
+extern "C" bool
+m_relation_history_push(struct m_relation_history *rh, const struct xrt_space_relation *in_relation, uint64_t timestamp)
+{
+	uint64_t n = rh->count.load(std::memory_order_relaxed);
+
+	if (n > rh->first.load(std::memory_order_relaxed) && timestamp <= rh->last_timestamp) {
+		return false;
+	}
+
+	struct relation_history_entry &e = rh->entries[n % M_RELATION_HISTORY_CAPACITY];
+
+	e.generation.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	e.timestamp = timestamp;
+	e.relation = *in_relation;
+
+	e.generation.store(2 * n + 2, std::memory_order_release);
+	rh->count.store(n + 1, std::memory_order_release);
+
+	rh->last_timestamp = timestamp;
+
+	return true;
+}
+
+extern "C" enum m_relation_history_result
+m_relation_history_get(struct m_relation_history *rh, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	enum m_relation_history_result result = M_RELATION_HISTORY_RESULT_INVALID;
+
+	// Only fails if the writer lapped us, which takes a long time at normal IMU rates.
+	while (!try_get(rh, at_timestamp_ns, &result, out_relation)) {
+	}
+
+	return result;
+}
+
+extern "C" bool
+m_relation_history_get_latest(struct m_relation_history *rh,
+                              uint64_t *out_timestamp_ns,
+                              struct xrt_space_relation *out_relation)
+{
+	while (true) {
+		uint64_t count = rh->count.load(std::memory_order_acquire);
+		if (count <= rh->first.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		if (read_entry(rh, count - 1, out_timestamp_ns, out_relation)) {
+			return true;
+		}
+	}
+}
+
+extern "C" uint32_t
+m_relation_history_get_size(const struct m_relation_history *rh)
+{
+	uint64_t count = rh->count.load(std::memory_order_acquire);
+	uint64_t first = rh->first.load(std::memory_order_acquire);
+
+	uint64_t size = count > first ? count - first : 0;
+	if (size > M_RELATION_HISTORY_CAPACITY - 1) {
+		size = M_RELATION_HISTORY_CAPACITY - 1;
+	}
+
+	return (uint32_t)size;
+}
+
+extern "C" void
+m_relation_history_clear(struct m_relation_history *rh)
+{
+	rh->first.store(rh->count.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+extern "C" void
+m_relation_history_destroy(struct m_relation_history **rh_ptr)
+{
+	struct m_relation_history *rh = *rh_ptr;
+	if (rh == NULL) {
+		return;
+	}
+
+	delete rh;
+	*rh_ptr = NULL;
+}
@@ -0,0 +1,127 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free history of timestamped space relations.
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * How many relations a @ref m_relation_history keeps, a bit over a second of
+ * samples from a 1kHz IMU.
+ *
+ * @ingroup aux_math
+ */
+#define M_RELATION_HISTORY_CAPACITY 1024
+
+/*!
+ * How a relation returned from @ref m_relation_history_get was made.
+ *
+ * @ingroup aux_math
+ */
+enum m_relation_history_result
+{
+	//! Nothing has been pushed yet, the relation is an identity pose with no valid flags.
+	M_RELATION_HISTORY_RESULT_INVALID = 0,
+	//! A pushed relation had exactly the requested timestamp.
+	M_RELATION_HISTORY_RESULT_EXACT,
+	//! Interpolated between the two pushed relations around the timestamp.
+	M_RELATION_HISTORY_RESULT_INTERPOLATED,
+	//! Predicted forward from the newest relation.
+	M_RELATION_HISTORY_RESULT_PREDICTED,
+	//! Predicted backwards from the oldest relation still kept.
+	M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED,
+};
+
+/*!
+ * A ring of timestamped relations, pushed by a single writer (typically the
+ * driver's IMU or tracking thread) and queried by any number of readers
+ * without taking any locks.
+ *
+ * Readers get the relation at any timestamp: inside the kept window it is
+ * interpolated (slerp for orientation, linear for the rest), outside of it
+ * it is predicted with @ref m_predict_relation from the closest relation.
+ *
+ * @ingroup aux_math
+ */
+struct m_relation_history;
+
+/*!
+ * Allocate a new, empty history.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_create(struct m_relation_history **rh_ptr);
+
+/*!
+ * Push a new relation, timestamps must be strictly increasing, anything else
+ * is dropped and false returned. Must only be called from one thread at a time.
+ *
+ * @public @memberof m_relation_history
+ */
+bool
+m_relation_history_push(struct m_relation_history *rh,
+                        const struct xrt_space_relation *in_relation,
+                        uint64_t timestamp);
+
+/*!
+ * Get the relation at @p at_timestamp_ns, see @ref m_relation_history_result
+ * for how it was made. Safe to call from any thread, concurrently with push.
+ *
+ * @public @memberof m_relation_history
+ */
+enum m_relation_history_result
+m_relation_history_get(struct m_relation_history *rh,
+                       uint64_t at_timestamp_ns,
+                       struct xrt_space_relation *out_relation);
+
+/*!
+ * Get the newest relation pushed and its timestamp, returns false if the
+ * history is empty.
+ *
+ * @public @memberof m_relation_history
+ */
+bool
+m_relation_history_get_latest(struct m_relation_history *rh,
+                              uint64_t *out_timestamp_ns,
+                              struct xrt_space_relation *out_relation);
+
+/*!
+ * Number of relations currently available to readers.
+ *
+ * @public @memberof m_relation_history
+ */
+uint32_t
+m_relation_history_get_size(const struct m_relation_history *rh);
+
+/*!
+ * Drop all relations, must be called from the writer thread.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_clear(struct m_relation_history *rh);
+
+/*!
+ * Free the history and set the pointer to NULL.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_destroy(struct m_relation_history **rh_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,8 @@
 #include "util/u_misc.h"
 
 #include "math/m_api.h"
+#include "math/m_pose.h"
+#include "math/m_quat.h"
 #include "math/m_vec2.h"
 #include "math/m_vec3.h"
 #include "math/m_space.h"
@@ -78,15 +80,19 @@ dump_graph(const struct xrt_space_graph *xsg)
  *
  */
 
+static inline bool
+has_no_pose(const struct xrt_space_relation *r)
+{
+	const uint32_t pose_flags = XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+
+	return (r->relation_flags & pose_flags) == 0;
+}
+
 static bool
 has_step_with_no_pose(const struct xrt_space_graph *xsg)
 {
-	const enum xrt_space_relation_flags pose_flags = (enum xrt_space_relation_flags)(
-	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
-
 	for (uint32_t i = 0; i < xsg->num_steps; i++) {
-		const struct xrt_space_relation *r = &xsg->steps[i];
-		if ((r->relation_flags & pose_flags) == 0) {
+		if (has_no_pose(&xsg->steps[i])) {
 			return true;
 		}
 	}
@@ -94,6 +100,36 @@ has_step_with_no_pose(const struct xrt_space_graph *xsg)
 	return false;
 }
 
+/*!
+ * The flags of @p af applied to @p bf, the same rules as @ref apply_relation
+ * but on the bits directly so the batch path can do it without branching.
+ */
+static inline uint32_t
+combine_flags(uint32_t af, uint32_t bf)
+{
+	const uint32_t kept = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |     //
+	                      XRT_SPACE_RELATION_POSITION_VALID_BIT |        //
+	                      XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |   //
+	                      XRT_SPACE_RELATION_POSITION_TRACKED_BIT |      //
+	                      XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | //
+	                      XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+	uint32_t both = af | bf;
+	uint32_t ret = both & kept;
+
+	// Position upgrades the orientation to valid, @see make_valid_pose.
+	if (both & XRT_SPACE_RELATION_POSITION_VALID_BIT) {
+		ret |= XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+	}
+
+	// The base rotating gives the body a tangential velocity.
+	if (bf & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) {
+		ret |= XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT;
+	}
+
+	return ret;
+}
+
 struct flags
 {
 	unsigned int has_orientation : 1;
@@ -301,3 +337,95 @@ m_space_graph_resolve(const struct xrt_space_graph *xsg, struct xrt_space_relati
 
 	*out_relation = r;
 }
+
+void
+m_space_relation_apply_many(const struct xrt_space_relation *base,
+                            const struct xrt_space_relation *relations,
+                            struct xrt_space_relation *out_relations,
+                            uint32_t count)
+{
+	if (has_no_pose(base)) {
+		for (uint32_t i = 0; i < count; i++) {
+			out_relations[i] = XRT_SPACE_RELATION_ZERO;
+		}
+		return;
+	}
+
+	flags bf = get_flags(base);
+	uint32_t base_flags = base->relation_flags;
+
+	struct xrt_pose base_pose = XRT_POSE_IDENTITY;
+	make_valid_pose(bf, &base->pose, &base_pose);
+
+	// Base velocities that don't apply are zero, so the loops below don't branch on them.
+	struct xrt_vec3 base_linear = bf.has_linear_velocity ? base->linear_velocity : xrt_vec3{0, 0, 0};
+	struct xrt_vec3 base_angular = bf.has_angular_velocity ? base->angular_velocity : xrt_vec3{0, 0, 0};
+
+	// Work in chunks so the structure of arrays fits on the stack.
+	constexpr uint32_t kChunk = 32;
+	struct xrt_pose poses[kChunk];
+	struct xrt_vec3 linear[kChunk];
+	struct xrt_vec3 angular[kChunk];
+	uint32_t new_flags[kChunk];
+
+	for (uint32_t start = 0; start < count; start += kChunk) {
+		const struct xrt_space_relation *in = &relations[start];
+		struct xrt_space_relation *out = &out_relations[start];
+		uint32_t num = count - start < kChunk ? count - start : kChunk;
+
+		for (uint32_t i = 0; i < num; i++) {
+			flags af = get_flags(&in[i]);
+			make_valid_pose(af, &in[i].pose, &poses[i]);
+			linear[i] = af.has_linear_velocity ? in[i].linear_velocity : xrt_vec3{0, 0, 0};
+			angular[i] = af.has_angular_velocity ? in[i].angular_velocity : xrt_vec3{0, 0, 0};
+			new_flags[i] = combine_flags(in[i].relation_flags, base_flags);
+		}
+
+		m_pose_transform_many(&base_pose, poses, poses, num);
+
+		for (uint32_t i = 0; i < num; i++) {
+			// Same as apply_relation, the position rotated into the base is the result minus the base.
+			struct xrt_vec3 rotated_position = m_vec3_sub(poses[i].position, base_pose.position);
+			struct xrt_vec3 tangential = m_vec3_cross(base_angular, rotated_position);
+
+			linear[i] = m_quat_rotate_vec3(base_pose.orientation, linear[i]) + base_linear + tangential;
+			angular[i] = m_quat_rotate_vec3(base_pose.orientation, angular[i]) + base_angular;
+		}
+
+		for (uint32_t i = 0; i < num; i++) {
+			if (has_no_pose(&in[i])) {
+				out[i] = XRT_SPACE_RELATION_ZERO;
+				continue;
+			}
+
+			struct xrt_space_relation r;
+			r.relation_flags = (enum xrt_space_relation_flags)new_flags[i];
+			r.pose.orientation = m_quat_normalize(poses[i].orientation);
+			r.pose.position = poses[i].position;
+			r.linear_velocity = linear[i];
+			r.angular_velocity = angular[i];
+			out[i] = r;
+		}
+	}
+}
+
+void
+m_space_graph_resolve_many(const struct xrt_space_graph *xsg,
+                           const struct xrt_space_relation *relations,
+                           struct xrt_space_relation *out_relations,
+                           uint32_t count)
+{
+	if (xsg->num_steps == 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			struct xrt_space_graph single = {};
+			m_space_graph_add_relation(&single, &relations[i]);
+			m_space_graph_resolve(&single, &out_relations[i]);
+		}
+		return;
+	}
+
+	struct xrt_space_relation base;
+	m_space_graph_resolve(xsg, &base);
+
+	m_space_relation_apply_many(&base, relations, out_relations, count);
+}
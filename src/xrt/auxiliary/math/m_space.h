@@ -165,6 +165,29 @@ m_space_graph_add_inverted_pose_if_not_identity(struct xrt_space_graph *xsg, con
 void
 m_space_graph_resolve(const struct xrt_space_graph *xsg, struct xrt_space_relation *out_relation);
 
+/*!
+ * Applies the same @p base to @p count relations, each result is the same as
+ * resolving a graph with the relation followed by @p base. Used for things
+ * like hand joints, where all joints share the chain up to the base space.
+ * The arrays may be the same.
+ */
+void
+m_space_relation_apply_many(const struct xrt_space_relation *base,
+                            const struct xrt_space_relation *relations,
+                            struct xrt_space_relation *out_relations,
+                            uint32_t count);
+
+/*!
+ * Resolves @p count relations that share the same chain of bases, each result
+ * is the same as resolving @p xsg with the relation added as its first step.
+ * The chain is only resolved once. The arrays may be the same.
+ */
+void
+m_space_graph_resolve_many(const struct xrt_space_graph *xsg,
+                           const struct xrt_space_relation *relations,
+                           struct xrt_space_relation *out_relations,
+                           uint32_t count);
+
 /*!
  * @}
  */
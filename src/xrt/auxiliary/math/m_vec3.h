@@ -72,6 +72,17 @@ m_vec3_dot(struct xrt_vec3 l, struct xrt_vec3 r)
 	return l.x * r.x + l.y * r.y + l.z * r.z;
 }
 
+static inline struct xrt_vec3
+m_vec3_cross(struct xrt_vec3 l, struct xrt_vec3 r)
+{
+	struct xrt_vec3 ret = {
+	    l.y * r.z - l.z * r.y,
+	    l.z * r.x - l.x * r.z,
+	    l.x * r.y - l.y * r.x,
+	};
+	return ret;
+}
+
 static inline float
 m_vec3_len_sqrd(struct xrt_vec3 l)
 {
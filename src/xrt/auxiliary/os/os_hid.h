@@ -39,6 +39,8 @@ struct os_hid_device
 
 	int (*get_physical_address)(struct os_hid_device *hid_dev, uint8_t *data, size_t size);
 
+	int (*get_fd)(struct os_hid_device *hid_dev);
+
 	void (*destroy)(struct os_hid_device *hid_dev);
 };
 
@@ -121,6 +123,21 @@ os_hid_get_physical_address(struct os_hid_device *hid_dev, uint8_t *data, size_t
 	return hid_dev->get_physical_address(hid_dev, data, size);
 }
 
+/*!
+ * Get the file descriptor that input reports are read from, for use with
+ * poll/epoll. Returns -1 if the implementation doesn't have one.
+ *
+ * @public @memberof os_hid_device
+ */
+static inline int
+os_hid_get_fd(struct os_hid_device *hid_dev)
+{
+	if (hid_dev->get_fd == NULL) {
+		return -1;
+	}
+	return hid_dev->get_fd(hid_dev);
+}
+
 /*!
  * Close and free the given device.
  *
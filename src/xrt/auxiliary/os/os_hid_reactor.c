@@ -0,0 +1,529 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Epoll based hid reactor.
+ *
+ * @ingroup aux_os
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "os_hid_reactor.h"
+
+#ifdef XRT_OS_LINUX
+
+#include "os/os_threading.h"
+#include "os/os_thread_role.h"
+#include "util/u_misc.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+//! Max number of reports read from one device per wakeup, so one device can't starve the others.
+#define MAX_REPORTS_PER_WAKEUP 32
+
+//! Max number of ready devices returned by one epoll_wait.
+#define MAX_EVENTS 16
+
+//! Slot index lives in the low bits of the id, the generation in the rest.
+#define SLOT_BITS 8
+#define SLOT_MASK ((1u << SLOT_BITS) - 1)
+
+//! Epoll data value for the wakeup eventfd, never a valid id since generations start at one.
+#define WAKEUP_ID 0
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+struct hid_reactor_entry
+{
+	struct os_hid_device *hid_dev;
+	int fd;
+
+	//! File status flags from before the fd was made non-blocking.
+	int old_flags;
+
+	os_hid_reactor_func func;
+	void *ptr;
+
+	//! Zero when the slot is free.
+	uint32_t id;
+};
+
+struct os_hid_reactor
+{
+	struct os_thread_helper oth;
+
+	//! Held while dispatching and while changing the entries.
+	struct os_mutex dispatch_lock;
+
+	struct os_hid_reactor_params params;
+
+	int epoll_fd;
+	int wakeup_fd;
+
+	//! Bumped on every add so stale ids and epoll events can be told apart.
+	uint32_t generation;
+
+	struct hid_reactor_entry entries[OS_HID_REACTOR_MAX_DEVICES];
+
+	//! Only touched by the reactor thread.
+	uint8_t buffer[OS_HID_REACTOR_MAX_REPORT_SIZE];
+};
+
+
+/*
+ *
+ * Shared instance.
+ *
+ */
+
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct os_hid_reactor *shared_reactor = NULL;
+static uint32_t shared_refs = 0;
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static int
+get_env_int(const char *name, int _default)
+{
+	const char *str = getenv(name);
+	if (str == NULL || str[0] == '\0') {
+		return _default;
+	}
+
+	return atoi(str);
+}
+
+static struct hid_reactor_entry *
+get_entry_locked(struct os_hid_reactor *hr, uint32_t id)
+{
+	if (id == 0) {
+		return NULL;
+	}
+
+	struct hid_reactor_entry *e = &hr->entries[id & SLOT_MASK];
+	if (e->id != id) {
+		return NULL;
+	}
+
+	return e;
+}
+
+static void
+remove_entry_locked(struct os_hid_reactor *hr, struct hid_reactor_entry *e)
+{
+	epoll_ctl(hr->epoll_fd, EPOLL_CTL_DEL, e->fd, NULL);
+	fcntl(e->fd, F_SETFL, e->old_flags);
+
+	U_ZERO(e);
+}
+
+static void
+setup_thread(struct os_hid_reactor *hr)
+{
+	// Best effort, the reactor works fine without any of these.
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "hid_reactor");
+
+	// The reactor specific options override the role policy.
+	if (hr->params.cpu >= 0 && hr->params.cpu < CPU_SETSIZE) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(hr->params.cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+
+	if (hr->params.priority > 0) {
+		struct sched_param param = {.sched_priority = hr->params.priority};
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+}
+
+/*!
+ * Read all pending reports from the device, returns false if the entry was
+ * removed.
+ */
+static bool
+drain_entry_locked(struct os_hid_reactor *hr, struct hid_reactor_entry *e, uint32_t events)
+{
+	uint32_t id = e->id;
+
+	for (int i = 0; i < MAX_REPORTS_PER_WAKEUP; i++) {
+		ssize_t ret = read(e->fd, hr->buffer, sizeof(hr->buffer));
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0 && errno == EAGAIN) {
+			break;
+		}
+
+		if (ret <= 0) {
+			int err = ret < 0 ? -errno : -ENODEV;
+			e->func(e->ptr, NULL, err);
+			// The callback might have removed the entry itself.
+			if (e->id == id) {
+				remove_entry_locked(hr, e);
+			}
+			return false;
+		}
+
+		if (!e->func(e->ptr, hr->buffer, (int)ret)) {
+			if (e->id == id) {
+				remove_entry_locked(hr, e);
+			}
+			return false;
+		}
+
+		if (e->id != id) {
+			return false;
+		}
+	}
+
+	// Hung up with nothing left to read.
+	if ((events & (EPOLLHUP | EPOLLERR)) != 0 && (events & EPOLLIN) == 0) {
+		e->func(e->ptr, NULL, -ENODEV);
+		if (e->id == id) {
+			remove_entry_locked(hr, e);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+static void *
+run_thread(void *ptr)
+{
+	struct os_hid_reactor *hr = (struct os_hid_reactor *)ptr;
+	struct epoll_event events[MAX_EVENTS];
+
+	setup_thread(hr);
+
+	os_thread_helper_lock(&hr->oth);
+	while (os_thread_helper_is_running_locked(&hr->oth)) {
+		os_thread_helper_unlock(&hr->oth);
+
+		int num = epoll_wait(hr->epoll_fd, events, MAX_EVENTS, -1);
+		if (num < 0 && errno != EINTR) {
+			os_thread_helper_lock(&hr->oth);
+			break;
+		}
+
+		os_mutex_lock(&hr->dispatch_lock);
+		for (int i = 0; i < num; i++) {
+			uint32_t id = (uint32_t)events[i].data.u64;
+
+			if (id == WAKEUP_ID) {
+				uint64_t value;
+				ssize_t ret = read(hr->wakeup_fd, &value, sizeof(value));
+				(void)ret;
+				continue;
+			}
+
+			// The device might have been removed by an earlier callback in this batch.
+			struct hid_reactor_entry *e = get_entry_locked(hr, id);
+			if (e == NULL) {
+				continue;
+			}
+
+			drain_entry_locked(hr, e, events[i].events);
+		}
+		os_mutex_unlock(&hr->dispatch_lock);
+
+		// Just keep swimming.
+		os_thread_helper_lock(&hr->oth);
+	}
+	os_thread_helper_unlock(&hr->oth);
+
+	return NULL;
+}
+
+static bool
+is_reactor_thread(struct os_hid_reactor *hr)
+{
+	bool ret;
+
+	os_thread_helper_lock(&hr->oth);
+	ret = hr->oth.running && pthread_equal(pthread_self(), hr->oth.thread);
+	os_thread_helper_unlock(&hr->oth);
+
+	return ret;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+os_hid_reactor_create(const struct os_hid_reactor_params *params, struct os_hid_reactor **out_hr)
+{
+	struct os_hid_reactor *hr = U_TYPED_CALLOC(struct os_hid_reactor);
+	int ret;
+
+	hr->params.cpu = -1;
+	if (params != NULL) {
+		hr->params = *params;
+	}
+
+	hr->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (hr->epoll_fd < 0) {
+		ret = -errno;
+		free(hr);
+		return ret;
+	}
+
+	hr->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (hr->wakeup_fd < 0) {
+		ret = -errno;
+		close(hr->epoll_fd);
+		free(hr);
+		return ret;
+	}
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.u64 = WAKEUP_ID};
+	if (epoll_ctl(hr->epoll_fd, EPOLL_CTL_ADD, hr->wakeup_fd, &ev) < 0) {
+		ret = -errno;
+		goto err_fds;
+	}
+
+	ret = os_mutex_init(&hr->dispatch_lock);
+	if (ret != 0) {
+		ret = -ret;
+		goto err_fds;
+	}
+
+	ret = os_thread_helper_init(&hr->oth);
+	if (ret != 0) {
+		ret = -ret;
+		goto err_mutex;
+	}
+
+	ret = os_thread_helper_start(&hr->oth, run_thread, hr);
+	if (ret != 0) {
+		ret = ret < 0 ? ret : -ret;
+		goto err_oth;
+	}
+
+	*out_hr = hr;
+
+	return 0;
+
+err_oth:
+	os_thread_helper_destroy(&hr->oth);
+err_mutex:
+	os_mutex_destroy(&hr->dispatch_lock);
+err_fds:
+	close(hr->wakeup_fd);
+	close(hr->epoll_fd);
+	free(hr);
+
+	return ret;
+}
+
+struct os_hid_reactor *
+os_hid_reactor_get_shared(void)
+{
+	struct os_hid_reactor *hr = NULL;
+
+	pthread_mutex_lock(&shared_mutex);
+
+	if (shared_reactor == NULL) {
+		// Opt-in only, see os_hid_reactor_get_shared in the header.
+		struct os_hid_reactor_params params = {
+		    .cpu = get_env_int("OS_HID_REACTOR_CPU", -1),
+		    .priority = get_env_int("OS_HID_REACTOR_PRIORITY", 0),
+		};
+
+		if (os_hid_reactor_create(&params, &shared_reactor) != 0) {
+			shared_reactor = NULL;
+		}
+	}
+
+	if (shared_reactor != NULL) {
+		shared_refs++;
+		hr = shared_reactor;
+	}
+
+	pthread_mutex_unlock(&shared_mutex);
+
+	return hr;
+}
+
+void
+os_hid_reactor_put_shared(struct os_hid_reactor **hr_ptr)
+{
+	struct os_hid_reactor *hr = *hr_ptr;
+	if (hr == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&shared_mutex);
+
+	assert(hr == shared_reactor && shared_refs > 0);
+	if (--shared_refs == 0) {
+		os_hid_reactor_destroy(&shared_reactor);
+	}
+
+	pthread_mutex_unlock(&shared_mutex);
+
+	*hr_ptr = NULL;
+}
+
+int
+os_hid_reactor_add(struct os_hid_reactor *hr,
+                   struct os_hid_device *hid_dev,
+                   os_hid_reactor_func func,
+                   void *ptr,
+                   uint32_t *out_id)
+{
+	int fd = os_hid_get_fd(hid_dev);
+	if (fd < 0) {
+		return -EINVAL;
+	}
+
+	int old_flags = fcntl(fd, F_GETFL);
+	if (old_flags < 0) {
+		return -errno;
+	}
+
+	bool on_thread = is_reactor_thread(hr);
+	if (!on_thread) {
+		os_mutex_lock(&hr->dispatch_lock);
+	}
+
+	int ret = -ENOSPC;
+	for (uint32_t i = 0; i < OS_HID_REACTOR_MAX_DEVICES; i++) {
+		struct hid_reactor_entry *e = &hr->entries[i];
+		if (e->id != 0) {
+			continue;
+		}
+
+		// Generation zero would make an id that could be zero.
+		if (++hr->generation > (UINT32_MAX >> SLOT_BITS)) {
+			hr->generation = 1;
+		}
+		uint32_t id = (hr->generation << SLOT_BITS) | i;
+
+		if (fcntl(fd, F_SETFL, old_flags | O_NONBLOCK) < 0) {
+			ret = -errno;
+			break;
+		}
+
+		struct epoll_event ev = {.events = EPOLLIN, .data.u64 = id};
+		if (epoll_ctl(hr->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			ret = -errno;
+			fcntl(fd, F_SETFL, old_flags);
+			break;
+		}
+
+		e->hid_dev = hid_dev;
+		e->fd = fd;
+		e->old_flags = old_flags;
+		e->func = func;
+		e->ptr = ptr;
+		e->id = id;
+
+		*out_id = id;
+		ret = 0;
+		break;
+	}
+
+	if (!on_thread) {
+		os_mutex_unlock(&hr->dispatch_lock);
+	}
+
+	return ret;
+}
+
+void
+os_hid_reactor_remove(struct os_hid_reactor *hr, uint32_t *id_ptr)
+{
+	uint32_t id = *id_ptr;
+	if (hr == NULL || id == 0) {
+		return;
+	}
+
+	// Callbacks are called with the lock held.
+	bool on_thread = is_reactor_thread(hr);
+	if (!on_thread) {
+		os_mutex_lock(&hr->dispatch_lock);
+	}
+
+	struct hid_reactor_entry *e = get_entry_locked(hr, id);
+	if (e != NULL) {
+		remove_entry_locked(hr, e);
+	}
+
+	if (!on_thread) {
+		os_mutex_unlock(&hr->dispatch_lock);
+	}
+
+	*id_ptr = 0;
+}
+
+void
+os_hid_reactor_destroy(struct os_hid_reactor **hr_ptr)
+{
+	struct os_hid_reactor *hr = *hr_ptr;
+	if (hr == NULL) {
+		return;
+	}
+
+	// Tell the thread to stop then kick it out of epoll_wait.
+	os_thread_helper_lock(&hr->oth);
+	hr->oth.running = false;
+	os_thread_helper_unlock(&hr->oth);
+
+	uint64_t value = 1;
+	ssize_t ret = write(hr->wakeup_fd, &value, sizeof(value));
+	(void)ret;
+
+	pthread_join(hr->oth.thread, NULL);
+	os_thread_helper_destroy(&hr->oth);
+
+	for (uint32_t i = 0; i < OS_HID_REACTOR_MAX_DEVICES; i++) {
+		if (hr->entries[i].id != 0) {
+			remove_entry_locked(hr, &hr->entries[i]);
+		}
+	}
+
+	os_mutex_destroy(&hr->dispatch_lock);
+	close(hr->wakeup_fd);
+	close(hr->epoll_fd);
+	free(hr);
+
+	*hr_ptr = NULL;
+}
+
+#endif
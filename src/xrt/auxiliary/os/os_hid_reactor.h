@@ -0,0 +1,156 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Single thread that reads and dispatches reports from many hid devices.
+ *
+ * @ingroup aux_os
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_hid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Max number of hid devices a single reactor can have registered.
+ *
+ * @ingroup aux_os
+ */
+#define OS_HID_REACTOR_MAX_DEVICES 32
+
+/*!
+ * Largest input report that can be dispatched, bigger reports are truncated.
+ *
+ * @ingroup aux_os
+ */
+#define OS_HID_REACTOR_MAX_REPORT_SIZE 1024
+
+/*!
+ * Called on the reactor thread for each input report read from the device.
+ *
+ * @p size is the number of bytes in @p data, or a negative errno if reading
+ * from the device failed (say it was unplugged), in which case @p data is
+ * NULL and the device is removed from the reactor after the call.
+ *
+ * Return false to have the device removed from the reactor, this replaces
+ * returning from a per device read thread.
+ *
+ * @ingroup aux_os
+ */
+typedef bool (*os_hid_reactor_func)(void *ptr, const uint8_t *data, int size);
+
+/*!
+ * Thread options for a @ref os_hid_reactor.
+ *
+ * @ingroup aux_os
+ */
+struct os_hid_reactor_params
+{
+	//! CPU to pin the reactor thread to, negative to let the scheduler pick.
+	int cpu;
+
+	//! SCHED_FIFO priority for the reactor thread, zero keeps the default scheduler.
+	int priority;
+};
+
+/*!
+ * Reads input reports from many hid devices on one thread: all devices are
+ * in one epoll set and every wakeup drains all pending reports from each
+ * ready device before going back to sleep. Replaces having one thread per
+ * device looping on @ref os_hid_read.
+ *
+ * Callbacks are called with an internal lock held, so after
+ * @ref os_hid_reactor_remove returns the callback will not be called again
+ * and the callback data can be freed.
+ *
+ * Only hid devices that implement @ref os_hid_get_fd can be added.
+ *
+ * @ingroup aux_os
+ */
+struct os_hid_reactor;
+
+#ifdef XRT_OS_LINUX
+/*!
+ * Create a reactor and start its thread, @p params may be NULL.
+ *
+ * @public @memberof os_hid_reactor
+ */
+int
+os_hid_reactor_create(const struct os_hid_reactor_params *params, struct os_hid_reactor **out_hr);
+
+/*!
+ * Get a reference to the reactor shared by all drivers, created on first use.
+ *
+ * The thread gets the @ref OS_THREAD_ROLE_IMU policy. On top of that it can be
+ * pinned and made realtime with the environment variables `OS_HID_REACTOR_CPU`
+ * and `OS_HID_REACTOR_PRIORITY`. Both are opt-in like the role policy: a
+ * SCHED_FIFO thread needs privileges most users don't have, and when it does
+ * get them a busy reactor could starve the compositor.
+ *
+ * @public @memberof os_hid_reactor
+ */
+struct os_hid_reactor *
+os_hid_reactor_get_shared(void);
+
+/*!
+ * Release a reference gotten from @ref os_hid_reactor_get_shared, the reactor
+ * is destroyed when the last one is released. Sets the pointer to NULL.
+ *
+ * @public @memberof os_hid_reactor
+ */
+void
+os_hid_reactor_put_shared(struct os_hid_reactor **hr_ptr);
+
+/*!
+ * Start dispatching reports from @p hid_dev to @p func. The device is made
+ * non-blocking while added, so don't read from it on any other thread.
+ *
+ * @param      hr       Reactor.
+ * @param      hid_dev  Device, must outlive the registration.
+ * @param      func     Called for every report.
+ * @param      ptr      Passed to @p func.
+ * @param[out] out_id   Non-zero id to pass to @ref os_hid_reactor_remove.
+ *
+ * @return Zero on success, negative errno on failure.
+ *
+ * @public @memberof os_hid_reactor
+ */
+int
+os_hid_reactor_add(struct os_hid_reactor *hr,
+                   struct os_hid_device *hid_dev,
+                   os_hid_reactor_func func,
+                   void *ptr,
+                   uint32_t *out_id);
+
+/*!
+ * Stop dispatching reports for the given registration and set the id to zero,
+ * does nothing if it is zero or was already removed. Safe to call from within
+ * a callback.
+ *
+ * @public @memberof os_hid_reactor
+ */
+void
+os_hid_reactor_remove(struct os_hid_reactor *hr, uint32_t *id_ptr);
+
+/*!
+ * Stop the thread and free the reactor, all devices must have been removed.
+ * Sets the pointer to NULL.
+ *
+ * @public @memberof os_hid_reactor
+ */
+void
+os_hid_reactor_destroy(struct os_hid_reactor **hr_ptr);
+#endif
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
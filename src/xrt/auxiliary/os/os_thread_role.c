@@ -0,0 +1,292 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Registry of runtime threads and the scheduling policy of their roles.
+ *
+ * @ingroup aux_os
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "os_thread_role.h"
+
+#include "os/os_threading.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#ifdef XRT_OS_LINUX
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+
+/*
+ *
+ * Globals.
+ *
+ */
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct os_thread_role_entry registry[OS_THREAD_ROLE_MAX_THREADS];
+
+static pthread_once_t policies_once = PTHREAD_ONCE_INIT;
+static struct os_thread_role_policy policies[OS_THREAD_ROLE_COUNT];
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t entry_key;
+
+
+/*
+ *
+ * Policy parsing.
+ *
+ */
+
+static bool
+parse_cpus(const char *str, uint64_t *out_mask)
+{
+	uint64_t mask = 0;
+
+	while (*str != '\0') {
+		char *end = NULL;
+		long first = strtol(str, &end, 10);
+		if (end == str) {
+			return false;
+		}
+
+		long last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtol(str, &end, 10);
+			if (end == str) {
+				return false;
+			}
+		}
+
+		if (first < 0 || last < first || last >= 64) {
+			return false;
+		}
+
+		for (long i = first; i <= last; i++) {
+			mask |= UINT64_C(1) << i;
+		}
+
+		str = end;
+		if (*str == ',') {
+			str++;
+		} else if (*str != '\0') {
+			return false;
+		}
+	}
+
+	*out_mask = mask;
+
+	return true;
+}
+
+static void
+parse_policy(const char *str, struct os_thread_role_policy *policy)
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "%s", str);
+
+	char *save = NULL;
+	for (char *tok = strtok_r(buffer, " ;", &save); tok != NULL; tok = strtok_r(NULL, " ;", &save)) {
+		if (strncmp(tok, "cpus=", 5) == 0) {
+			if (!parse_cpus(tok + 5, &policy->cpu_mask)) {
+				fprintf(stderr, "Invalid thread role option '%s'\n", tok);
+			}
+		} else if (strncmp(tok, "nice=", 5) == 0) {
+			policy->has_nice = true;
+			policy->nice = atoi(tok + 5);
+		} else if (strncmp(tok, "rt=", 3) == 0) {
+			policy->rt_priority = atoi(tok + 3);
+		} else {
+			fprintf(stderr, "Unknown thread role option '%s'\n", tok);
+		}
+	}
+}
+
+static void
+load_policies(void)
+{
+	for (int i = 0; i < OS_THREAD_ROLE_COUNT; i++) {
+		char name[64];
+		snprintf(name, sizeof(name), "XRT_THREAD_ROLE_%s", os_thread_role_str((enum os_thread_role)i));
+
+		const char *str = getenv(name);
+		if (str != NULL && str[0] != '\0') {
+			parse_policy(str, &policies[i]);
+		}
+	}
+}
+
+
+/*
+ *
+ * Registry.
+ *
+ */
+
+static void
+entry_destructor(void *ptr)
+{
+	struct os_thread_role_entry *e = (struct os_thread_role_entry *)ptr;
+
+	pthread_mutex_lock(&registry_mutex);
+	e->active = false;
+	snprintf(e->info, sizeof(e->info), "(exited) %s", e->name);
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+static void
+create_key(void)
+{
+	pthread_key_create(&entry_key, entry_destructor);
+}
+
+static int32_t
+get_tid(void)
+{
+#ifdef XRT_OS_LINUX
+	return (int32_t)syscall(SYS_gettid);
+#else
+	return 0;
+#endif
+}
+
+/*!
+ * Apply the policy to the calling thread, returns the number of parts that
+ * could not be applied.
+ */
+static int
+apply_policy(const struct os_thread_role_policy *policy, int32_t tid)
+{
+	int failed = 0;
+
+#ifdef XRT_OS_LINUX
+	if (policy->cpu_mask != 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int i = 0; i < 64; i++) {
+			if (policy->cpu_mask & (UINT64_C(1) << i)) {
+				CPU_SET(i, &set);
+			}
+		}
+		failed += pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0;
+	}
+
+	// On Linux the nice value is per thread when given the thread id.
+	if (policy->has_nice) {
+		failed += setpriority(PRIO_PROCESS, (id_t)tid, policy->nice) != 0;
+	}
+#else
+	(void)tid;
+	failed += policy->cpu_mask != 0;
+	failed += policy->has_nice;
+#endif
+
+	if (policy->rt_priority > 0) {
+		failed += os_thread_self_set_realtime(policy->rt_priority) != 0;
+	}
+
+	return failed;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+const char *
+os_thread_role_str(enum os_thread_role role)
+{
+	switch (role) {
+	case OS_THREAD_ROLE_BACKGROUND: return "BACKGROUND";
+	case OS_THREAD_ROLE_RENDER: return "RENDER";
+	case OS_THREAD_ROLE_IMU: return "IMU";
+	case OS_THREAD_ROLE_CAMERA: return "CAMERA";
+	case OS_THREAD_ROLE_TRACKING: return "TRACKING";
+	case OS_THREAD_ROLE_IPC: return "IPC";
+	default: return "UNKNOWN";
+	}
+}
+
+void
+os_thread_role_get_policy(enum os_thread_role role, struct os_thread_role_policy *out_policy)
+{
+	pthread_once(&policies_once, load_policies);
+
+	if (role < 0 || role >= OS_THREAD_ROLE_COUNT) {
+		memset(out_policy, 0, sizeof(*out_policy));
+		return;
+	}
+
+	*out_policy = policies[role];
+}
+
+int
+os_thread_role_set(enum os_thread_role role, const char *name)
+{
+	pthread_once(&key_once, create_key);
+
+	struct os_thread_role_policy policy;
+	os_thread_role_get_policy(role, &policy);
+
+	int32_t tid = get_tid();
+
+#ifdef XRT_OS_LINUX
+	// The kernel limits names to 15 characters, pthread_setname_np fails on longer ones.
+	char short_name[16];
+	snprintf(short_name, sizeof(short_name), "%s", name);
+	pthread_setname_np(pthread_self(), short_name);
+#endif
+
+	int failed = apply_policy(&policy, tid);
+
+	pthread_mutex_lock(&registry_mutex);
+
+	struct os_thread_role_entry *e = (struct os_thread_role_entry *)pthread_getspecific(entry_key);
+	for (int i = 0; e == NULL && i < OS_THREAD_ROLE_MAX_THREADS; i++) {
+		if (!registry[i].active) {
+			e = &registry[i];
+		}
+	}
+
+	if (e != NULL) {
+		e->active = true;
+		e->role = role;
+		e->tid = tid;
+		snprintf(e->name, sizeof(e->name), "%s", name);
+		snprintf(e->info, sizeof(e->info), "%s %s tid: %i cpus: 0x%" PRIx64 " nice: %i rt: %i%s",
+		         os_thread_role_str(role), e->name, tid, policy.cpu_mask, policy.has_nice ? policy.nice : 0,
+		         policy.rt_priority, failed ? " (not all applied)" : "");
+	}
+
+	pthread_mutex_unlock(&registry_mutex);
+
+	if (e != NULL) {
+		pthread_setspecific(entry_key, e);
+	}
+
+	return failed == 0 ? 0 : -1;
+}
+
+void
+os_thread_role_copy_entries(struct os_thread_role_entry out_entries[OS_THREAD_ROLE_MAX_THREADS])
+{
+	pthread_mutex_lock(&registry_mutex);
+	memcpy(out_entries, registry, sizeof(registry));
+	pthread_mutex_unlock(&registry_mutex);
+}
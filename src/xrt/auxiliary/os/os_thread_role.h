@@ -0,0 +1,136 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Registry of runtime threads and the scheduling policy of their roles.
+ *
+ * @ingroup aux_os
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Max number of threads that can be registered at the same time.
+ *
+ * @ingroup aux_os
+ */
+#define OS_THREAD_ROLE_MAX_THREADS 64
+
+/*!
+ * What a thread does, the scheduling policy is per role.
+ *
+ * The policy of a role is read from the environment variable
+ * `XRT_THREAD_ROLE_<ROLE>`, for example `XRT_THREAD_ROLE_TRACKING`, as space
+ * separated options:
+ *
+ * - `cpus=2-5,7` the CPUs the threads may run on.
+ * - `nice=5` the nice value of the threads.
+ * - `rt=10` makes the threads SCHED_FIFO with the given priority.
+ *
+ * With no variable set the threads are only named and registered.
+ *
+ * @ingroup aux_os
+ */
+enum os_thread_role
+{
+	OS_THREAD_ROLE_BACKGROUND,
+	OS_THREAD_ROLE_RENDER,
+	OS_THREAD_ROLE_IMU,
+	OS_THREAD_ROLE_CAMERA,
+	OS_THREAD_ROLE_TRACKING,
+	OS_THREAD_ROLE_IPC,
+	OS_THREAD_ROLE_COUNT,
+};
+
+/*!
+ * Scheduling policy of a role.
+ *
+ * @ingroup aux_os
+ */
+struct os_thread_role_policy
+{
+	//! CPUs the threads may run on, zero leaves the affinity alone.
+	uint64_t cpu_mask;
+
+	//! Is @ref nice set.
+	bool has_nice;
+
+	//! Nice value of the threads.
+	int nice;
+
+	//! SCHED_FIFO priority, zero keeps the default scheduler.
+	int rt_priority;
+};
+
+/*!
+ * A registered thread, the registry is a fixed array of these.
+ *
+ * @ingroup aux_os
+ */
+struct os_thread_role_entry
+{
+	//! Is this entry a live thread.
+	bool active;
+
+	enum os_thread_role role;
+
+	//! Kernel thread id, what top and perf show.
+	int32_t tid;
+
+	//! Thread name, the kernel limits them to 15 characters.
+	char name[16];
+
+	//! Summary of the thread and its applied policy for the debug gui.
+	char info[128];
+};
+
+/*!
+ * Name of the role, as used in the environment variable.
+ *
+ * @ingroup aux_os
+ */
+const char *
+os_thread_role_str(enum os_thread_role role);
+
+/*!
+ * Get the policy of the role, parsed from the environment the first time.
+ *
+ * @ingroup aux_os
+ */
+void
+os_thread_role_get_policy(enum os_thread_role role, struct os_thread_role_policy *out_policy);
+
+/*!
+ * Register the calling thread with the given role and name, names the thread
+ * and applies the policy of the role to it. The entry is removed when the
+ * thread exits. Calling it again updates the entry.
+ *
+ * Returns zero if the whole policy could be applied, the thread is registered
+ * even if not, say because the process is missing CAP_SYS_NICE.
+ *
+ * @ingroup aux_os
+ */
+int
+os_thread_role_set(enum os_thread_role role, const char *name);
+
+/*!
+ * Copy all entries of the registry, taken under its lock so no entry is torn
+ * by a thread registering or exiting. Check @ref os_thread_role_entry::active.
+ *
+ * @ingroup aux_os
+ */
+void
+os_thread_role_copy_entries(struct os_thread_role_entry out_entries[OS_THREAD_ROLE_MAX_THREADS]);
+
+
+#ifdef __cplusplus
+}
+#endif
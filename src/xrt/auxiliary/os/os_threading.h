@@ -19,6 +19,7 @@
 
 #if defined(XRT_OS_LINUX)
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <assert.h>
 #elif defined(XRT_OS_WINDOWS)
@@ -153,6 +154,24 @@ static inline void
 os_thread_destroy(struct os_thread *ost)
 {}
 
+/*!
+ * Make the calling thread a SCHED_FIFO realtime thread with @p priority, needs
+ * CAP_SYS_NICE or a RLIMIT_RTPRIO grant. Returns zero on success.
+ */
+static inline int
+os_thread_self_set_realtime(int priority)
+{
+#if defined(XRT_OS_LINUX)
+	struct sched_param param = {0};
+	param.sched_priority = priority;
+
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#else
+	(void)priority;
+	return -1;
+#endif
+}
+
 
 /*
  *
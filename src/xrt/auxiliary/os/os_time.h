@@ -24,6 +24,9 @@
 #ifdef XRT_OS_LINUX
 #include <time.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <unistd.h>
 #define XRT_HAVE_TIMESPEC
 #define XRT_HAVE_TIMEVAL
 
@@ -81,6 +84,14 @@ os_nanosleep(int32_t nsec)
 #endif
 }
 
+/*!
+ * @brief How long before the deadline @ref os_precise_sleeper_nanosleep_until
+ * stops sleeping and spins instead, covers the wake up latency of a loaded
+ * system without burning too much CPU.
+ * @ingroup aux_os_time
+ */
+#define OS_PRECISE_SLEEPER_DEFAULT_SPIN_NS (100 * 1000)
+
 /*!
  * @brief A structure for storing state as needed for more precise sleeping, mostly for compositor use.
  * @ingroup aux_os_time
@@ -89,6 +100,12 @@ struct os_precise_sleeper
 {
 #if defined(XRT_OS_WINDOWS)
 	HANDLE timer;
+#elif defined(XRT_OS_LINUX)
+	//! Absolute monotonic timer used to sleep up to the spin part.
+	int timerfd;
+
+	//! How long before the deadline to spin instead of sleep.
+	uint64_t spin_ns;
 #else
 	int unused_;
 #endif
@@ -103,6 +120,9 @@ os_precise_sleeper_init(struct os_precise_sleeper *ops)
 {
 #if defined(XRT_OS_WINDOWS)
 	ops->timer = CreateWaitableTimer(NULL, TRUE, NULL);
+#elif defined(XRT_OS_LINUX)
+	ops->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	ops->spin_ns = OS_PRECISE_SLEEPER_DEFAULT_SPIN_NS;
 #endif
 }
 
@@ -119,6 +139,11 @@ os_precise_sleeper_deinit(struct os_precise_sleeper *ops)
 		CloseHandle(ops->timer);
 		ops->timer = NULL;
 	}
+#elif defined(XRT_OS_LINUX)
+	if (ops->timerfd >= 0) {
+		close(ops->timerfd);
+		ops->timerfd = -1;
+	}
 #endif
 }
 
@@ -251,6 +276,56 @@ os_realtime_get_ns(void)
 #endif
 
 
+/*!
+ * @brief Sleep until the monotonic @p deadline_ns, returns the time it woke up.
+ *
+ * On Linux this sleeps on an absolute timerfd until @ref
+ * os_precise_sleeper::spin_ns before the deadline and then spins the rest, so
+ * neither the time spent setting up the sleep nor the wake up latency of the
+ * scheduler adds to the sleep. Elsewhere it is the same as @ref
+ * os_precise_sleeper_nanosleep with the time left.
+ *
+ * @public @memberof os_precise_sleeper
+ */
+static inline uint64_t
+os_precise_sleeper_nanosleep_until(struct os_precise_sleeper *ops, uint64_t deadline_ns)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (now_ns >= deadline_ns) {
+		return now_ns;
+	}
+
+#if defined(XRT_OS_LINUX)
+	if (ops->timerfd >= 0 && deadline_ns - now_ns > ops->spin_ns) {
+		struct itimerspec spec;
+		spec.it_interval.tv_sec = 0;
+		spec.it_interval.tv_nsec = 0;
+		os_ns_to_timespec(deadline_ns - ops->spin_ns, &spec.it_value);
+
+		if (timerfd_settime(ops->timerfd, TFD_TIMER_ABSTIME, &spec, NULL) == 0) {
+			uint64_t expirations = 0;
+			ssize_t ret;
+			do {
+				ret = read(ops->timerfd, &expirations, sizeof(expirations));
+			} while (ret < 0 && errno == EINTR);
+		}
+	}
+
+	while ((now_ns = os_monotonic_get_ns()) < deadline_ns) {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+
+	return now_ns;
+#else
+	os_precise_sleeper_nanosleep(ops, (int32_t)(deadline_ns - now_ns));
+
+	return os_monotonic_get_ns();
+#endif
+}
+
+
 #ifdef __cplusplus
 }
 #endif
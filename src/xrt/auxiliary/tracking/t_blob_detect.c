@@ -0,0 +1,401 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Single pass connected component labeller for LED blobs.
+ * @ingroup aux_tracking
+ */
+
+#include "tracking/t_tracking.h"
+#include "util/u_misc.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+#define NO_LABEL UINT32_MAX
+
+#define BYTES_ONES (0x0101010101010101ULL)
+#define BYTES_HIGHS (0x8080808080808080ULL)
+
+/*!
+ * A horizontal run of pixels at or above the threshold on a single row.
+ */
+struct run
+{
+	//! Inclusive start and end.
+	uint16_t x0, x1;
+
+	uint32_t label;
+};
+
+/*!
+ * Union-find node, the stats are only complete on the root after merging.
+ */
+struct label
+{
+	uint32_t parent;
+
+	uint32_t area;
+	uint64_t sum_x;
+	uint64_t sum_y;
+
+	uint16_t min_x, min_y, max_x, max_y;
+};
+
+/*!
+ * @see t_blob_detector_detect_l8
+ */
+struct t_blob_detector
+{
+	//! Runs on the previous and current row.
+	struct run *prev, *cur;
+	uint32_t num_prev, num_cur;
+	uint32_t runs_alloc;
+
+	struct label *labels;
+	uint32_t num_labels;
+	uint32_t labels_alloc;
+
+	struct t_blob_detection *blobs;
+	uint32_t num_blobs;
+	uint32_t blobs_alloc;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+/*!
+ * Returns false only if none of the eight bytes at @p ptr are at or above the
+ * threshold that @p add was made from, may give false positives.
+ */
+static inline bool
+maybe_any_at_or_above(const uint8_t *ptr, uint64_t add)
+{
+	uint64_t v;
+	memcpy(&v, ptr, sizeof(v));
+	return (((v + add) | v) & BYTES_HIGHS) != 0;
+}
+
+static uint32_t
+find_root(struct label *labels, uint32_t i)
+{
+	while (labels[i].parent != i) {
+		// Path halving.
+		labels[i].parent = labels[labels[i].parent].parent;
+		i = labels[i].parent;
+	}
+	return i;
+}
+
+static bool
+ensure_runs(struct t_blob_detector *det, uint32_t width)
+{
+	// At most every other pixel starts a run.
+	uint32_t needed = width / 2 + 1;
+	if (det->runs_alloc >= needed) {
+		return true;
+	}
+
+	U_ARRAY_REALLOC_OR_FREE(det->prev, struct run, needed);
+	U_ARRAY_REALLOC_OR_FREE(det->cur, struct run, needed);
+	if (det->prev == NULL || det->cur == NULL) {
+		free(det->prev);
+		free(det->cur);
+		det->prev = NULL;
+		det->cur = NULL;
+		det->runs_alloc = 0;
+		return false;
+	}
+
+	det->runs_alloc = needed;
+	return true;
+}
+
+static uint32_t
+new_label(struct t_blob_detector *det)
+{
+	if (det->num_labels >= det->labels_alloc) {
+		uint32_t alloc = det->labels_alloc < 64 ? 64 : det->labels_alloc * 2;
+		U_ARRAY_REALLOC_OR_FREE(det->labels, struct label, alloc);
+		if (det->labels == NULL) {
+			det->labels_alloc = 0;
+			det->num_labels = 0;
+			return NO_LABEL;
+		}
+		det->labels_alloc = alloc;
+	}
+
+	uint32_t i = det->num_labels++;
+	struct label *l = &det->labels[i];
+	U_ZERO(l);
+	l->parent = i;
+	l->min_x = UINT16_MAX;
+	l->min_y = UINT16_MAX;
+
+	return i;
+}
+
+static bool
+push_blob(struct t_blob_detector *det, const struct label *l)
+{
+	if (det->num_blobs >= det->blobs_alloc) {
+		uint32_t alloc = det->blobs_alloc < 16 ? 16 : det->blobs_alloc * 2;
+		U_ARRAY_REALLOC_OR_FREE(det->blobs, struct t_blob_detection, alloc);
+		if (det->blobs == NULL) {
+			det->blobs_alloc = 0;
+			det->num_blobs = 0;
+			return false;
+		}
+		det->blobs_alloc = alloc;
+	}
+
+	struct t_blob_detection *b = &det->blobs[det->num_blobs++];
+	b->x = (float)((double)l->sum_x / (double)l->area);
+	b->y = (float)((double)l->sum_y / (double)l->area);
+	b->area = l->area;
+	b->min_x = l->min_x;
+	b->min_y = l->min_y;
+	b->max_x = l->max_x;
+	b->max_y = l->max_y;
+
+	return true;
+}
+
+/*!
+ * Find all runs on a row, a word at a time over dark areas.
+ */
+static void
+find_runs(struct t_blob_detector *det, const uint8_t *row, uint32_t x_begin, uint32_t x_end, uint8_t threshold)
+{
+	// The word check only works for thresholds 1 to 128.
+	bool use_words = threshold >= 1 && threshold <= 128;
+	uint64_t add = BYTES_ONES * (uint64_t)(128 - threshold);
+
+	det->num_cur = 0;
+
+	uint32_t x = x_begin;
+	while (x < x_end) {
+		if (use_words) {
+			while (x + 8 <= x_end && !maybe_any_at_or_above(row + x, add)) {
+				x += 8;
+			}
+		}
+
+		if (x >= x_end) {
+			break;
+		}
+
+		if (row[x] < threshold) {
+			x++;
+			continue;
+		}
+
+		uint32_t start = x;
+		while (x < x_end && row[x] >= threshold) {
+			x++;
+		}
+
+		struct run *r = &det->cur[det->num_cur++];
+		r->x0 = (uint16_t)start;
+		r->x1 = (uint16_t)(x - 1);
+		r->label = NO_LABEL;
+	}
+}
+
+/*!
+ * Give each run on the current row a label, merging labels of the 8-connected
+ * runs on the previous row, and accumulate the stats.
+ */
+static bool
+label_runs(struct t_blob_detector *det, uint32_t y)
+{
+	uint32_t p = 0;
+
+	for (uint32_t i = 0; i < det->num_cur; i++) {
+		struct run *c = &det->cur[i];
+		uint32_t label = NO_LABEL;
+
+		// Previous runs that end before this one can't touch later ones.
+		while (p < det->num_prev && (uint32_t)det->prev[p].x1 + 1 < c->x0) {
+			p++;
+		}
+
+		for (uint32_t q = p; q < det->num_prev && det->prev[q].x0 <= (uint32_t)c->x1 + 1; q++) {
+			uint32_t root = find_root(det->labels, det->prev[q].label);
+			if (label == NO_LABEL) {
+				label = root;
+			} else if (root < label) {
+				det->labels[label].parent = root;
+				label = root;
+			} else if (root > label) {
+				det->labels[root].parent = label;
+			}
+		}
+
+		if (label == NO_LABEL) {
+			label = new_label(det);
+			if (label == NO_LABEL) {
+				return false;
+			}
+		}
+
+		c->label = label;
+
+		uint32_t len = (uint32_t)c->x1 - c->x0 + 1;
+		struct label *l = &det->labels[label];
+		l->area += len;
+		l->sum_x += (uint64_t)((uint32_t)c->x0 + c->x1) * len / 2;
+		l->sum_y += (uint64_t)y * len;
+		l->min_x = c->x0 < l->min_x ? c->x0 : l->min_x;
+		l->max_x = c->x1 > l->max_x ? c->x1 : l->max_x;
+		l->min_y = (uint16_t)y < l->min_y ? (uint16_t)y : l->min_y;
+		l->max_y = (uint16_t)y > l->max_y ? (uint16_t)y : l->max_y;
+	}
+
+	return true;
+}
+
+static void
+merge_label(struct label *dst, const struct label *src)
+{
+	dst->area += src->area;
+	dst->sum_x += src->sum_x;
+	dst->sum_y += src->sum_y;
+	dst->min_x = src->min_x < dst->min_x ? src->min_x : dst->min_x;
+	dst->min_y = src->min_y < dst->min_y ? src->min_y : dst->min_y;
+	dst->max_x = src->max_x > dst->max_x ? src->max_x : dst->max_x;
+	dst->max_y = src->max_y > dst->max_y ? src->max_y : dst->max_y;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+t_blob_detector_create(struct t_blob_detector **out_det)
+{
+	struct t_blob_detector *det = U_TYPED_CALLOC(struct t_blob_detector);
+	if (det == NULL) {
+		return -1;
+	}
+
+	*out_det = det;
+
+	return 0;
+}
+
+void
+t_blob_detector_destroy(struct t_blob_detector **det_ptr)
+{
+	struct t_blob_detector *det = *det_ptr;
+	if (det == NULL) {
+		return;
+	}
+
+	free(det->prev);
+	free(det->cur);
+	free(det->labels);
+	free(det->blobs);
+	free(det);
+
+	*det_ptr = NULL;
+}
+
+uint32_t
+t_blob_detector_detect_l8(struct t_blob_detector *det,
+                          const uint8_t *data,
+                          uint32_t width,
+                          uint32_t height,
+                          size_t stride,
+                          uint8_t threshold,
+                          const struct xrt_rect *roi,
+                          uint32_t min_area,
+                          uint32_t max_area,
+                          const struct t_blob_detection **out_blobs)
+{
+	assert(width <= UINT16_MAX && height <= UINT16_MAX);
+
+	det->num_prev = 0;
+	det->num_cur = 0;
+	det->num_labels = 0;
+	det->num_blobs = 0;
+	*out_blobs = det->blobs;
+
+	int x_begin = 0;
+	int y_begin = 0;
+	int x_end = (int)width;
+	int y_end = (int)height;
+
+	if (roi != NULL) {
+		x_begin = roi->offset.w > 0 ? roi->offset.w : 0;
+		y_begin = roi->offset.h > 0 ? roi->offset.h : 0;
+		x_end = roi->offset.w + roi->extent.w;
+		y_end = roi->offset.h + roi->extent.h;
+		x_end = x_end < (int)width ? x_end : (int)width;
+		y_end = y_end < (int)height ? y_end : (int)height;
+	}
+
+	if (x_begin >= x_end || y_begin >= y_end) {
+		return 0;
+	}
+
+	if (!ensure_runs(det, width)) {
+		return 0;
+	}
+
+	for (int y = y_begin; y < y_end; y++) {
+		const uint8_t *row = data + (size_t)y * stride;
+
+		find_runs(det, row, (uint32_t)x_begin, (uint32_t)x_end, threshold);
+
+		if (!label_runs(det, (uint32_t)y)) {
+			return 0;
+		}
+
+		struct run *tmp = det->prev;
+		det->prev = det->cur;
+		det->cur = tmp;
+		det->num_prev = det->num_cur;
+	}
+
+	/*
+	 * Parents always have a lower index, so each label only needs to add
+	 * its own stats to its final root.
+	 */
+	for (uint32_t i = 0; i < det->num_labels; i++) {
+		uint32_t root = find_root(det->labels, i);
+		if (root != i) {
+			merge_label(&det->labels[root], &det->labels[i]);
+		}
+	}
+
+	for (uint32_t i = 0; i < det->num_labels; i++) {
+		const struct label *l = &det->labels[i];
+		if (l->parent != i || l->area < min_area || l->area > max_area) {
+			continue;
+		}
+
+		if (!push_blob(det, l)) {
+			return 0;
+		}
+	}
+
+	*out_blobs = det->blobs;
+
+	return det->num_blobs;
+}
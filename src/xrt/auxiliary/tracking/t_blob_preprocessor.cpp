@@ -0,0 +1,556 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared rectification and blob detection for the blob trackers.
+ * @ingroup aux_tracking
+ */
+
+#include "tracking/t_tracking.h"
+#include "tracking/t_calibration_opencv.hpp"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_frame.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+
+#include <vector>
+#include <algorithm>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(sparse_undistort, "T_BLOB_SPARSE_UNDISTORT", false)
+DEBUG_GET_ONCE_BOOL_OPTION(use_roi, "T_BLOB_USE_ROI", true)
+DEBUG_GET_ONCE_NUM_OPTION(roi_full_frame_interval, "T_BLOB_ROI_FULL_FRAME_INTERVAL", 30)
+
+
+namespace xrt::auxiliary::tracking {
+
+struct BlobPreprocessor;
+
+/*!
+ * A single channel of the preprocessor, pushes to one @ref t_blob_sink.
+ *
+ * @implements xrt_frame_sink
+ */
+struct BlobChannel
+{
+	struct xrt_frame_sink base = {};
+
+	BlobPreprocessor *pre = nullptr;
+
+	struct t_blob_sink *blob_sink = nullptr;
+
+	cv::Ptr<cv::SimpleBlobDetector> sbd;
+
+	//! Reused between frames to avoid allocations.
+	std::vector<cv::KeyPoint> keypoints;
+	std::vector<struct t_blob> blobs[2];
+
+	//! Frames searched with predicted regions since the last full frame.
+	int32_t frames_since_full_frame = 0;
+
+	//! Scratch for the sparse path, reused between frames.
+	struct
+	{
+		struct t_blob_detector *det;
+		std::vector<cv::Point2f> distorted;
+		std::vector<cv::Point2f> undistorted;
+		std::vector<float> sizes;
+	} sparse;
+};
+
+/*!
+ * What is needed to undistort and rectify single points in a view.
+ */
+struct BlobViewUndistort
+{
+	cv::Matx33d intrinsics;
+	cv::Mat distortion;
+	cv::Mat distortion_fisheye;
+	bool use_fisheye;
+
+	cv::Mat rotation;
+	cv::Mat projection;
+};
+
+/*!
+ * Undistorts, rectifies, thresholds and detects blobs in the channel frames
+ * from the hsv filter, the trackers only do matching and fusion.
+ *
+ * @implements xrt_frame_node
+ */
+struct BlobPreprocessor
+{
+	struct xrt_frame_node node = {};
+
+	BlobChannel channels[T_BLOB_MAX_CHANNELS];
+
+	//! Shared by all channels, they all come from the same camera.
+	RemapPair rectify[2];
+
+	//! Used instead of @ref rectify for blob centers on the sparse path.
+	BlobViewUndistort undistort[2];
+
+	//! Only undistort the blob centers, toggled in the debug gui.
+	bool sparse;
+
+	//! Only search the regions predicted by the sinks, toggled in the debug gui.
+	bool use_roi;
+
+	//! Search the whole frame at least this often when using regions.
+	int32_t full_frame_interval;
+};
+
+static cv::Ptr<cv::SimpleBlobDetector>
+create_detector(const struct t_blob_detector_params &params)
+{
+	// clang-format off
+	cv::SimpleBlobDetector::Params blob_params;
+	blob_params.filterByArea = false;
+	blob_params.filterByConvexity = params.filter_by_convexity;
+	blob_params.minConvexity = params.min_convexity;
+	blob_params.filterByInertia = false;
+	blob_params.filterByColor = true;
+	blob_params.blobColor = 255; // 0 or 255 - color comes from binarized image?
+	blob_params.minArea = params.min_area;
+	blob_params.maxArea = params.max_area;
+	blob_params.maxThreshold = 51; // using a wide threshold span slows things down bigtime
+	blob_params.minThreshold = 50;
+	blob_params.thresholdStep = 1;
+	blob_params.minDistBetweenBlobs = 5;
+	blob_params.minRepeatability = 1; // need this to avoid error?
+	// clang-format on
+
+	return cv::SimpleBlobDetector::create(blob_params);
+}
+
+/*!
+ * Get the regions to search in from the sink, returns false if the whole frame
+ * should be searched. The regions are clamped to the view.
+ */
+static bool
+get_rois(BlobPreprocessor &pre, BlobChannel &c, cv::Size view_size, cv::Rect out_rois[2])
+{
+	if (!pre.use_roi || c.blob_sink->get_rois == NULL) {
+		return false;
+	}
+
+	// Regularly search the whole frame to pick up blobs we have missed.
+	if (c.frames_since_full_frame >= pre.full_frame_interval) {
+		c.frames_since_full_frame = 0;
+		return false;
+	}
+
+	struct xrt_rect rois[2] = {};
+	if (!c.blob_sink->get_rois(c.blob_sink, rois)) {
+		c.frames_since_full_frame = 0;
+		return false;
+	}
+
+	cv::Rect bounds(cv::Point(0, 0), view_size);
+	for (int view = 0; view < 2; view++) {
+		cv::Rect roi(rois[view].offset.w, rois[view].offset.h, rois[view].extent.w, rois[view].extent.h);
+		out_rois[view] = roi & bounds;
+
+		// Predicted to be out of view, better to search everything.
+		if (out_rois[view].area() <= 0) {
+			c.frames_since_full_frame = 0;
+			return false;
+		}
+	}
+
+	c.frames_since_full_frame++;
+
+	return true;
+}
+
+/*!
+ * Returns the region of the unrectified view that the rectified region is
+ * remapped from, by sampling the rectification maps along its border.
+ */
+static cv::Rect
+unrectified_roi(BlobPreprocessor &pre, int view, const cv::Rect &roi, cv::Size view_size)
+{
+	const cv::Mat &map_x = pre.rectify[view].remap_x;
+	const cv::Mat &map_y = pre.rectify[view].remap_y;
+
+	float min_x = (float)view_size.width;
+	float min_y = (float)view_size.height;
+	float max_x = 0.0f;
+	float max_y = 0.0f;
+
+	auto sample = [&](int x, int y) {
+		float sx = map_x.at<float>(y, x);
+		float sy = map_y.at<float>(y, x);
+		min_x = std::min(min_x, sx);
+		min_y = std::min(min_y, sy);
+		max_x = std::max(max_x, sx);
+		max_y = std::max(max_y, sy);
+	};
+
+	const int step = 4;
+	int right = roi.x + roi.width - 1;
+	int bottom = roi.y + roi.height - 1;
+
+	for (int x = roi.x; x < right; x += step) {
+		sample(x, roi.y);
+		sample(x, bottom);
+	}
+	for (int y = roi.y; y < bottom; y += step) {
+		sample(roi.x, y);
+		sample(right, y);
+	}
+	sample(right, bottom);
+
+	// Pad a pixel for rounding.
+	cv::Point tl((int)floorf(min_x) - 1, (int)floorf(min_y) - 1);
+	cv::Point br((int)ceilf(max_x) + 2, (int)ceilf(max_y) + 2);
+
+	return cv::Rect(tl, br) & cv::Rect(cv::Point(0, 0), view_size);
+}
+
+/*!
+ * Undistort, rectify and threshold the region of interest of a view, the rest
+ * of the rectified view is cleared if the region doesn't cover all of it.
+ */
+static void
+remap_view(BlobPreprocessor &pre, int view, cv::Mat &grey, cv::Mat &rectified, const cv::Rect &roi)
+{
+	if (roi.size() != rectified.size()) {
+		rectified.setTo(cv::Scalar(0));
+	}
+
+	cv::Mat dst = rectified(roi);
+
+	// The source is the whole view, the maps index into it.
+	cv::remap(grey,                           // src
+	          dst,                            // dst
+	          pre.rectify[view].remap_x(roi), // map1
+	          pre.rectify[view].remap_y(roi), // map2
+	          cv::INTER_NEAREST,              // interpolation
+	          cv::BORDER_CONSTANT,            // borderMode
+	          cv::Scalar(0, 0, 0));           // borderValue
+
+	cv::threshold(dst,   // src
+	              dst,   // dst
+	              32.0,  // thresh
+	              255.0, // maxval
+	              0);    // type
+}
+
+/*!
+ * Full frame path, finds blobs with the detector on the rectified frame.
+ */
+static void
+do_view(BlobPreprocessor &pre, BlobChannel &c, int view, cv::Mat &grey, cv::Mat &rectified, const cv::Rect &roi)
+{
+	remap_view(pre, view, grey, rectified, roi);
+
+	//! @todo Re-enable masks.
+	c.sbd->detect(rectified(roi), // image
+	              c.keypoints,    // keypoints
+	              cv::noArray()); // mask
+
+	std::vector<struct t_blob> &blobs = c.blobs[view];
+	blobs.clear();
+	for (const cv::KeyPoint &kp : c.keypoints) {
+		float x = kp.pt.x + roi.x;
+		float y = kp.pt.y + roi.y;
+		blobs.push_back({x, y, kp.size, x, y});
+	}
+}
+
+/*!
+ * Sparse path, finds blobs with @ref t_blob_detector on the unrectified image
+ * and only undistorts and rectifies their centers. If @p roi is given only the
+ * part of the unrectified image that it is remapped from is searched.
+ *
+ * Doesn't filter by convexity like the blob detector can.
+ */
+static void
+do_view_sparse(BlobPreprocessor &pre, BlobChannel &c, int view, struct xrt_frame *xf, const cv::Rect *roi)
+{
+	auto &s = c.sparse;
+	const struct t_blob_detector_params &params = c.blob_sink->params;
+
+	uint32_t cols = xf->width / 2;
+
+	struct xrt_rect unrectified = {};
+	if (roi != NULL) {
+		cv::Rect r = unrectified_roi(pre, view, *roi, cv::Size(cols, xf->height));
+		unrectified.offset.w = r.x;
+		unrectified.offset.h = r.y;
+		unrectified.extent.w = r.width;
+		unrectified.extent.h = r.height;
+	}
+
+	const struct t_blob_detection *detections = NULL;
+	uint32_t num = t_blob_detector_detect_l8(s.det,                             // det
+	                                         xf->data + view * cols,            // data
+	                                         cols,                              // width
+	                                         xf->height,                        // height
+	                                         xf->stride,                        // stride
+	                                         32,                                // threshold
+	                                         roi != NULL ? &unrectified : NULL, // roi
+	                                         (uint32_t)params.min_area,         // min_area
+	                                         (uint32_t)params.max_area,         // max_area
+	                                         &detections);                      // out_blobs
+
+	s.distorted.clear();
+	s.sizes.clear();
+
+	for (uint32_t i = 0; i < num; i++) {
+		float area = (float)detections[i].area;
+
+		s.distorted.emplace_back(detections[i].x, detections[i].y);
+		// Diameter of a circle with the same area, same as the detector.
+		s.sizes.push_back(2.0f * sqrtf(area / (float)M_PI));
+	}
+
+	std::vector<struct t_blob> &blobs = c.blobs[view];
+	blobs.clear();
+
+	if (s.distorted.empty()) {
+		return;
+	}
+
+	const BlobViewUndistort &u = pre.undistort[view];
+	if (u.use_fisheye) {
+		cv::fisheye::undistortPoints(s.distorted,          // distorted
+		                             s.undistorted,        // undistorted
+		                             u.intrinsics,         // K
+		                             u.distortion_fisheye, // D
+		                             u.rotation,           // R
+		                             u.projection);        // P
+	} else {
+		cv::undistortPoints(s.distorted,   // src
+		                    s.undistorted, // dst
+		                    u.intrinsics,  // cameraMatrix
+		                    u.distortion,  // distCoeffs
+		                    u.rotation,    // R
+		                    u.projection); // P
+	}
+
+	for (size_t i = 0; i < s.undistorted.size(); i++) {
+		const cv::Point2f &d = s.distorted[i];
+		blobs.push_back({s.undistorted[i].x, s.undistorted[i].y, s.sizes[i], d.x, d.y});
+	}
+}
+
+static void
+process_sparse(BlobPreprocessor &pre, BlobChannel &c, struct xrt_frame *xf)
+{
+	int cols = xf->width / 2;
+	int rows = xf->height;
+
+	cv::Rect rois[2];
+	bool have_rois = get_rois(pre, c, cv::Size(cols, rows), rois);
+	if (!have_rois) {
+		rois[0] = rois[1] = cv::Rect(0, 0, cols, rows);
+	}
+
+	for (int view = 0; view < 2; view++) {
+		do_view_sparse(pre, c, view, xf, have_rois ? &rois[view] : NULL);
+	}
+
+	// Only remap the full frame if the sink wants it, like for debugging.
+	struct xrt_frame *rectified = NULL;
+	if (xrt_atomic_s32_load(&c.blob_sink->want_rectified_frame) != 0) {
+		u_frame_create_one_off(XRT_FORMAT_L8, xf->width, xf->height, &rectified);
+
+		rectified->timestamp = xf->timestamp;
+		rectified->source_id = xf->source_id;
+		rectified->stereo_format = xf->stereo_format;
+		rectified->source_sequence = xf->source_sequence;
+		rectified->source_timestamp = xf->source_timestamp;
+
+		for (int view = 0; view < 2; view++) {
+			cv::Mat grey(rows, cols, CV_8UC1, xf->data + view * cols, xf->stride);
+			cv::Mat dst(rows, cols, CV_8UC1, rectified->data + view * cols, rectified->stride);
+			remap_view(pre, view, grey, dst, rois[view]);
+
+			// The blobs are now at their rectified centers in the frame.
+			for (struct t_blob &blob : c.blobs[view]) {
+				blob.frame_x = blob.x;
+				blob.frame_y = blob.y;
+			}
+		}
+	}
+
+	struct t_blob_observation obs = {};
+	obs.frame = rectified != NULL ? rectified : xf;
+	obs.rectified = rectified != NULL;
+	for (int view = 0; view < 2; view++) {
+		obs.blobs[view] = c.blobs[view].data();
+		obs.num_blobs[view] = (uint32_t)c.blobs[view].size();
+	}
+
+	c.blob_sink->push_blobs(c.blob_sink, &obs);
+
+	xrt_frame_reference(&rectified, NULL);
+}
+
+static void
+process(BlobPreprocessor &pre, BlobChannel &c, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	if (xf->format != XRT_FORMAT_L8) {
+		U_LOG_E("Bad format '%s'", u_format_str(xf->format));
+		return;
+	}
+
+	if (pre.sparse) {
+		process_sparse(pre, c, xf);
+		return;
+	}
+
+	// Each sink might hold on to the frame, so a new one every time.
+	struct xrt_frame *rectified = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, xf->width, xf->height, &rectified);
+
+	rectified->timestamp = xf->timestamp;
+	rectified->source_id = xf->source_id;
+	rectified->stereo_format = xf->stereo_format;
+	rectified->source_sequence = xf->source_sequence;
+	rectified->source_timestamp = xf->source_timestamp;
+
+	int cols = xf->width / 2;
+	int rows = xf->height;
+
+	cv::Rect rois[2];
+	if (!get_rois(pre, c, cv::Size(cols, rows), rois)) {
+		rois[0] = rois[1] = cv::Rect(0, 0, cols, rows);
+	}
+
+	for (int view = 0; view < 2; view++) {
+		cv::Mat grey(rows, cols, CV_8UC1, xf->data + view * cols, xf->stride);
+		cv::Mat dst(rows, cols, CV_8UC1, rectified->data + view * cols, rectified->stride);
+		do_view(pre, c, view, grey, dst, rois[view]);
+	}
+
+	struct t_blob_observation obs = {};
+	obs.frame = rectified;
+	obs.rectified = true;
+	for (int view = 0; view < 2; view++) {
+		obs.blobs[view] = c.blobs[view].data();
+		obs.num_blobs[view] = (uint32_t)c.blobs[view].size();
+	}
+
+	c.blob_sink->push_blobs(c.blob_sink, &obs);
+
+	xrt_frame_reference(&rectified, NULL);
+}
+
+} // namespace xrt::auxiliary::tracking
+
+using xrt::auxiliary::tracking::BlobChannel;
+using xrt::auxiliary::tracking::create_detector;
+using xrt::auxiliary::tracking::BlobPreprocessor;
+using xrt::auxiliary::tracking::BlobViewUndistort;
+using xrt::auxiliary::tracking::CameraCalibrationWrapper;
+using xrt::auxiliary::tracking::StereoRectificationMaps;
+
+
+/*
+ *
+ * C wrapper functions.
+ *
+ */
+
+extern "C" void
+t_blob_preprocessor_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+{
+	auto &c = *container_of(xsink, BlobChannel, base);
+	process(*c.pre, c, xf);
+}
+
+extern "C" void
+t_blob_preprocessor_node_break_apart(struct xrt_frame_node *node)
+{
+	// Noop
+}
+
+extern "C" void
+t_blob_preprocessor_node_destroy(struct xrt_frame_node *node)
+{
+	auto pre_ptr = container_of(node, BlobPreprocessor, node);
+
+	for (BlobChannel &c : pre_ptr->channels) {
+		t_blob_detector_destroy(&c.sparse.det);
+	}
+
+	// Tidy variable setup.
+	u_var_remove_root(pre_ptr);
+
+	delete pre_ptr;
+}
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+extern "C" int
+t_blob_preprocessor_create(struct xrt_frame_context *xfctx,
+                           struct t_stereo_camera_calibration *data,
+                           struct t_blob_sink *blob_sinks[T_BLOB_MAX_CHANNELS],
+                           struct xrt_frame_sink *out_sinks[T_BLOB_MAX_CHANNELS])
+{
+	U_LOG_D("Creating blob preprocessor.");
+
+	auto &pre = *(new BlobPreprocessor());
+
+	pre.node.break_apart = t_blob_preprocessor_node_break_apart;
+	pre.node.destroy = t_blob_preprocessor_node_destroy;
+
+	StereoRectificationMaps rectify(data);
+	for (int view = 0; view < 2; view++) {
+		pre.rectify[view] = rectify.view[view].rectify;
+
+		CameraCalibrationWrapper wrap(data->view[view]);
+		BlobViewUndistort &u = pre.undistort[view];
+		u.intrinsics = wrap.intrinsics_mat;
+		u.distortion = wrap.distortion_mat.clone();
+		u.distortion_fisheye = wrap.distortion_fisheye_mat.clone();
+		u.use_fisheye = wrap.use_fisheye;
+		u.rotation = rectify.view[view].rotation_mat;
+		u.projection = rectify.view[view].projection_mat;
+	}
+
+	pre.sparse = debug_get_bool_option_sparse_undistort();
+	pre.use_roi = debug_get_bool_option_use_roi();
+	pre.full_frame_interval = (int32_t)debug_get_num_option_roi_full_frame_interval();
+
+	for (int i = 0; i < T_BLOB_MAX_CHANNELS; i++) {
+		BlobChannel &c = pre.channels[i];
+
+		if (blob_sinks[i] == NULL) {
+			out_sinks[i] = NULL;
+			continue;
+		}
+
+		c.base.push_frame = t_blob_preprocessor_push_frame;
+		c.pre = &pre;
+		c.blob_sink = blob_sinks[i];
+		c.sbd = create_detector(blob_sinks[i]->params);
+		t_blob_detector_create(&c.sparse.det);
+
+		out_sinks[i] = &c.base;
+	}
+
+	xrt_frame_context_add(xfctx, &pre.node);
+
+	// Everything is safe, now setup the variable tracking.
+	u_var_add_root(&pre, "Blob preprocessor", true);
+	u_var_add_bool(&pre, &pre.sparse, "Sparse undistort");
+	u_var_add_bool(&pre, &pre.use_roi, "Use predicted regions");
+	u_var_add_i32(&pre, &pre.full_frame_interval, "Full frame interval");
+
+	return 0;
+}
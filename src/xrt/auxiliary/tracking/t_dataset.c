@@ -0,0 +1,443 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Tracking dataset recorder and reader.
+ * @ingroup aux_tracking
+ */
+
+#include "tracking/t_tracking.h"
+
+#include "util/u_misc.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+
+#include "os/os_threading.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*
+ *
+ * File format, everything is in host byte order.
+ *
+ * The file starts with a @ref dataset_file_header, followed by records that
+ * each start with a @ref dataset_record_header and are followed by size bytes
+ * of payload. The payload of a calibration record is the calibration saved
+ * with @ref t_stereo_camera_calibration_save_v1, a frame record starts with a
+ * @ref dataset_frame_header followed by the frame data without row padding
+ * and IMU records hold a @ref dataset_imu.
+ *
+ */
+
+#define DATASET_MAGIC "MNDTDS\r\n"
+#define DATASET_VERSION 1
+
+struct dataset_file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t _pad;
+};
+
+struct dataset_record_header
+{
+	uint32_t type;
+	uint32_t source;
+	int64_t timestamp;
+	uint64_t size;
+};
+
+struct dataset_frame_header
+{
+	uint32_t format;
+	uint32_t stereo_format;
+	uint32_t width;
+	uint32_t height;
+	//! Packed row size, zero for formats that are not made of blocks.
+	uint64_t stride;
+	uint64_t source_timestamp;
+	uint64_t source_sequence;
+	uint64_t source_id;
+};
+
+struct dataset_imu
+{
+	float accel_m_s2[3];
+	float gyro_rad_secs[3];
+};
+
+/*!
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct t_dataset_recorder
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	//! Protects the file, frames and IMU samples come from different threads.
+	struct os_mutex mutex;
+
+	FILE *file;
+};
+
+struct t_dataset_reader
+{
+	FILE *file;
+};
+
+
+/*
+ *
+ * Recorder functions.
+ *
+ */
+
+static bool
+write_record_header(FILE *file, enum t_dataset_record_type type, uint32_t source, int64_t timestamp, uint64_t size)
+{
+	struct dataset_record_header header = {
+	    .type = type,
+	    .source = source,
+	    .timestamp = timestamp,
+	    .size = size,
+	};
+
+	return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+static bool
+write_calibration(FILE *file, struct t_stereo_camera_calibration *calib)
+{
+	// Save to a temporary file first to get the size of it.
+	FILE *tmp = tmpfile();
+	if (tmp == NULL) {
+		return false;
+	}
+
+	bool ret = t_stereo_camera_calibration_save_v1(tmp, calib);
+	long size = ftell(tmp);
+	if (!ret || size <= 0) {
+		fclose(tmp);
+		return false;
+	}
+
+	uint8_t *buf = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+	rewind(tmp);
+	ret = fread(buf, size, 1, tmp) == 1 &&
+	      write_record_header(file, T_DATASET_RECORD_CALIBRATION, 0, 0, (uint64_t)size) &&
+	      fwrite(buf, size, 1, file) == 1;
+
+	free(buf);
+	fclose(tmp);
+
+	return ret;
+}
+
+static void
+recorder_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+{
+	struct t_dataset_recorder *rec = container_of(xsink, struct t_dataset_recorder, base);
+
+	struct dataset_frame_header fh = {
+	    .format = xf->format,
+	    .stereo_format = xf->stereo_format,
+	    .width = xf->width,
+	    .height = xf->height,
+	    .source_timestamp = xf->source_timestamp,
+	    .source_sequence = xf->source_sequence,
+	    .source_id = xf->source_id,
+	};
+
+	size_t size = xf->size;
+	uint32_t rows = 0;
+	if (u_format_is_blocks(xf->format)) {
+		size_t stride = 0;
+		u_format_size_for_dimensions(xf->format, xf->width, xf->height, &stride, &size);
+		fh.stride = stride;
+		rows = (uint32_t)(size / stride);
+	}
+
+	os_mutex_lock(&rec->mutex);
+
+	bool ok = write_record_header(rec->file, T_DATASET_RECORD_FRAME, 0, (int64_t)xf->timestamp,
+	                              sizeof(fh) + size) &&
+	          fwrite(&fh, sizeof(fh), 1, rec->file) == 1;
+
+	if (ok && (rows == 0 || fh.stride == xf->stride)) {
+		ok = fwrite(xf->data, size, 1, rec->file) == 1;
+	} else {
+		// Strip the row padding.
+		for (uint32_t y = 0; ok && y < rows; y++) {
+			ok = fwrite(xf->data + y * xf->stride, fh.stride, 1, rec->file) == 1;
+		}
+	}
+
+	os_mutex_unlock(&rec->mutex);
+
+	if (!ok) {
+		U_LOG_E("Failed to write frame!");
+	}
+}
+
+static void
+recorder_break_apart(struct xrt_frame_node *node)
+{
+	// Noop
+}
+
+static void
+recorder_destroy(struct xrt_frame_node *node)
+{
+	struct t_dataset_recorder *rec = container_of(node, struct t_dataset_recorder, node);
+
+	fclose(rec->file);
+	os_mutex_destroy(&rec->mutex);
+
+	free(rec);
+}
+
+
+/*
+ *
+ * Reader functions.
+ *
+ */
+
+static void
+free_frame(struct xrt_frame *xf)
+{
+	assert(xf->reference.count == 0);
+	free(xf->data);
+	free(xf);
+}
+
+static bool
+read_calibration(FILE *file, uint64_t size, struct t_stereo_camera_calibration **out_calib)
+{
+	uint8_t *buf = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+	if (fread(buf, size, 1, file) != 1) {
+		free(buf);
+		return false;
+	}
+
+	// The loader wants a file.
+	FILE *tmp = tmpfile();
+	bool ret = tmp != NULL && fwrite(buf, size, 1, tmp) == 1;
+	free(buf);
+
+	if (ret) {
+		rewind(tmp);
+		ret = t_stereo_camera_calibration_load_v1(tmp, out_calib);
+	}
+
+	if (tmp != NULL) {
+		fclose(tmp);
+	}
+
+	return ret;
+}
+
+static bool
+read_frame(FILE *file, uint64_t size, timepoint_ns timestamp, struct xrt_frame **out_frame)
+{
+	struct dataset_frame_header fh;
+	if (size < sizeof(fh) || fread(&fh, sizeof(fh), 1, file) != 1) {
+		return false;
+	}
+
+	struct xrt_frame *xf = U_TYPED_CALLOC(struct xrt_frame);
+	xf->format = (enum xrt_format)fh.format;
+	xf->stereo_format = (enum xrt_stereo_format)fh.stereo_format;
+	xf->width = fh.width;
+	xf->height = fh.height;
+	xf->stride = fh.stride;
+	xf->size = size - sizeof(fh);
+	xf->timestamp = timestamp;
+	xf->source_timestamp = fh.source_timestamp;
+	xf->source_sequence = fh.source_sequence;
+	xf->source_id = fh.source_id;
+	xf->destroy = free_frame;
+	xf->data = U_TYPED_ARRAY_CALLOC(uint8_t, xf->size);
+
+	if (fread(xf->data, xf->size, 1, file) != 1) {
+		free_frame(xf);
+		return false;
+	}
+
+	xrt_frame_reference(out_frame, xf);
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+t_dataset_recorder_create(struct xrt_frame_context *xfctx,
+                          const char *path,
+                          struct t_stereo_camera_calibration *calib,
+                          struct t_dataset_recorder **out_rec,
+                          struct xrt_frame_sink **out_sink)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		U_LOG_E("Could not open '%s' for writing!", path);
+		return -1;
+	}
+
+	struct dataset_file_header header = {.version = DATASET_VERSION};
+	memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 || (calib != NULL && !write_calibration(file, calib))) {
+		U_LOG_E("Could not write dataset header to '%s'!", path);
+		fclose(file);
+		return -1;
+	}
+
+	struct t_dataset_recorder *rec = U_TYPED_CALLOC(struct t_dataset_recorder);
+	rec->base.push_frame = recorder_push_frame;
+	rec->node.break_apart = recorder_break_apart;
+	rec->node.destroy = recorder_destroy;
+	rec->file = file;
+
+	int ret = os_mutex_init(&rec->mutex);
+	if (ret != 0) {
+		fclose(file);
+		free(rec);
+		return ret;
+	}
+
+	xrt_frame_context_add(xfctx, &rec->node);
+
+	U_LOG_I("Recording tracking dataset to '%s'.", path);
+
+	*out_rec = rec;
+	*out_sink = &rec->base;
+
+	return 0;
+}
+
+void
+t_dataset_recorder_push_imu(struct t_dataset_recorder *rec,
+                            uint32_t source,
+                            timepoint_ns timestamp_ns,
+                            const struct xrt_tracking_sample *sample)
+{
+	struct dataset_imu imu = {
+	    .accel_m_s2 = {sample->accel_m_s2.x, sample->accel_m_s2.y, sample->accel_m_s2.z},
+	    .gyro_rad_secs = {sample->gyro_rad_secs.x, sample->gyro_rad_secs.y, sample->gyro_rad_secs.z},
+	};
+
+	os_mutex_lock(&rec->mutex);
+
+	bool ok = write_record_header(rec->file, T_DATASET_RECORD_IMU, source, timestamp_ns, sizeof(imu)) &&
+	          fwrite(&imu, sizeof(imu), 1, rec->file) == 1;
+
+	os_mutex_unlock(&rec->mutex);
+
+	if (!ok) {
+		U_LOG_E("Failed to write IMU sample!");
+	}
+}
+
+int
+t_dataset_reader_open(const char *path, struct t_dataset_reader **out_reader)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		U_LOG_E("Could not open '%s'!", path);
+		return -1;
+	}
+
+	struct dataset_file_header header;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, DATASET_MAGIC, sizeof(header.magic)) != 0) {
+		U_LOG_E("'%s' is not a tracking dataset!", path);
+		fclose(file);
+		return -1;
+	}
+
+	if (header.version != DATASET_VERSION) {
+		U_LOG_E("Unsupported dataset version %u in '%s'!", header.version, path);
+		fclose(file);
+		return -1;
+	}
+
+	struct t_dataset_reader *reader = U_TYPED_CALLOC(struct t_dataset_reader);
+	reader->file = file;
+
+	*out_reader = reader;
+
+	return 0;
+}
+
+bool
+t_dataset_reader_next(struct t_dataset_reader *reader, struct t_dataset_record *out_record)
+{
+	struct dataset_record_header header;
+
+	U_ZERO(out_record);
+
+	if (fread(&header, sizeof(header), 1, reader->file) != 1) {
+		return false;
+	}
+
+	out_record->type = (enum t_dataset_record_type)header.type;
+	out_record->timestamp = header.timestamp;
+	out_record->source = header.source;
+
+	switch (header.type) {
+	case T_DATASET_RECORD_CALIBRATION:
+		return read_calibration(reader->file, header.size, &out_record->calib);
+	case T_DATASET_RECORD_FRAME:
+		return read_frame(reader->file, header.size, header.timestamp, &out_record->frame);
+	case T_DATASET_RECORD_IMU: {
+		struct dataset_imu imu;
+		if (header.size != sizeof(imu) || fread(&imu, sizeof(imu), 1, reader->file) != 1) {
+			return false;
+		}
+		out_record->imu.accel_m_s2.x = imu.accel_m_s2[0];
+		out_record->imu.accel_m_s2.y = imu.accel_m_s2[1];
+		out_record->imu.accel_m_s2.z = imu.accel_m_s2[2];
+		out_record->imu.gyro_rad_secs.x = imu.gyro_rad_secs[0];
+		out_record->imu.gyro_rad_secs.y = imu.gyro_rad_secs[1];
+		out_record->imu.gyro_rad_secs.z = imu.gyro_rad_secs[2];
+		return true;
+	}
+	default:
+		// Skip records from newer writers.
+		out_record->type = T_DATASET_RECORD_NONE;
+		return fseek(reader->file, (long)header.size, SEEK_CUR) == 0;
+	}
+}
+
+void
+t_dataset_reader_close(struct t_dataset_reader **reader_ptr)
+{
+	struct t_dataset_reader *reader = *reader_ptr;
+	if (reader == NULL) {
+		return;
+	}
+
+	fclose(reader->file);
+	free(reader);
+
+	*reader_ptr = NULL;
+}
+
+void
+t_dataset_record_clear(struct t_dataset_record *record)
+{
+	xrt_frame_reference(&record->frame, NULL);
+	t_stereo_camera_calibration_reference(&record->calib, NULL);
+
+	U_ZERO(record);
+}
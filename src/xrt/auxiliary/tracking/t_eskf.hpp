@@ -0,0 +1,947 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Generic error-state Kalman filter for 6DoF IMU fusion.
+ * @ingroup aux_tracking
+ *
+ * The nominal state is position, velocity, orientation and the gyro and
+ * accelerometer biases, the filter estimates a 15 element error state on top
+ * of it. The orientation error is expressed in body space, so
+ * `R_true = R * exp(d_theta)`. World space is Y up like the rest of Monado,
+ * so a resting accelerometer reads +9.81 on the body axis pointing up.
+ *
+ * IMU samples are folded into an @ref xrt::auxiliary::tracking::eskf::Preintegration
+ * which only depends on the biases, so several samples can be integrated and
+ * then applied to the filter in one go. Corrections are done by measurement
+ * classes, any type providing the following can be used:
+ *
+ * @code{.cpp}
+ * struct Measurement
+ * {
+ * 	static constexpr int Dimension = D;
+ * 	Eigen::Matrix<double, D, 1> getResidual(State const &s) const;        // z - h(s)
+ * 	Eigen::Matrix<double, D, kErrorDim> getJacobian(State const &s) const; // dh / d_error
+ * 	Eigen::Matrix<double, D, D> getCovariance(State const &s) const;
+ * };
+ * @endcode
+ *
+ * Everything is fixed size and lives inside the filter, nothing is allocated
+ * after construction.
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include "math/m_api.h"
+#include "util/u_time.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/Cholesky>
+
+#include "flexkalman/EigenQuatExponentialMap.h"
+
+#include <array>
+#include <type_traits>
+#include <variant>
+
+
+namespace xrt::auxiliary::tracking::eskf {
+
+//! Size of the error state.
+constexpr int kErrorDim = 15;
+
+//! Offsets of the blocks in the error state.
+enum ErrorIndex : int
+{
+	kPosition = 0,
+	kVelocity = 3,
+	kRotation = 6,
+	kGyroBias = 9,
+	kAccelBias = 12,
+};
+
+using ErrorVector = Eigen::Matrix<double, kErrorDim, 1>;
+using Covariance = Eigen::Matrix<double, kErrorDim, kErrorDim>;
+
+//! Gravity in world space.
+static const Eigen::Vector3d kGravity{0, -MATH_GRAVITY_M_S2, 0};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+inline Eigen::Matrix3d
+skew(Eigen::Vector3d const &v)
+{
+	Eigen::Matrix3d m;
+	m << 0, -v.z(), v.y(), //
+	    v.z(), 0, -v.x(),  //
+	    -v.y(), v.x(), 0;
+	return m;
+}
+
+//! Rotation vector, angle times axis, to quaternion.
+inline Eigen::Quaterniond
+rotvec_to_quat(Eigen::Vector3d const &v)
+{
+	return flexkalman::util::quat_exp(v * 0.5);
+}
+
+//! Quaternion to rotation vector, picks the shortest rotation.
+inline Eigen::Vector3d
+quat_to_rotvec(Eigen::Quaterniond const &q)
+{
+	return flexkalman::util::smallest_quat_ln(q) * 2.0;
+}
+
+/*!
+ * Does `P = F * P * F^T` for a transition of the form `[[A, B], [0, I]]`,
+ * which is what IMU propagation looks like since the biases are random walks.
+ */
+inline void
+propagate_covariance(Covariance &P,
+                     Eigen::Matrix<double, 9, 9> const &A,
+                     Eigen::Matrix<double, 9, 6> const &B)
+{
+	Eigen::Matrix<double, 9, 9> M1 = A * P.topLeftCorner<9, 9>() + B * P.bottomLeftCorner<6, 9>();
+	Eigen::Matrix<double, 9, 6> M2 = A * P.topRightCorner<9, 6>() + B * P.bottomRightCorner<6, 6>();
+
+	P.topLeftCorner<9, 9>() = M1 * A.transpose() + M2 * B.transpose();
+	P.topRightCorner<9, 6>() = M2;
+	P.bottomLeftCorner<6, 9>() = M2.transpose();
+}
+
+
+/*
+ *
+ * State and IMU.
+ *
+ */
+
+/*!
+ * Nominal state of the filter.
+ */
+struct State
+{
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	Eigen::Vector3d position{Eigen::Vector3d::Zero()};
+	Eigen::Vector3d velocity{Eigen::Vector3d::Zero()};
+	Eigen::Quaterniond orientation{Eigen::Quaterniond::Identity()};
+	Eigen::Vector3d gyro_bias{Eigen::Vector3d::Zero()};
+	Eigen::Vector3d accel_bias{Eigen::Vector3d::Zero()};
+};
+
+/*!
+ * Continuous time noise densities of the IMU, the defaults are in the range
+ * of the consumer IMUs found in headsets.
+ */
+struct ImuNoise
+{
+	//! rad/s/sqrt(Hz)
+	double gyro = 2e-3;
+	//! m/s^2/sqrt(Hz)
+	double accel = 2e-2;
+	//! rad/s^2/sqrt(Hz)
+	double gyro_bias = 2e-5;
+	//! m/s^3/sqrt(Hz)
+	double accel_bias = 2e-4;
+};
+
+/*!
+ * One IMU sample, body space.
+ */
+struct ImuSample
+{
+	timepoint_ns timestamp_ns;
+	//! m/s^2
+	Eigen::Vector3d accel;
+	//! rad/s
+	Eigen::Vector3d gyro;
+};
+
+/*!
+ * IMU samples integrated relative to the state at the start of the interval.
+ *
+ * Position and velocity deltas, and the position and velocity rows of the
+ * transition and noise, are in the body space of the start of the interval,
+ * that makes them independent of the state and they are rotated into world
+ * space when applied. Biases are held fixed during the interval.
+ *
+ * The process noise of the interval is added once when applied, instead of
+ * being propagated through every sample of the interval, the difference is
+ * negligible over the few milliseconds an interval covers.
+ */
+class Preintegration
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	Preintegration() = default;
+
+	explicit Preintegration(State const &s, ImuNoise const &noise = ImuNoise{})
+	{
+		reset(s, noise);
+	}
+
+	void
+	reset(State const &s, ImuNoise const &noise)
+	{
+		gyro_bias_ = s.gyro_bias;
+		accel_bias_ = s.accel_bias;
+		noise_ = noise;
+
+		delta_rot_ = Eigen::Quaterniond::Identity();
+		delta_vel_.setZero();
+		delta_pos_.setZero();
+		dt_ = 0;
+
+		A_.setIdentity();
+		B_.setZero();
+	}
+
+	/*!
+	 * Add one sample that covers @p dt seconds.
+	 */
+	void
+	integrate(Eigen::Vector3d const &accel, Eigen::Vector3d const &gyro, double dt)
+	{
+		Eigen::Vector3d a = accel - accel_bias_;
+		Eigen::Vector3d w = gyro - gyro_bias_;
+		Eigen::Matrix3d R = delta_rot_.toRotationMatrix();
+		Eigen::Quaterniond step = rotvec_to_quat(w * dt);
+
+		/*
+		 * The transition of one sample is identity except for a few 3x3
+		 * blocks, so it is applied block by block to the rows of the
+		 * transition so far instead of a full matrix multiply.
+		 */
+		Eigen::Matrix3d step_t = step.toRotationMatrix().transpose();
+		Eigen::Matrix3d vel_rot = -R * skew(a) * dt;
+		Eigen::Matrix3d pos_rot = 0.5 * vel_rot * dt;
+
+		auto pos = A_.middleRows<3>(kPosition);
+		auto vel = A_.middleRows<3>(kVelocity);
+		auto rot = A_.middleRows<3>(kRotation);
+		pos += dt * vel + pos_rot * rot;
+		vel += vel_rot * rot;
+		rot = step_t * rot;
+
+		auto pos_b = B_.middleRows<3>(kPosition);
+		auto vel_b = B_.middleRows<3>(kVelocity);
+		auto rot_b = B_.middleRows<3>(kRotation);
+		pos_b += dt * vel_b + pos_rot * rot_b;
+		vel_b += vel_rot * rot_b;
+		rot_b = step_t * rot_b;
+
+		pos_b.middleCols<3>(kAccelBias - 9) -= 0.5 * R * dt * dt;
+		vel_b.middleCols<3>(kAccelBias - 9) -= R * dt;
+		rot_b.middleCols<3>(kGyroBias - 9).diagonal().array() -= dt;
+
+		// Nominal deltas.
+		Eigen::Vector3d Ra_dt = R * a * dt;
+		delta_pos_ += delta_vel_ * dt + 0.5 * Ra_dt * dt;
+		delta_vel_ += Ra_dt;
+		delta_rot_ = (delta_rot_ * step).normalized();
+		dt_ += dt;
+	}
+
+	double
+	getDuration() const
+	{
+		return dt_;
+	}
+
+	Eigen::Quaterniond const &
+	getDeltaRotation() const
+	{
+		return delta_rot_;
+	}
+
+	Eigen::Vector3d const &
+	getDeltaVelocity() const
+	{
+		return delta_vel_;
+	}
+
+	Eigen::Vector3d const &
+	getDeltaPosition() const
+	{
+		return delta_pos_;
+	}
+
+	/*!
+	 * Apply the integrated samples to @p s and its covariance @p P.
+	 */
+	void
+	apply(State &s, Covariance &P) const
+	{
+		Eigen::Matrix3d R = s.orientation.toRotationMatrix();
+
+		// Rotate the body space rows into world space, T = diag(R, R, I).
+		Eigen::Matrix<double, 9, 9> T = Eigen::Matrix<double, 9, 9>::Identity();
+		T.block<3, 3>(kPosition, kPosition) = R;
+		T.block<3, 3>(kVelocity, kVelocity) = R;
+
+		Eigen::Matrix<double, 9, 9> A = T * A_ * T.transpose();
+		Eigen::Matrix<double, 9, 6> B = T * B_;
+
+		propagate_covariance(P, A, B);
+
+		// The noise is isotropic so the rotation does not change it.
+		P.diagonal().segment<3>(kVelocity).array() += noise_.accel * noise_.accel * dt_;
+		P.diagonal().segment<3>(kRotation).array() += noise_.gyro * noise_.gyro * dt_;
+		P.diagonal().segment<3>(kGyroBias).array() += noise_.gyro_bias * noise_.gyro_bias * dt_;
+		P.diagonal().segment<3>(kAccelBias).array() += noise_.accel_bias * noise_.accel_bias * dt_;
+
+		applyState(s);
+	}
+
+	/*!
+	 * Apply the integrated samples to @p s only.
+	 */
+	void
+	applyState(State &s) const
+	{
+		Eigen::Matrix3d R = s.orientation.toRotationMatrix();
+
+		s.position += s.velocity * dt_ + 0.5 * kGravity * dt_ * dt_ + R * delta_pos_;
+		s.velocity += kGravity * dt_ + R * delta_vel_;
+		s.orientation = (s.orientation * delta_rot_).normalized();
+	}
+
+private:
+	Eigen::Quaterniond delta_rot_{Eigen::Quaterniond::Identity()};
+	Eigen::Vector3d delta_vel_{Eigen::Vector3d::Zero()};
+	Eigen::Vector3d delta_pos_{Eigen::Vector3d::Zero()};
+	double dt_{0};
+
+	//! Error transition, `[[A, B], [0, I]]`.
+	Eigen::Matrix<double, 9, 9> A_{Eigen::Matrix<double, 9, 9>::Identity()};
+	Eigen::Matrix<double, 9, 6> B_{Eigen::Matrix<double, 9, 6>::Zero()};
+
+	Eigen::Vector3d gyro_bias_{Eigen::Vector3d::Zero()};
+	Eigen::Vector3d accel_bias_{Eigen::Vector3d::Zero()};
+	ImuNoise noise_{};
+};
+
+
+/*
+ *
+ * Measurements.
+ *
+ */
+
+/*!
+ * Absolute position of a point fixed on the body, like the ball of a PS Move
+ * or the origin of a lighthouse tracked device.
+ */
+class PositionMeasurement
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	static constexpr int Dimension = 3;
+
+	PositionMeasurement(Eigen::Vector3d const &position,
+	                    Eigen::Vector3d const &variance,
+	                    Eigen::Vector3d const &point_in_body = Eigen::Vector3d::Zero())
+	    : position_(position), variance_(variance), point_in_body_(point_in_body)
+	{}
+
+	Eigen::Vector3d
+	getResidual(State const &s) const
+	{
+		return position_ - (s.position + s.orientation * point_in_body_);
+	}
+
+	Eigen::Matrix<double, Dimension, kErrorDim>
+	getJacobian(State const &s) const
+	{
+		Eigen::Matrix<double, Dimension, kErrorDim> H = Eigen::Matrix<double, Dimension, kErrorDim>::Zero();
+		H.block<3, 3>(0, kPosition).setIdentity();
+		H.block<3, 3>(0, kRotation) = -(s.orientation.toRotationMatrix() * skew(point_in_body_));
+		return H;
+	}
+
+	Eigen::Matrix3d
+	getCovariance(State const & /*s*/) const
+	{
+		return variance_.asDiagonal();
+	}
+
+private:
+	Eigen::Vector3d position_;
+	Eigen::Vector3d variance_;
+	Eigen::Vector3d point_in_body_;
+};
+
+/*!
+ * Absolute pose of the body, from something like an optical tracker that
+ * already solved for the pose. The orientation variance is in body space.
+ */
+class PoseMeasurement
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	static constexpr int Dimension = 6;
+
+	PoseMeasurement(Eigen::Vector3d const &position,
+	                Eigen::Quaterniond const &orientation,
+	                Eigen::Vector3d const &position_variance,
+	                Eigen::Vector3d const &orientation_variance)
+	    : position_(position), orientation_(orientation)
+	{
+		variance_ << position_variance, orientation_variance;
+	}
+
+	Eigen::Matrix<double, Dimension, 1>
+	getResidual(State const &s) const
+	{
+		Eigen::Matrix<double, Dimension, 1> r;
+		r << position_ - s.position, quat_to_rotvec(s.orientation.conjugate() * orientation_);
+		return r;
+	}
+
+	Eigen::Matrix<double, Dimension, kErrorDim>
+	getJacobian(State const & /*s*/) const
+	{
+		Eigen::Matrix<double, Dimension, kErrorDim> H = Eigen::Matrix<double, Dimension, kErrorDim>::Zero();
+		H.block<3, 3>(0, kPosition).setIdentity();
+		H.block<3, 3>(3, kRotation).setIdentity();
+		return H;
+	}
+
+	Eigen::Matrix<double, Dimension, Dimension>
+	getCovariance(State const & /*s*/) const
+	{
+		return variance_.asDiagonal();
+	}
+
+private:
+	Eigen::Vector3d position_;
+	Eigen::Quaterniond orientation_;
+	Eigen::Matrix<double, Dimension, 1> variance_;
+};
+
+/*!
+ * The accelerometer as a gravity direction sensor, only valid while the
+ * device is not accelerating, gives 3DoF devices drift free tilt and helps
+ * to estimate the accelerometer bias.
+ */
+class GravityMeasurement
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	static constexpr int Dimension = 3;
+
+	GravityMeasurement(Eigen::Vector3d const &accel, Eigen::Vector3d const &variance)
+	    : accel_(accel), variance_(variance)
+	{}
+
+	Eigen::Vector3d
+	getResidual(State const &s) const
+	{
+		return accel_ - predict(s);
+	}
+
+	Eigen::Matrix<double, Dimension, kErrorDim>
+	getJacobian(State const &s) const
+	{
+		Eigen::Matrix<double, Dimension, kErrorDim> H = Eigen::Matrix<double, Dimension, kErrorDim>::Zero();
+		H.block<3, 3>(0, kRotation) = skew(s.orientation.conjugate() * -kGravity);
+		H.block<3, 3>(0, kAccelBias).setIdentity();
+		return H;
+	}
+
+	Eigen::Matrix3d
+	getCovariance(State const & /*s*/) const
+	{
+		return variance_.asDiagonal();
+	}
+
+private:
+	static Eigen::Vector3d
+	predict(State const &s)
+	{
+		return s.orientation.conjugate() * -kGravity + s.accel_bias;
+	}
+
+	Eigen::Vector3d accel_;
+	Eigen::Vector3d variance_;
+};
+
+/*!
+ * A known point on the body seen by a camera with a known pose, in normalized
+ * image coordinates of a +Z forward camera like OpenCV uses, that is
+ * undistorted pixels multiplied with the inverse of the camera matrix.
+ */
+class KeypointMeasurement
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	static constexpr int Dimension = 2;
+
+	KeypointMeasurement(Eigen::Vector2d const &normalized,
+	                    double variance,
+	                    Eigen::Vector3d const &point_in_body,
+	                    Eigen::Isometry3d const &world_from_camera)
+	    : normalized_(normalized), variance_(variance), point_in_body_(point_in_body),
+	      camera_from_world_(world_from_camera.inverse())
+	{}
+
+	Eigen::Vector2d
+	getResidual(State const &s) const
+	{
+		Eigen::Vector3d p = pointInCamera(s);
+		return normalized_ - p.head<2>() / p.z();
+	}
+
+	Eigen::Matrix<double, Dimension, kErrorDim>
+	getJacobian(State const &s) const
+	{
+		Eigen::Vector3d p = pointInCamera(s);
+		double inv_z = 1.0 / p.z();
+
+		Eigen::Matrix<double, 2, 3> project;
+		project << inv_z, 0, -p.x() * inv_z * inv_z, //
+		    0, inv_z, -p.y() * inv_z * inv_z;
+
+		Eigen::Matrix3d R_cw = camera_from_world_.linear();
+		Eigen::Matrix<double, Dimension, kErrorDim> H = Eigen::Matrix<double, Dimension, kErrorDim>::Zero();
+		H.block<2, 3>(0, kPosition) = project * R_cw;
+		H.block<2, 3>(0, kRotation) =
+		    -project * R_cw * s.orientation.toRotationMatrix() * skew(point_in_body_);
+		return H;
+	}
+
+	Eigen::Matrix2d
+	getCovariance(State const & /*s*/) const
+	{
+		return Eigen::Matrix2d::Identity() * variance_;
+	}
+
+	//! The point must be in front of the camera for the update to be used.
+	bool
+	isValid(State const &s) const
+	{
+		return pointInCamera(s).z() > 1e-3;
+	}
+
+private:
+	Eigen::Vector3d
+	pointInCamera(State const &s) const
+	{
+		return camera_from_world_ * (s.position + s.orientation * point_in_body_);
+	}
+
+	Eigen::Vector2d normalized_;
+	double variance_;
+	Eigen::Vector3d point_in_body_;
+	Eigen::Isometry3d camera_from_world_;
+};
+
+namespace detail {
+
+	template <typename M, typename = void> struct has_is_valid : std::false_type
+	{};
+
+	template <typename M>
+	struct has_is_valid<M, std::void_t<decltype(std::declval<M const &>().isValid(std::declval<State const &>()))>>
+	    : std::true_type
+	{};
+
+} // namespace detail
+
+
+/*
+ *
+ * Filter.
+ *
+ */
+
+/*!
+ * @brief Error-state Kalman filter fusing IMU samples with the given
+ * measurement types.
+ *
+ * The filter runs on IMU time, a measurement is applied at the state of the
+ * newest IMU sample at or before it, at 1kHz IMU rates that is at most a
+ * millisecond off.
+ *
+ * The last @p HistorySize IMU samples and measurements are kept together with
+ * the state after them. When a measurement older than the newest IMU sample
+ * arrives the filter rewinds to the newest snapshot before it, and replays the
+ * events after it with the measurement inserted in order. Anything older than
+ * the history is dropped.
+ *
+ * @tparam HistorySize Number of events to keep for out of order measurements.
+ * @tparam Measurements Measurement types that can be given to the filter.
+ */
+template <size_t HistorySize, typename... Measurements> class Filter
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	using Event = std::variant<ImuSample, Measurements...>;
+
+	explicit Filter(ImuNoise const &noise = ImuNoise{}) : noise_(noise) {}
+
+	/*!
+	 * Start the filter from the given state, IMU samples are integrated
+	 * from @p timestamp_ns onwards.
+	 */
+	void
+	reset(State const &s, Covariance const &P, timepoint_ns timestamp_ns)
+	{
+		state_ = s;
+		P_ = P;
+		timestamp_ns_ = timestamp_ns;
+		have_last_imu_ = false;
+		started_ = true;
+		head_ = 0;
+		count_ = 0;
+	}
+
+	/*!
+	 * @return true if the filter has been started with @ref reset.
+	 */
+	bool
+	valid() const noexcept
+	{
+		return started_;
+	}
+
+	State const &
+	getState() const
+	{
+		return state_;
+	}
+
+	Covariance const &
+	getCovariance() const
+	{
+		return P_;
+	}
+
+	//! Timestamp of the newest IMU sample, or the reset.
+	timepoint_ns
+	getTimestamp() const
+	{
+		return timestamp_ns_;
+	}
+
+	/*!
+	 * Extrapolate the state to @p timestamp_ns using the last IMU sample,
+	 * does not change the filter.
+	 */
+	State
+	getPredictedState(timepoint_ns timestamp_ns) const
+	{
+		State s = state_;
+		if (!have_last_imu_ || timestamp_ns <= timestamp_ns_) {
+			return s;
+		}
+
+		Preintegration pre(state_, noise_);
+		pre.integrate(last_imu_.accel, last_imu_.gyro, time_ns_to_s(timestamp_ns - timestamp_ns_));
+		pre.applyState(s);
+
+		return s;
+	}
+
+	/*!
+	 * Process IMU samples, they must be in order and each sample covers the
+	 * time since the previous one. All samples are integrated into one
+	 * preintegration so the covariance is only propagated once.
+	 *
+	 * @return false if the filter isn't started or the samples are old.
+	 */
+	bool
+	handleImu(ImuSample const *samples, size_t count)
+	{
+		if (!started_ || count == 0 || samples[0].timestamp_ns < timestamp_ns_) {
+			return false;
+		}
+
+		Preintegration pre(state_, noise_);
+		for (size_t i = 0; i < count; i++) {
+			integrateImu(pre, samples[i]);
+			pushHistory(samples[i].timestamp_ns, Event{samples[i]});
+		}
+		pre.apply(state_, P_);
+
+		// Only the last sample of the batch gets a snapshot.
+		storeSnapshot(count_ - 1);
+
+		return true;
+	}
+
+	bool
+	handleImu(ImuSample const &sample)
+	{
+		return handleImu(&sample, 1);
+	}
+
+	/*!
+	 * Process a measurement taken at @p timestamp_ns, it may be older than
+	 * the newest IMU sample as long as it is within the history.
+	 *
+	 * @return true if the measurement was used.
+	 */
+	template <typename M>
+	bool
+	handleMeasurement(timepoint_ns timestamp_ns, M const &m)
+	{
+		static_assert((std::is_same_v<M, Measurements> || ...), "Not one of the filter's measurement types");
+
+		if (!started_) {
+			return false;
+		}
+
+		if (timestamp_ns >= timestamp_ns_) {
+			bool ret = correct(m);
+			pushHistory(timestamp_ns_, Event{m});
+			storeSnapshot(count_ - 1);
+			return ret;
+		}
+
+		return insertAndReplay(timestamp_ns, Event{m});
+	}
+
+private:
+	struct Entry
+	{
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		timepoint_ns timestamp_ns;
+		Event event;
+
+		//! The snapshot is the state after the event.
+		bool has_snapshot;
+		State state;
+		Covariance P;
+		timepoint_ns imu_timestamp_ns;
+		ImuSample last_imu;
+		bool have_last_imu;
+	};
+
+	void
+	integrateImu(Preintegration &pre, ImuSample const &sample)
+	{
+		pre.integrate(sample.accel, sample.gyro, time_ns_to_s(sample.timestamp_ns - timestamp_ns_));
+
+		timestamp_ns_ = sample.timestamp_ns;
+		last_imu_ = sample;
+		have_last_imu_ = true;
+	}
+
+	template <typename M>
+	bool
+	correct(M const &m)
+	{
+		constexpr int D = M::Dimension;
+
+		if constexpr (detail::has_is_valid<M>::value) {
+			if (!m.isValid(state_)) {
+				return false;
+			}
+		}
+
+		Eigen::Matrix<double, D, 1> r = m.getResidual(state_);
+		Eigen::Matrix<double, D, kErrorDim> H = m.getJacobian(state_);
+		Eigen::Matrix<double, D, D> R = m.getCovariance(state_);
+
+		Eigen::Matrix<double, kErrorDim, D> PHt = P_ * H.transpose();
+		Eigen::Matrix<double, D, D> S = H * PHt + R;
+
+		Eigen::LDLT<Eigen::Matrix<double, D, D>> ldlt(S);
+		if (ldlt.info() != Eigen::Success) {
+			return false;
+		}
+
+		Eigen::Matrix<double, kErrorDim, D> K = ldlt.solve(PHt.transpose()).transpose();
+		ErrorVector dx = K * r;
+
+		// P - K * H * P, symmetrized to keep rounding from building up.
+		P_ -= K * PHt.transpose();
+		P_ = 0.5 * (P_ + P_.transpose()).eval();
+
+		inject(dx);
+
+		return true;
+	}
+
+	//! Move the error into the nominal state and reset it.
+	void
+	inject(ErrorVector const &dx)
+	{
+		Eigen::Vector3d d_theta = dx.segment<3>(kRotation);
+
+		state_.position += dx.segment<3>(kPosition);
+		state_.velocity += dx.segment<3>(kVelocity);
+		state_.orientation = (state_.orientation * rotvec_to_quat(d_theta)).normalized();
+		state_.gyro_bias += dx.segment<3>(kGyroBias);
+		state_.accel_bias += dx.segment<3>(kAccelBias);
+
+		// The reset Jacobian, only the rotation block differs from identity.
+		Eigen::Matrix3d G = Eigen::Matrix3d::Identity() - 0.5 * skew(d_theta);
+		P_.middleRows<3>(kRotation) = G * P_.middleRows<3>(kRotation);
+		P_.middleCols<3>(kRotation) = P_.middleCols<3>(kRotation) * G.transpose();
+	}
+
+
+	/*
+	 *
+	 * History.
+	 *
+	 */
+
+	Entry &
+	at(size_t i)
+	{
+		return history_[(head_ + i) % HistorySize];
+	}
+
+	void
+	dropOldest()
+	{
+		head_ = (head_ + 1) % HistorySize;
+		count_--;
+	}
+
+	void
+	pushHistory(timepoint_ns timestamp_ns, Event const &event)
+	{
+		if (count_ == HistorySize) {
+			dropOldest();
+		}
+
+		Entry &e = at(count_++);
+		e.timestamp_ns = timestamp_ns;
+		e.event = event;
+		e.has_snapshot = false;
+	}
+
+	void
+	storeSnapshot(size_t i)
+	{
+		Entry &e = at(i);
+		e.has_snapshot = true;
+		e.state = state_;
+		e.P = P_;
+		e.imu_timestamp_ns = timestamp_ns_;
+		e.last_imu = last_imu_;
+		e.have_last_imu = have_last_imu_;
+	}
+
+	void
+	restoreSnapshot(size_t i)
+	{
+		Entry &e = at(i);
+		state_ = e.state;
+		P_ = e.P;
+		timestamp_ns_ = e.imu_timestamp_ns;
+		last_imu_ = e.last_imu;
+		have_last_imu_ = e.have_last_imu;
+	}
+
+	bool
+	insertAndReplay(timepoint_ns timestamp_ns, Event const &event)
+	{
+		// Find the newest snapshot at or before the measurement.
+		size_t base = count_;
+		for (size_t i = count_; i-- > 0;) {
+			Entry &e = at(i);
+			if (e.timestamp_ns <= timestamp_ns && e.has_snapshot) {
+				base = i;
+				break;
+			}
+		}
+
+		if (base == count_) {
+			// Older than the history.
+			return false;
+		}
+
+		// Goes after all events that are not newer than it.
+		size_t pos = base + 1;
+		while (pos < count_ && at(pos).timestamp_ns <= timestamp_ns) {
+			pos++;
+		}
+
+		if (count_ == HistorySize) {
+			if (base == 0) {
+				// Would have to drop the snapshot we rewind to.
+				return false;
+			}
+			dropOldest();
+			base--;
+			pos--;
+		}
+
+		for (size_t i = count_; i > pos; i--) {
+			at(i) = at(i - 1);
+		}
+		at(pos).timestamp_ns = timestamp_ns;
+		at(pos).event = event;
+		at(pos).has_snapshot = false;
+		count_++;
+
+		restoreSnapshot(base);
+		replay(base + 1);
+
+		return true;
+	}
+
+	//! Apply all events from @p first onwards, refreshing their snapshots.
+	void
+	replay(size_t first)
+	{
+		size_t i = first;
+		while (i < count_) {
+			if (!std::holds_alternative<ImuSample>(at(i).event)) {
+				std::visit(
+				    [this](auto const &m) {
+					    if constexpr (!std::is_same_v<std::decay_t<decltype(m)>, ImuSample>) {
+						    correct(m);
+					    }
+				    },
+				    at(i).event);
+				storeSnapshot(i++);
+				continue;
+			}
+
+			// Integrate the whole run of IMU samples in one go.
+			Preintegration pre(state_, noise_);
+			for (; i < count_ && std::holds_alternative<ImuSample>(at(i).event); i++) {
+				integrateImu(pre, std::get<ImuSample>(at(i).event));
+				at(i).has_snapshot = false;
+			}
+			pre.apply(state_, P_);
+			storeSnapshot(i - 1);
+		}
+	}
+
+	ImuNoise noise_;
+
+	State state_{};
+	Covariance P_{Covariance::Identity()};
+	timepoint_ns timestamp_ns_{0};
+	bool started_{false};
+
+	ImuSample last_imu_{};
+	bool have_last_imu_{false};
+
+	std::array<Entry, HistorySize> history_{};
+	size_t head_{0};
+	size_t count_{0};
+};
+
+} // namespace xrt::auxiliary::tracking::eskf
@@ -11,6 +11,7 @@
 #include "xrt/xrt_frame.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_var.h"
 #include "util/u_sink.h"
@@ -249,6 +250,7 @@ extern "C" void *
 t_ht_run(void *ptr)
 {
 	auto &t = *(TrackerHand *)ptr;
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "t_hand");
 	run(t);
 	return NULL;
 }
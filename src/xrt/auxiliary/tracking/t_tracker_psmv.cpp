@@ -25,6 +25,7 @@
 #include "math/m_api.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -42,29 +43,27 @@ namespace xrt::auxiliary::tracking::psmv {
  */
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
-
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
 	cv::Vec4d distortion_fisheye;
 	bool use_fisheye;
 
-	std::vector<cv::KeyPoint> keypoints;
+	//! Projects rectified camera space points into this view.
+	cv::Matx34d projection;
 
-	cv::Mat frame_undist_rectified;
+	//! Blobs from the preprocessor waiting to be processed.
+	std::vector<cv::KeyPoint> pending_keypoints;
+
+	std::vector<cv::KeyPoint> keypoints;
 
 	void
-	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
+	populate_from_calib(t_camera_calibration &calib)
 	{
 		CameraCalibrationWrapper wrap(calib);
 		intrinsics = wrap.intrinsics_mat;
 		distortion = wrap.distortion_mat.clone();
 		distortion_fisheye = wrap.distortion_fisheye_mat;
 		use_fisheye = wrap.use_fisheye;
-
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
 	}
 };
 
@@ -72,16 +71,16 @@ struct View
  * The core object of the PS Move tracking setup.
  *
  * @implements xrt_tracked_psmv
- * @implements xrt_frame_sink
+ * @implements t_blob_sink
  * @implements xrt_frame_node
  */
 struct TrackerPSMV
 {
 	struct xrt_tracked_psmv base = {};
-	struct xrt_frame_sink sink = {};
+	struct t_blob_sink sink = {};
 	struct xrt_frame_node node = {};
 
-	//! Frame waiting to be processed.
+	//! Rectified frame from the preprocessor waiting to be processed.
 	struct xrt_frame *frame;
 
 	//! Thread and lock helper.
@@ -108,50 +107,36 @@ struct TrackerPSMV
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
-
 	std::unique_ptr<PSMVFusionInterface> filter;
 
 	xrt_vec3 tracked_object_position;
+
+	//! Where the ball is predicted to be in the next frame.
+	struct
+	{
+		//! Read by the preprocessor, protected by the thread helper lock.
+		bool valid = false;
+		struct xrt_rect rects[2] = {};
+
+		//! Last measured position, only used by the tracker thread.
+		bool has_last = false;
+		struct xrt_vec3 last_position = {};
+	} roi;
 };
 
 
 /*!
- * @brief Perform per-view (two in a stereo camera image) processing on an
- * image, before tracking math is performed.
+ * @brief Perform per-view (two in a stereo camera image) processing on the
+ * blobs found by the preprocessor, before tracking math is performed.
  *
- * Right now, this is mainly finding blobs/keypoints.
+ * Right now, this is only drawing the blobs/keypoints for debugging.
  */
 static void
-do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSMV &t, View &view, cv::Mat &rectified, cv::Mat &rgb)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
-	              0);                          // type
-
-	// tracker_measurement_t m = {};
-
-	// Do blob detection with our masks.
-	//! @todo Re-enable masks.
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
-
-
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
-		cv::drawKeypoints(view.frame_undist_rectified,                // image
+		cv::drawKeypoints(rectified,                                  // image
 		                  view.keypoints,                             // keypoints
 		                  rgb,                                        // outImage
 		                  cv::Scalar(255, 0, 0),                      // color
@@ -231,6 +216,78 @@ world_point_from_blobs(cv::Point2f left, cv::Point2f right, const cv::Matx44d &d
 	return world_point;
 }
 
+/*!
+ * @brief Project a point in Monado camera space into a rectified view, returns
+ * false if the point is behind the camera.
+ */
+static bool
+project_to_view(const View &view, const cv::Point3f &point, cv::Point2f &out_pixel)
+{
+	// Back into OpenCV camera space, see world_point_from_blobs.
+	cv::Vec3d h = view.projection * cv::Vec4d(point.x, -point.y, -point.z, 1.0);
+	if (h[2] <= 0.0) {
+		return false;
+	}
+
+	out_pixel = cv::Point2f(h[0] / h[2], h[1] / h[2]);
+	return true;
+}
+
+/*!
+ * @brief Predict where the ball will be in the next frame, assuming constant
+ * velocity between the last two measurements, and store the regions around it
+ * in both views for the preprocessor.
+ */
+static void
+update_roi(TrackerPSMV &t, bool tracked)
+{
+	// Radius of the ball.
+	const float ball_radius_m = 0.0225f;
+	// Extra pixels around the ball, for the prediction error.
+	const float margin_px = 16.0f;
+
+	struct xrt_rect rects[2] = {};
+	bool valid = tracked;
+
+	if (tracked) {
+		cv::Point3f pos(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
+		cv::Point3f predicted = pos;
+		if (t.roi.has_last) {
+			cv::Point3f last(t.roi.last_position.x, t.roi.last_position.y, t.roi.last_position.z);
+			predicted += pos - last;
+		}
+
+		for (int i = 0; i < 2; i++) {
+			const View &view = t.view[i];
+			cv::Point2f now_px;
+			cv::Point2f next_px;
+			valid = project_to_view(view, pos, now_px) && project_to_view(view, predicted, next_px);
+			if (!valid) {
+				break;
+			}
+
+			// Depth is along -Z in Monado camera space.
+			float radius_px = (float)view.projection(0, 0) * ball_radius_m / -predicted.z;
+			float motion_px = (float)cv::norm(next_px - now_px);
+			float half = radius_px * 2.0f + motion_px + margin_px;
+
+			rects[i].offset.w = (int)(next_px.x - half);
+			rects[i].offset.h = (int)(next_px.y - half);
+			rects[i].extent.w = (int)(half * 2.0f);
+			rects[i].extent.h = (int)(half * 2.0f);
+		}
+	}
+
+	t.roi.has_last = tracked;
+	t.roi.last_position = t.tracked_object_position;
+
+	os_thread_helper_lock(&t.oth);
+	t.roi.valid = valid;
+	t.roi.rects[0] = rects[0];
+	t.roi.rects[1] = rects[1];
+	os_thread_helper_unlock(&t.oth);
+}
+
 /*!
  * @brief Perform tracking computations on a frame of video data.
  */
@@ -252,21 +309,22 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 		return;
 	}
 
+	// Only ask for a fully rectified frame when drawing debug output.
+	xrt_atomic_s32_store(&t.sink.want_rectified_frame, t.debug.sink != NULL);
+
 	// Create the debug frame if needed.
 	t.debug.refresh(xf);
 
-	t.view[0].keypoints.clear();
-	t.view[1].keypoints.clear();
-
 	int cols = xf->width / 2;
 	int rows = xf->height;
 	int stride = xf->stride;
 
-	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
-	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
+	// Rectified and thresholded by the preprocessor if we asked for it.
+	cv::Mat l_rectified(rows, cols, CV_8UC1, xf->data, stride);
+	cv::Mat r_rectified(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	do_view(t, t.view[0], l_rectified, t.debug.rgb[0]);
+	do_view(t, t.view[1], r_rectified, t.debug.rgb[1]);
 
 	cv::Point3f last_point(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
 	auto nearest_world = make_lowest_score_finder<cv::Point3f>([&](cv::Point3f world_point) {
@@ -306,6 +364,8 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 		t.filter->clear_position_tracked_flag();
 	}
 
+	update_roi(t, nearest_world.got_one);
+
 	// We are done with the debug frame.
 	t.debug.submit();
 
@@ -362,6 +422,10 @@ run(TrackerPSMV &t)
 		frame = t.frame;
 		t.frame = NULL;
 
+		// The keypoints belong to the frame.
+		std::swap(t.view[0].keypoints, t.view[0].pending_keypoints);
+		std::swap(t.view[1].keypoints, t.view[1].pending_keypoints);
+
 		// Unlock the mutex when we do the work.
 		os_thread_helper_unlock(&t.oth);
 
@@ -423,7 +487,7 @@ imu_data(TrackerPSMV &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 }
 
 static void
-frame(TrackerPSMV &t, struct xrt_frame *xf)
+blobs(TrackerPSMV &t, struct t_blob_observation *obs)
 {
 	os_thread_helper_lock(&t.oth);
 
@@ -433,13 +497,37 @@ frame(TrackerPSMV &t, struct xrt_frame *xf)
 		return;
 	}
 
-	xrt_frame_reference(&t.frame, xf);
+	xrt_frame_reference(&t.frame, obs->frame);
+
+	for (int i = 0; i < 2; i++) {
+		std::vector<cv::KeyPoint> &keypoints = t.view[i].pending_keypoints;
+		keypoints.clear();
+		for (uint32_t k = 0; k < obs->num_blobs[i]; k++) {
+			const struct t_blob &blob = obs->blobs[i][k];
+			keypoints.emplace_back(blob.x, blob.y, blob.size);
+		}
+	}
+
 	// Wake up the thread.
 	os_thread_helper_signal_locked(&t.oth);
 
 	os_thread_helper_unlock(&t.oth);
 }
 
+static bool
+get_rois(TrackerPSMV &t, struct xrt_rect out_rois[2])
+{
+	os_thread_helper_lock(&t.oth);
+
+	bool valid = t.roi.valid;
+	out_rois[0] = t.roi.rects[0];
+	out_rois[1] = t.roi.rects[1];
+
+	os_thread_helper_unlock(&t.oth);
+
+	return valid;
+}
+
 static void
 break_apart(TrackerPSMV &t)
 {
@@ -482,10 +570,17 @@ t_psmv_fake_destroy(struct xrt_tracked_psmv *xtmv)
 }
 
 extern "C" void
-t_psmv_sink_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+t_psmv_sink_push_blobs(struct t_blob_sink *sink, struct t_blob_observation *obs)
+{
+	auto &t = *container_of(sink, TrackerPSMV, sink);
+	blobs(t, obs);
+}
+
+extern "C" bool
+t_psmv_sink_get_rois(struct t_blob_sink *sink, struct xrt_rect out_rois[2])
 {
-	auto &t = *container_of(xsink, TrackerPSMV, sink);
-	frame(t, xf);
+	auto &t = *container_of(sink, TrackerPSMV, sink);
+	return get_rois(t, out_rois);
 }
 
 extern "C" void
@@ -511,6 +606,7 @@ extern "C" void *
 t_psmv_run(void *ptr)
 {
 	auto &t = *(TrackerPSMV *)ptr;
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "t_psmv");
 	run(t);
 	return NULL;
 }
@@ -534,7 +630,7 @@ t_psmv_create(struct xrt_frame_context *xfctx,
               struct xrt_colour_rgb_f32 *rgb,
               struct t_stereo_camera_calibration *data,
               struct xrt_tracked_psmv **out_xtmv,
-              struct xrt_frame_sink **out_sink)
+              struct t_blob_sink **out_sink)
 {
 	U_LOG_D("Creating PSMV tracker.");
 
@@ -545,7 +641,12 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	t.base.push_imu = t_psmv_push_imu;
 	t.base.destroy = t_psmv_fake_destroy;
 	t.base.colour = *rgb;
-	t.sink.push_frame = t_psmv_sink_push_frame;
+	t.sink.get_rois = t_psmv_sink_get_rois;
+	t.sink.push_blobs = t_psmv_sink_push_blobs;
+	t.sink.params.filter_by_convexity = true;
+	t.sink.params.min_convexity = 0.8f;
+	t.sink.params.min_area = 1.0f;
+	t.sink.params.max_area = 1000.0f;
 	t.node.break_apart = t_psmv_node_break_apart;
 	t.node.destroy = t_psmv_node_destroy;
 	t.fusion.rot.x = 0.0f;
@@ -580,32 +681,16 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	}
 
 	StereoRectificationMaps rectify(data);
-	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
-	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
+	t.view[0].populate_from_calib(data->view[0]);
+	t.view[1].populate_from_calib(data->view[1]);
+	t.view[0].projection = rectify.view[0].projection_mat;
+	t.view[1].projection = rectify.view[1].projection_mat;
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
 	t.calibrated = true;
 
-	// clang-format off
-	cv::SimpleBlobDetector::Params blob_params;
-	blob_params.filterByArea = false;
-	blob_params.filterByConvexity = true;
-	blob_params.minConvexity = 0.8;
-	blob_params.filterByInertia = false;
-	blob_params.filterByColor = true;
-	blob_params.blobColor = 255; // 0 or 255 - color comes from binarized image?
-	blob_params.minArea = 1;
-	blob_params.maxArea = 1000;
-	blob_params.maxThreshold = 51; // using a wide threshold span slows things down bigtime
-	blob_params.minThreshold = 50;
-	blob_params.thresholdStep = 1;
-	blob_params.minDistBetweenBlobs = 5;
-	blob_params.minRepeatability = 1; // need this to avoid error?
-	// clang-format on
-
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
 	xrt_frame_context_add(xfctx, &t.node);
 
 	// Everything is safe, now setup the variable tracking.
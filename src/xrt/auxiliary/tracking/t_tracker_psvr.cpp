@@ -13,6 +13,7 @@
 #include "tracking/t_tracking.h"
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
+#include "tracking/t_tracker_psvr.hpp"
 
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -27,6 +28,7 @@
 #include "math/m_imu_3dof.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -103,6 +105,12 @@ DEBUG_GET_ONCE_LOG_OPTION(psvr_log, "PSVR_TRACKING_LOG", U_LOGGING_WARN)
 //! hold the previously recognised configuration unless we depart significantly
 #define PSVR_HOLD_THRESH 0.086f
 
+/*!
+ * Pixels to pad the region around the predicted LEDs with, covers the
+ * prediction error and the size of the LEDs themselves.
+ */
+#define PSVR_ROI_MARGIN_PX 48.0f
+
 // uncomment this to dump comprehensive optical and imu data to
 // /tmp/psvr_dump.txt
 
@@ -132,29 +140,37 @@ typedef struct blob_point
 
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
-
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
 	cv::Vec4d distortion_fisheye;
 	bool use_fisheye;
 
+	//! Projects rectified camera space points into this view.
+	cv::Matx34d projection;
+
+	//! Blobs from the preprocessor waiting to be processed.
+	std::vector<cv::KeyPoint> pending_keypoints;
+	std::vector<cv::Point2f> pending_frame_points;
+
 	std::vector<cv::KeyPoint> keypoints;
 
+	//! Centers of @ref keypoints in @ref frame_undist_rectified.
+	std::vector<cv::Point2f> frame_points;
+
+	/*!
+	 * Points into the frame being processed, only rectified by the
+	 * preprocessor when the debug sink is attached.
+	 */
 	cv::Mat frame_undist_rectified;
 
 	void
-	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
+	populate_from_calib(t_camera_calibration &calib)
 	{
 		CameraCalibrationWrapper wrap(calib);
 		intrinsics = wrap.intrinsics_mat;
 		distortion = wrap.distortion_mat.clone();
 		distortion_fisheye = wrap.distortion_fisheye_mat;
 		use_fisheye = wrap.use_fisheye;
-
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
 	}
 };
 
@@ -216,13 +232,13 @@ class TrackerPSVR
 public:
 	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 	struct xrt_tracked_psvr base = {};
-	struct xrt_frame_sink sink = {};
+	struct t_blob_sink sink = {};
 	struct xrt_frame_node node = {};
 
 	//! Logging stuff.
 	enum u_logging_level ll;
 
-	//! Frame waiting to be processed.
+	//! Rectified frame from the preprocessor waiting to be processed.
 	struct xrt_frame *frame;
 
 	//! Thread and lock helper.
@@ -273,8 +289,11 @@ public:
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
 	std::vector<cv::KeyPoint> l_blobs, r_blobs;
+
+	//! Centers of @ref l_blobs in the frame, for sampling their shape.
+	std::vector<cv::Point2f> l_frame_blobs;
+
 	std::vector<match_model_t> matches;
 
 	// we refine our measurement by rejecting outliers and merging 'too
@@ -302,6 +321,13 @@ public:
 
 	Eigen::Vector4f model_center; // center of rotation
 
+	//! Where the LEDs are predicted to be in the next frame, protected by the lock.
+	struct
+	{
+		bool valid = false;
+		struct xrt_rect rects[2] = {};
+	} roi;
+
 #ifdef PSVR_DUMP_FOR_OFFLINE_ANALYSIS
 	FILE *dump_file;
 #endif
@@ -359,6 +385,30 @@ filter_predict(std::vector<match_data_t> *pose, cv::KalmanFilter *filters, float
 	}
 }
 
+/*!
+ * Like filter_predict but doesn't advance the filters.
+ */
+static void
+filter_peek(std::vector<match_data_t> *pose, cv::KalmanFilter *filters, float dt)
+{
+	for (uint32_t i = 0; i < PSVR_NUM_LEDS; i++) {
+		match_data_t current_led;
+		cv::KalmanFilter *current_kf = filters + i;
+
+		// set our dt components in the transition matrix
+		current_kf->transitionMatrix.at<float>(0, 3) = dt;
+		current_kf->transitionMatrix.at<float>(1, 4) = dt;
+		current_kf->transitionMatrix.at<float>(2, 5) = dt;
+
+		current_led.vertex_index = i;
+		cv::Mat prediction = current_kf->transitionMatrix * current_kf->statePost;
+		current_led.position[0] = prediction.at<float>(0, 0);
+		current_led.position[1] = prediction.at<float>(1, 0);
+		current_led.position[2] = prediction.at<float>(2, 0);
+		pose->push_back(current_led);
+	}
+}
+
 static void
 filter_update(std::vector<match_data_t> *pose, cv::KalmanFilter *filters, float dt)
 {
@@ -1225,26 +1275,10 @@ create_match_list(TrackerPSVR &t)
 }
 
 static void
-do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSVR &t, View &view, cv::Mat &rectified, cv::Mat &rgb)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation - LINEAR seems
-	                                        // very slow on my setup
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
-	              0);
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
+	// Rectified and thresholded by the preprocessor if we asked for it.
+	view.frame_undist_rectified = rectified;
 
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
@@ -1293,8 +1327,9 @@ sample_line(cv::Mat &src, cv::Point2i start, cv::Point2i end, int *inside_length
 
 			// @todo: we are just counting pixels rather
 			// than measuring length - bresenhams may introduce some
-			// inaccuracy here.
-			if (*val > 128) {
+			// inaccuracy here. Same threshold as the preprocessor,
+			// the frame is only thresholded when rectified.
+			if (*val > 32) {
 				(*inside_length) += 1;
 			}
 		}
@@ -1506,6 +1541,55 @@ tag_points(TrackerPSVR &t, std::vector<blob_data_t> *blob_datas)
 }
 
 
+/*!
+ * Project the LEDs as predicted for the next frame into both rectified views
+ * and store the regions around them for the preprocessor.
+ */
+static void
+update_roi(TrackerPSVR &t, bool tracked)
+{
+	struct xrt_rect rects[2] = {};
+	bool valid = tracked && t.last_vertices.size() == PSVR_NUM_LEDS;
+
+	std::vector<match_data_t> predicted;
+	if (valid) {
+		// Same dt as used in process for a single frame.
+		filter_peek(&predicted, t.track_filters, 0.5f);
+	}
+
+	for (int i = 0; i < 2 && valid; i++) {
+		cv::Rect2f bounds;
+		bool first = true;
+
+		for (const match_data_t &led : predicted) {
+			cv::Point3f p(led.position.x(), led.position.y(), led.position.z());
+			cv::Point2f px;
+			if (!project(t.view[i].projection, p, px)) {
+				valid = false;
+				break;
+			}
+
+			if (first) {
+				bounds = cv::Rect2f(px, px);
+				first = false;
+			} else {
+				bounds |= cv::Rect2f(px, px);
+			}
+		}
+
+		rects[i].offset.w = (int)(bounds.x - PSVR_ROI_MARGIN_PX);
+		rects[i].offset.h = (int)(bounds.y - PSVR_ROI_MARGIN_PX);
+		rects[i].extent.w = (int)(bounds.width + PSVR_ROI_MARGIN_PX * 2.0f);
+		rects[i].extent.h = (int)(bounds.height + PSVR_ROI_MARGIN_PX * 2.0f);
+	}
+
+	os_thread_helper_lock(&t.oth);
+	t.roi.valid = valid;
+	t.roi.rects[0] = rects[0];
+	t.roi.rects[1] = rects[1];
+	os_thread_helper_unlock(&t.oth);
+}
+
 static void
 process(TrackerPSVR &t, struct xrt_frame *xf)
 {
@@ -1514,6 +1598,9 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 		return;
 	}
 
+	// Only ask for a fully rectified frame when drawing debug output.
+	xrt_atomic_s32_store(&t.sink.want_rectified_frame, t.debug.sink != NULL);
+
 	t.debug.refresh(xf);
 
 	// compute a dt for our filter(s)
@@ -1532,21 +1619,20 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 
 	// get our raw measurements
 
-	t.view[0].keypoints.clear();
-	t.view[1].keypoints.clear();
 	t.l_blobs.clear();
 	t.r_blobs.clear();
+	t.l_frame_blobs.clear();
 	t.world_points.clear();
 
 	int cols = xf->width / 2;
 	int rows = xf->height;
 	int stride = xf->stride;
 
-	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
-	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
+	cv::Mat l_rectified(rows, cols, CV_8UC1, xf->data, stride);
+	cv::Mat r_rectified(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	do_view(t, t.view[0], l_rectified, t.debug.rgb[0]);
+	do_view(t, t.view[1], r_rectified, t.debug.rgb[1]);
 
 	// if we wish to confirm our camera input contents, dump frames
 	// to disk
@@ -1580,6 +1666,7 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 			cv::KeyPoint rkp = t.view[1].keypoints.at(r_index);
 			t.l_blobs.push_back(lkp);
 			t.r_blobs.push_back(rkp);
+			t.l_frame_blobs.push_back(t.view[0].frame_points.at(l_index));
 			// U_LOG_D("2D coords: LX %f LY %f RX %f RY %f",
 			// lkp.pt.x,
 			//       lkp.pt.y, rkp.pt.x, rkp.pt.y);
@@ -1592,15 +1679,9 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	if (t.l_blobs.size() > 0) {
 		for (uint32_t i = 0; i < t.l_blobs.size(); i++) {
 			float disp = t.r_blobs[i].pt.x - t.l_blobs[i].pt.x;
-			cv::Vec4d xydw(t.l_blobs[i].pt.x, t.l_blobs[i].pt.y, disp, 1.0f);
-			// Transform
-			cv::Vec4d h_world = (cv::Matx44d)t.disparity_to_depth * xydw;
 
-			// Divide by scale to get 3D vector from
-			// homogeneous coordinate. we also invert x here
 			blob_point_t bp;
-			bp.p =
-			    cv::Point3f(-h_world[0] / h_world[3], h_world[1] / h_world[3], (h_world[2] / h_world[3]));
+			bp.p = triangulate((cv::Matx44d)t.disparity_to_depth, t.l_blobs[i].pt, disp);
 			bp.lkp = t.l_blobs[i];
 			bp.rkp = t.r_blobs[i];
 			bp.btype = BLOB_TYPE_UNKNOWN;
@@ -1608,8 +1689,10 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 
 			// compute the shape data for each blob
 
+			// Sampled around the center in the frame, it's not always rectified.
+			cv::KeyPoint frame_kp(t.l_frame_blobs[i], bp.lkp.size);
 			blob_data_t intersections;
-			blob_intersections(t.view[0].frame_undist_rectified, &bp.lkp, &intersections);
+			blob_intersections(t.view[0].frame_undist_rectified, &frame_kp, &intersections);
 			blob_datas.push_back(intersections);
 		}
 	}
@@ -1789,6 +1872,9 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 		filter_update(&t.last_vertices, t.track_filters, dt / 1000.0f);
 	}
 
+	// Search the whole frame again when we don't see any LEDs.
+	update_roi(t, !t.merged_points.empty());
+
 
 	Eigen::Vector4f position = model_center_transform.col(3);
 	pose_filter_update(&position, &t.pose_filter, dt);
@@ -1811,6 +1897,10 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 
 	t.debug.submit();
 
+	// Make sure that the cv::Mats doesn't use the data.
+	t.view[0].frame_undist_rectified = cv::Mat();
+	t.view[1].frame_undist_rectified = cv::Mat();
+
 	xrt_frame_reference(&xf, NULL);
 }
 
@@ -1836,6 +1926,12 @@ run(TrackerPSVR &t)
 		frame = t.frame;
 		t.frame = NULL;
 
+		// The keypoints belong to the frame.
+		for (View &view : t.view) {
+			std::swap(view.keypoints, view.pending_keypoints);
+			std::swap(view.frame_points, view.pending_frame_points);
+		}
+
 		// Unlock the mutex when we do the work.
 		os_thread_helper_unlock(&t.oth);
 
@@ -1926,7 +2022,7 @@ imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 }
 
 static void
-frame(TrackerPSVR &t, struct xrt_frame *xf)
+blobs(TrackerPSVR &t, struct t_blob_observation *obs)
 {
 	os_thread_helper_lock(&t.oth);
 
@@ -1936,7 +2032,19 @@ frame(TrackerPSVR &t, struct xrt_frame *xf)
 		return;
 	}
 
-	xrt_frame_reference(&t.frame, xf);
+	xrt_frame_reference(&t.frame, obs->frame);
+
+	for (int i = 0; i < 2; i++) {
+		std::vector<cv::KeyPoint> &keypoints = t.view[i].pending_keypoints;
+		std::vector<cv::Point2f> &frame_points = t.view[i].pending_frame_points;
+		keypoints.clear();
+		frame_points.clear();
+		for (uint32_t k = 0; k < obs->num_blobs[i]; k++) {
+			const struct t_blob &blob = obs->blobs[i][k];
+			keypoints.emplace_back(blob.x, blob.y, blob.size);
+			frame_points.emplace_back(blob.frame_x, blob.frame_y);
+		}
+	}
 
 	// Wake up the thread.
 	os_thread_helper_signal_locked(&t.oth);
@@ -1944,6 +2052,20 @@ frame(TrackerPSVR &t, struct xrt_frame *xf)
 	os_thread_helper_unlock(&t.oth);
 }
 
+static bool
+get_rois(TrackerPSVR &t, struct xrt_rect out_rois[2])
+{
+	os_thread_helper_lock(&t.oth);
+
+	bool valid = t.roi.valid;
+	out_rois[0] = t.roi.rects[0];
+	out_rois[1] = t.roi.rects[1];
+
+	os_thread_helper_unlock(&t.oth);
+
+	return valid;
+}
+
 static void
 break_apart(TrackerPSVR &t)
 {
@@ -1983,10 +2105,17 @@ t_psvr_fake_destroy(struct xrt_tracked_psvr *xtvr)
 }
 
 extern "C" void
-t_psvr_sink_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+t_psvr_sink_push_blobs(struct t_blob_sink *sink, struct t_blob_observation *obs)
 {
-	auto &t = *container_of(xsink, TrackerPSVR, sink);
-	frame(t, xf);
+	auto &t = *container_of(sink, TrackerPSVR, sink);
+	blobs(t, obs);
+}
+
+extern "C" bool
+t_psvr_sink_get_rois(struct t_blob_sink *sink, struct xrt_rect out_rois[2])
+{
+	auto &t = *container_of(sink, TrackerPSVR, sink);
+	return get_rois(t, out_rois);
 }
 
 extern "C" void
@@ -2012,6 +2141,7 @@ extern "C" void *
 t_psvr_run(void *ptr)
 {
 	auto &t = *(TrackerPSVR *)ptr;
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "t_psvr");
 	run(t);
 	return NULL;
 }
@@ -2042,7 +2172,7 @@ extern "C" int
 t_psvr_create(struct xrt_frame_context *xfctx,
               struct t_stereo_camera_calibration *data,
               struct xrt_tracked_psvr **out_xtvr,
-              struct xrt_frame_sink **out_sink)
+              struct t_blob_sink **out_sink)
 {
 	auto &t = *(new TrackerPSVR());
 	t.ll = debug_get_log_option_psvr_log();
@@ -2059,8 +2189,10 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	init_filter(t.pose_filter, PSVR_POSE_PROCESS_NOISE, PSVR_POSE_MEASUREMENT_NOISE, 1.0f);
 
 	StereoRectificationMaps rectify(data);
-	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
-	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
+	t.view[0].populate_from_calib(data->view[0]);
+	t.view[1].populate_from_calib(data->view[1]);
+	t.view[0].projection = rectify.view[0].projection_mat;
+	t.view[1].projection = rectify.view[1].projection_mat;
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
@@ -2069,24 +2201,6 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 
 
 
-	// clang-format off
-	cv::SimpleBlobDetector::Params blob_params;
-	blob_params.filterByArea = false;
-	blob_params.filterByConvexity = false;
-	blob_params.filterByInertia = false;
-	blob_params.filterByColor = true;
-	blob_params.blobColor = 255; // 0 or 255 - color comes from binarized image?
-	blob_params.minArea = 0;
-	blob_params.maxArea = 1000;
-	blob_params.maxThreshold = 51; // using a wide threshold span slows things down bigtime
-	blob_params.minThreshold = 50;
-	blob_params.thresholdStep = 1;
-	blob_params.minDistBetweenBlobs = 5;
-	blob_params.minRepeatability = 1; // need this to avoid error?
-	// clang-format on
-
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
-
 	t.target_optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	t.optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	t.axis_align_rot = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
@@ -2110,7 +2224,12 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	t.base.get_tracked_pose = t_psvr_get_tracked_pose;
 	t.base.push_imu = t_psvr_push_imu;
 	t.base.destroy = t_psvr_fake_destroy;
-	t.sink.push_frame = t_psvr_sink_push_frame;
+	t.sink.get_rois = t_psvr_sink_get_rois;
+	t.sink.push_blobs = t_psvr_sink_push_blobs;
+	t.sink.params.filter_by_convexity = false;
+	t.sink.params.min_convexity = 0.0f;
+	t.sink.params.min_area = 0.0f;
+	t.sink.params.max_area = 1000.0f;
 	t.node.break_apart = t_psvr_node_break_apart;
 	t.node.destroy = t_psvr_node_destroy;
 
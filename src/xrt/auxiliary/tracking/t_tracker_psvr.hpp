@@ -0,0 +1,53 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  PSVR tracker helpers, between pixels and tracker space.
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include <opencv2/core.hpp>
+
+
+namespace xrt::auxiliary::tracking::psvr {
+
+/*!
+ * Triangulate a LED seen at @p left in the rectified left view, with the
+ * disparity to the right view, into tracker space. That is the space of
+ * @p disparity_to_depth with x inverted.
+ */
+static inline cv::Point3f
+triangulate(const cv::Matx44d &disparity_to_depth, const cv::Point2f &left, float disparity)
+{
+	cv::Vec4d xydw(left.x, left.y, disparity, 1.0);
+	cv::Vec4d h_world = disparity_to_depth * xydw;
+
+	// Divide by scale to get 3D vector from homogeneous coordinate, we also invert x here.
+	return cv::Point3f(-h_world[0] / h_world[3], h_world[1] / h_world[3], h_world[2] / h_world[3]);
+}
+
+/*!
+ * Project a point in tracker space into a rectified view, the inverse of
+ * @ref triangulate. Returns false if the point is behind the view.
+ */
+static inline bool
+project(const cv::Matx34d &projection, const cv::Point3f &p, cv::Point2f &out_px)
+{
+	// Back into the space of the rectification, undoing the inverted x.
+	cv::Vec4d h_world(-p.x, p.y, p.z, 1.0);
+	cv::Vec3d h = projection * h_world;
+	if (h[2] <= 0.0) {
+		return false;
+	}
+
+	out_px = cv::Point2f(h[0] / h[2], h[1] / h[2]);
+	return true;
+}
+
+} // namespace xrt::auxiliary::tracking::psvr
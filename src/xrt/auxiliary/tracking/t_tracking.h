@@ -12,6 +12,7 @@
 #pragma once
 
 #include "xrt/xrt_frame.h"
+#include "xrt/xrt_tracking.h"
 #include "util/u_misc.h"
 
 #include <stdio.h>
@@ -273,6 +274,305 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink **out_sink);
 
 
+/*
+ *
+ * Blob detection.
+ *
+ */
+
+/*!
+ * A blob found by @ref t_blob_detector.
+ */
+struct t_blob_detection
+{
+	//! Centroid of the blob in pixels, relative to the image.
+	float x, y;
+
+	//! Number of pixels in the blob.
+	uint32_t area;
+
+	//! Inclusive bounding box of the blob, relative to the image.
+	uint16_t min_x, min_y, max_x, max_y;
+};
+
+/*!
+ * Single pass 8-connected component labeller for bright blobs like LEDs in a
+ * greyscale image, replacing cv::SimpleBlobDetector on the hot path. Runs of
+ * pixels at or above the threshold are found a word at a time and merged with
+ * overlapping runs on the row above, so no label image is written.
+ *
+ * Holds the scratch memory between frames, not thread safe.
+ */
+struct t_blob_detector;
+
+/*!
+ * @public @memberof t_blob_detector
+ */
+int
+t_blob_detector_create(struct t_blob_detector **out_det);
+
+/*!
+ * @public @memberof t_blob_detector
+ */
+void
+t_blob_detector_destroy(struct t_blob_detector **det_ptr);
+
+/*!
+ * Find blobs in a L8 image.
+ *
+ * @param det       Detector.
+ * @param data      Pointer to the top left pixel of the image.
+ * @param width     Width of the image.
+ * @param height    Height of the image.
+ * @param stride    Bytes between rows.
+ * @param threshold Pixels at or above this value are part of a blob.
+ * @param roi       Optional, only search this part of the image.
+ * @param min_area  Drop blobs with fewer pixels than this.
+ * @param max_area  Drop blobs with more pixels than this.
+ * @param out_blobs Array of blobs, valid until the next call.
+ *
+ * @return Number of blobs in @p out_blobs.
+ *
+ * @public @memberof t_blob_detector
+ */
+uint32_t
+t_blob_detector_detect_l8(struct t_blob_detector *det,
+                          const uint8_t *data,
+                          uint32_t width,
+                          uint32_t height,
+                          size_t stride,
+                          uint8_t threshold,
+                          const struct xrt_rect *roi,
+                          uint32_t min_area,
+                          uint32_t max_area,
+                          const struct t_blob_detection **out_blobs);
+
+
+/*
+ *
+ * Blob preprocessor.
+ *
+ */
+
+//! Number of channels the blob preprocessor takes, same as the hsv filter.
+#define T_BLOB_MAX_CHANNELS 4
+
+/*!
+ * A single blob found in one view of a rectified frame.
+ */
+struct t_blob
+{
+	//! Center of the blob in rectified pixel coordinates.
+	float x, y;
+
+	//! Diameter of the blob in pixels.
+	float size;
+
+	/*!
+	 * Center of the blob in the pixel coordinates of
+	 * @ref t_blob_observation::frame, the same as @ref x and @ref y when
+	 * that frame is rectified.
+	 */
+	float frame_x, frame_y;
+};
+
+/*!
+ * All of the blobs found in both views of a single channel frame.
+ */
+struct t_blob_observation
+{
+	/*!
+	 * Side by side frame the blobs were found in, only valid during the push
+	 * call, reference it to keep it around. Rectified and thresholded if
+	 * @ref rectified is set, otherwise the unrectified input frame.
+	 */
+	struct xrt_frame *frame;
+
+	//! Is @ref frame rectified, the blob coordinates always are.
+	bool rectified;
+
+	//! Blobs in the left and right view, only valid during the push call.
+	const struct t_blob *blobs[2];
+	uint32_t num_blobs[2];
+};
+
+/*!
+ * Parameters for the blob detector of a single channel.
+ */
+struct t_blob_detector_params
+{
+	bool filter_by_convexity;
+	float min_convexity;
+	float min_area;
+	float max_area;
+};
+
+/*!
+ * Receives blobs from the @ref t_blob_preprocessor, implemented by trackers.
+ */
+struct t_blob_sink
+{
+	//! Detector parameters this sink wants, read at creation.
+	struct t_blob_detector_params params;
+
+	/*!
+	 * Non-zero if this sink needs a rectified frame. The sink may change it
+	 * from any thread with @ref xrt_atomic_s32_store, the preprocessor loads
+	 * it once per frame. When zero the preprocessor may only undistort the
+	 * blob centers, see @ref t_blob_preprocessor_create.
+	 */
+	xrt_atomic_s32_t want_rectified_frame;
+
+	/*!
+	 * Optional, called by the preprocessor for every frame to get the
+	 * region of each view the sink predicts its blobs to be in, in rectified
+	 * pixel coordinates. Only blobs in the regions are searched for, and only
+	 * they are rectified if @ref want_rectified_frame is set. Return false
+	 * when the tracked object has been lost to search the whole frame.
+	 */
+	bool (*get_rois)(struct t_blob_sink *sink, struct xrt_rect out_rois[2]);
+
+	void (*push_blobs)(struct t_blob_sink *sink, struct t_blob_observation *obs);
+};
+
+/*!
+ * Create a preprocessor that undistorts, rectifies, thresholds and finds blobs
+ * in the channel frames from the hsv filter, with rectification maps shared by
+ * all channels. Each returned frame sink pushes to the blob sink of the same
+ * index, the frame sink is NULL for channels without a blob sink.
+ *
+ * By default the full frame is remapped and blobs are found with the blob
+ * detector. Set the `T_BLOB_SPARSE_UNDISTORT` environment variable to true, or
+ * toggle it in the debug gui, to instead find blobs with connected components
+ * on the unrectified image and only undistort and rectify their centers, the
+ * full frame remap is then only done for sinks that want a rectified frame.
+ * That path only filters blobs by area, not by the other shape parameters.
+ *
+ * Sinks that implement @ref t_blob_sink::get_rois only get the predicted
+ * regions searched, the whole frame is still searched every
+ * `T_BLOB_ROI_FULL_FRAME_INTERVAL` frames to pick up lost blobs. Set the
+ * `T_BLOB_USE_ROI` environment variable to false to always search the whole
+ * frame.
+ *
+ * @public @memberof t_blob_preprocessor
+ *
+ * @see xrt_frame_context
+ */
+int
+t_blob_preprocessor_create(struct xrt_frame_context *xfctx,
+                           struct t_stereo_camera_calibration *data,
+                           struct t_blob_sink *blob_sinks[T_BLOB_MAX_CHANNELS],
+                           struct xrt_frame_sink *out_sinks[T_BLOB_MAX_CHANNELS]);
+
+
+/*
+ *
+ * Dataset recording and playback.
+ *
+ */
+
+/*!
+ * Type of a record in a dataset file.
+ */
+enum t_dataset_record_type
+{
+	T_DATASET_RECORD_NONE = 0,
+	T_DATASET_RECORD_CALIBRATION = 1,
+	T_DATASET_RECORD_FRAME = 2,
+	T_DATASET_RECORD_IMU = 3,
+};
+
+/*!
+ * A single record read from a dataset file, see @ref t_dataset_reader_next.
+ */
+struct t_dataset_record
+{
+	enum t_dataset_record_type type;
+
+	//! When the frame or IMU sample was captured.
+	timepoint_ns timestamp;
+
+	//! Which device the IMU sample is from, as given to the recorder.
+	uint32_t source;
+
+	//! Referenced, only set for frame records.
+	struct xrt_frame *frame;
+
+	//! Referenced, only set for calibration records.
+	struct t_stereo_camera_calibration *calib;
+
+	//! Only set for IMU records.
+	struct xrt_tracking_sample imu;
+};
+
+/*!
+ * Writes camera frames, IMU samples and the stereo calibration to a single
+ * file with a timestamp on every record, so that a tracking session can be
+ * replayed without any hardware.
+ *
+ * Frames are written as they arrive, without the row padding, writes from
+ * different threads are serialised.
+ */
+struct t_dataset_recorder;
+
+/*!
+ * Create a recorder writing to the file at @p path, the calibration is written
+ * first if given. The recorder is owned by the frame context and the returned
+ * frame sink records all frames pushed to it.
+ *
+ * @public @memberof t_dataset_recorder
+ */
+int
+t_dataset_recorder_create(struct xrt_frame_context *xfctx,
+                          const char *path,
+                          struct t_stereo_camera_calibration *calib,
+                          struct t_dataset_recorder **out_rec,
+                          struct xrt_frame_sink **out_sink);
+
+/*!
+ * Record a IMU sample from the device identified by @p source.
+ *
+ * @public @memberof t_dataset_recorder
+ */
+void
+t_dataset_recorder_push_imu(struct t_dataset_recorder *rec,
+                            uint32_t source,
+                            timepoint_ns timestamp_ns,
+                            const struct xrt_tracking_sample *sample);
+
+/*!
+ * Reads back a file written by @ref t_dataset_recorder.
+ */
+struct t_dataset_reader;
+
+/*!
+ * @public @memberof t_dataset_reader
+ */
+int
+t_dataset_reader_open(const char *path, struct t_dataset_reader **out_reader);
+
+/*!
+ * Read the next record, returns false at the end of the file or on errors.
+ * Call @ref t_dataset_record_clear to release the record.
+ *
+ * @public @memberof t_dataset_reader
+ */
+bool
+t_dataset_reader_next(struct t_dataset_reader *reader, struct t_dataset_record *out_record);
+
+/*!
+ * @public @memberof t_dataset_reader
+ */
+void
+t_dataset_reader_close(struct t_dataset_reader **reader_ptr);
+
+/*!
+ * Drop the references held by the record and clear it.
+ */
+void
+t_dataset_record_clear(struct t_dataset_record *record);
+
+
 /*
  *
  * Tracker code.
@@ -293,7 +593,7 @@ t_psmv_create(struct xrt_frame_context *xfctx,
               struct xrt_colour_rgb_f32 *rgb,
               struct t_stereo_camera_calibration *data,
               struct xrt_tracked_psmv **out_xtmv,
-              struct xrt_frame_sink **out_sink);
+              struct t_blob_sink **out_sink);
 
 /*!
  * @public @memberof xrt_tracked_psvr
@@ -308,7 +608,7 @@ int
 t_psvr_create(struct xrt_frame_context *xfctx,
               struct t_stereo_camera_calibration *data,
               struct xrt_tracked_psvr **out_xtvr,
-              struct xrt_frame_sink **out_sink);
+              struct t_blob_sink **out_sink);
 
 /*!
  * @public @memberof xrt_tracked_hand
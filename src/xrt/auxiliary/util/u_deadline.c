@@ -0,0 +1,82 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Deadline sleeping with wake up lateness statistics.
+ * @ingroup aux_util
+ */
+
+#include "util/u_deadline.h"
+#include "util/u_trace_marker.h"
+#include "util/u_var.h"
+
+
+/*!
+ * How much each new wake up moves the average, about the last second at 90Hz.
+ */
+#define AVERAGE_WEIGHT (1.0f / 90.0f)
+
+
+void
+u_deadline_sleeper_init(struct u_deadline_sleeper *uds)
+{
+	os_precise_sleeper_init(&uds->sleeper);
+	u_deadline_sleeper_reset_stats(uds);
+}
+
+uint64_t
+u_deadline_sleeper_sleep_until(struct u_deadline_sleeper *uds, uint64_t deadline_ns)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (now_ns >= deadline_ns) {
+		return now_ns;
+	}
+
+	now_ns = os_precise_sleeper_nanosleep_until(&uds->sleeper, deadline_ns);
+
+	int64_t late_ns = (int64_t)(now_ns - deadline_ns);
+	float late_us = (float)late_ns / 1000.0f;
+
+	uds->last_late_ns = late_ns;
+	if (late_ns > uds->max_late_ns) {
+		uds->max_late_ns = late_ns;
+	}
+	if (late_ns > U_DEADLINE_MISSED_NS) {
+		uds->num_missed++;
+	}
+	if (uds->num_sleeps++ == 0) {
+		uds->average_late_us = late_us;
+	} else {
+		uds->average_late_us += (late_us - uds->average_late_us) * AVERAGE_WEIGHT;
+	}
+
+	U_TRACE_COUNTER(timing, wake_late, late_ns);
+
+	return now_ns;
+}
+
+void
+u_deadline_sleeper_reset_stats(struct u_deadline_sleeper *uds)
+{
+	uds->last_late_ns = 0;
+	uds->max_late_ns = 0;
+	uds->average_late_us = 0.0f;
+	uds->num_sleeps = 0;
+	uds->num_missed = 0;
+}
+
+void
+u_deadline_sleeper_add_vars(struct u_deadline_sleeper *uds, void *root)
+{
+	u_var_add_ro_i64(root, &uds->last_late_ns, "Wake up late last (ns)");
+	u_var_add_ro_i64(root, &uds->max_late_ns, "Wake up late max (ns)");
+	u_var_add_ro_f32(root, &uds->average_late_us, "Wake up late average (us)");
+	u_var_add_ro_u64(root, &uds->num_sleeps, "Wake ups");
+	u_var_add_ro_u64(root, &uds->num_missed, "Wake ups missed");
+}
+
+void
+u_deadline_sleeper_deinit(struct u_deadline_sleeper *uds)
+{
+	os_precise_sleeper_deinit(&uds->sleeper);
+}
@@ -0,0 +1,98 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Deadline sleeping with wake up lateness statistics.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "os/os_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Wake ups later than this count as missed, a quarter of a frame at 144Hz.
+ *
+ * @ingroup aux_util
+ */
+#define U_DEADLINE_MISSED_NS (1736 * 1000)
+
+/*!
+ * Sleeps until deadlines using @ref os_precise_sleeper and keeps statistics
+ * of how late it woke up, they are exposed with @ref u_var and as a counter
+ * track when tracing, see @ref tracing.
+ *
+ * @ingroup aux_util
+ */
+struct u_deadline_sleeper
+{
+	struct os_precise_sleeper sleeper;
+
+	//! How late the last wake up was.
+	int64_t last_late_ns;
+
+	//! The latest wake up, since creation or reset.
+	int64_t max_late_ns;
+
+	//! Moving average of how late wake ups are, in microseconds for the gui.
+	float average_late_us;
+
+	//! Number of sleeps.
+	uint64_t num_sleeps;
+
+	//! Number of wake ups later than @ref U_DEADLINE_MISSED_NS.
+	uint64_t num_missed;
+};
+
+/*!
+ * Init the sleeper, @see os_precise_sleeper_init.
+ *
+ * @public @memberof u_deadline_sleeper
+ */
+void
+u_deadline_sleeper_init(struct u_deadline_sleeper *uds);
+
+/*!
+ * Sleep until the monotonic @p deadline_ns, returns the time it woke up. If the
+ * deadline has already passed it returns right away and isn't counted.
+ *
+ * @public @memberof u_deadline_sleeper
+ */
+uint64_t
+u_deadline_sleeper_sleep_until(struct u_deadline_sleeper *uds, uint64_t deadline_ns);
+
+/*!
+ * Reset the statistics, not the sleeper.
+ *
+ * @public @memberof u_deadline_sleeper
+ */
+void
+u_deadline_sleeper_reset_stats(struct u_deadline_sleeper *uds);
+
+/*!
+ * Add the statistics to the given @ref u_var root.
+ *
+ * @public @memberof u_deadline_sleeper
+ */
+void
+u_deadline_sleeper_add_vars(struct u_deadline_sleeper *uds, void *root);
+
+/*!
+ * Free the resources of the sleeper, the struct itself is not freed.
+ *
+ * @public @memberof u_deadline_sleeper
+ */
+void
+u_deadline_sleeper_deinit(struct u_deadline_sleeper *uds);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free snapshots of device state.
+ * @ingroup aux_util
+ */
+
+#include "util/u_snapshot.h"
+
+#include <atomic>
+#include <vector>
+#include <assert.h>
+#include <string.h>
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * One of the two buffers, the generation is a seqlock that also says which
+ * publish the buffer holds: 2n + 1 while publish n is writing it, 2n + 2 once
+ * it is done.
+ */
+struct snapshot_buffer
+{
+	std::atomic<uint64_t> generation{0};
+	std::vector<uint8_t> data;
+};
+
+struct u_snapshot
+{
+	//! Number of times published, publish n lives in buffers[n % 2].
+	std::atomic<uint64_t> count{0};
+
+	size_t size;
+
+	struct snapshot_buffer buffers[2];
+};
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" void
+u_snapshot_create(size_t size, struct u_snapshot **us_ptr)
+{
+	assert(us_ptr != NULL);
+	assert(size > 0);
+
+	struct u_snapshot *us = new u_snapshot();
+	us->size = size;
+	us->buffers[0].data.resize(size);
+	us->buffers[1].data.resize(size);
+
+	*us_ptr = us;
+}
+
+extern "C" void
+u_snapshot_publish(struct u_snapshot *us, const void *data)
+{
+	uint64_t n = us->count.load(std::memory_order_relaxed);
+	struct snapshot_buffer &b = us->buffers[n % 2];
+
+	// Readers of the latest publish use the other buffer, so they are not disturbed.
+	b.generation.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(b.data.data(), data, us->size);
+
+	b.generation.store(2 * n + 2, std::memory_order_release);
+	us->count.store(n + 1, std::memory_order_release);
+}
+
+extern "C" bool
+u_snapshot_read(struct u_snapshot *us, void *out_data)
+{
+	while (true) {
+		uint64_t count = us->count.load(std::memory_order_acquire);
+		if (count == 0) {
+			return false;
+		}
+
+		uint64_t n = count - 1;
+		const struct snapshot_buffer &b = us->buffers[n % 2];
+		const uint64_t expected = 2 * n + 2;
+
+		if (b.generation.load(std::memory_order_acquire) != expected) {
+			continue;
+		}
+
+		memcpy(out_data, b.data.data(), us->size);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (b.generation.load(std::memory_order_relaxed) == expected) {
+			return true;
+		}
+	}
+}
+
+extern "C" uint64_t
+u_snapshot_get_count(const struct u_snapshot *us)
+{
+	return us->count.load(std::memory_order_acquire);
+}
+
+extern "C" void
+u_snapshot_destroy(struct u_snapshot **us_ptr)
+{
+	struct u_snapshot *us = *us_ptr;
+	if (us == NULL) {
+		return;
+	}
+
+	delete us;
+	*us_ptr = NULL;
+}
@@ -0,0 +1,80 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free snapshots of device state.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Holds the latest copy of a fixed size blob of state, published by a single
+ * writer (typically the driver's HID reader thread after each report) and
+ * read by any number of threads without taking any locks.
+ *
+ * It is double buffered with a seqlock per buffer, the writer never waits and
+ * a reader only retries if the writer publishes twice while it is copying, so
+ * a compositor or IPC thread asking for the device state never stalls behind
+ * sensor processing. The state should be plain data, it is copied with memcpy.
+ *
+ * @ingroup aux_util
+ */
+struct u_snapshot;
+
+/*!
+ * Allocate a new snapshot holding state of @p size bytes, nothing is
+ * published yet.
+ *
+ * @public @memberof u_snapshot
+ */
+void
+u_snapshot_create(size_t size, struct u_snapshot **us_ptr);
+
+/*!
+ * Publish a new copy of the state, @p data must be as big as the size given
+ * at creation. Must only be called from one thread at a time.
+ *
+ * @public @memberof u_snapshot
+ */
+void
+u_snapshot_publish(struct u_snapshot *us, const void *data);
+
+/*!
+ * Copy out the latest published state, returns false and leaves
+ * @p out_data alone if nothing has been published yet. Safe to call from any
+ * thread, concurrently with publish.
+ *
+ * @public @memberof u_snapshot
+ */
+bool
+u_snapshot_read(struct u_snapshot *us, void *out_data);
+
+/*!
+ * Number of times the state has been published.
+ *
+ * @public @memberof u_snapshot
+ */
+uint64_t
+u_snapshot_get_count(const struct u_snapshot *us);
+
+/*!
+ * Free the snapshot and set the pointer to NULL.
+ *
+ * @public @memberof u_snapshot
+ */
+void
+u_snapshot_destroy(struct u_snapshot **us_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,6 +31,7 @@ PERCETTO_TRACK_DEFINE(rt_info, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(rt_present, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(ft_cpu, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(ft_draw, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(wake_late, PERCETTO_TRACK_COUNTER);
 
 
 static enum u_trace_which static_which;
@@ -51,6 +52,8 @@ u_trace_marker_setup(enum u_trace_which which)
 
 	I_PERCETTO_TRACK_PTR(ft_cpu)->name = "FT 1 App";
 	I_PERCETTO_TRACK_PTR(ft_draw)->name = "FT 2 Draw";
+
+	I_PERCETTO_TRACK_PTR(wake_late)->name = "Wake up lateness";
 }
 
 void
@@ -78,6 +81,9 @@ u_trace_marker_init(void)
 		PERCETTO_REGISTER_TRACK(ft_cpu);
 		PERCETTO_REGISTER_TRACK(ft_draw);
 	}
+
+	// Both the service and the apps sleep in wait frame.
+	PERCETTO_REGISTER_TRACK(wake_late);
 }
 
 #else /* XRT_FEATURE_TRACING */
@@ -99,6 +99,7 @@ PERCETTO_TRACK_DECLARE(rt_info);
 PERCETTO_TRACK_DECLARE(rt_present);
 PERCETTO_TRACK_DECLARE(ft_cpu);
 PERCETTO_TRACK_DECLARE(ft_draw);
+PERCETTO_TRACK_DECLARE(wake_late);
 
 #define U_TRACE_EVENT(CATEGORY, NAME) TRACE_EVENT(CATEGORY, NAME)
 #define U_TRACE_EVENT_BEGIN_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                      \
@@ -109,6 +110,7 @@ PERCETTO_TRACK_DECLARE(ft_draw);
 #define U_TRACE_CATEGORY_IS_ENABLED(CATEGORY) PERCETTO_CATEGORY_IS_ENABLED(CATEGORY)
 #define U_TRACE_INSTANT_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                          \
 	TRACE_ANY_WITH_ARGS(PERCETTO_EVENT_INSTANT, CATEGORY, &g_percetto_track_##TRACK, TIME, NAME, 0)
+#define U_TRACE_COUNTER(CATEGORY, TRACK, VALUE) TRACE_COUNTER(CATEGORY, TRACK, VALUE)
 #define U_TRACE_DATA(fd, type, data) u_trace_data(fd, type, (void *)&(data), sizeof(data))
 
 #define U_TRACE_TARGET_SETUP(WHICH)                                                                                    \
@@ -149,6 +151,10 @@ PERCETTO_TRACK_DECLARE(ft_draw);
 	do {                                                                                                           \
 	} while (false)
 
+#define U_TRACE_COUNTER(CATEGORY, TRACK, VALUE)                                                                        \
+	do {                                                                                                           \
+	} while (false)
+
 #define U_TRACE_CATEGORY_IS_ENABLED(_) (false)
 
 /*!
@@ -281,6 +281,43 @@ client_gl_compositor_layer_equirect2(struct xrt_compositor *xc,
 	return xrt_comp_layer_equirect2(&c->xcn->base, xdev, xscfb, &d);
 }
 
+static xrt_result_t
+client_gl_compositor_layers(struct xrt_compositor *xc,
+                            struct xrt_device *xdev,
+                            const struct xrt_layer_entry *entries,
+                            uint32_t num_entries)
+{
+	struct client_gl_compositor *c = client_gl_compositor(xc);
+	struct xrt_layer_entry native[16];
+
+	// Swap in the native swapchains, a chunk at a time.
+	while (num_entries > 0) {
+		uint32_t num = num_entries;
+		if (num > ARRAY_SIZE(native)) {
+			num = ARRAY_SIZE(native);
+		}
+
+		for (uint32_t i = 0; i < num; i++) {
+			for (size_t k = 0; k < ARRAY_SIZE(native[i].xscs); k++) {
+				struct xrt_swapchain *xsc = entries[i].xscs[k];
+				native[i].xscs[k] = xsc != NULL ? &client_gl_swapchain(xsc)->xscn->base : NULL;
+			}
+			native[i].data = entries[i].data;
+			native[i].data.flip_y = !native[i].data.flip_y;
+		}
+
+		xrt_result_t ret = xrt_comp_layers(&c->xcn->base, xdev, native, num);
+		if (ret != XRT_SUCCESS) {
+			return ret;
+		}
+
+		entries += num;
+		num_entries -= num;
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 client_gl_compositor_layer_commit(struct xrt_compositor *xc, int64_t frame_id, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -464,6 +501,7 @@ client_gl_compositor_init(struct client_gl_compositor *c,
 	c->base.base.layer_cylinder = client_gl_compositor_layer_cylinder;
 	c->base.base.layer_equirect1 = client_gl_compositor_layer_equirect1;
 	c->base.base.layer_equirect2 = client_gl_compositor_layer_equirect2;
+	c->base.base.layers = client_gl_compositor_layers;
 	c->base.base.layer_commit = client_gl_compositor_layer_commit;
 	c->base.base.destroy = client_gl_compositor_destroy;
 	c->base.base.poll_events = client_gl_compositor_poll_events;
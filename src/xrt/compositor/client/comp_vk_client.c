@@ -364,6 +364,42 @@ client_vk_compositor_layer_equirect2(struct xrt_compositor *xc,
 	return xrt_comp_layer_equirect2(&c->xcn->base, xdev, xscfb, data);
 }
 
+static xrt_result_t
+client_vk_compositor_layers(struct xrt_compositor *xc,
+                            struct xrt_device *xdev,
+                            const struct xrt_layer_entry *entries,
+                            uint32_t num_entries)
+{
+	struct client_vk_compositor *c = client_vk_compositor(xc);
+	struct xrt_layer_entry native[16];
+
+	// Swap in the native swapchains, a chunk at a time.
+	while (num_entries > 0) {
+		uint32_t num = num_entries;
+		if (num > ARRAY_SIZE(native)) {
+			num = ARRAY_SIZE(native);
+		}
+
+		for (uint32_t i = 0; i < num; i++) {
+			for (size_t k = 0; k < ARRAY_SIZE(native[i].xscs); k++) {
+				struct xrt_swapchain *xsc = entries[i].xscs[k];
+				native[i].xscs[k] = xsc != NULL ? &client_vk_swapchain(xsc)->xscn->base : NULL;
+			}
+			native[i].data = entries[i].data;
+		}
+
+		xrt_result_t ret = xrt_comp_layers(&c->xcn->base, xdev, native, num);
+		if (ret != XRT_SUCCESS) {
+			return ret;
+		}
+
+		entries += num;
+		num_entries -= num;
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 client_vk_compositor_layer_commit(struct xrt_compositor *xc, int64_t frame_id, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -556,6 +592,7 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	c->base.base.layer_cylinder = client_vk_compositor_layer_cylinder;
 	c->base.base.layer_equirect1 = client_vk_compositor_layer_equirect1;
 	c->base.base.layer_equirect2 = client_vk_compositor_layer_equirect2;
+	c->base.base.layers = client_vk_compositor_layers;
 	c->base.base.layer_commit = client_vk_compositor_layer_commit;
 	c->base.base.destroy = client_vk_compositor_destroy;
 	c->base.base.poll_events = client_vk_compositor_poll_events;
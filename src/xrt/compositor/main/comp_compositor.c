@@ -208,13 +208,7 @@ compositor_wait_frame(struct xrt_compositor *xc,
 	    out_predicted_display_time_ns,    //
 	    out_predicted_display_period_ns); //
 
-	uint64_t now_ns = os_monotonic_get_ns();
-	if (now_ns < wake_up_time_ns) {
-		uint32_t delay = (uint32_t)(wake_up_time_ns - now_ns);
-		os_precise_sleeper_nanosleep(&c->sleeper, delay);
-	}
-
-	now_ns = os_monotonic_get_ns();
+	uint64_t now_ns = u_deadline_sleeper_sleep_until(&c->sleeper, wake_up_time_ns);
 
 	xrt_comp_mark_frame(xc, frame_id, XRT_COMPOSITOR_FRAME_POINT_WOKE, now_ns);
 
@@ -586,7 +580,7 @@ compositor_destroy(struct xrt_compositor *xc)
 		free(c->compositor_frame_times.debug_var);
 	}
 
-	os_precise_sleeper_deinit(&c->sleeper);
+	u_deadline_sleeper_deinit(&c->sleeper);
 
 	u_threading_stack_fini(&c->threading.destroy_swapchains);
 
@@ -1252,8 +1246,6 @@ compositor_init_window_pre_vulkan(struct comp_compositor *c)
 static bool
 compositor_init_window_post_vulkan(struct comp_compositor *c)
 {
-	os_precise_sleeper_init(&c->sleeper);
-
 	if (c->settings.window_type == WINDOW_DIRECT_NVIDIA) {
 #ifdef VK_USE_PLATFORM_XLIB_XRANDR_EXT
 		return compositor_try_window(c, comp_window_direct_nvidia_create(c));
@@ -1362,6 +1354,9 @@ xrt_gfx_provider_create_system(struct xrt_device *xdev, struct xrt_system_compos
 
 	u_threading_stack_init(&c->threading.destroy_swapchains);
 
+	// Init before anything can fail, compositor_destroy always deinits it.
+	u_deadline_sleeper_init(&c->sleeper);
+
 	COMP_DEBUG(c, "Doing init %p", (void *)c);
 
 	// Init the settings to default.
@@ -1489,6 +1484,7 @@ xrt_gfx_provider_create_system(struct xrt_device *xdev, struct xrt_system_compos
 
 	u_var_add_root(c, "Compositor", true);
 	u_var_add_ro_f32(c, &c->compositor_frame_times.fps, "FPS (Compositor)");
+	u_deadline_sleeper_add_vars(&c->sleeper, c);
 
 	struct u_var_timing *ft = U_TYPED_CALLOC(struct u_var_timing);
 
@@ -13,6 +13,7 @@
 #include "xrt/xrt_gfx_vk.h"
 #include "xrt/xrt_config_build.h"
 
+#include "util/u_deadline.h"
 #include "util/u_threading.h"
 #include "util/u_index_fifo.h"
 #include "util/u_logging.h"
@@ -197,7 +198,8 @@ struct comp_compositor
 	//! State for generating the correct set of events.
 	enum comp_state state;
 
-	struct os_precise_sleeper sleeper;
+	//! Sleeps in wait frame, only used when the app is in process.
+	struct u_deadline_sleeper sleeper;
 
 	//! Triple buffered layer stacks.
 	struct comp_layer_slot slots[3];
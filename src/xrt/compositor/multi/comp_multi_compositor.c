@@ -254,13 +254,7 @@ multi_compositor_wait_frame(struct xrt_compositor *xc,
 	    out_predicted_display_time_ns,    //
 	    out_predicted_display_period_ns); //
 
-	uint64_t now_ns = os_monotonic_get_ns();
-	if (now_ns < wake_up_time_ns) {
-		uint32_t delay = (uint32_t)(wake_up_time_ns - now_ns);
-		os_precise_sleeper_nanosleep(&mc->sleeper, delay);
-	}
-
-	now_ns = os_monotonic_get_ns();
+	uint64_t now_ns = u_deadline_sleeper_sleep_until(&mc->sleeper, wake_up_time_ns);
 
 	xrt_comp_mark_frame(xc, frame_id, XRT_COMPOSITOR_FRAME_POINT_WOKE, now_ns);
 
@@ -473,6 +467,28 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 	os_mutex_unlock(&mc->slot_lock);
 }
 
+static xrt_result_t
+multi_compositor_layers(struct xrt_compositor *xc,
+                        struct xrt_device *xdev,
+                        const struct xrt_layer_entry *entries,
+                        uint32_t num_entries)
+{
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	assert(mc->progress.num_layers + num_entries <= MULTI_MAX_LAYERS);
+
+	for (uint32_t i = 0; i < num_entries; i++) {
+		size_t index = mc->progress.num_layers++;
+		mc->progress.layers[index].xdev = xdev;
+		for (size_t k = 0; k < ARRAY_SIZE(entries[i].xscs); k++) {
+			xrt_swapchain_reference(&mc->progress.layers[index].xscs[k], entries[i].xscs[k]);
+		}
+		mc->progress.layers[index].data = entries[i].data;
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 multi_compositor_layer_commit(struct xrt_compositor *xc, int64_t frame_id, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -555,7 +571,7 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 	// Does null checking.
 	u_rt_destroy(&mc->urt);
 
-	os_precise_sleeper_deinit(&mc->sleeper);
+	u_deadline_sleeper_deinit(&mc->sleeper);
 
 	os_mutex_destroy(&mc->slot_lock);
 	os_mutex_destroy(&mc->event.mutex);
@@ -607,6 +623,7 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.layer_cylinder = multi_compositor_layer_cylinder;
 	mc->base.base.layer_equirect1 = multi_compositor_layer_equirect1;
 	mc->base.base.layer_equirect2 = multi_compositor_layer_equirect2;
+	mc->base.base.layers = multi_compositor_layers;
 	mc->base.base.layer_commit = multi_compositor_layer_commit;
 	mc->base.base.destroy = multi_compositor_destroy;
 	mc->base.base.poll_events = multi_compositor_poll_events;
@@ -620,7 +637,7 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.info = msc->xcn->base.info;
 
 	// Using in wait frame.
-	os_precise_sleeper_init(&mc->sleeper);
+	u_deadline_sleeper_init(&mc->sleeper);
 
 	// This is safe to do without a lock since we are not on the list yet.
 	u_rt_create(&mc->urt);
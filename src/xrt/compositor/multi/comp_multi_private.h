@@ -17,6 +17,7 @@
 #include "os/os_threading.h"
 
 #include "util/u_timing.h"
+#include "util/u_deadline.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -101,8 +102,8 @@ struct multi_compositor
 	//! Owning system compositor.
 	struct multi_system_compositor *msc;
 
-	//! Only matters for Windows and in process.
-	struct os_precise_sleeper sleeper;
+	//! Only used for in process clients, IPC clients sleep on their side.
+	struct u_deadline_sleeper sleeper;
 
 	struct
 	{
@@ -200,6 +201,9 @@ struct multi_system_compositor
 	//! Render loop thread.
 	struct os_thread_helper oth;
 
+	//! Sleeps the render loop thread until the predicted wake up time.
+	struct u_deadline_sleeper sleeper;
+
 	/*!
 	 * This mutex protects the list of client compositor
 	 * and the rendering timings on it.
@@ -11,6 +11,7 @@
 #include "xrt/xrt_gfx_native.h"
 
 #include "os/os_time.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -312,7 +313,8 @@ broadcast_timings(struct multi_system_compositor *msc,
 }
 
 static void
-wait_frame(struct xrt_compositor *xc,
+wait_frame(struct multi_system_compositor *msc,
+           struct xrt_compositor *xc,
            int64_t *out_frame_id,
            uint64_t *out_wake_time_ns,
            uint64_t *out_predicted_gpu_time_ns,
@@ -332,12 +334,7 @@ wait_frame(struct xrt_compositor *xc,
 	    out_predicted_display_time_ns,    //
 	    out_predicted_display_period_ns); //
 
-	uint64_t now_ns = os_monotonic_get_ns();
-	if (now_ns < wake_up_time_ns) {
-		os_nanosleep(wake_up_time_ns - now_ns);
-	}
-
-	now_ns = os_monotonic_get_ns();
+	uint64_t now_ns = u_deadline_sleeper_sleep_until(&msc->sleeper, wake_up_time_ns);
 
 	xrt_comp_mark_frame(xc, frame_id, XRT_COMPOSITOR_FRAME_POINT_WOKE, now_ns);
 
@@ -355,6 +352,10 @@ multi_main_loop(struct multi_system_compositor *msc)
 	//! @todo Don't make this a hack.
 	enum xrt_view_type view_type = XRT_VIEW_TYPE_STEREO;
 
+	if (os_thread_role_set(OS_THREAD_ROLE_RENDER, "comp_render") != 0) {
+		U_LOG_W("Could not apply the whole render thread policy, missing CAP_SYS_NICE?");
+	}
+
 	xrt_comp_begin_session(xc, view_type);
 
 	os_thread_helper_lock(&msc->oth);
@@ -368,6 +369,7 @@ multi_main_loop(struct multi_system_compositor *msc)
 		uint64_t predicted_display_period_ns = 0;
 
 		wait_frame(                        //
+		    msc,                           //
 		    xc,                            //
 		    &frame_id,                     //
 		    &wake_time_ns,                 //
@@ -489,6 +491,9 @@ system_compositor_destroy(struct xrt_system_compositor *xsc)
 	// Stop the render thread first.
 	os_thread_helper_stop(&msc->oth);
 
+	u_var_remove_root(msc);
+	u_deadline_sleeper_deinit(&msc->sleeper);
+
 	xrt_comp_native_destroy(&msc->xcn);
 
 	os_mutex_destroy(&msc->list_and_timing_lock);
@@ -526,6 +531,11 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->last_timings.predicted_display_period_ns = U_TIME_1MS_IN_NS * 16; // Just a wild guess.
 	msc->last_timings.diff_ns = U_TIME_1MS_IN_NS * 5;                      // Make sure it's not zero at least.
 
+	u_deadline_sleeper_init(&msc->sleeper);
+
+	u_var_add_root(msc, "Multi compositor", false);
+	u_deadline_sleeper_add_vars(&msc->sleeper, msc);
+
 	int ret = os_thread_helper_init(&msc->oth);
 	if (ret < 0) {
 		return XRT_ERROR_THREADING_INIT_FAILURE;
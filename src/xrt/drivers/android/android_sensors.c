@@ -12,6 +12,10 @@
 
 #include "android_sensors.h"
 
+#include "os/os_time.h"
+#include "os/os_thread_role.h"
+
+#include "util/u_misc.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_var.h"
@@ -74,6 +78,18 @@ android_sensor_callback(int fd, int events, void *data)
 
 			// Now done.
 			os_mutex_unlock(&d->lock);
+
+			// The gyro is in body space.
+			struct xrt_space_relation relation = {0};
+			relation.pose.orientation = d->fusion.rot;
+			math_quat_rotate_derivative(&d->fusion.rot, &gyro, &relation.angular_velocity);
+			//! @todo assuming that orientation is actually currently tracked.
+			relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+			                          XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+			                          XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+			// Event timestamps are not in the monotonic clock domain.
+			m_relation_history_push(d->relation_hist, &relation, os_monotonic_get_ns());
 		}
 		default: ANDROID_TRACE(d, "Unhandled event type %d", event.type);
 		}
@@ -87,6 +103,8 @@ android_run_thread(void *ptr)
 {
 	struct android_device *d = (struct android_device *)ptr;
 
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "android_sensors");
+
 #if __ANDROID_API__ >= 26
 	d->sensor_manager = ASensorManager_getInstanceForPackage(XRT_ANDROID_PACKAGE);
 #else
@@ -139,6 +157,7 @@ android_device_destroy(struct xrt_device *xdev)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&android->fusion);
+	m_relation_history_destroy(&android->relation_hist);
 
 	// Remove the variable tracking.
 	u_var_remove_root(android);
@@ -158,14 +177,10 @@ android_device_get_tracked_pose(struct xrt_device *xdev,
                                 uint64_t at_timestamp_ns,
                                 struct xrt_space_relation *out_relation)
 {
-	(void)at_timestamp_ns;
-
 	struct android_device *d = android_device(xdev);
-	out_relation->pose.orientation = d->fusion.rot;
 
-	//! @todo assuming that orientation is actually currently tracked.
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
-	                                                               XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+	U_ZERO(out_relation);
+	m_relation_history_get(d->relation_hist, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -213,6 +228,7 @@ android_device_create()
 	d->ll = debug_get_log_option_android_log();
 
 	m_imu_3dof_init(&d->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_relation_history_create(&d->relation_hist);
 
 	// Everything done, finally start the thread.
 	int ret = os_thread_helper_start(&d->oth, android_run_thread, d);
@@ -14,6 +14,7 @@
 #include "math/m_api.h"
 #include "math/m_imu_pre.h"
 #include "math/m_imu_3dof.h"
+#include "math/m_relation_history.h"
 
 #include "xrt/xrt_device.h"
 
@@ -46,6 +47,9 @@ struct android_device
 		//! Lock for last and fusion.
 		struct os_mutex lock;
 		struct m_imu_3dof fusion;
+
+		//! Timestamped fusion output, written by the thread, read without the lock.
+		struct m_relation_history *relation_hist;
 	};
 
 	enum u_logging_level ll;
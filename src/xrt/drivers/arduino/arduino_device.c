@@ -15,10 +15,12 @@
 #include "os/os_ble.h"
 #include "os/os_time.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "math/m_api.h"
 #include "math/m_imu_pre.h"
 #include "math/m_imu_3dof.h"
+#include "math/m_relation_history.h"
 
 #include "util/u_var.h"
 #include "util/u_time.h"
@@ -86,6 +88,9 @@ struct arduino_device
 		struct m_imu_pre_filter pre_filter;
 
 		struct m_imu_3dof fusion;
+
+		//! Timestamped fusion output, written by the thread, read without the lock.
+		struct m_relation_history *relation_hist;
 	};
 
 
@@ -156,6 +161,17 @@ update_fusion(struct arduino_device *ad,
 
 	m_imu_3dof_update(&ad->fusion, ad->device_time, &accel, &gyro);
 
+	// The gyro is in body space.
+	struct xrt_space_relation relation = {0};
+	relation.pose.orientation = ad->fusion.rot;
+	math_quat_rotate_derivative(&ad->fusion.rot, &gyro, &relation.angular_velocity);
+	//! @todo assuming that orientation is actually currently tracked.
+	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                          XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+	                          XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+	m_relation_history_push(ad->relation_hist, &relation, timestamp_ns);
+
 	double delta_device_ms = (double)sample->delta / 1000.0;
 	double delta_host_ms = (double)delta_ns / (1000.0 * 1000.0);
 	ARDUINO_DEBUG(ad, "%+fms %+fms", delta_host_ms, delta_device_ms);
@@ -234,6 +250,8 @@ arduino_run_thread(void *ptr)
 	timepoint_ns then_ns, now_ns;
 	struct arduino_parsed_input input; // = {0};
 
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "arduino");
+
 	// wait for a package to sync up, it's discarded but that's okay.
 	if (!arduino_read_one_packet(ad, buffer, 20)) {
 		return NULL;
@@ -271,16 +289,6 @@ arduino_run_thread(void *ptr)
  *
  */
 
-static void
-arduino_get_fusion_pose(struct arduino_device *ad, enum xrt_input_name name, struct xrt_space_relation *out_relation)
-{
-	out_relation->pose.orientation = ad->fusion.rot;
-
-	//! @todo assuming that orientation is actually currently tracked.
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
-	                                                               XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
-}
-
 static void
 arduino_device_destroy(struct xrt_device *xdev)
 {
@@ -297,6 +305,7 @@ arduino_device_destroy(struct xrt_device *xdev)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&ad->fusion);
+	m_relation_history_destroy(&ad->relation_hist);
 
 	// Does null checking and zeros.
 	os_ble_destroy(&ad->ble);
@@ -335,8 +344,8 @@ arduino_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct arduino_device *ad = arduino_device(xdev);
 
-	(void)at_timestamp_ns;
-	arduino_get_fusion_pose(ad, name, out_relation);
+	U_ZERO(out_relation);
+	m_relation_history_get(ad->relation_hist, at_timestamp_ns, out_relation);
 }
 
 
@@ -398,6 +407,7 @@ arduino_device_create(struct os_ble_device *ble)
 	ad->ll = debug_get_log_option_arduino_log();
 
 	m_imu_3dof_init(&ad->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_300MS);
+	m_relation_history_create(&ad->relation_hist);
 
 #define DEG_TO_RAD ((double)M_PI / 180.0)
 	float accel_ticks_to_float = (4.0 * MATH_GRAVITY_M_S2) / INT16_MAX;
@@ -12,6 +12,7 @@
 #include "xrt/xrt_tracking.h"
 
 #include "os/os_time.h"
+#include "os/os_thread_role.h"
 
 #include "math/m_api.h"
 #include "tracking/t_imu.h"
@@ -106,6 +107,17 @@ update_fusion(struct daydream_device *dd,
 	DAYDREAM_DEBUG(dd, "-");
 
 	m_imu_3dof_update(&dd->fusion, timestamp_ns, &accel, &gyro);
+
+	// The gyro is in body space.
+	struct xrt_space_relation relation = {0};
+	relation.pose.orientation = dd->fusion.rot;
+	math_quat_rotate_derivative(&dd->fusion.rot, &gyro, &relation.angular_velocity);
+	//! @todo assuming that orientation is actually currently tracked.
+	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                          XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+	                          XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+	m_relation_history_push(dd->relation_hist, &relation, timestamp_ns);
 }
 
 static int
@@ -189,6 +201,8 @@ daydream_run_thread(void *ptr)
 	uint8_t buffer[20];
 	struct daydream_parsed_input input; // = {0};
 
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "daydream");
+
 	// wait for a package to sync up, it's discarded but that's okay.
 	if (!daydream_read_one_packet(daydream, buffer, 20)) {
 		// Does null checking and sets to null.
@@ -237,18 +251,6 @@ daydream_get_calibration(struct daydream_device *daydream)
  *
  */
 
-static void
-daydream_get_fusion_pose(struct daydream_device *daydream,
-                         enum xrt_input_name name,
-                         struct xrt_space_relation *out_relation)
-{
-	out_relation->pose.orientation = daydream->fusion.rot;
-
-	//! @todo assuming that orientation is actually currently tracked.
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
-	                                                               XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
-}
-
 static void
 daydream_device_destroy(struct xrt_device *xdev)
 {
@@ -262,6 +264,7 @@ daydream_device_destroy(struct xrt_device *xdev)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&daydream->fusion);
+	m_relation_history_destroy(&daydream->relation_hist);
 
 	// Remove the variable tracking.
 	u_var_remove_root(daydream);
@@ -315,8 +318,8 @@ daydream_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct daydream_device *daydream = daydream_device(xdev);
 
-	(void)at_timestamp_ns;
-	daydream_get_fusion_pose(daydream, name, out_relation);
+	U_ZERO(out_relation);
+	m_relation_history_get(daydream->relation_hist, at_timestamp_ns, out_relation);
 }
 
 
@@ -381,6 +384,7 @@ daydream_device_create(struct os_ble_device *ble)
 	float gyro_ticks_to_float = 1.0 / 120.0;
 	m_imu_pre_filter_init(&dd->pre_filter, accel_ticks_to_float, gyro_ticks_to_float);
 	m_imu_3dof_init(&dd->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_300MS);
+	m_relation_history_create(&dd->relation_hist);
 
 	daydream_get_calibration(dd);
 
@@ -12,6 +12,7 @@
 #include "math/m_api.h"
 #include "math/m_imu_pre.h"
 #include "math/m_imu_3dof.h"
+#include "math/m_relation_history.h"
 
 #include "xrt/xrt_device.h"
 
@@ -84,6 +85,9 @@ struct daydream_device
 
 		struct m_imu_pre_filter pre_filter;
 		struct m_imu_3dof fusion;
+
+		//! Timestamped fusion output, written by the thread, read without the lock.
+		struct m_relation_history *relation_hist;
 	};
 
 	enum u_logging_level ll;
@@ -10,6 +10,7 @@
 
 #include "os/os_time.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -179,6 +180,8 @@ depthai_mainloop(void *ptr)
 	struct depthai_fs *depthai = (struct depthai_fs *)ptr;
 	DEPTHAI_DEBUG(depthai, "DepthAI: Mainloop called");
 
+	os_thread_role_set(OS_THREAD_ROLE_CAMERA, "depthai");
+
 	os_thread_helper_lock(&depthai->play_thread);
 	while (os_thread_helper_is_running_locked(&depthai->play_thread)) {
 		os_thread_helper_unlock(&depthai->play_thread);
@@ -9,9 +9,11 @@
 
 #include "xrt/xrt_tracking.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 #include "util/u_debug.h"
 #include "util/u_logging.h"
 #include "util/u_misc.h"
+#include "util/u_time.h"
 #include "util/u_var.h"
 #include "tracking/t_frame_cv_mat_wrapper.hpp"
 #include "math/m_filter_fifo.h"
@@ -19,8 +21,12 @@
 #include "euroc_interface.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #define EUROC_PLAYER_STR "Euroc Player"
 #define CLAMP(X, A, B) (MIN(MAX((X), (A)), (B)))
@@ -42,12 +48,19 @@
 #define EUROC_ASSERT_(predicate) EUROC_ASSERT(predicate, "Assertion failed " #predicate)
 
 DEBUG_GET_ONCE_LOG_OPTION(euroc_log, "EUROC_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(euroc_max_speed, "EUROC_MAX_SPEED", false)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_max_speed_wait_ms, "EUROC_MAX_SPEED_WAIT_MS", 1000)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_prefetch_frames, "EUROC_PREFETCH_FRAMES", 8)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_prefetch_threads, "EUROC_PREFETCH_THREADS", 2)
+DEBUG_GET_ONCE_BOOL_OPTION(euroc_preload_all, "EUROC_PRELOAD_ALL", false)
 
 
 typedef std::pair<timepoint_ns, std::string> img_sample;
 typedef std::vector<xrt_imu_sample> imu_samples;
 typedef std::vector<img_sample> img_samples;
 
+struct euroc_prefetcher;
+
 enum euroc_player_ui_state
 {
 	UNINITIALIZED = 0,
@@ -101,6 +114,9 @@ struct euroc_player
 	img_samples *left_imgs;  //!< List of all image names to read from the dataset
 	img_samples *right_imgs; //!< List of all image names to read from the dataset
 
+	//! Decodes images ahead of playback, only alive while the play thread runs
+	struct euroc_prefetcher *prefetcher;
+
 	// Timestamp correction fields
 	timepoint_ns base_ts;   //!< First imu0 timestamp, samples timestamps are relative to this
 	timepoint_ns start_ts;  //!< When did the dataset started to be played
@@ -118,8 +134,20 @@ struct euroc_player
 		float speed;              //!< Intended reproduction speed, could be slower due to read times
 		bool send_all_imus_first; //!< If enabled all imu samples will be sent before img samples
 		bool paused;              //!< Whether to pause the playback
+
+		//! Don't sleep between samples, only wait for consumers to release
+		//! the previously pushed frame before pushing the next one
+		bool max_speed;
+		int32_t max_speed_wait_ms; //!< Longest time to wait for consumers on each frame
+		int32_t prefetch_frames;   //!< Stereo pairs to decode ahead of playback, 0 disables (set at start)
+		int32_t prefetch_threads;  //!< Threads decoding images ahead of playback (set at start)
+		bool preload_all;          //!< Decode the whole dataset into memory before playing (set at start)
 	} playback;
 
+	//! Last pushed left frame, only kept around in max speed mode
+	struct xrt_frame *last_pushed_xf;
+	bool warned_max_speed_wait;
+
 	// UI related fields
 	enum euroc_player_ui_state ui_state;
 	struct u_var_button start_btn;
@@ -305,21 +333,14 @@ euroc_player_mapped_ts(struct euroc_player *ep, timepoint_ns relative_ts)
 	return mapped_ts;
 }
 
-static void
-euroc_player_load_next_frame(struct euroc_player *ep, bool is_left, struct xrt_frame *&xf)
+//! Read an image from disk as requested by the playback options
+static cv::Mat
+euroc_player_load_image(struct euroc_player *ep, const std::string &img_name)
 {
-	using xrt::auxiliary::tracking::FrameMat;
-	img_sample sample = is_left ? ep->left_imgs->at(ep->img_seq) : ep->right_imgs->at(ep->img_seq);
-	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
-
 	// Load will be influenced by these playback options
 	bool use_color = ep->playback.color;
 	float scale = ep->playback.scale;
 
-	// Load image from disk
-	timepoint_ns timestamp = euroc_player_mapped_ts(ep, sample.first);
-	std::string img_name = sample.second;
-	EUROC_TRACE(ep, "%s img t = %ld filename = %s", is_left ? "left" : "right", timestamp, img_name.c_str());
 	cv::ImreadModes read_mode = use_color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
 	cv::Mat img = cv::imread(img_name, read_mode);
 
@@ -329,6 +350,17 @@ euroc_player_load_next_frame(struct euroc_player *ep, bool is_left, struct xrt_f
 		img = tmp;
 	}
 
+	return img;
+}
+
+static void
+euroc_player_wrap_frame(struct euroc_player *ep, bool is_left, cv::Mat img, struct xrt_frame *&xf)
+{
+	using xrt::auxiliary::tracking::FrameMat;
+	img_sample sample = is_left ? ep->left_imgs->at(ep->img_seq) : ep->right_imgs->at(ep->img_seq);
+	timepoint_ns timestamp = euroc_player_mapped_ts(ep, sample.first);
+	EUROC_TRACE(ep, "%s img t = %ld filename = %s", is_left ? "left" : "right", timestamp, sample.second.c_str());
+
 	// Create xrt_frame, it will be freed by FrameMat destructor
 	EUROC_ASSERT(xf == nullptr || xf->reference.count > 0, "Must be given a valid or nullptr frame ptr");
 	EUROC_ASSERT(timestamp > 0, "Unexpected negative timestamp");
@@ -342,6 +374,207 @@ euroc_player_load_next_frame(struct euroc_player *ep, bool is_left, struct xrt_f
 	xf->source_id = ep->base.source_id;
 }
 
+
+// Prefetching functionality
+
+/*!
+ * A stereo pair decoded ahead of time, indexed by its image sequence number.
+ */
+struct euroc_prefetch_slot
+{
+	uint64_t img_seq;
+	bool ready;
+	cv::Mat left;
+	cv::Mat right;
+};
+
+/*!
+ * Decodes the next few stereo pairs on a pool of threads so the play thread
+ * only has to wrap and push them. Workers never get further ahead of the play
+ * thread than the number of slots, which also bounds the memory used.
+ */
+struct euroc_prefetcher
+{
+	std::mutex mutex;
+	std::condition_variable decoded_cv; //!< Signaled by workers when a slot is ready
+	std::condition_variable space_cv;   //!< Signaled by the play thread when a slot is freed
+	std::vector<std::thread> workers;
+	std::vector<euroc_prefetch_slot> slots;
+
+	uint64_t next_decode; //!< Next image sequence number to give to a worker
+	uint64_t next_take;   //!< Next image sequence number the play thread will take
+	uint64_t end;         //!< One past the last image sequence number to decode
+	uint64_t decoded;     //!< Number of pairs decoded so far
+	bool stereo;
+	bool stop;
+};
+
+static void
+euroc_prefetcher_worker(struct euroc_player *ep, struct euroc_prefetcher *pf)
+{
+	std::unique_lock<std::mutex> lock(pf->mutex);
+
+	while (true) {
+		pf->space_cv.wait(lock, [pf] {
+			return pf->stop ||
+			       (pf->next_decode < pf->end && pf->next_decode < pf->next_take + pf->slots.size());
+		});
+
+		if (pf->stop) {
+			return;
+		}
+
+		uint64_t seq = pf->next_decode++;
+		bool stereo = pf->stereo;
+		lock.unlock();
+
+		cv::Mat left = euroc_player_load_image(ep, ep->left_imgs->at(seq).second);
+		cv::Mat right;
+		if (stereo) {
+			right = euroc_player_load_image(ep, ep->right_imgs->at(seq).second);
+		}
+
+		lock.lock();
+		euroc_prefetch_slot &slot = pf->slots[seq % pf->slots.size()];
+		slot.img_seq = seq;
+		slot.ready = true;
+		slot.left = left;
+		slot.right = right;
+		pf->decoded++;
+		pf->decoded_cv.notify_all();
+	}
+}
+
+static void
+euroc_prefetcher_start(struct euroc_player *ep)
+{
+	uint64_t remaining = ep->left_imgs->size() - ep->img_seq;
+	uint64_t num_slots = ep->playback.preload_all ? remaining : (uint64_t)MAX(ep->playback.prefetch_frames, 0);
+	if (num_slots == 0) {
+		return;
+	}
+
+	struct euroc_prefetcher *pf = new euroc_prefetcher{};
+	pf->slots.resize(num_slots);
+	pf->next_decode = ep->img_seq;
+	pf->next_take = ep->img_seq;
+	pf->end = ep->left_imgs->size();
+	pf->stereo = ep->playback.stereo;
+
+	int32_t num_threads = CLAMP(ep->playback.prefetch_threads, 1, 64);
+	for (int32_t i = 0; i < num_threads; i++) {
+		pf->workers.emplace_back(euroc_prefetcher_worker, ep, pf);
+	}
+
+	ep->prefetcher = pf;
+
+	if (ep->playback.preload_all) {
+		EUROC_INFO(ep, "Preloading %" PRIu64 " frames", remaining);
+		std::unique_lock<std::mutex> lock(pf->mutex);
+		// Workers signal every decoded frame, so a stop is noticed within one frame.
+		pf->decoded_cv.wait(lock, [ep, pf, remaining] { return pf->decoded == remaining || !ep->is_running; });
+	}
+}
+
+static void
+euroc_prefetcher_stop(struct euroc_player *ep)
+{
+	struct euroc_prefetcher *pf = ep->prefetcher;
+	if (pf == nullptr) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(pf->mutex);
+		pf->stop = true;
+		pf->space_cv.notify_all();
+	}
+
+	for (std::thread &worker : pf->workers) {
+		worker.join();
+	}
+
+	delete pf;
+	ep->prefetcher = nullptr;
+}
+
+//! Take the decoded pair for `ep->img_seq`, waiting for a worker if needed
+static void
+euroc_prefetcher_take(struct euroc_player *ep, cv::Mat &left, cv::Mat &right)
+{
+	struct euroc_prefetcher *pf = ep->prefetcher;
+	uint64_t seq = ep->img_seq;
+
+	std::unique_lock<std::mutex> lock(pf->mutex);
+	euroc_prefetch_slot &slot = pf->slots[seq % pf->slots.size()];
+	pf->decoded_cv.wait(lock, [&slot, seq] { return slot.ready && slot.img_seq == seq; });
+
+	left = slot.left;
+	right = slot.right;
+	slot.ready = false;
+	slot.left.release();
+	slot.right.release();
+
+	pf->next_take = seq + 1;
+	pf->space_cv.notify_all();
+}
+
+static void
+euroc_player_load_next_frames(struct euroc_player *ep,
+                              bool stereo,
+                              struct xrt_frame *&left_xf,
+                              struct xrt_frame *&right_xf)
+{
+	// Prefetch workers read this concurrently, so only clamp it here
+	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
+
+	cv::Mat left;
+	cv::Mat right;
+
+	if (ep->prefetcher != nullptr) {
+		euroc_prefetcher_take(ep, left, right);
+	} else {
+		left = euroc_player_load_image(ep, ep->left_imgs->at(ep->img_seq).second);
+		if (stereo) {
+			right = euroc_player_load_image(ep, ep->right_imgs->at(ep->img_seq).second);
+		}
+	}
+
+	euroc_player_wrap_frame(ep, true, left, left_xf);
+	if (stereo) {
+		euroc_player_wrap_frame(ep, false, right, right_xf);
+	}
+}
+
+//! In max speed mode, wait for consumers to be done with the last pushed
+//! frame, this is what paces the playback instead of the timestamps
+static void
+euroc_player_wait_for_consumers(struct euroc_player *ep)
+{
+	struct xrt_frame *xf = ep->last_pushed_xf;
+	if (xf == nullptr) {
+		return;
+	}
+
+	timepoint_ns max_wait_ns = (timepoint_ns)MAX(ep->playback.max_speed_wait_ms, 0) * U_TIME_1MS_IN_NS;
+	timepoint_ns start = os_monotonic_get_ts();
+
+	// We hold the only remaining reference once every consumer is done.
+	while (xf->reference.count > 1 && ep->is_running) {
+		if (os_monotonic_get_ts() - start >= max_wait_ns) {
+			if (!ep->warned_max_speed_wait) {
+				EUROC_WARN(ep, "Consumers held on to a frame for over %dms, they might keep the latest frame",
+				           ep->playback.max_speed_wait_ms);
+				ep->warned_max_speed_wait = true;
+			}
+			break;
+		}
+		os_nanosleep(50 * 1000);
+	}
+
+	xrt_frame_reference(&ep->last_pushed_xf, NULL);
+}
+
 static bool
 euroc_player_is_imu_next(struct euroc_player *ep)
 {
@@ -372,20 +605,28 @@ euroc_player_push_next_sample(struct euroc_player *ep)
 
 	// Push next frame(s)
 	struct xrt_frame *left_xf = NULL, *right_xf = NULL;
-	euroc_player_load_next_frame(ep, true, left_xf);
+	euroc_player_load_next_frames(ep, stereo, left_xf, right_xf);
 	if (stereo) {
 		// TODO: Some SLAM systems expect synced frames, but that's not an
 		// EuRoC requirement. Adapt to work with unsynced datasets too.
-		euroc_player_load_next_frame(ep, false, right_xf);
 		EUROC_ASSERT(left_xf->timestamp == right_xf->timestamp, "Unsynced stereo frames");
 	}
 	ep->img_seq++;
 
+	if (ep->playback.max_speed) {
+		euroc_player_wait_for_consumers(ep);
+	}
+
 	xrt_sink_push_frame(ep->left_sink, left_xf);
 	if (stereo) {
 		xrt_sink_push_frame(ep->right_sink, left_xf);
 	}
 
+	// Keep the left frame to know when consumers are done with it.
+	if (ep->playback.max_speed) {
+		xrt_frame_reference(&ep->last_pushed_xf, left_xf);
+	}
+
 	// We are now done with the frames, unreference them so
 	// they can be freed if all consumers are done with them.
 	xrt_frame_reference(&left_xf, NULL);
@@ -395,7 +636,7 @@ euroc_player_push_next_sample(struct euroc_player *ep)
 	         ep->left_imgs->size(), ep->imu_seq, ep->imus->size());
 
 	// Determine how much to sleep until next frame
-	if (ep->img_seq >= ep->left_imgs->size()) {
+	if (ep->img_seq >= ep->left_imgs->size() || ep->playback.max_speed) {
 		return;
 	}
 	timepoint_ns next_frame_ts = euroc_player_mapped_ts(ep, ep->left_imgs->at(ep->img_seq).first);
@@ -415,7 +656,11 @@ euroc_player_is_paused(struct euroc_player *ep)
 	os_nanosleep(200 * 1000 * 1000);
 	timepoint_ns pos_pause = os_monotonic_get_ts();
 	timepoint_ns pause_length = pos_pause - pre_pause;
-	ep->offset_ts += pause_length;
+
+	// Timestamps aren't tied to the wall clock at max speed
+	if (!ep->playback.max_speed) {
+		ep->offset_ts += pause_length;
+	}
 	return true;
 }
 
@@ -424,10 +669,12 @@ euroc_player_mainloop(void *ptr)
 {
 	struct xrt_fs *xfs = (struct xrt_fs *)ptr;
 	struct euroc_player *ep = euroc_player(xfs);
+	os_thread_role_set(OS_THREAD_ROLE_CAMERA, "euroc");
 	EUROC_INFO(ep, "Starting euroc playback");
 
 	euroc_player_preload(ep);
 	euroc_player_user_skip(ep);
+	euroc_prefetcher_start(ep);
 
 	ep->start_ts = os_monotonic_get_ts();
 
@@ -445,6 +692,9 @@ euroc_player_mainloop(void *ptr)
 		more_imgs = ep->img_seq < ep->left_imgs->size();
 	}
 
+	euroc_prefetcher_stop(ep);
+	xrt_frame_reference(&ep->last_pushed_xf, NULL);
+
 	EUROC_INFO(ep, "Euroc dataset playback finished");
 	euroc_player_set_ui_state(ep, STREAM_ENDED);
 
@@ -660,6 +910,11 @@ euroc_player_setup_gui(struct euroc_player *ep)
 	u_var_add_f32(ep, &ep->playback.scale, "Scale");
 	u_var_add_f32(ep, &ep->playback.speed, "Speed (set at start)");
 	u_var_add_bool(ep, &ep->playback.send_all_imus_first, "Send all IMU samples now");
+	u_var_add_bool(ep, &ep->playback.max_speed, "As fast as consumers allow");
+	u_var_add_i32(ep, &ep->playback.max_speed_wait_ms, "Max wait for consumers (ms)");
+	u_var_add_i32(ep, &ep->playback.prefetch_frames, "Frames to decode ahead (set at start)");
+	u_var_add_i32(ep, &ep->playback.prefetch_threads, "Decoding threads (set at start)");
+	u_var_add_bool(ep, &ep->playback.preload_all, "Preload all frames to RAM (set at start)");
 
 	u_var_add_gui_header(ep, NULL, "Streams");
 	u_var_add_ro_ff_vec3_f32(ep, ep->gyro_ff, "Gyroscope");
@@ -695,6 +950,11 @@ euroc_player_create(struct xrt_frame_context *xfctx, const char *path)
 	ep->playback.scale = 1.0;
 	ep->playback.speed = 1.0;
 	ep->playback.send_all_imus_first = false;
+	ep->playback.max_speed = debug_get_bool_option_euroc_max_speed();
+	ep->playback.max_speed_wait_ms = debug_get_num_option_euroc_max_speed_wait_ms();
+	ep->playback.prefetch_frames = debug_get_num_option_euroc_prefetch_frames();
+	ep->playback.prefetch_threads = debug_get_num_option_euroc_prefetch_threads();
+	ep->playback.preload_all = debug_get_bool_option_euroc_preload_all();
 
 	ep->ll = debug_get_log_option_euroc_log();
 	euroc_player_setup_gui(ep);
@@ -27,6 +27,7 @@
 
 #include "os/os_hid.h"
 #include "os/os_time.h"
+#include "os/os_thread_role.h"
 
 #include "math/m_api.h"
 
@@ -99,8 +100,8 @@ hdk_device_destroy(struct xrt_device *xdev)
 
 	os_thread_helper_destroy(&hd->imu_thread);
 
-	// Now that the thread is not running we can destroy the lock.
-	os_mutex_destroy(&hd->lock);
+	// Now that the thread is not running we can destroy the snapshot.
+	u_snapshot_destroy(&hd->snapshot);
 
 	if (hd->dev != NULL) {
 		os_hid_destroy(hd->dev);
@@ -133,13 +134,15 @@ hdk_device_update(struct hdk_device *hd)
 			          __func__);
 			hd->disconnect_notified = true;
 		}
-		hd->quat_valid = false;
+		hd->state.quat_valid = false;
+		u_snapshot_publish(hd->snapshot, &hd->state);
 		return 0;
 	}
 	while (bytesRead > 0) {
 		if (bytesRead != MSG_LEN_LARGE && bytesRead != MSG_LEN_SMALL) {
 			HDK_DEBUG(hd, "Only got %d bytes", bytesRead);
-			hd->quat_valid = false;
+			hd->state.quat_valid = false;
+			u_snapshot_publish(hd->snapshot, &hd->state);
 			return 1;
 		}
 		bytesRead = os_hid_read(hd->dev, buffer, sizeof(buffer), 0);
@@ -185,7 +188,7 @@ hdk_device_update(struct hdk_device *hd)
 	// Fix that 90
 	math_quat_rotate(&negative_90_about_y, &quat, &quat);
 
-	hd->quat = quat;
+	hd->state.quat = quat;
 
 	/// @todo might not be accurate on some version 1 reports??
 
@@ -207,11 +210,10 @@ hdk_device_update(struct hdk_device *hd)
 	math_quat_rotate(&ang_vel_quat, &rot_90_about_x, &ang_vel_quat);
 	math_quat_rotate(&negative_90_about_x, &ang_vel_quat, &ang_vel_quat);
 
-	os_mutex_lock(&hd->lock);
-	hd->ang_vel_quat = ang_vel_quat;
+	hd->state.ang_vel_quat = ang_vel_quat;
+	hd->state.quat_valid = true;
 
-	hd->quat_valid = true;
-	os_mutex_unlock(&hd->lock);
+	u_snapshot_publish(hd->snapshot, &hd->state);
 
 	return 1;
 }
@@ -234,28 +236,25 @@ hdk_device_get_tracked_pose(struct xrt_device *xdev,
 	// Adjusting for latency - 14ms, found empirically.
 	now -= 14000000;
 
-	os_mutex_lock(&hd->lock);
-	if (!hd->quat_valid) {
+	struct hdk_state state;
+	if (!u_snapshot_read(hd->snapshot, &state) || !state.quat_valid) {
 		out_relation->relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
 		HDK_TRACE(hd, "GET_TRACKED_POSE: No pose");
-		os_mutex_unlock(&hd->lock);
 		return;
 	}
 
-	out_relation->pose.orientation = hd->quat;
+	out_relation->pose.orientation = state.quat;
 
-	out_relation->angular_velocity.x = hd->ang_vel_quat.x;
-	out_relation->angular_velocity.y = hd->ang_vel_quat.y;
-	out_relation->angular_velocity.z = hd->ang_vel_quat.z;
-
-	os_mutex_unlock(&hd->lock);
+	out_relation->angular_velocity.x = state.ang_vel_quat.x;
+	out_relation->angular_velocity.y = state.ang_vel_quat.y;
+	out_relation->angular_velocity.z = state.ang_vel_quat.z;
 
 	out_relation->relation_flags = xrt_space_relation_flags(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
 	                                                        XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT |
 	                                                        XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
 
-	HDK_TRACE(hd, "GET_TRACKED_POSE (%f, %f, %f, %f) ANG_VEL (%f, %f, %f)", hd->quat.x, hd->quat.y, hd->quat.z,
-	          hd->quat.w, hd->ang_vel_quat.x, hd->ang_vel_quat.y, hd->ang_vel_quat.z);
+	HDK_TRACE(hd, "GET_TRACKED_POSE (%f, %f, %f, %f) ANG_VEL (%f, %f, %f)", state.quat.x, state.quat.y,
+	          state.quat.z, state.quat.w, state.ang_vel_quat.x, state.ang_vel_quat.y, state.ang_vel_quat.z);
 }
 
 static void
@@ -273,6 +272,8 @@ hdk_device_run_thread(void *ptr)
 {
 	struct hdk_device *hd = hdk_device((struct xrt_device *)ptr);
 
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "hdk_imu");
+
 	os_thread_helper_lock(&hd->imu_thread);
 	while (os_thread_helper_is_running_locked(&hd->imu_thread)) {
 		os_thread_helper_unlock(&hd->imu_thread);
@@ -478,16 +479,11 @@ hdk_device_create(struct os_hid_device *dev, enum HDK_VARIANT variant)
 	// XRT_DISTORTION_MODEL_PANOTOOLS;
 	// }
 
-	if (hd->dev) {
-		// Mutex before thread.
-		int ret = os_mutex_init(&hd->lock);
-		if (ret != 0) {
-			HDK_ERROR(hd, "Failed to init mutex!");
-			hdk_device_destroy(&hd->base);
-			return NULL;
-		}
+	// Snapshot before thread.
+	u_snapshot_create(sizeof(struct hdk_state), &hd->snapshot);
 
-		ret = os_thread_helper_start(&hd->imu_thread, hdk_device_run_thread, hd);
+	if (hd->dev) {
+		int ret = os_thread_helper_start(&hd->imu_thread, hdk_device_run_thread, hd);
 		if (ret != 0) {
 			HDK_ERROR(hd, "Failed to start mainboard thread!");
 			hdk_device_destroy((struct xrt_device *)hd);
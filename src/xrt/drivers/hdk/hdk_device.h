@@ -11,6 +11,7 @@
 #pragma once
 
 #include "os/os_threading.h"
+#include "util/u_snapshot.h"
 #include "util/u_logging.h"
 
 #ifdef __cplusplus
@@ -25,6 +26,16 @@ enum HDK_VARIANT
 	HDK_VARIANT_2
 };
 
+/*!
+ * State read by get_tracked_pose, published by the imu thread.
+ */
+struct hdk_state
+{
+	struct xrt_quat quat;
+	struct xrt_quat ang_vel_quat;
+	bool quat_valid;
+};
+
 /*!
  * @implements xrt_device
  */
@@ -35,14 +46,15 @@ struct hdk_device
 	enum HDK_VARIANT variant;
 
 	struct os_thread_helper imu_thread;
-	struct os_mutex lock;
+
+	//! Latest @ref hdk_state, read without a lock.
+	struct u_snapshot *snapshot;
 
 	enum u_logging_level ll;
 	bool disconnect_notified;
 
-	struct xrt_quat quat;
-	struct xrt_quat ang_vel_quat;
-	bool quat_valid;
+	//! Only touched by the imu thread, published after each report.
+	struct hdk_state state;
 };
 
 static inline struct hdk_device *
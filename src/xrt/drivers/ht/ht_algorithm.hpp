@@ -12,6 +12,7 @@
 #include "ht_driver.hpp"
 
 #include "util/u_frame.h"
+#include "os/os_thread_role.h"
 
 #include "ht_image_math.hpp"
 #include "ht_models.hpp"
@@ -45,13 +46,13 @@ errHistory2D(HandHistory2DBBox *past, Palm7KP *present)
 	        m_vec2_len(*past->middle_unfiltered[0] - present->kps[MIDDLE_7KP]));
 }
 
-static std::vector<Hand2D>
-htImageToKeypoints(struct ht_view *htv)
+/*!
+ * Runs the palm detector on the view and matches the palms to the existing
+ * bbox histories, adding new histories and pruning stale ones.
+ */
+static void
+htDetectAndMatchHands(struct ht_view *htv)
 {
-	int view = htv->view;
-	struct ht_device *htd = htv->htd;
-
-
 	cv::Mat raw_input = htv->run_model_on_this;
 
 	// Get a list of palms - drop confidences and ssd bounding boxes, just keypoints.
@@ -112,20 +113,52 @@ htImageToKeypoints(struct ht_view *htv)
 			bob--;
 		}
 	}
-	if (htv->bbox_histories.size() == 0) {
-		return {}; // bail early
-	}
+}
 
+/*!
+ * Finds the hands in the view and fills in @p htv->keypoint_crops and
+ * @p htv->crop_warps for the keypoint model to run on.
+ */
+static void
+htImageToCrops(struct ht_view *htv)
+{
+	struct ht_device *htd = htv->htd;
 
+	htv->keypoint_crops.clear();
+	htv->crop_warps.clear();
+
+	int interval = htd->runtime_config.palm_detection_interval;
+	bool run_detection = interval <= 1 || htv->bbox_histories.empty() ||
+	                     htv->frames_since_detection + 1 >= interval;
+
+	// Hands the keypoint model lost last frame need the palm detector to find them again.
+	if (interval > 1) {
+		for (size_t i = 0; i < htv->bbox_histories.size();) {
+			if (htv->bbox_histories[i].lost) {
+				htv->bbox_histories.erase(htv->bbox_histories.begin() + i);
+				run_detection = true;
+			} else {
+				i++;
+			}
+		}
+	}
 
-	std::vector<Hand2D> list_of_hands_in_bbox(
-	    htv->bbox_histories.size()); // all of these are same size as htv->bbox_histories
+	if (run_detection) {
+		htDetectAndMatchHands(htv);
+		htv->frames_since_detection = 0;
+	} else {
+		// Crops come from last frame's keypoints.
+		htv->frames_since_detection++;
+	}
 
-	std::vector<std::future<Hand2D>> await_list_of_hand_in_bbox; //(htv->bbox_histories.size());
+	cv::Mat raw_input = htv->run_model_on_this;
 
-	std::vector<DetectionModelOutput> blah(htv->bbox_histories.size());
+	if (htv->bbox_histories.size() == 0) {
+		return; // bail early
+	}
 
-	std::vector<Hand2D> output;
+	std::vector<DetectionModelOutput> &blah = htv->crop_warps;
+	blah.resize(htv->bbox_histories.size());
 
 	if (htv->bbox_histories.size() > 2) {
 		HT_DEBUG(htd, "More than two hands (%zu) in 2D view %i", htv->bbox_histories.size(), htv->view);
@@ -149,15 +182,25 @@ htImageToKeypoints(struct ht_view *htv)
 
 		warpAffine(raw_input, hand_rect, blah[i].warp_there, hand_rect.size());
 
-		await_list_of_hand_in_bbox.push_back(
-		    std::async(std::launch::async, htd->views[view].run_keypoint_model, &htd->views[view], hand_rect));
+		htv->keypoint_crops.push_back(hand_rect);
 	}
+}
+
+/*!
+ * Takes the keypoint model output for each of the crops made by
+ * @ref htImageToCrops and turns them into rays in the view.
+ */
+static std::vector<Hand2D>
+htCropKeypointsToRays(struct ht_view *htv, const Hand2D *list_of_hands_in_bbox)
+{
+	struct ht_device *htd = htv->htd;
+	std::vector<DetectionModelOutput> &blah = htv->crop_warps;
 
-	// cut here
+	std::vector<Hand2D> output;
 
-	for (size_t i = 0; i < htv->bbox_histories.size(); i++) {
+	for (size_t i = 0; i < htv->keypoint_crops.size(); i++) {
 
-		Hand2D in_bbox = await_list_of_hand_in_bbox[i].get();
+		Hand2D in_bbox = list_of_hands_in_bbox[i];
 
 		cv::Matx23f warp_back = blah[i].warp_back;
 
@@ -187,6 +230,15 @@ htImageToKeypoints(struct ht_view *htv)
 		xrt_vec2 middle_in_px_coords = {in_image_px_coords.kps[MIDL_PXM].x, in_image_px_coords.kps[MIDL_PXM].y};
 		xrt_vec2 wrist_in_px_coords = {in_image_px_coords.kps[WRIST].x, in_image_px_coords.kps[WRIST].y};
 		xrt_vec2 dontuse;
+
+		if (htd->runtime_config.palm_detection_interval > 1) {
+			// The next frame's crop comes from these unless the palm detector runs.
+			HandHistory2DBBox *hist = &htv->bbox_histories[i];
+			hist->wrist_unfiltered.push(wrist_in_px_coords);
+			hist->middle_unfiltered.push(middle_in_px_coords);
+			hist->lost = in_bbox.confidence < htd->runtime_config.keypoint_min_confidence;
+		}
+
 		m_filter_euro_vec2_run(&htv->bbox_histories[i].m_filter_wrist, htv->htd->current_frame_timestamp,
 		                       &wrist_in_px_coords, &dontuse);
 
@@ -281,6 +333,52 @@ htBailThisFrame(struct ht_device *htd)
 	os_mutex_unlock(&htd->openxr_hand_data_mediator);
 }
 
+static void *
+htViewWorkerMainloop(void *ptr)
+{
+	struct ht_device *htd = (struct ht_device *)ptr;
+	struct os_thread_helper *oth = &htd->view_worker.oth;
+
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "ht_view_worker");
+
+	os_thread_helper_lock(oth);
+	while (os_thread_helper_is_running_locked(oth)) {
+		if (!htd->view_worker.has_work) {
+			os_thread_helper_wait_locked(oth);
+			continue;
+		}
+
+		os_thread_helper_unlock(oth);
+		htImageToCrops(&htd->views[1]);
+		os_thread_helper_lock(oth);
+
+		htd->view_worker.has_work = false;
+		os_thread_helper_signal_locked(oth);
+	}
+	os_thread_helper_unlock(oth);
+
+	return NULL;
+}
+
+static void
+htFindHandsInBothViews(struct ht_device *htd)
+{
+	struct os_thread_helper *oth = &htd->view_worker.oth;
+
+	os_thread_helper_lock(oth);
+	htd->view_worker.has_work = true;
+	os_thread_helper_signal_locked(oth);
+	os_thread_helper_unlock(oth);
+
+	htImageToCrops(&htd->views[0]);
+
+	os_thread_helper_lock(oth);
+	while (htd->view_worker.has_work) {
+		os_thread_helper_wait_locked(oth);
+	}
+	os_thread_helper_unlock(oth);
+}
+
 int64_t last_frame, this_frame;
 
 static void
@@ -318,12 +416,18 @@ htRunAlgorithm(struct ht_device *htd)
 		    htd->camera.one_view_size_px.w, 0, htd->camera.one_view_size_px.w, htd->camera.one_view_size_px.h));
 	}
 
-	std::future<std::vector<Hand2D>> future_left =
-	    std::async(std::launch::async, htImageToKeypoints, &htd->views[0]);
-	std::future<std::vector<Hand2D>> future_right =
-	    std::async(std::launch::async, htImageToKeypoints, &htd->views[1]);
-	std::vector<Hand2D> hands_in_left_view = future_left.get();
-	std::vector<Hand2D> hands_in_right_view = future_right.get();
+	htFindHandsInBothViews(htd);
+
+	// Run the keypoint model on the hands from both views at once.
+	std::vector<cv::Mat> crops = htd->views[0].keypoint_crops;
+	crops.insert(crops.end(), htd->views[1].keypoint_crops.begin(), htd->views[1].keypoint_crops.end());
+
+	std::vector<Hand2D> hands_in_bbox;
+	runKeypointEstimatorBatch(&htd->views[0], crops, hands_in_bbox);
+
+	const Hand2D *right_hands_in_bbox = hands_in_bbox.data() + htd->views[0].keypoint_crops.size();
+	std::vector<Hand2D> hands_in_left_view = htCropKeypointsToRays(&htd->views[0], hands_in_bbox.data());
+	std::vector<Hand2D> hands_in_right_view = htCropKeypointsToRays(&htd->views[1], right_hands_in_bbox);
 	end = os_monotonic_get_ns();
 
 
@@ -544,6 +648,7 @@ htRunAlgorithm(struct ht_device *htd)
 	}
 
 	struct xrt_hand_joint_set final_hands_ordered_by_handedness[2];
+	struct xrt_vec3 final_velocities[2][XRT_HAND_JOINT_COUNT] = {};
 	memset(&final_hands_ordered_by_handedness[0], 0, sizeof(xrt_hand_joint_set));
 	memset(&final_hands_ordered_by_handedness[1], 0, sizeof(xrt_hand_joint_set));
 	final_hands_ordered_by_handedness[0].is_active = false;
@@ -555,71 +660,20 @@ htRunAlgorithm(struct ht_device *htd)
 
 		struct xrt_hand_joint_set *put_in_set = &final_hands_ordered_by_handedness[xr_indices[i]];
 
-		xrt_vec3 wrist = hand->kps[0];
-
-		xrt_vec3 index_prox = hand->kps[5];
-		xrt_vec3 middle_prox = hand->kps[9];
-		xrt_vec3 ring_prox = hand->kps[13];
-		xrt_vec3 pinky_prox = hand->kps[17];
-
-		xrt_vec3 middle_to_index = m_vec3_sub(index_prox, middle_prox);
-		xrt_vec3 middle_to_ring = m_vec3_sub(ring_prox, middle_prox);
-		xrt_vec3 middle_to_pinky = m_vec3_sub(pinky_prox, middle_prox);
-
-		xrt_vec3 three_fourths_down_middle_mcp =
-		    m_vec3_add(m_vec3_mul_scalar(wrist, 3.0f / 4.0f), m_vec3_mul_scalar(middle_prox, 1.0f / 4.0f));
-
-		xrt_vec3 middle_metacarpal = three_fourths_down_middle_mcp;
-
-		float s = 0.6f;
-
-		xrt_vec3 index_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_index, s);
-		xrt_vec3 ring_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_ring, s);
-		xrt_vec3 pinky_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_pinky, s);
-
-		float palm_ness = 0.33;
-		xrt_vec3 palm =
-		    m_vec3_add(m_vec3_mul_scalar(wrist, palm_ness), m_vec3_mul_scalar(middle_prox, (1.0f - palm_ness)));
+		xrt_vec3 joints[XRT_HAND_JOINT_COUNT];
+		htKeypointsToJoints(hand->kps, joints);
 
+		for (int joint = 0; joint < XRT_HAND_JOINT_COUNT; joint++) {
+			htProcessJoint(htd, joints[joint], put_in_set, (enum xrt_hand_joint)joint);
+		}
 
+		// The joints are linear in the keypoints, so the same mapping gives their velocities.
+		HandHistory3D *history = &htd->histories_3d[hand - filtered_hands.data()];
+		htKeypointsToJoints(history->velocities, final_velocities[xr_indices[i]]);
 
-		// clang-format off
-
-		htProcessJoint(htd,palm, put_in_set, XRT_HAND_JOINT_PALM);
-
-		htProcessJoint(htd,hand->kps[0], put_in_set, XRT_HAND_JOINT_WRIST);
-		htProcessJoint(htd,hand->kps[1], put_in_set, XRT_HAND_JOINT_THUMB_METACARPAL);
-		htProcessJoint(htd,hand->kps[2], put_in_set, XRT_HAND_JOINT_THUMB_PROXIMAL);
-		htProcessJoint(htd,hand->kps[3], put_in_set, XRT_HAND_JOINT_THUMB_DISTAL);
-		htProcessJoint(htd,hand->kps[4], put_in_set, XRT_HAND_JOINT_THUMB_TIP);
-
-		htProcessJoint(htd,index_metacarpal, put_in_set, XRT_HAND_JOINT_INDEX_METACARPAL);
-		htProcessJoint(htd,hand->kps[5], put_in_set, XRT_HAND_JOINT_INDEX_PROXIMAL);
-		htProcessJoint(htd,hand->kps[6], put_in_set, XRT_HAND_JOINT_INDEX_INTERMEDIATE);
-		htProcessJoint(htd,hand->kps[7], put_in_set, XRT_HAND_JOINT_INDEX_DISTAL);
-		htProcessJoint(htd,hand->kps[8], put_in_set, XRT_HAND_JOINT_INDEX_TIP);
-
-		htProcessJoint(htd,middle_metacarpal, put_in_set, XRT_HAND_JOINT_MIDDLE_METACARPAL);
-		htProcessJoint(htd,hand->kps[9], put_in_set, XRT_HAND_JOINT_MIDDLE_PROXIMAL);
-		htProcessJoint(htd,hand->kps[10], put_in_set, XRT_HAND_JOINT_MIDDLE_INTERMEDIATE);
-		htProcessJoint(htd,hand->kps[11], put_in_set, XRT_HAND_JOINT_MIDDLE_DISTAL);
-		htProcessJoint(htd,hand->kps[12], put_in_set, XRT_HAND_JOINT_MIDDLE_TIP);
-
-		htProcessJoint(htd,ring_metacarpal, put_in_set, XRT_HAND_JOINT_RING_METACARPAL);
-		htProcessJoint(htd,hand->kps[13], put_in_set, XRT_HAND_JOINT_RING_PROXIMAL);
-		htProcessJoint(htd,hand->kps[14], put_in_set, XRT_HAND_JOINT_RING_INTERMEDIATE);
-		htProcessJoint(htd,hand->kps[15], put_in_set, XRT_HAND_JOINT_RING_DISTAL);
-		htProcessJoint(htd,hand->kps[16], put_in_set, XRT_HAND_JOINT_RING_TIP);
-
-		htProcessJoint(htd, pinky_metacarpal, put_in_set, XRT_HAND_JOINT_LITTLE_METACARPAL);
-		htProcessJoint(htd,hand->kps[17], put_in_set, XRT_HAND_JOINT_LITTLE_PROXIMAL);
-		htProcessJoint(htd,hand->kps[18], put_in_set, XRT_HAND_JOINT_LITTLE_INTERMEDIATE);
-		htProcessJoint(htd,hand->kps[19], put_in_set, XRT_HAND_JOINT_LITTLE_DISTAL);
-		htProcessJoint(htd,hand->kps[20], put_in_set, XRT_HAND_JOINT_LITTLE_TIP);
-    put_in_set->is_active = true;
-    math_pose_identity(&put_in_set->hand_pose.pose);
+		put_in_set->is_active = true;
+		math_pose_identity(&put_in_set->hand_pose.pose);
 		put_in_set->hand_pose.relation_flags = valid_flags_ht;
-		// clang-format on
 		applyJointWidths(put_in_set);
 		applyJointOrientations(put_in_set, xr_indices[i]);
 	}
@@ -630,6 +684,13 @@ htRunAlgorithm(struct ht_device *htd)
 	os_mutex_lock(&htd->openxr_hand_data_mediator);
 	memcpy(&htd->hands_for_openxr[0], &final_hands_ordered_by_handedness[0], sizeof(struct xrt_hand_joint_set));
 	memcpy(&htd->hands_for_openxr[1], &final_hands_ordered_by_handedness[1], sizeof(struct xrt_hand_joint_set));
+	memcpy(htd->hands_for_openxr_velocities, final_velocities, sizeof(final_velocities));
+	htd->hands_for_openxr_timestamp = htd->current_frame_timestamp;
+
+	uint64_t published_ns = os_monotonic_get_ns();
+	htd->latency.latency_ms[htd->latency.index] =
+	    (float)time_ns_to_ms_f((int64_t)published_ns - (int64_t)htd->current_frame_timestamp);
+	htd->latency.index = (htd->latency.index + 1) % HT_LATENCY_COUNT;
 
 #if defined(JSON_OUTPUT)
 	json_add_set(htd);
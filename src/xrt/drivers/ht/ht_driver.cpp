@@ -163,6 +163,16 @@ getUserConfig(struct ht_device *htd)
 	// Make sure you build DebugOptimized!
 	htd->runtime_config.desired_format = XRT_FORMAT_YUYV422;
 
+	// The models already run in parallel per view and per hand.
+	htd->runtime_config.ort_intra_op_threads = 1;
+	htd->runtime_config.ort_inter_op_threads = 1;
+
+	htd->runtime_config.palm_detection_interval = 1;
+	htd->runtime_config.keypoint_min_confidence = 0.5f;
+
+	// About two camera frames at 54Hz.
+	htd->runtime_config.max_extrapolation_ms = 40.0f;
+
 	struct u_config_json config_json = {};
 
 	u_config_json_open_or_create_main_file(&config_json);
@@ -178,6 +188,11 @@ getUserConfig(struct ht_device *htd)
 	cJSON *palm_detection_type = cJSON_GetObjectItemCaseSensitive(ht_config_json, "palm_detection_model");
 	cJSON *keypoint_estimation_type = cJSON_GetObjectItemCaseSensitive(ht_config_json, "keypoint_estimation_model");
 	cJSON *uvc_wire_format = cJSON_GetObjectItemCaseSensitive(ht_config_json, "uvc_wire_format");
+	cJSON *intra_op_threads = cJSON_GetObjectItemCaseSensitive(ht_config_json, "onnx_intra_op_threads");
+	cJSON *inter_op_threads = cJSON_GetObjectItemCaseSensitive(ht_config_json, "onnx_inter_op_threads");
+	cJSON *detection_interval = cJSON_GetObjectItemCaseSensitive(ht_config_json, "palm_detection_interval");
+	cJSON *min_confidence = cJSON_GetObjectItemCaseSensitive(ht_config_json, "keypoint_min_confidence");
+	cJSON *max_extrapolation = cJSON_GetObjectItemCaseSensitive(ht_config_json, "max_extrapolation_ms");
 
 	// IsString does its own null-checking
 	if (cJSON_IsString(palm_detection_type)) {
@@ -216,6 +231,27 @@ getUserConfig(struct ht_device *htd)
 		}
 	}
 
+	if (cJSON_IsNumber(intra_op_threads) && intra_op_threads->valueint > 0) {
+		htd->runtime_config.ort_intra_op_threads = intra_op_threads->valueint;
+	}
+
+	if (cJSON_IsNumber(inter_op_threads) && inter_op_threads->valueint > 0) {
+		htd->runtime_config.ort_inter_op_threads = inter_op_threads->valueint;
+	}
+
+	if (cJSON_IsNumber(detection_interval) && detection_interval->valueint > 0) {
+		htd->runtime_config.palm_detection_interval = detection_interval->valueint;
+	}
+
+	if (cJSON_IsNumber(min_confidence) && min_confidence->valuedouble >= 0.0 &&
+	    min_confidence->valuedouble <= 1.0) {
+		htd->runtime_config.keypoint_min_confidence = (float)min_confidence->valuedouble;
+	}
+
+	if (cJSON_IsNumber(max_extrapolation) && max_extrapolation->valuedouble >= 0.0) {
+		htd->runtime_config.max_extrapolation_ms = (float)max_extrapolation->valuedouble;
+	}
+
 	cJSON_Delete(config_json.root);
 	return;
 }
@@ -339,7 +375,6 @@ ht_device_get_hand_tracking(struct xrt_device *xdev,
                             uint64_t at_timestamp_ns,
                             struct xrt_hand_joint_set *out_value)
 {
-	// Note! Currently, this totally ignores at_timestamp_ns. We need a better interface.
 	struct ht_device *htd = ht_device(xdev);
 
 	if (name != XRT_INPUT_GENERIC_HAND_TRACKING_LEFT && name != XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT) {
@@ -350,9 +385,29 @@ ht_device_get_hand_tracking(struct xrt_device *xdev,
 
 
 
+	struct xrt_vec3 velocities[XRT_HAND_JOINT_COUNT];
+
 	os_mutex_lock(&htd->openxr_hand_data_mediator);
 	memcpy(out_value, &htd->hands_for_openxr[hand_index], sizeof(struct xrt_hand_joint_set));
+	memcpy(velocities, htd->hands_for_openxr_velocities[hand_index], sizeof(velocities));
+	uint64_t captured_ns = htd->hands_for_openxr_timestamp;
 	os_mutex_unlock(&htd->openxr_hand_data_mediator);
+
+	if (!out_value->is_active) {
+		return;
+	}
+
+	// Predict the joints from when the frame was captured to when they were asked for, but not too far.
+	double dt = time_ns_to_s((int64_t)at_timestamp_ns - (int64_t)captured_ns);
+	dt = std::min(std::max(dt, 0.0), htd->runtime_config.max_extrapolation_ms / 1000.0);
+
+	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		struct xrt_space_relation *rel = &out_value->values.hand_joint_set_default[i].relation;
+		rel->pose.position = m_vec3_add(rel->pose.position, m_vec3_mul_scalar(velocities[i], (float)dt));
+		rel->linear_velocity = velocities[i];
+		rel->relation_flags = (enum xrt_space_relation_flags)(rel->relation_flags |
+		                                                      XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+	}
 }
 
 static void
@@ -367,6 +422,7 @@ ht_device_destroy(struct xrt_device *xdev)
 
 	// Lock this mutex so we don't try to free things as they're being used on the last iteration
 	os_mutex_lock(&htd->dying_breath);
+	os_thread_helper_destroy(&htd->view_worker.oth);
 	destroyOnnx(htd);
 #if defined(JSON_OUTPUT)
 	const char *string = cJSON_Print(htd->output_root);
@@ -384,8 +440,11 @@ ht_device_destroy(struct xrt_device *xdev)
 
 	// Shhhhhhhhhhh, it's okay. It'll all be okay.
 	htd->histories_3d.~vector();
-	htd->views[0].bbox_histories.~vector();
-	htd->views[1].bbox_histories.~vector();
+	for (int i = 0; i < 2; i++) {
+		htd->views[i].bbox_histories.~vector();
+		htd->views[i].keypoint_crops.~vector();
+		htd->views[i].crop_warps.~vector();
+	}
 	// Okay, fine, since we're mixing C and C++ idioms here, I couldn't find a clean way to implicitly
 	// call the destructors on these (ht_device doesn't have a destructor; neither do most of its members; and if
 	// you read u_device_allocate and u_device_free you'll agree it'd be somewhat annoying to write a
@@ -445,6 +504,9 @@ ht_device_create(struct xrt_prober *xp, struct t_stereo_camera_calibration *cali
 
 	initOnnx(htd);
 
+	os_thread_helper_init(&htd->view_worker.oth);
+	os_thread_helper_start(&htd->view_worker.oth, htViewWorkerMainloop, htd);
+
 	htd->base.tracking_origin = &htd->tracking_origin;
 	htd->base.tracking_origin->type = XRT_TRACKING_TYPE_RGB;
 	htd->base.tracking_origin->offset.position.x = 0.0f;
@@ -482,6 +544,20 @@ ht_device_create(struct xrt_prober *xp, struct t_stereo_camera_calibration *cali
 
 	u_var_add_root(htd, "Camera based Hand Tracker", true);
 	u_var_add_ro_text(htd, htd->base.str, "Name");
+	u_var_add_i32(htd, &htd->runtime_config.palm_detection_interval, "Palm detection interval (frames)");
+	u_var_add_f32(htd, &htd->runtime_config.keypoint_min_confidence, "Keypoint min confidence");
+	u_var_add_f32(htd, &htd->runtime_config.max_extrapolation_ms, "Max extrapolation (ms)");
+
+	struct u_var_timing *lt = &htd->latency.debug_var;
+	lt->values.data = htd->latency.latency_ms;
+	lt->values.length = HT_LATENCY_COUNT;
+	lt->values.index_ptr = &htd->latency.index;
+	lt->reference_timing = htd->runtime_config.max_extrapolation_ms;
+	lt->range = 100.f;
+	lt->unit = "ms";
+	lt->dynamic_rescale = true;
+	lt->center_reference_timing = false;
+	u_var_add_f32_timing(htd, lt, "Capture to publish latency");
 
 	// This puts u_sink_create_to_r8g8b8_or_l8 on its own thread, so that nothing gets backed up if it runs slower
 	// than the native camera framerate.
@@ -70,6 +70,9 @@ DEBUG_GET_ONCE_LOG_OPTION(ht_log, "HT_LOG", U_LOGGING_WARN)
 #define FCMIN_D_HAND 12.0f
 #define BETA_HAND 0.05f
 
+// How many hand pose latencies the debug gui plots.
+#define HT_LATENCY_COUNT 128
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -125,6 +128,9 @@ struct Hand2D
 {
 	struct xrt_vec3 kps[21];
 	// Third value is depth from ML model. Do not believe the depth.
+
+	// How sure the keypoint model is that there is a hand in the crop, 1 if the model doesn't say.
+	float confidence;
 };
 
 struct Hand3D
@@ -155,6 +161,8 @@ struct HandHistory3D
 	DiscardLastBuffer<Hand3D, 5> last_hands;
 	// Euro filter for 21kps.
 	m_filter_euro_vec3 filters[21];
+	// Smoothed velocity of each keypoint in m/s, taken from the euro filters' derivative.
+	xrt_vec3 velocities[21];
 };
 
 struct HandHistory2DBBox
@@ -164,9 +172,25 @@ struct HandHistory2DBBox
 
 	DiscardLastBuffer<xrt_vec2, 50> wrist_unfiltered;
 	DiscardLastBuffer<xrt_vec2, 50> middle_unfiltered;
+
+	// The keypoint model wasn't confident about this hand on the last frame.
+	bool lost;
 };
 
 
+// Input and output tensors bound to a session once and then reused for every inference.
+struct ModelIo
+{
+	OrtIoBinding *binding = nullptr;
+
+	std::vector<float> input;
+	OrtValue *input_tensor = nullptr;
+
+	// Same order as ModelInfo::output_names
+	std::vector<std::vector<float>> outputs;
+	std::vector<OrtValue *> output_tensors;
+};
+
 struct ModelInfo
 {
 	OrtSession *session = nullptr;
@@ -176,6 +200,19 @@ struct ModelInfo
 	size_t input_size_bytes;
 	std::vector<const char *> output_names;
 	std::vector<const char *> input_names;
+
+	// Queried from the session, same order as output_names
+	std::vector<std::vector<int64_t>> output_shapes;
+
+	// Whether the first input dimension is dynamic so several images can be run at once.
+	bool dynamic_batch;
+	// Indexed by batch size, only used from the frame thread.
+	std::vector<ModelIo *> batch_io;
+
+	// Several hands in one view run the same model at once, so there is one ModelIo per concurrent inference.
+	struct os_mutex io_mutex;
+	std::vector<ModelIo *> all_io;
+	std::vector<ModelIo *> free_io;
 };
 
 
@@ -196,10 +233,15 @@ struct ht_view
 	cv::Mat debug_out_to_this;
 
 	std::vector<HandHistory2DBBox> bbox_histories;
+	int frames_since_detection;
 
 	struct ModelInfo detection_model;
 	std::vector<Palm7KP> (*run_detection_model)(struct ht_view *htv, cv::Mat &img);
 
+	// One crop for each entry in bbox_histories, gathered from both views to run the keypoint model in one batch.
+	std::vector<cv::Mat> keypoint_crops;
+	std::vector<DetectionModelOutput> crop_warps;
+
 	struct ModelInfo keypoint_model;
 	// The cv::mat is passed by value, *not* passed by reference or by pointer;
 	// in the tight loop that sets these off we reuse that cv::Mat; changing the data pointer as all the models are
@@ -253,10 +295,28 @@ struct ht_device
 
 	struct os_mutex openxr_hand_data_mediator;
 	struct xrt_hand_joint_set hands_for_openxr[2];
+	// Capture timestamp of hands_for_openxr, and the joint velocities used to predict them to the requested time.
+	uint64_t hands_for_openxr_timestamp;
+	struct xrt_vec3 hands_for_openxr_velocities[2][XRT_HAND_JOINT_COUNT];
+
+	// Capture to publish latency of the hand poses, for the debug gui.
+	struct
+	{
+		float latency_ms[HT_LATENCY_COUNT];
+		int index;
+		struct u_var_timing debug_var;
+	} latency;
 
 	bool tracking_should_die;
 	struct os_mutex dying_breath;
 
+	// Persistent thread that finds the hands in the right view while the frame thread does the left one.
+	struct
+	{
+		struct os_thread_helper oth;
+		bool has_work;
+	} view_worker;
+
 	bool debug_scribble = true;
 
 
@@ -271,6 +331,15 @@ struct ht_device
 		bool keypoint_estimation_use_mediapipe;
 		enum xrt_format desired_format;
 		char model_slug[1024];
+		int ort_intra_op_threads;
+		int ort_inter_op_threads;
+
+		// Run the palm detector every this many frames while hands are tracked, 1 runs it every frame.
+		int palm_detection_interval;
+		// Below this the keypoint model has lost the hand, and the palm detector has to find it again.
+		float keypoint_min_confidence;
+		// Never predict the hands further ahead of their capture time than this.
+		float max_extrapolation_ms;
 	} runtime_config;
 
 
@@ -12,6 +12,7 @@
 #include "ht_driver.hpp"
 #include "math/m_api.h"
 #include "math/m_vec3.h"
+#include "util/u_time.h"
 
 const int num_real_joints = 21;
 
@@ -50,6 +51,67 @@ errHandHistory(HandHistory3D *history_hand, Hand3D *present_hand)
 }
 
 
+/*!
+ * Maps the 21 model keypoints to the OpenXR joints, making up the palm and metacarpals that the model doesn't have.
+ *
+ * This is linear in the keypoints, so it works for both positions and velocities.
+ */
+static void
+htKeypointsToJoints(const struct xrt_vec3 kps[21], struct xrt_vec3 out[XRT_HAND_JOINT_COUNT])
+{
+	xrt_vec3 wrist = kps[0];
+
+	xrt_vec3 index_prox = kps[5];
+	xrt_vec3 middle_prox = kps[9];
+	xrt_vec3 ring_prox = kps[13];
+	xrt_vec3 pinky_prox = kps[17];
+
+	xrt_vec3 middle_to_index = m_vec3_sub(index_prox, middle_prox);
+	xrt_vec3 middle_to_ring = m_vec3_sub(ring_prox, middle_prox);
+	xrt_vec3 middle_to_pinky = m_vec3_sub(pinky_prox, middle_prox);
+
+	xrt_vec3 three_fourths_down_middle_mcp =
+	    m_vec3_add(m_vec3_mul_scalar(wrist, 3.0f / 4.0f), m_vec3_mul_scalar(middle_prox, 1.0f / 4.0f));
+
+	xrt_vec3 middle_metacarpal = three_fourths_down_middle_mcp;
+
+	float s = 0.6f;
+
+	xrt_vec3 index_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_index, s);
+	xrt_vec3 ring_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_ring, s);
+	xrt_vec3 pinky_metacarpal = middle_metacarpal + m_vec3_mul_scalar(middle_to_pinky, s);
+
+	float palm_ness = 0.33;
+	xrt_vec3 palm =
+	    m_vec3_add(m_vec3_mul_scalar(wrist, palm_ness), m_vec3_mul_scalar(middle_prox, (1.0f - palm_ness)));
+
+	out[XRT_HAND_JOINT_PALM] = palm;
+	out[XRT_HAND_JOINT_WRIST] = kps[0];
+
+	out[XRT_HAND_JOINT_THUMB_METACARPAL] = kps[1];
+	out[XRT_HAND_JOINT_THUMB_PROXIMAL] = kps[2];
+	out[XRT_HAND_JOINT_THUMB_DISTAL] = kps[3];
+	out[XRT_HAND_JOINT_THUMB_TIP] = kps[4];
+
+	out[XRT_HAND_JOINT_INDEX_METACARPAL] = index_metacarpal;
+	out[XRT_HAND_JOINT_MIDDLE_METACARPAL] = middle_metacarpal;
+	out[XRT_HAND_JOINT_RING_METACARPAL] = ring_metacarpal;
+	out[XRT_HAND_JOINT_LITTLE_METACARPAL] = pinky_metacarpal;
+
+	// The four fingers are laid out the same way in both, metacarpal excepted.
+	const enum xrt_hand_joint finger_proximals[4] = {
+	    XRT_HAND_JOINT_INDEX_PROXIMAL,
+	    XRT_HAND_JOINT_MIDDLE_PROXIMAL,
+	    XRT_HAND_JOINT_RING_PROXIMAL,
+	    XRT_HAND_JOINT_LITTLE_PROXIMAL,
+	};
+	for (int finger = 0; finger < 4; finger++) {
+		for (int joint = 0; joint < 4; joint++) {
+			out[finger_proximals[finger] + joint] = kps[5 + (finger * 4) + joint];
+		}
+	}
+}
+
 static void
 applyJointWidths(struct xrt_hand_joint_set *set)
 {
@@ -266,9 +328,21 @@ handEuroFiltersRun(HandHistory3D *history)
 {
 	// Assume present hand is in element 0!
 	Hand3D hand;
+	uint64_t ts = history->last_hands[0]->timestamp;
 	for (int i = 0; i < 21; i++) {
-		m_filter_euro_vec3_run(&history->filters[i], history->last_hands[0]->timestamp,
-		                       &history->last_hands[0]->kps[i], &hand.kps[i]);
+		m_filter_euro_vec3 *f = &history->filters[i];
+		bool had_prev = f->have_prev_y;
+		uint64_t prev_ts = f->prev_ts;
+
+		m_filter_euro_vec3_run(f, ts, &history->last_hands[0]->kps[i], &hand.kps[i]);
+
+		// The filter keeps a smoothed per-sample delta, turn it into m/s.
+		if (had_prev && ts > prev_ts) {
+			float dt = (float)((double)(ts - prev_ts) / U_TIME_1S_IN_NS);
+			history->velocities[i] = m_vec3_mul_scalar(f->prev_dy, 1.0f / dt);
+		} else {
+			history->velocities[i] = XRT_VEC3_ZERO;
+		}
 	}
 	return hand;
 }
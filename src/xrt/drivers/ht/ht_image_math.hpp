@@ -16,6 +16,7 @@
 #include <opencv2/calib3d.hpp>
 
 #include <opencv2/core/types.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <opencv2/imgproc.hpp>
 
 static cv::Scalar
@@ -190,19 +191,63 @@ rotatedRectFromJoints(struct ht_view *htv, xrt_vec2 middle, xrt_vec2 wrist, Dete
 	return *out;
 }
 
+#if CV_SIMD
+//! Widen 8-bit lanes to floats, apply scale and offset and store them.
+static inline void
+storeNormalized(const cv::v_uint8 &in, float *out, const cv::v_float32 &scale, const cv::v_float32 &offset)
+{
+	const int step = cv::v_float32::nlanes;
+
+	cv::v_uint16 lo16, hi16;
+	cv::v_expand(in, lo16, hi16);
+
+	cv::v_uint32 q[4];
+	cv::v_expand(lo16, q[0], q[1]);
+	cv::v_expand(hi16, q[2], q[3]);
+
+	for (int i = 0; i < 4; i++) {
+		cv::v_float32 f = cv::v_cvt_f32(cv::v_reinterpret_as_s32(q[i]));
+		cv::v_store(out + i * step, cv::v_fma(f, scale, offset));
+	}
+}
+#endif
+
+/*!
+ * Turns an interleaved 8-bit three channel image into three float planes,
+ * doing `value * scale + offset` on the way, in one pass.
+ */
 static void
-planarize(cv::Mat &input, uint8_t *output)
+planarizeAndNormalize(const cv::Mat &input, float *output, float scale, float offset)
 {
 	// output better be the right size, because we are not doing any bounds checking!
 	assert(input.isContinuous());
-	int lix = input.cols;
-	int liy = input.rows;
-	cv::Mat planes[3];
-	cv::split(input, planes);
-	cv::Mat red = planes[0];
-	cv::Mat green = planes[1];
-	cv::Mat blue = planes[2];
-	memcpy(output, red.data, lix * liy);
-	memcpy(output + (lix * liy), green.data, lix * liy);
-	memcpy(output + (lix * liy * 2), blue.data, lix * liy);
+	assert(input.type() == CV_8UC3);
+
+	const int num_px = input.cols * input.rows;
+	const uint8_t *src = input.data;
+	float *out_r = output;
+	float *out_g = output + num_px;
+	float *out_b = output + num_px * 2;
+
+	int i = 0;
+
+#if CV_SIMD
+	const int step = cv::v_uint8::nlanes;
+	const cv::v_float32 v_scale = cv::vx_setall_f32(scale);
+	const cv::v_float32 v_offset = cv::vx_setall_f32(offset);
+
+	for (; i <= num_px - step; i += step) {
+		cv::v_uint8 r, g, b;
+		cv::v_load_deinterleave(src + i * 3, r, g, b);
+		storeNormalized(r, out_r + i, v_scale, v_offset);
+		storeNormalized(g, out_g + i, v_scale, v_offset);
+		storeNormalized(b, out_b + i, v_scale, v_offset);
+	}
+#endif
+
+	for (; i < num_px; i++) {
+		out_r[i] = (float)src[i * 3 + 0] * scale + offset;
+		out_g[i] = (float)src[i * 3 + 1] * scale + offset;
+		out_b[i] = (float)src[i * 3 + 2] * scale + offset;
+	}
 }
@@ -43,7 +43,9 @@
 #include <stdio.h>
 #include <math.h>
 
+#include <algorithm>
 #include <exception>
+#include <functional>
 #include <fstream>
 #include <iostream>
 #include <limits>
@@ -433,55 +435,83 @@ static std::vector<std::vector<float>> anchor{
     {0.875000, 0.875000, 1.000000, 1.000000}, {0.875000, 0.875000, 1.000000, 1.000000},
     {0.875000, 0.875000, 1.000000, 1.000000}, {0.875000, 0.875000, 1.000000, 1.000000}};
 
-static Hand2D
-runKeypointEstimator(struct ht_view *htv, cv::Mat img)
-{
-	const size_t lix = 224;
-	const size_t liy = 224;
-	cv::Mat planes[3];
-
+#define HT_MAX_KEYPOINT_BATCH 8
 
-	uint8_t combined_planes[224 * 224 * 3];
-	planarize(img, combined_planes);
-
-	// Normalize - supposedly, the keypoint estimator wants keypoints in [0,1]
-	float real_thing[lix * liy * 3] = {0};
-	for (size_t i = 0; i < lix * liy * 3; i++) {
-		real_thing[i] = (float)combined_planes[i] / 255.0;
-	}
+static ModelIo *
+createModelIo(const OrtApi *g_ort, struct ModelInfo *model, int64_t batch = 1)
+{
+	ModelIo *io = new ModelIo;
 
-	const OrtApi *g_ort = htv->htd->ort_api;
-	struct ModelInfo *model = &htv->keypoint_model;
+	std::vector<int64_t> input_shape = model->input_shape;
+	input_shape[0] = batch;
+	size_t input_size_bytes = model->input_size_bytes * batch;
 
+	io->input.resize(input_size_bytes / sizeof(float));
+	ORT_CHECK(g_ort, g_ort->CreateTensorWithDataAsOrtValue(model->memoryInfo, io->input.data(), input_size_bytes,
+	                                                       input_shape.data(), input_shape.size(),
+	                                                       ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &io->input_tensor));
 
-	OrtValue *input_tensor = nullptr;
+	ORT_CHECK(g_ort, g_ort->CreateIoBinding(model->session, &io->binding));
+	ORT_CHECK(g_ort, g_ort->BindInput(io->binding, model->input_names[0], io->input_tensor));
 
+	io->outputs.resize(model->output_names.size());
+	io->output_tensors.resize(model->output_names.size(), nullptr);
 
-	ORT_CHECK(g_ort, g_ort->CreateTensorWithDataAsOrtValue(model->memoryInfo, real_thing, model->input_size_bytes,
-	                                                       model->input_shape.data(), model->input_shape.size(),
-	                                                       ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &input_tensor));
+	for (size_t i = 0; i < model->output_names.size(); i++) {
+		std::vector<int64_t> shape = model->output_shapes[i];
+		shape[0] *= batch;
+		size_t count = std::accumulate(shape.begin(), shape.end(), (int64_t)1, std::multiplies<int64_t>());
 
-	// Cargo-culted
-	assert(input_tensor != nullptr);
-	int is_tensor;
-	ORT_CHECK(g_ort, g_ort->IsTensor(input_tensor, &is_tensor));
-	assert(is_tensor);
+		io->outputs[i].resize(count);
+		ORT_CHECK(g_ort, g_ort->CreateTensorWithDataAsOrtValue(
+		                     model->memoryInfo, io->outputs[i].data(), count * sizeof(float), shape.data(),
+		                     shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &io->output_tensors[i]));
+		ORT_CHECK(g_ort, g_ort->BindOutput(io->binding, model->output_names[i], io->output_tensors[i]));
+	}
 
-	const char *output_names[] = {"Identity", "Identity_2", "Identity_2"};
+	return io;
+}
 
-	// If any of these are non-NULL, ONNX will explode and won't tell you why! Be extremely paranoid!
-	OrtValue *output_tensor[3] = {nullptr, nullptr, nullptr};
-	ORT_CHECK(g_ort, g_ort->Run(model->session, nullptr, model->input_names.data(), &input_tensor, 1, output_names,
-	                            3, output_tensor));
+static void
+destroyModelIo(const OrtApi *g_ort, ModelIo *io)
+{
+	g_ort->ReleaseIoBinding(io->binding);
+	g_ort->ReleaseValue(io->input_tensor);
+	for (OrtValue *value : io->output_tensors) {
+		g_ort->ReleaseValue(value);
+	}
+	delete io;
+}
 
-	ORT_CHECK(g_ort, g_ort->IsTensor(output_tensor[0], &is_tensor));
-	assert(is_tensor);
+// Get a set of bound tensors nobody else is using, they are only created the first time they are needed.
+static ModelIo *
+acquireModelIo(const OrtApi *g_ort, struct ModelInfo *model)
+{
+	os_mutex_lock(&model->io_mutex);
+	ModelIo *io = nullptr;
+	if (!model->free_io.empty()) {
+		io = model->free_io.back();
+		model->free_io.pop_back();
+	} else {
+		io = createModelIo(g_ort, model);
+		model->all_io.push_back(io);
+	}
+	os_mutex_unlock(&model->io_mutex);
 
-	float *landmarks = nullptr;
+	return io;
+}
 
-	// Should give a pointer to data that is freed on g_ort->ReleaseValue(output_tensor[0]);.
-	ORT_CHECK(g_ort, g_ort->GetTensorMutableData(output_tensor[0], (void **)&landmarks));
+static void
+releaseModelIo(struct ModelInfo *model, ModelIo *io)
+{
+	os_mutex_lock(&model->io_mutex);
+	model->free_io.push_back(io);
+	os_mutex_unlock(&model->io_mutex);
+}
 
+static Hand2D
+landmarksToHand2D(const float *landmarks, const float *hand_flag)
+{
 	int stride = 3;
 	Hand2D dumb;
 	for (size_t i = 0; i < 21; i++) {
@@ -494,88 +524,119 @@ runKeypointEstimator(struct ht_view *htv, cv::Mat img)
 		dumb.kps[i].z = z;
 	}
 
-	// We have to get to here, or else we leak a whole lot! If you need to return early, make this into a goto!
-	g_ort->ReleaseValue(output_tensor[0]);
-	g_ort->ReleaseValue(output_tensor[1]);
-	g_ort->ReleaseValue(output_tensor[2]);
-	g_ort->ReleaseValue(input_tensor);
+	dumb.confidence = hand_flag != nullptr ? *hand_flag : 1.0f;
+
 	return dumb;
 }
 
+static Hand2D
+runKeypointEstimator(struct ht_view *htv, cv::Mat img)
+{
+	const OrtApi *g_ort = htv->htd->ort_api;
+	struct ModelInfo *model = &htv->keypoint_model;
+
+	ModelIo *io = acquireModelIo(g_ort, model);
 
+	// Normalize - supposedly, the keypoint estimator wants keypoints in [0,1]
+	planarizeAndNormalize(img, io->input.data(), 1.0f / 255.0f, 0.0f);
 
-static std::vector<Palm7KP>
-runHandDetector(struct ht_view *htv, cv::Mat &raw_input)
+	ORT_CHECK(g_ort, g_ort->RunWithBinding(model->session, nullptr, io->binding));
+
+	// "Identity" and "Identity_1"
+	Hand2D hand = landmarksToHand2D(io->outputs[0].data(), io->outputs[1].data());
+
+	releaseModelIo(model, io);
+	return hand;
+}
+
+/*!
+ * Runs the keypoint model on all crops with as few Run calls as possible,
+ * one per crop if the model has a fixed batch size.
+ */
+static void
+runKeypointEstimatorBatch(struct ht_view *htv, const std::vector<cv::Mat> &crops, std::vector<Hand2D> &out)
 {
 	const OrtApi *g_ort = htv->htd->ort_api;
+	struct ModelInfo *model = &htv->keypoint_model;
 
-	cv::Mat img;
+	out.resize(crops.size());
 
-	const int hd_size = 128;
-	const int inputTensorSize = hd_size * hd_size * 3 * sizeof(float);
-
-	cv::Matx23f back_from_blackbar = blackbar(raw_input, img, {hd_size, hd_size});
+	if (!model->dynamic_batch) {
+		for (size_t i = 0; i < crops.size(); i++) {
+			out[i] = runKeypointEstimator(htv, crops[i]);
+		}
+		return;
+	}
 
-	float scale_factor = back_from_blackbar(0, 0); // 960/128
-	assert(img.isContinuous());
-	float mean = 128.0f;
-	float std = 128.0f;
-	float real_thing[hd_size * hd_size * 3];
+	const size_t floats_per_image = model->input_size_bytes / sizeof(float);
 
+	for (size_t first = 0; first < crops.size(); first += HT_MAX_KEYPOINT_BATCH) {
+		size_t num = std::min(crops.size() - first, (size_t)HT_MAX_KEYPOINT_BATCH);
 
-	if (htv->htd->runtime_config.palm_detection_use_mediapipe) {
-		uint8_t combined_planes[hd_size * hd_size * 3] = {0};
-		planarize(img, combined_planes);
-		for (size_t i = 0; i < hd_size * hd_size * 3; i++) {
-			float val = (float)combined_planes[i];
-			real_thing[i] = (val - mean) / std;
+		if (model->batch_io.size() <= num) {
+			model->batch_io.resize(num + 1, nullptr);
 		}
-		// Hope it was worth it...
-	} else {
+		if (model->batch_io[num] == nullptr) {
+			model->batch_io[num] = createModelIo(g_ort, model, num);
+		}
+		ModelIo *io = model->batch_io[num];
 
-		assert(img.isContinuous());
+		for (size_t i = 0; i < num; i++) {
+			planarizeAndNormalize(crops[first + i], io->input.data() + i * floats_per_image, 1.0f / 255.0f,
+			                      0.0f);
+		}
 
-		for (size_t i = 0; i < hd_size * hd_size * 3; i++) {
-			int val = img.data[i];
+		ORT_CHECK(g_ort, g_ort->RunWithBinding(model->session, nullptr, io->binding));
 
-			real_thing[i] = (val - mean) / std;
+		// "Identity" and "Identity_1"
+		size_t floats_per_output = io->outputs[0].size() / num;
+		size_t floats_per_flag = io->outputs[1].size() / num;
+		for (size_t i = 0; i < num; i++) {
+			out[first + i] = landmarksToHand2D(io->outputs[0].data() + i * floats_per_output,
+			                                   io->outputs[1].data() + i * floats_per_flag);
 		}
 	}
+}
 
-	// Convenience
-	struct ModelInfo *model_hd = &htv->detection_model;
 
-	// If this is non-NULL, ONNX will explode and won't tell you why!
-	OrtValue *input_tensor = nullptr;
 
-	ORT_CHECK(g_ort, g_ort->CreateTensorWithDataAsOrtValue(
-	                     model_hd->memoryInfo, real_thing, inputTensorSize, model_hd->input_shape.data(),
-	                     model_hd->input_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &input_tensor));
+static std::vector<Palm7KP>
+runHandDetector(struct ht_view *htv, cv::Mat &raw_input)
+{
+	const OrtApi *g_ort = htv->htd->ort_api;
 
-	// Cargo-culted
-	assert(input_tensor != nullptr);
-	int is_tensor;
-	ORT_CHECK(g_ort, g_ort->IsTensor(input_tensor, &is_tensor));
-	assert(is_tensor);
+	cv::Mat img;
 
-	// If any of these are non-NULL, ONNX will explode and won't tell you why! Be extremely paranoid!
-	OrtValue *output_tensor[2] = {nullptr, nullptr};
-	ORT_CHECK(g_ort, g_ort->Run(model_hd->session, nullptr, model_hd->input_names.data(),
-	                            (const OrtValue *const *)&input_tensor, model_hd->input_names.size(),
-	                            model_hd->output_names.data(), model_hd->output_names.size(), output_tensor));
+	const int hd_size = 128;
 
-	ORT_CHECK(g_ort, g_ort->IsTensor(output_tensor[0], &is_tensor));
-	assert(is_tensor);
+	cv::Matx23f back_from_blackbar = blackbar(raw_input, img, {hd_size, hd_size});
 
-	float *classificators = nullptr;
-	float *regressors = nullptr;
+	float scale_factor = back_from_blackbar(0, 0); // 960/128
+	assert(img.isContinuous());
 
-	ORT_CHECK(g_ort,
-	          g_ort->GetTensorMutableData(output_tensor[0], (void **)&classificators)); // Totally won't segfault!
-	ORT_CHECK(g_ort, g_ort->GetTensorMutableData(output_tensor[1], (void **)&regressors));
-	// We need to free these!
+	// (val - 128) / 128
+	const float scale = 1.0f / 128.0f;
+	const float offset = -1.0f;
 
-	float *rg = regressors; // shorter name
+	// Convenience
+	struct ModelInfo *model_hd = &htv->detection_model;
+
+	ModelIo *io = acquireModelIo(g_ort, model_hd);
+
+	if (htv->htd->runtime_config.palm_detection_use_mediapipe) {
+		planarizeAndNormalize(img, io->input.data(), scale, offset);
+	} else {
+		// Interleaved input, writes straight into the bound tensor.
+		cv::Mat real_thing(hd_size, hd_size, CV_32FC3, io->input.data());
+		img.convertTo(real_thing, CV_32FC3, scale, offset);
+	}
+
+	ORT_CHECK(g_ort, g_ort->RunWithBinding(model_hd->session, nullptr, io->binding));
+
+	const float *classificators = io->outputs[0].data();
+	const float *regressors = io->outputs[1].data();
+
+	const float *rg = regressors; // shorter name
 
 	std::vector<NMSPalm> detections;
 	int count = 0;
@@ -678,9 +739,7 @@ runHandDetector(struct ht_view *htv, cv::Mat &raw_input)
 	}
 
 cleanup:
-	g_ort->ReleaseValue(output_tensor[0]);
-	g_ort->ReleaseValue(output_tensor[1]);
-	g_ort->ReleaseValue(input_tensor);
+	releaseModelIo(model_hd, io);
 	return output;
 }
 
@@ -692,6 +751,56 @@ addSlug(struct ht_device *htd, const char *suffix, char *out)
 	strcat(out, suffix);
 }
 
+// Outputs are bound up front, so we need to know their shapes. Dynamic dimensions are the batch size of 1.
+static void
+queryOutputShapes(const OrtApi *g_ort, struct ModelInfo *model)
+{
+	OrtAllocator *allocator = nullptr;
+	ORT_CHECK(g_ort, g_ort->GetAllocatorWithDefaultOptions(&allocator));
+
+	size_t count = 0;
+	ORT_CHECK(g_ort, g_ort->SessionGetOutputCount(model->session, &count));
+
+	model->output_shapes.resize(model->output_names.size());
+
+	for (size_t i = 0; i < count; i++) {
+		char *name = nullptr;
+		ORT_CHECK(g_ort, g_ort->SessionGetOutputName(model->session, i, allocator, &name));
+
+		for (size_t k = 0; k < model->output_names.size(); k++) {
+			if (strcmp(name, model->output_names[k]) != 0) {
+				continue;
+			}
+
+			OrtTypeInfo *type_info = nullptr;
+			const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+			ORT_CHECK(g_ort, g_ort->SessionGetOutputTypeInfo(model->session, i, &type_info));
+			ORT_CHECK(g_ort, g_ort->CastTypeInfoToTensorInfo(type_info, &tensor_info));
+
+			size_t num_dims = 0;
+			ORT_CHECK(g_ort, g_ort->GetDimensionsCount(tensor_info, &num_dims));
+			std::vector<int64_t> &shape = model->output_shapes[k];
+			shape.resize(num_dims);
+			ORT_CHECK(g_ort, g_ort->GetDimensions(tensor_info, shape.data(), num_dims));
+			for (int64_t &dim : shape) {
+				dim = dim < 1 ? 1 : dim;
+			}
+
+			g_ort->ReleaseTypeInfo(type_info);
+		}
+
+		ORT_CHECK(g_ort, g_ort->AllocatorFree(allocator, name));
+	}
+}
+
+static void
+setThreadOptions(struct ht_device *htd, OrtSessionOptions *opts)
+{
+	const OrtApi *g_ort = htd->ort_api;
+	ORT_CHECK(g_ort, g_ort->SetIntraOpNumThreads(opts, htd->runtime_config.ort_intra_op_threads));
+	ORT_CHECK(g_ort, g_ort->SetInterOpNumThreads(opts, htd->runtime_config.ort_inter_op_threads));
+}
+
 static void
 initKeypointEstimator(struct ht_device *htd, ht_view *htv)
 {
@@ -702,7 +811,7 @@ initKeypointEstimator(struct ht_device *htd, ht_view *htv)
 	ORT_CHECK(g_ort, g_ort->CreateSessionOptions(&opts));
 
 	ORT_CHECK(g_ort, g_ort->SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT_CHECK(g_ort, g_ort->SetIntraOpNumThreads(opts, 1));
+	setThreadOptions(htd, opts);
 
 	char modelLocation[1024];
 	if (htd->runtime_config.keypoint_estimation_use_mediapipe) {
@@ -728,6 +837,24 @@ initKeypointEstimator(struct ht_device *htd, ht_view *htv)
 
 	ORT_CHECK(g_ort, g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &model_ke->memoryInfo));
 
+	queryOutputShapes(g_ort, model_ke);
+	os_mutex_init(&model_ke->io_mutex);
+
+	{
+		OrtTypeInfo *type_info = nullptr;
+		const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+		ORT_CHECK(g_ort, g_ort->SessionGetInputTypeInfo(model_ke->session, 0, &type_info));
+		ORT_CHECK(g_ort, g_ort->CastTypeInfoToTensorInfo(type_info, &tensor_info));
+
+		size_t num_dims = 0;
+		ORT_CHECK(g_ort, g_ort->GetDimensionsCount(tensor_info, &num_dims));
+		std::vector<int64_t> dims(num_dims);
+		ORT_CHECK(g_ort, g_ort->GetDimensions(tensor_info, dims.data(), num_dims));
+		model_ke->dynamic_batch = num_dims > 0 && dims[0] < 1;
+
+		g_ort->ReleaseTypeInfo(type_info);
+	}
+
 	htv->run_keypoint_model = runKeypointEstimator;
 }
 
@@ -742,7 +869,7 @@ initHandDetector(struct ht_device *htd, ht_view *htv)
 	ORT_CHECK(g_ort, g_ort->CreateSessionOptions(&opts));
 
 	ORT_CHECK(g_ort, g_ort->SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT_CHECK(g_ort, g_ort->SetIntraOpNumThreads(opts, 1));
+	setThreadOptions(htd, opts);
 
 	char modelLocation[1024];
 
@@ -776,8 +903,13 @@ initHandDetector(struct ht_device *htd, ht_view *htv)
 	model_hd->output_names.push_back("classificators");
 	model_hd->output_names.push_back("regressors");
 
+	model_hd->input_size_bytes = 128 * 128 * 3 * sizeof(float);
+
 	ORT_CHECK(g_ort, g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &model_hd->memoryInfo));
 
+	queryOutputShapes(g_ort, model_hd);
+	os_mutex_init(&model_hd->io_mutex);
+
 	htv->run_detection_model = runHandDetector;
 }
 
@@ -799,10 +931,23 @@ static void
 destroyModelInfo(struct ht_device *htd, ModelInfo *info)
 {
 	const OrtApi *g_ort = htd->ort_api;
+	for (ModelIo *io : info->all_io) {
+		destroyModelIo(g_ort, io);
+	}
+	for (ModelIo *io : info->batch_io) {
+		if (io != nullptr) {
+			destroyModelIo(g_ort, io);
+		}
+	}
+	os_mutex_destroy(&info->io_mutex);
 	g_ort->ReleaseSession(info->session);
 	g_ort->ReleaseMemoryInfo(info->memoryInfo);
 	// Same deal as in ht_device - I'm mixing C and C++ idioms, so sometimes it's easier to just manually call their
 	// destructors instead of figuring out some way to convince C++ to call them implicitly.
+	info->batch_io.~vector();
+	info->free_io.~vector();
+	info->all_io.~vector();
+	info->output_shapes.~vector();
 	info->output_names.~vector();
 	info->input_names.~vector();
 	info->input_shape.~vector();
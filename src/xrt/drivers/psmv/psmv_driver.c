@@ -13,6 +13,7 @@
 
 #include "os/os_threading.h"
 #include "os/os_hid.h"
+#include "os/os_hid_reactor.h"
 #include "os/os_time.h"
 
 #include "math/m_api.h"
@@ -27,6 +28,7 @@
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_logging.h"
+#include "util/u_snapshot.h"
 
 #include "psmv_interface.h"
 
@@ -414,6 +416,21 @@ struct psmv_parsed_input
 	};
 };
 
+/*!
+ * What update_inputs and the fusion pose need, published after each report.
+ */
+struct psmv_input_state
+{
+	uint32_t buttons;
+	uint8_t trigger;
+
+	//! When the report arrived.
+	uint64_t timestamp_ns;
+
+	struct xrt_quat rot;
+	struct xrt_vec3 angvel;
+};
+
 /*!
  * A single PlayStation Move Controller.
  *
@@ -436,7 +453,24 @@ struct psmv_device
 
 	struct xrt_tracked_psmv *ball;
 
-	struct os_thread_helper oth;
+	struct os_hid_reactor *reactor;
+	uint32_t reactor_id;
+
+	//! Only touched by the report callback.
+	struct
+	{
+		//! The first report after start is only used to sync up.
+		bool synced;
+
+		//! When the last report arrived.
+		timepoint_ns then_ns;
+	} reports;
+
+	/*!
+	 * Lock for wants and state, held while writing them to the device. Never
+	 * taken by the report callback so a slow write can't stall the reactor.
+	 */
+	struct os_mutex output_lock;
 
 	struct
 	{
@@ -462,6 +496,9 @@ struct psmv_device
 	} calibration;
 
 
+	//! Latest @ref psmv_input_state, read without a lock.
+	struct u_snapshot *snapshot;
+
 	struct
 	{
 		//! Lock for last and fusion.
@@ -565,17 +602,17 @@ psmv_clamp_zero_to_one_float_to_u8(float v)
 }
 
 static void
-psmv_update_input_click(struct psmv_device *psmv, int index, int64_t when_ns, uint32_t bit)
+psmv_update_input_click(struct psmv_device *psmv, const struct psmv_input_state *state, int index, uint32_t bit)
 {
-	psmv->base.inputs[index].timestamp = when_ns;
-	psmv->base.inputs[index].value.boolean = (psmv->last.buttons & bit) != 0;
+	psmv->base.inputs[index].timestamp = state->timestamp_ns;
+	psmv->base.inputs[index].value.boolean = (state->buttons & bit) != 0;
 }
 
 static void
-psmv_update_trigger_value(struct psmv_device *psmv, int index, int64_t when_ns)
+psmv_update_trigger_value(struct psmv_device *psmv, const struct psmv_input_state *state, int index)
 {
-	psmv->base.inputs[index].timestamp = when_ns;
-	psmv->base.inputs[index].value.vec1.x = psmv->last.trigger / 255.0f;
+	psmv->base.inputs[index].timestamp = state->timestamp_ns;
+	psmv->base.inputs[index].value.vec1.x = state->trigger / 255.0f;
 }
 
 
@@ -625,9 +662,9 @@ psmv_led_and_trigger_update_locked(volatile struct psmv_device *psmv, int64_t ti
 static void
 psmv_led_and_trigger_update(struct psmv_device *psmv, int64_t time)
 {
-	os_mutex_lock(&psmv->lock);
+	os_mutex_lock(&psmv->output_lock);
 	psmv_led_and_trigger_update_locked(psmv, time);
-	os_mutex_unlock(&psmv->lock);
+	os_mutex_unlock(&psmv->output_lock);
 }
 
 static void
@@ -671,98 +708,75 @@ update_fusion(struct psmv_device *psmv,
 }
 
 /*!
- * Reads one packet from the device, handles time out, locking and checking if
- * the thread has been told to shut down.
+ * Called by the reactor for each input report from the device.
  */
 static bool
-psmv_read_one_packet(struct psmv_device *psmv, uint8_t *buffer, size_t size)
+psmv_handle_report(void *ptr, const uint8_t *buffer, int size)
 {
-	os_thread_helper_lock(&psmv->oth);
-
-	while (os_thread_helper_is_running_locked(&psmv->oth)) {
-
-		os_thread_helper_unlock(&psmv->oth);
-
-		int ret = os_hid_read(psmv->hid, buffer, size, 1000);
+	struct psmv_device *psmv = (struct psmv_device *)ptr;
 
-		if (ret == 0) {
-			PSMV_DEBUG(psmv, "Timeout");
+	if (size < 0) {
+		PSMV_ERROR(psmv, "Failed to read device '%i'!", size);
+		return false;
+	}
 
-			// Must lock thread before check in while.
-			os_thread_helper_lock(&psmv->oth);
-			continue;
-		}
-		if (ret < 0) {
-			PSMV_ERROR(psmv, "Failed to read device '%i'!", ret);
-			return false;
-		}
+	timepoint_ns now_ns = os_monotonic_get_ns();
 
+	// Wait for a package to sync up, it's discarded but that's okay.
+	if (!psmv->reports.synced) {
+		psmv->reports.synced = true;
+		psmv->reports.then_ns = now_ns;
 		return true;
 	}
 
-	return false;
-}
-
-static void *
-psmv_run_thread(void *ptr)
-{
-	struct psmv_device *psmv = (struct psmv_device *)ptr;
-
 	union {
 		uint8_t buffer[256];
 		struct psmv_input_zcm1 input;
-	} data;
-
-	struct psmv_parsed_input input = {0};
-
-	while (os_hid_read(psmv->hid, data.buffer, sizeof(data), 0) > 0) {
-		// Empty queue first
-	}
-
-	// Now wait for a package to sync up, it's discarded but that's okay.
-	if (!psmv_read_one_packet(psmv, data.buffer, sizeof(data))) {
-		return NULL;
-	}
-
-	timepoint_ns then_ns = os_monotonic_get_ns();
+	} data = {0};
 
-	while (psmv_read_one_packet(psmv, data.buffer, sizeof(data))) {
+	memcpy(data.buffer, buffer, (size_t)size < sizeof(data) ? (size_t)size : sizeof(data));
 
-		timepoint_ns now_ns = os_monotonic_get_ns();
+	struct psmv_parsed_input input = {0};
 
-		int num = psmv_parse_input(psmv, data.buffer, &input);
+	int num = psmv_parse_input(psmv, data.buffer, &input);
 
-		time_duration_ns delta_ns = now_ns - then_ns;
-		then_ns = now_ns;
+	time_duration_ns delta_ns = now_ns - psmv->reports.then_ns;
+	psmv->reports.then_ns = now_ns;
 
-		// Lock last and the fusion.
-		os_mutex_lock(&psmv->lock);
+	// Lock last and the fusion.
+	os_mutex_lock(&psmv->lock);
 
-		// Make sure the leds stays on.
-		psmv_led_and_trigger_update_locked(psmv, now_ns);
+	// Copy to device.
+	psmv->last = input;
+
+	// Process the parsed data.
+	if (num == 2) {
+		// ZCM1
+		update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
+		update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
+		psmv->last_timestamp_ns = now_ns;
+	} else if (num == 1) {
+		// ZCM2
+		update_fusion(psmv, &input.sample, now_ns, delta_ns);
+		psmv->last_timestamp_ns = now_ns;
+	} else {
+		assert(false);
+	}
 
-		// Copy to device.
-		psmv->last = input;
+	struct psmv_input_state state = {
+	    .buttons = input.buttons,
+	    .trigger = input.trigger,
+	    .timestamp_ns = psmv->last_timestamp_ns,
+	    .rot = psmv->fusion.rot,
+	    .angvel = psmv->fusion.angvel,
+	};
 
-		// Process the parsed data.
-		if (num == 2) {
-			// ZCM1
-			update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
-			update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
-			psmv->last_timestamp_ns = now_ns;
-		} else if (num == 1) {
-			// ZCM2
-			update_fusion(psmv, &input.sample, now_ns, delta_ns);
-			psmv->last_timestamp_ns = now_ns;
-		} else {
-			assert(false);
-		}
+	// Now done.
+	os_mutex_unlock(&psmv->lock);
 
-		// Now done.
-		os_mutex_unlock(&psmv->lock);
-	}
+	u_snapshot_publish(psmv->snapshot, &state);
 
-	return NULL;
+	return true;
 }
 
 static void
@@ -771,8 +785,12 @@ psmv_get_fusion_pose(struct psmv_device *psmv,
                      timepoint_ns when,
                      struct xrt_space_relation *out_relation)
 {
-	out_relation->pose.orientation = psmv->fusion.rot;
-	out_relation->angular_velocity = psmv->fusion.angvel;
+	struct psmv_input_state state = {0};
+	state.rot.w = 1.0f;
+	u_snapshot_read(psmv->snapshot, &state);
+
+	out_relation->pose.orientation = state.rot;
+	out_relation->angular_velocity = state.angvel;
 	out_relation->linear_velocity.x = 0.0f;
 	out_relation->linear_velocity.y = 0.0f;
 	out_relation->linear_velocity.z = 0.0f;
@@ -783,7 +801,7 @@ psmv_get_fusion_pose(struct psmv_device *psmv,
 	 * device orientation is enough to get it into the right space, angular
 	 * velocity is a derivative so needs a special rotation.
 	 */
-	math_quat_rotate_derivative(&psmv->fusion.rot, &psmv->fusion.angvel, &out_relation->angular_velocity);
+	math_quat_rotate_derivative(&state.rot, &state.angvel, &out_relation->angular_velocity);
 
 	//! @todo assuming that orientation is actually currently tracked.
 	out_relation->relation_flags = (enum xrt_space_relation_flags)(
@@ -829,11 +847,14 @@ psmv_device_destroy(struct xrt_device *xdev)
 {
 	struct psmv_device *psmv = psmv_device(xdev);
 
-	// Destroy the thread object.
-	os_thread_helper_destroy(&psmv->oth);
+	// No callbacks are running once this returns.
+	os_hid_reactor_remove(psmv->reactor, &psmv->reactor_id);
+	os_hid_reactor_put_shared(&psmv->reactor);
 
-	// Now that the thread is not running we can destroy the lock.
+	// Now that no callbacks are running we can destroy the locks and snapshot.
 	os_mutex_destroy(&psmv->lock);
+	os_mutex_destroy(&psmv->output_lock);
+	u_snapshot_destroy(&psmv->snapshot);
 
 	// Destroy the IMU fusion.
 	imu_fusion_destroy(psmv->fusion.fusion);
@@ -859,27 +880,28 @@ psmv_device_update_inputs(struct xrt_device *xdev)
 {
 	struct psmv_device *psmv = psmv_device(xdev);
 
-	// Lock the data.
-	os_mutex_lock(&psmv->lock);
-
-	// clang-format off
-	uint64_t last_ns = psmv->last_timestamp_ns;
-	psmv_update_input_click(psmv, PSMV_INDEX_PS_CLICK, last_ns, PSMV_BUTTON_BIT_PS);
-	psmv_update_input_click(psmv, PSMV_INDEX_MOVE_CLICK, last_ns, PSMV_BUTTON_BIT_MOVE_ANY);
-	psmv_update_input_click(psmv, PSMV_INDEX_START_CLICK, last_ns, PSMV_BUTTON_BIT_START);
-	psmv_update_input_click(psmv, PSMV_INDEX_SELECT_CLICK, last_ns, PSMV_BUTTON_BIT_SELECT);
-	psmv_update_input_click(psmv, PSMV_INDEX_SQUARE_CLICK, last_ns, PSMV_BUTTON_BIT_SQUARE);
-	psmv_update_input_click(psmv, PSMV_INDEX_CROSS_CLICK, last_ns, PSMV_BUTTON_BIT_CROSS);
-	psmv_update_input_click(psmv, PSMV_INDEX_CIRCLE_CLICK, last_ns, PSMV_BUTTON_BIT_CIRCLE);
-	psmv_update_input_click(psmv, PSMV_INDEX_TRIANGLE_CLICK, last_ns, PSMV_BUTTON_BIT_TRIANGLE);
-	psmv_update_trigger_value(psmv, PSMV_INDEX_TRIGGER_VALUE, last_ns);
+	// Make sure the leds stays on, done here to keep writes out of the reactor.
+	psmv_led_and_trigger_update(psmv, os_monotonic_get_ns());
 
 	// Only report the ball as active if we can track it.
 	psmv->base.inputs[PSMV_INDEX_BALL_CENTER_POSE].active = psmv->ball != NULL;
-	// clang-format on
 
-	// Done now.
-	os_mutex_unlock(&psmv->lock);
+	struct psmv_input_state state;
+	if (!u_snapshot_read(psmv->snapshot, &state)) {
+		return;
+	}
+
+	// clang-format off
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_PS_CLICK, PSMV_BUTTON_BIT_PS);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_MOVE_CLICK, PSMV_BUTTON_BIT_MOVE_ANY);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_START_CLICK, PSMV_BUTTON_BIT_START);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_SELECT_CLICK, PSMV_BUTTON_BIT_SELECT);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_SQUARE_CLICK, PSMV_BUTTON_BIT_SQUARE);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_CROSS_CLICK, PSMV_BUTTON_BIT_CROSS);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_CIRCLE_CLICK, PSMV_BUTTON_BIT_CIRCLE);
+	psmv_update_input_click(psmv, &state, PSMV_INDEX_TRIANGLE_CLICK, PSMV_BUTTON_BIT_TRIANGLE);
+	psmv_update_trigger_value(psmv, &state, PSMV_INDEX_TRIGGER_VALUE);
+	// clang-format on
 }
 
 static xrt_result_t
@@ -939,7 +961,7 @@ psmv_device_set_output(struct xrt_device *xdev, enum xrt_output_name name, union
 		return;
 	}
 
-	os_mutex_lock(&psmv->lock);
+	os_mutex_lock(&psmv->output_lock);
 
 	float amp = value->vibration.amplitude;
 	// don't scale amp = 0, it disables rumble
@@ -952,7 +974,7 @@ psmv_device_set_output(struct xrt_device *xdev, enum xrt_output_name name, union
 	int64_t now = os_monotonic_get_ns();
 	psmv_led_and_trigger_update_locked(psmv, now);
 
-	os_mutex_unlock(&psmv->lock);
+	os_mutex_unlock(&psmv->output_lock);
 }
 
 
@@ -1031,6 +1053,7 @@ psmv_found(struct xrt_prober *xp,
 	psmv->base.num_binding_profiles = ARRAY_SIZE(binding_profiles);
 	psmv->fusion.rot.w = 1.0f;
 	psmv->fusion.fusion = imu_fusion_create();
+	u_snapshot_create(sizeof(struct psmv_input_state), &psmv->snapshot);
 	psmv->log_level = debug_get_log_option_psmv_log();
 	psmv->pid = devices[index]->product_id;
 	psmv->hid = hid;
@@ -1093,7 +1116,7 @@ psmv_found(struct xrt_prober *xp,
 	// We only have one output.
 	psmv->base.outputs[0].name = XRT_OUTPUT_NAME_PSMV_RUMBLE_VIBRATION;
 
-	// Mutex before thread.
+	// Mutex before reports.
 	ret = os_mutex_init(&psmv->lock);
 	if (ret != 0) {
 		PSMV_ERROR(psmv, "Failed to init mutex!");
@@ -1101,13 +1124,13 @@ psmv_found(struct xrt_prober *xp,
 		return ret;
 	}
 
-	// Thread and other state.
-	ret = os_thread_helper_init(&psmv->oth);
+	ret = os_mutex_init(&psmv->output_lock);
 	if (ret != 0) {
-		PSMV_ERROR(psmv, "Failed to init threading!");
+		PSMV_ERROR(psmv, "Failed to init mutex!");
 		psmv_device_destroy(&psmv->base);
 		return ret;
 	}
+
 	// Get calibration data.
 	ret = psmv_get_calibration(psmv);
 	if (ret != 0) {
@@ -1151,9 +1174,21 @@ psmv_found(struct xrt_prober *xp,
 	// Send the first update package.
 	psmv_led_and_trigger_update(psmv, 1);
 
-	ret = os_thread_helper_start(&psmv->oth, psmv_run_thread, psmv);
+	uint8_t buffer[256];
+	while (os_hid_read(psmv->hid, buffer, sizeof(buffer), 0) > 0) {
+		// Empty queue first
+	}
+
+	psmv->reactor = os_hid_reactor_get_shared();
+	if (psmv->reactor == NULL) {
+		PSMV_ERROR(psmv, "Failed to get hid reactor!");
+		psmv_device_destroy(&psmv->base);
+		return -1;
+	}
+
+	ret = os_hid_reactor_add(psmv->reactor, psmv->hid, psmv_handle_report, psmv, &psmv->reactor_id);
 	if (ret != 0) {
-		PSMV_ERROR(psmv, "Failed to start thread!");
+		PSMV_ERROR(psmv, "Failed to add device to reactor!");
 		psmv_device_destroy(&psmv->base);
 		return ret;
 	}
@@ -26,6 +26,7 @@
 #include "util/u_distortion_mesh.h"
 
 #include "math/m_imu_3dof.h"
+#include "math/m_relation_history.h"
 
 #include "math/m_mathinclude.h"
 
@@ -60,8 +61,13 @@ struct psvr_device
 
 	hid_device *hid_sensor;
 	hid_device *hid_control;
+
+	//! Held by the thread draining the device.
 	struct os_mutex device_mutex;
 
+	//! Timestamped fusion output, written by the draining thread, read without the mutex.
+	struct m_relation_history *relation_hist;
+
 	struct xrt_tracked_psvr *tracker;
 
 	timepoint_ns last_sensor_time;
@@ -311,6 +317,16 @@ update_fusion(struct psvr_device *psvr, struct psvr_parsed_sample *sample, uint6
 		xrt_tracked_psvr_push_imu(psvr->tracker, timestamp_ns, &sample);
 	} else {
 		m_imu_3dof_update(&psvr->fusion, timestamp_ns, &psvr->read.accel, &psvr->read.gyro);
+
+		// The gyro is in body space.
+		struct xrt_space_relation relation = {0};
+		relation.pose.orientation = psvr->fusion.rot;
+		math_quat_rotate_derivative(&psvr->fusion.rot, &psvr->read.gyro, &relation.angular_velocity);
+		relation.relation_flags =
+		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+		    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+		m_relation_history_push(psvr->relation_hist, &relation, timestamp_ns);
 	}
 }
 
@@ -868,6 +884,7 @@ teardown(struct psvr_device *psvr)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&psvr->fusion);
+	m_relation_history_destroy(&psvr->relation_hist);
 
 	os_mutex_destroy(&psvr->device_mutex);
 }
@@ -879,12 +896,31 @@ teardown(struct psvr_device *psvr)
  *
  */
 
+/*!
+ * Drain the device and publish the fusion output, unless another thread is
+ * already doing so in which case it returns right away.
+ */
+static void
+try_read_packets(struct psvr_device *psvr, bool control)
+{
+	if (os_mutex_trylock(&psvr->device_mutex) != 0) {
+		return;
+	}
+
+	read_sensor_packets(psvr);
+	if (control) {
+		read_control_packets(psvr);
+	}
+
+	os_mutex_unlock(&psvr->device_mutex);
+}
+
 static void
 psvr_device_update_inputs(struct xrt_device *xdev)
 {
 	struct psvr_device *psvr = psvr_device(xdev);
 
-	read_sensor_packets(psvr);
+	try_read_packets(psvr, false);
 	update_leds_if_changed(psvr);
 }
 
@@ -901,27 +937,19 @@ psvr_device_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	os_mutex_lock(&psvr->device_mutex);
-
-	// Read all packets.
-	read_sensor_packets(psvr);
-	read_control_packets(psvr);
+	// Read all packets, a thread already doing so won't make us wait.
+	try_read_packets(psvr, true);
 
 	// Clear out the relation.
 	U_ZERO(out_relation);
 
 	// We have no tracking, don't return a position.
 	if (psvr->tracker == NULL) {
-		out_relation->pose.orientation = psvr->fusion.rot;
-
-		out_relation->relation_flags = (enum xrt_space_relation_flags)(
-		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+		m_relation_history_get(psvr->relation_hist, at_timestamp_ns, out_relation);
 	} else {
 		xrt_tracked_psvr_get_tracked_pose(psvr->tracker, at_timestamp_ns, out_relation);
 	}
 
-	os_mutex_unlock(&psvr->device_mutex);
-
 	//! @todo Move this to the tracker.
 	// Make sure that the orientation is valid.
 	math_quat_normalize(&out_relation->pose.orientation);
@@ -1010,6 +1038,7 @@ psvr_device_create(struct hid_device_info *sensor_hid_info,
 #else
 	psvr->fusion.rot.w = 1.0f;
 #endif
+	m_relation_history_create(&psvr->relation_hist);
 
 	snprintf(psvr->base.str, XRT_DEVICE_NAME_LEN, "PS VR Headset");
 	snprintf(psvr->base.serial, XRT_DEVICE_NAME_LEN, "PS VR Headset");
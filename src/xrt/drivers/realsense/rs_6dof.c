@@ -14,10 +14,11 @@
 #include "xrt/xrt_device.h"
 #include "math/m_api.h"
 #include "math/m_space.h"
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 
 #include "os/os_time.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_time.h"
 #include "util/u_device.h"
@@ -54,6 +55,9 @@ struct rs_6dof
 	uint64_t relation_timestamp_ns;
 	struct xrt_space_relation relation;
 
+	//! Every pose from the camera, in monotonic time, read without the lock.
+	struct m_relation_history *relation_hist;
+
 	struct os_thread_helper oth;
 
 	bool enable_mapping;
@@ -287,6 +291,8 @@ process_frame(struct rs_6dof *rs, rs2_frame *frame)
 	    XRT_SPACE_RELATION_POSITION_TRACKED_BIT;
 	// clang-format on
 
+	m_relation_history_push(rs->relation_hist, &rs->relation, timestamp_ns);
+
 	// Re-use the thread lock for the data.
 	os_thread_helper_unlock(&rs->oth);
 }
@@ -329,6 +335,8 @@ rs_run_thread(void *ptr)
 {
 	struct rs_6dof *rs = (struct rs_6dof *)ptr;
 
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "rs_6dof");
+
 	os_thread_helper_lock(&rs->oth);
 
 	while (os_thread_helper_is_running_locked(&rs->oth)) {
@@ -413,20 +421,14 @@ rs_6dof_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	os_thread_helper_lock(&rs->oth);
-	struct xrt_space_relation relation_not_predicted = rs->relation;
-	uint64_t relation_timestamp_ns = rs->relation_timestamp_ns;
-	os_thread_helper_unlock(&rs->oth);
-
-	int64_t diff_prediction_ns = 0;
-	diff_prediction_ns = at_timestamp_ns - relation_timestamp_ns;
-
-	double delta_s = time_ns_to_s(diff_prediction_ns);
 	if (rs->enable_pose_prediction) {
-		m_predict_relation(&relation_not_predicted, delta_s, out_relation);
-	} else {
-		*out_relation = relation_not_predicted;
+		m_relation_history_get(rs->relation_hist, at_timestamp_ns, out_relation);
+		return;
 	}
+
+	os_thread_helper_lock(&rs->oth);
+	*out_relation = rs->relation;
+	os_thread_helper_unlock(&rs->oth);
 }
 static void
 rs_6dof_get_view_pose(struct xrt_device *xdev,
@@ -447,6 +449,8 @@ rs_6dof_destroy(struct xrt_device *xdev)
 
 	close_6dof(rs);
 
+	m_relation_history_destroy(&rs->relation_hist);
+
 	free(rs);
 }
 
@@ -482,6 +486,7 @@ rs_6dof_create(void)
 	rs->base.destroy = rs_6dof_destroy;
 	rs->base.name = XRT_DEVICE_REALSENSE;
 	rs->relation.pose.orientation.w = 1.0f; // All other values set to zero.
+	m_relation_history_create(&rs->relation_hist);
 
 	rs->base.tracking_origin->type = XRT_TRACKING_TYPE_EXTERNAL_SLAM;
 
@@ -29,6 +29,7 @@
 #include "util/u_config_json.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "os/os_time.h"
 
@@ -42,7 +43,7 @@
 #include "util/u_hand_tracking.h"
 #include "util/u_logging.h"
 
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 
 #include "vive/vive_config.h"
 
@@ -129,6 +130,9 @@ struct survive_device
 	struct xrt_space_relation last_relation;
 	timepoint_ns last_relation_ts;
 
+	//! Every pose libsurvive gave us, written by the event thread, read without a lock.
+	struct m_relation_history *relation_hist;
+
 	//! Number of inputs.
 	size_t num_last_inputs;
 	//! Array of input structs.
@@ -215,6 +219,7 @@ survive_device_destroy(struct xrt_device *xdev)
 	}
 
 	free(survive->last_inputs);
+	m_relation_history_destroy(&survive->relation_hist);
 	u_device_free(&survive->base);
 }
 
@@ -299,20 +304,6 @@ pose_to_relation(const SurvivePose *pose, const SurviveVelocity *vel, struct xrt
 	}
 }
 
-static void
-_predict_pose(struct survive_device *survive, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
-{
-	timepoint_ns prediction_ns = at_timestamp_ns - survive->last_relation_ts;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
-	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
-	SURVIVE_TRACE(survive, "dev %s At %ldns: Pose requested for +%ldns (%ldns), predicting %ldns",
-	              survive->base.str, monotonic_now_ns, remaining_ns, at_timestamp_ns, prediction_ns);
-
-	m_predict_relation(&survive->last_relation, prediction_s, out_relation);
-}
-
 static bool
 verify_device_name(struct survive_device *survive, enum xrt_input_name name)
 {
@@ -344,9 +335,7 @@ survive_device_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	os_mutex_lock(&survive->sys->lock);
-	_predict_pose(survive, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&survive->sys->lock);
+	m_relation_history_get(survive->relation_hist, at_timestamp_ns, out_relation);
 
 	struct xrt_pose *p = &out_relation->pose;
 	SURVIVE_TRACE(survive, "GET_POSITION (%f %f %f) GET_ORIENTATION (%f, %f, %f, %f)", p->position.x, p->position.y,
@@ -732,6 +721,7 @@ _process_pose_event(struct survive_device *survive, const struct SurviveSimplePo
 {
 	pose_to_relation(&e->pose, &e->velocity, &survive->last_relation);
 	survive->last_relation_ts = survive_timecode_to_monotonic(e->time);
+	m_relation_history_push(survive->relation_hist, &survive->last_relation, survive->last_relation_ts);
 	SURVIVE_TRACE(survive, "Process pose event for %s", survive->base.str);
 }
 
@@ -822,6 +812,8 @@ _create_hmd_device(struct survive_system *sys, const struct SurviveSimpleObject
 		return false;
 	}
 
+	m_relation_history_create(&survive->relation_hist);
+
 	sys->hmd = survive;
 	survive->sys = sys;
 	survive->survive_obj = sso;
@@ -1037,6 +1029,7 @@ _create_controller_device(struct survive_system *sys,
 	int outputs = 1;
 	struct survive_device *survive = U_DEVICE_ALLOCATE(struct survive_device, flags, inputs, outputs);
 	survive->ctrl.config = *config;
+	m_relation_history_create(&survive->relation_hist);
 
 	sys->controllers[idx] = survive;
 	survive->sys = sys;
@@ -1253,6 +1246,8 @@ run_event_thread(void *ptr)
 {
 	struct survive_system *ss = (struct survive_system *)ptr;
 
+	os_thread_role_set(OS_THREAD_ROLE_IMU, "survive_events");
+
 	os_thread_helper_lock(&ss->event_thread);
 	while (os_thread_helper_is_running_locked(&ss->event_thread)) {
 		os_thread_helper_unlock(&ss->event_thread);
@@ -18,6 +18,7 @@
 #include "util/u_time.h"
 #include "os/os_time.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "Leap.h"
 
@@ -201,6 +202,8 @@ leap_input_loop(void *ptr_to_xdev)
 	struct ulv2_device *ulv2d = ulv2_device(xdev);
 	ULV2_DEBUG(ulv2d, "num tries %d; sleep time %f", num_tries, timeout);
 
+	os_thread_role_set(OS_THREAD_ROLE_TRACKING, "ulv2");
+
 	Leap::Controller LeapController;
 	os_nanosleep(U_1_000_000_000 * 0.01);
 	// sleep for an arbitrary amount of time so that Leap::Controller can initialize and connect to the service.
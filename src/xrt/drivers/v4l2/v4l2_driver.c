@@ -9,6 +9,7 @@
  */
 
 #include "os/os_time.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -807,6 +808,8 @@ v4l2_fs_mainloop(void *ptr)
 	struct xrt_fs *xfs = (struct xrt_fs *)ptr;
 	struct v4l2_fs *vid = v4l2_fs(xfs);
 
+	os_thread_role_set(OS_THREAD_ROLE_CAMERA, "v4l2");
+
 	V4L2_DEBUG(vid, "info: Thread enter!");
 
 	if (vid->fd == -1) {
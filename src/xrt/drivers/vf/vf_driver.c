@@ -11,6 +11,7 @@
 
 #include "os/os_time.h"
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "util/u_trace_marker.h"
 #include "util/u_var.h"
@@ -298,6 +299,8 @@ vf_fs_mainloop(void *ptr)
 
 	struct vf_fs *vid = (struct vf_fs *)ptr;
 
+	os_thread_role_set(OS_THREAD_ROLE_CAMERA, "vf");
+
 	VF_DEBUG(vid, "Let's run!");
 	g_main_loop_run(vid->loop);
 	VF_DEBUG(vid, "Going out!");
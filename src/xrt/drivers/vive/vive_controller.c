@@ -22,7 +22,7 @@
 #include "xrt/xrt_prober.h"
 
 #include "math/m_api.h"
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_json.h"
@@ -105,12 +105,16 @@ vive_controller_device_destroy(struct xrt_device *xdev)
 {
 	struct vive_controller_device *d = vive_controller_device(xdev);
 
-	os_thread_helper_destroy(&d->controller_thread);
+	// No callbacks are running once this returns.
+	os_hid_reactor_remove(d->reactor, &d->controller_reactor_id);
+	os_hid_reactor_put_shared(&d->reactor);
 
-	// Now that the thread is not running we can destroy the lock.
+	// Now that no callbacks are running we can destroy the lock and snapshot.
 	os_mutex_destroy(&d->lock);
+	u_snapshot_destroy(&d->state_snapshot);
 
 	m_imu_3dof_close(&d->fusion);
+	m_relation_history_destroy(&d->relation_hist);
 
 	if (d->controller_hid)
 		os_hid_destroy(d->controller_hid);
@@ -123,9 +127,12 @@ vive_controller_device_update_wand_inputs(struct xrt_device *xdev)
 {
 	struct vive_controller_device *d = vive_controller_device(xdev);
 
-	os_mutex_lock(&d->lock);
+	struct vive_controller_state state;
+	if (!u_snapshot_read(d->state_snapshot, &state)) {
+		return;
+	}
 
-	uint8_t buttons = d->state.buttons;
+	uint8_t buttons = state.buttons;
 
 	/*
 	int i = 8;
@@ -137,7 +144,7 @@ vive_controller_device_update_wand_inputs(struct xrt_device *xdev)
 
 	uint64_t now = os_monotonic_get_ns();
 
-	/* d->state.buttons is bitmask of currently pressed buttons.
+	/* state.buttons is bitmask of currently pressed buttons.
 	 * (index n) nth bit in the bitmask -> input "name"
 	 */
 	const int button_index_map[] = {VIVE_CONTROLLER_INDEX_TRIGGER_CLICK,  VIVE_CONTROLLER_INDEX_TRACKPAD_TOUCH,
@@ -148,7 +155,7 @@ vive_controller_device_update_wand_inputs(struct xrt_device *xdev)
 	for (int i = 0; i < button_count; i++) {
 
 		bool pressed = (buttons >> i) & 1;
-		bool last_pressed = (d->state.last_buttons >> i) & 1;
+		bool last_pressed = (d->last_buttons >> i) & 1;
 
 		if (pressed != last_pressed) {
 			struct xrt_input *input = &d->base.inputs[button_index_map[i]];
@@ -159,22 +166,20 @@ vive_controller_device_update_wand_inputs(struct xrt_device *xdev)
 			VIVE_DEBUG(d, "button %d %s\n", i, pressed ? "pressed" : "released");
 		}
 	}
-	d->state.last_buttons = d->state.buttons;
+	d->last_buttons = state.buttons;
 
 
 	struct xrt_input *trackpad_input = &d->base.inputs[VIVE_CONTROLLER_INDEX_TRACKPAD];
 	trackpad_input->timestamp = now;
-	trackpad_input->value.vec2.x = d->state.trackpad.x;
-	trackpad_input->value.vec2.y = d->state.trackpad.y;
-	VIVE_TRACE(d, "Trackpad: %f, %f", d->state.trackpad.x, d->state.trackpad.y);
+	trackpad_input->value.vec2.x = state.trackpad.x;
+	trackpad_input->value.vec2.y = state.trackpad.y;
+	VIVE_TRACE(d, "Trackpad: %f, %f", state.trackpad.x, state.trackpad.y);
 
 
 	struct xrt_input *trigger_input = &d->base.inputs[VIVE_CONTROLLER_INDEX_TRIGGER_VALUE];
 	trigger_input->timestamp = now;
-	trigger_input->value.vec1.x = d->state.trigger;
-	VIVE_TRACE(d, "Trigger: %f", d->state.trigger);
-
-	os_mutex_unlock(&d->lock);
+	trigger_input->value.vec1.x = state.trigger;
+	VIVE_TRACE(d, "Trigger: %f", state.trigger);
 }
 
 static void
@@ -182,8 +187,12 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 {
 	struct vive_controller_device *d = vive_controller_device(xdev);
 
-	os_mutex_lock(&d->lock);
-	uint8_t buttons = d->state.buttons;
+	struct vive_controller_state state;
+	if (!u_snapshot_read(d->state_snapshot, &state)) {
+		return;
+	}
+
+	uint8_t buttons = state.buttons;
 
 	/*
 	int i = 8;
@@ -197,7 +206,7 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 
 	uint64_t now = os_monotonic_get_ns();
 
-	/* d->state.buttons is bitmask of currently pressed buttons.
+	/* state.buttons is bitmask of currently pressed buttons.
 	 * (index n) nth bit in the bitmask -> input "name"
 	 */
 	const int button_index_map[] = {VIVE_CONTROLLER_INDEX_TRIGGER_CLICK,    VIVE_CONTROLLER_INDEX_TRACKPAD_TOUCH,
@@ -208,7 +217,7 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 	for (int i = 0; i < button_count; i++) {
 
 		bool pressed = (buttons >> i) & 1;
-		bool last_pressed = (d->state.last_buttons >> i) & 1;
+		bool last_pressed = (d->last_buttons >> i) & 1;
 
 		if (pressed != last_pressed) {
 			struct xrt_input *input = &d->base.inputs[button_index_map[i]];
@@ -219,7 +228,7 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 			VIVE_DEBUG(d, "button %d %s\n", i, pressed ? "pressed" : "released");
 		}
 	}
-	d->state.last_buttons = d->state.buttons;
+	d->last_buttons = state.buttons;
 
 	bool is_trackpad_touched = d->base.inputs[VIVE_CONTROLLER_INDEX_TRACKPAD_TOUCH].value.boolean;
 
@@ -235,22 +244,22 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 	else
 		thumb_input = &d->base.inputs[VIVE_CONTROLLER_INDEX_THUMBSTICK];
 	thumb_input->timestamp = now;
-	thumb_input->value.vec2.x = d->state.trackpad.x;
-	thumb_input->value.vec2.y = d->state.trackpad.y;
+	thumb_input->value.vec2.x = state.trackpad.x;
+	thumb_input->value.vec2.y = state.trackpad.y;
 
 	const char *component = is_trackpad_touched || was_trackpad_touched ? "Trackpad" : "Thumbstick";
-	VIVE_TRACE(d, "%s: %f, %f", component, d->state.trackpad.x, d->state.trackpad.y);
+	VIVE_TRACE(d, "%s: %f, %f", component, state.trackpad.x, state.trackpad.y);
 
 
 	struct xrt_input *trigger_input = &d->base.inputs[VIVE_CONTROLLER_INDEX_TRIGGER_VALUE];
 
 	trigger_input->timestamp = now;
-	trigger_input->value.vec1.x = d->state.trigger;
+	trigger_input->value.vec1.x = state.trigger;
 
-	VIVE_TRACE(d, "Trigger: %f", d->state.trigger);
+	VIVE_TRACE(d, "Trigger: %f", state.trigger);
 
 
-	/* d->state.touch is bitmask of currently touched buttons.
+	/* state.touch is bitmask of currently touched buttons.
 	 * (index n) nth bit in the bitmask -> input "name"
 	 */
 	const int touched_button_index_map[] = {0,
@@ -261,11 +270,11 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 	                                        VIVE_CONTROLLER_INDEX_B_TOUCH,
 	                                        VIVE_CONTROLLER_INDEX_THUMBSTICK_TOUCH};
 	int touch_button_count = ARRAY_SIZE(touched_button_index_map);
-	uint8_t touch_buttons = d->state.touch;
+	uint8_t touch_buttons = state.touch;
 	for (int i = 0; i < touch_button_count; i++) {
 
 		bool touched = (touch_buttons >> i) & 1;
-		bool last_touched = (d->state.last_touch >> i) & 1;
+		bool last_touched = (d->last_touch >> i) & 1;
 
 		if (touched != last_touched) {
 			struct xrt_input *input = &d->base.inputs[touched_button_index_map[i]];
@@ -276,21 +285,19 @@ vive_controller_device_update_index_inputs(struct xrt_device *xdev)
 			VIVE_DEBUG(d, "button %d %s\n", i, touched ? "touched" : "untouched");
 		}
 	}
-	d->state.last_touch = d->state.touch;
+	d->last_touch = state.touch;
 
-	d->base.inputs[VIVE_CONTROLLER_INDEX_SQUEEZE_FORCE].value.vec1.x = (float)d->state.squeeze_force / UINT8_MAX;
+	d->base.inputs[VIVE_CONTROLLER_INDEX_SQUEEZE_FORCE].value.vec1.x = (float)state.squeeze_force / UINT8_MAX;
 	d->base.inputs[VIVE_CONTROLLER_INDEX_SQUEEZE_FORCE].timestamp = now;
-	if (d->state.squeeze_force > 0) {
-		VIVE_DEBUG(d, "Squeeze force: %f\n", (float)d->state.squeeze_force / UINT8_MAX);
+	if (state.squeeze_force > 0) {
+		VIVE_DEBUG(d, "Squeeze force: %f\n", (float)state.squeeze_force / UINT8_MAX);
 	}
 
-	d->base.inputs[VIVE_CONTROLLER_INDEX_TRACKPAD_FORCE].value.vec1.x = (float)d->state.trackpad_force / UINT8_MAX;
+	d->base.inputs[VIVE_CONTROLLER_INDEX_TRACKPAD_FORCE].value.vec1.x = (float)state.trackpad_force / UINT8_MAX;
 	d->base.inputs[VIVE_CONTROLLER_INDEX_TRACKPAD_FORCE].timestamp = now;
-	if (d->state.trackpad_force > 0) {
-		VIVE_DEBUG(d, "Trackpad force: %f\n", (float)d->state.trackpad_force / UINT8_MAX);
+	if (state.trackpad_force > 0) {
+		VIVE_DEBUG(d, "Trackpad force: %f\n", (float)state.trackpad_force / UINT8_MAX);
 	}
-
-	os_mutex_unlock(&d->lock);
 }
 
 
@@ -324,10 +331,13 @@ vive_controller_get_hand_tracking(struct xrt_device *xdev,
 		thumb_curl = 1.0;
 	}
 
-	struct u_hand_tracking_curl_values values = {.little = (float)d->state.pinky_finger_handle / UINT8_MAX,
-	                                             .ring = (float)d->state.ring_finger_handle / UINT8_MAX,
-	                                             .middle = (float)d->state.middle_finger_handle / UINT8_MAX,
-	                                             .index = (float)d->state.index_finger_trigger / UINT8_MAX,
+	struct vive_controller_state state = {0};
+	u_snapshot_read(d->state_snapshot, &state);
+
+	struct u_hand_tracking_curl_values values = {.little = (float)state.pinky_finger_handle / UINT8_MAX,
+	                                             .ring = (float)state.ring_finger_handle / UINT8_MAX,
+	                                             .middle = (float)state.middle_finger_handle / UINT8_MAX,
+	                                             .index = (float)state.index_finger_trigger / UINT8_MAX,
 	                                             .thumb = thumb_curl};
 
 	u_hand_joints_update_curl(&d->hand_tracking, hand, at_timestamp_ns, &values);
@@ -357,25 +367,6 @@ vive_controller_get_hand_tracking(struct xrt_device *xdev,
 	out_value->is_active = true;
 }
 
-static void
-predict_pose(struct vive_controller_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
-{
-	timepoint_ns prediction_ns = at_timestamp_ns - d->imu.ts_received_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
-	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
-	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns), predicting %ldns", d->base.str,
-	           monotonic_now_ns, remaining_ns, at_timestamp_ns, prediction_ns);
-
-	//! @todo integrate position here
-	struct xrt_space_relation relation = {0};
-	relation.pose.orientation = d->rot_filtered;
-	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
-
-	m_predict_relation(&relation, prediction_s, out_relation);
-}
-
 static void
 vive_controller_device_get_tracked_pose(struct xrt_device *xdev,
                                         enum xrt_input_name name,
@@ -394,9 +385,8 @@ vive_controller_device_get_tracked_pose(struct xrt_device *xdev,
 	// Clear out the relation.
 	U_ZERO(out_relation);
 
-	os_mutex_lock(&d->lock);
-	predict_pose(d, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&d->lock);
+	//! @todo integrate position here
+	m_relation_history_get(d->relation_hist, at_timestamp_ns, out_relation);
 
 	struct xrt_vec3 pos = out_relation->pose.position;
 	struct xrt_quat quat = out_relation->pose.orientation;
@@ -610,6 +600,16 @@ vive_controller_handle_imu_sample(struct vive_controller_device *d, struct watch
 
 	d->rot_filtered = d->fusion.rot;
 
+	// The gyro is in body space, the relation wants it in base space.
+	struct xrt_space_relation relation = {0};
+	relation.pose.orientation = d->rot_filtered;
+	math_quat_rotate_derivative(&d->rot_filtered, &angular_velocity, &relation.angular_velocity);
+	relation.relation_flags =
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+	m_relation_history_push(d->relation_hist, &relation, d->imu.ts_received_ns);
+
 	//      VIVE_TRACE(d, "Rot %f %f %f", d->rot_filtered.x,
 	//                           d->rot_filtered.y, d->rot_filtered.z);
 }
@@ -915,34 +915,26 @@ vive_controller_decode_message(struct vive_controller_device *d, struct vive_con
 
 #define FEATURE_BUFFER_SIZE 256
 
-static int
-vive_controller_device_update(struct vive_controller_device *d)
+static bool
+vive_controller_handle_report(void *ptr, const uint8_t *buf, int size)
 {
-	uint8_t buf[FEATURE_BUFFER_SIZE];
-
-	int ret = os_hid_read(d->controller_hid, buf, sizeof(buf), 1000);
-	if (ret == 0) {
-		// controller off
-		return true;
-	}
+	struct vive_controller_device *d = (struct vive_controller_device *)ptr;
 
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read device '%i'!", ret);
+	if (size < 0) {
+		VIVE_ERROR(d, "Failed to read device '%i'!", size);
 		return false;
 	}
 
 	switch (buf[0]) {
 	case VIVE_CONTROLLER_REPORT1_ID:
-		os_mutex_lock(&d->lock);
 		vive_controller_decode_message(d, &((struct vive_controller_report1 *)buf)->message);
-		os_mutex_unlock(&d->lock);
+		u_snapshot_publish(d->state_snapshot, &d->state);
 		break;
 
 	case VIVE_CONTROLLER_REPORT2_ID:
-		os_mutex_lock(&d->lock);
 		vive_controller_decode_message(d, &((struct vive_controller_report2 *)buf)->message[0]);
 		vive_controller_decode_message(d, &((struct vive_controller_report2 *)buf)->message[1]);
-		os_mutex_unlock(&d->lock);
+		u_snapshot_publish(d->state_snapshot, &d->state);
 		break;
 	case VIVE_CONTROLLER_DISCONNECT_REPORT_ID: VIVE_DEBUG(d, "Controller disconnected."); break;
 	default: VIVE_ERROR(d, "Unknown controller message type: %u", buf[0]);
@@ -951,31 +943,6 @@ vive_controller_device_update(struct vive_controller_device *d)
 	return true;
 }
 
-static void *
-vive_controller_run_thread(void *ptr)
-{
-	struct vive_controller_device *d = (struct vive_controller_device *)ptr;
-
-	uint8_t buf[FEATURE_BUFFER_SIZE];
-	while (os_hid_read(d->controller_hid, buf, sizeof(buf), 0) > 0) {
-		// Empty queue first
-	}
-
-	os_thread_helper_lock(&d->controller_thread);
-	while (os_thread_helper_is_running_locked(&d->controller_thread)) {
-		os_thread_helper_unlock(&d->controller_thread);
-
-		if (!vive_controller_device_update(d)) {
-			return NULL;
-		}
-
-		// Just keep swimming.
-		os_thread_helper_lock(&d->controller_thread);
-	}
-
-	return NULL;
-}
-
 /*
  *
  * Bindings
@@ -1049,6 +1016,8 @@ vive_controller_create(struct os_hid_device *controller_hid, enum watchman_gen w
 	d->watchman_gen = watchman_gen;
 
 	m_imu_3dof_init(&d->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_relation_history_create(&d->relation_hist);
+	u_snapshot_create(sizeof(struct vive_controller_state), &d->state_snapshot);
 
 	/* default values, will be queried from device */
 	d->config.imu.gyro_range = 8.726646f;
@@ -1185,7 +1154,7 @@ vive_controller_create(struct os_hid_device *controller_hid, enum watchman_gen w
 	}
 
 	if (d->controller_hid) {
-		// Mutex before thread.
+		// Mutex before reports.
 		int ret = os_mutex_init(&d->lock);
 		if (ret != 0) {
 			VIVE_ERROR(d, "Failed to init mutex!");
@@ -1193,9 +1162,22 @@ vive_controller_create(struct os_hid_device *controller_hid, enum watchman_gen w
 			return NULL;
 		}
 
-		ret = os_thread_helper_start(&d->controller_thread, vive_controller_run_thread, d);
+		uint8_t buf[FEATURE_BUFFER_SIZE];
+		while (os_hid_read(d->controller_hid, buf, sizeof(buf), 0) > 0) {
+			// Empty queue first
+		}
+
+		d->reactor = os_hid_reactor_get_shared();
+		if (d->reactor == NULL) {
+			VIVE_ERROR(d, "Failed to get hid reactor!");
+			vive_controller_device_destroy(&d->base);
+			return NULL;
+		}
+
+		ret = os_hid_reactor_add(d->reactor, d->controller_hid, vive_controller_handle_report, d,
+		                         &d->controller_reactor_id);
 		if (ret != 0) {
-			VIVE_ERROR(d, "Failed to start mainboard thread!");
+			VIVE_ERROR(d, "Failed to add controller device to reactor!");
 			vive_controller_device_destroy(&d->base);
 			return NULL;
 		}
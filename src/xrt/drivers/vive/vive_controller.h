@@ -15,9 +15,11 @@
 
 #include "xrt/xrt_device.h"
 #include "os/os_threading.h"
+#include "os/os_hid_reactor.h"
 #include "math/m_imu_3dof.h"
 #include "util/u_logging.h"
 #include "util/u_hand_tracking.h"
+#include "util/u_snapshot.h"
 #include "vive/vive_config.h"
 
 
@@ -37,6 +39,30 @@ enum watchman_gen
 	WATCHMAN_GEN_UNKNOWN
 };
 
+/*!
+ * Input state decoded from the controller reports.
+ *
+ * @ingroup drv_vive
+ */
+struct vive_controller_state
+{
+	struct xrt_vec2 trackpad;
+	float trigger;
+	uint8_t buttons;
+	uint8_t touch;
+
+	uint8_t middle_finger_handle;
+	uint8_t ring_finger_handle;
+	uint8_t pinky_finger_handle;
+	uint8_t index_finger_trigger;
+
+	uint8_t squeeze_force;
+	uint8_t trackpad_force;
+
+	bool charging;
+	uint8_t battery;
+};
+
 /*!
  * A Vive Controller device, representing just a single controller.
  *
@@ -48,7 +74,10 @@ struct vive_controller_device
 	struct xrt_device base;
 
 	struct os_hid_device *controller_hid;
-	struct os_thread_helper controller_thread;
+	struct os_hid_reactor *reactor;
+	uint32_t controller_reactor_id;
+
+	//! Serialises the haptic output.
 	struct os_mutex lock;
 
 	struct
@@ -60,6 +89,9 @@ struct vive_controller_device
 
 	struct m_imu_3dof fusion;
 
+	//! Timestamped fusion output, written from the controller reports, read without a lock.
+	struct m_relation_history *relation_hist;
+
 	struct
 	{
 		struct xrt_vec3 acc;
@@ -75,27 +107,15 @@ struct vive_controller_device
 	//! Which vive controller in the system are we?
 	size_t index;
 
-	struct
-	{
-		struct xrt_vec2 trackpad;
-		float trigger;
-		uint8_t buttons;
-		uint8_t last_buttons;
-
-		uint8_t touch;
-		uint8_t last_touch;
-
-		uint8_t middle_finger_handle;
-		uint8_t ring_finger_handle;
-		uint8_t pinky_finger_handle;
-		uint8_t index_finger_trigger;
+	//! Only touched by the controller reports, published after each one.
+	struct vive_controller_state state;
 
-		uint8_t squeeze_force;
-		uint8_t trackpad_force;
+	//! Latest @ref vive_controller_state, read without a lock.
+	struct u_snapshot *state_snapshot;
 
-		bool charging;
-		uint8_t battery;
-	} state;
+	//! Buttons and touches as last seen by update_inputs.
+	uint8_t last_buttons;
+	uint8_t last_touch;
 
 	enum watchman_gen watchman_gen;
 
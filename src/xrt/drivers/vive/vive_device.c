@@ -19,7 +19,7 @@
 #include "util/u_time.h"
 
 #include "math/m_api.h"
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 
 #include "os/os_hid.h"
 #include "os/os_time.h"
@@ -49,15 +49,17 @@ vive_device_destroy(struct xrt_device *xdev)
 	if (d->mainboard_dev)
 		vive_mainboard_power_off(d);
 
-	// Destroy the thread object.
-	os_thread_helper_destroy(&d->sensors_thread);
-	os_thread_helper_destroy(&d->watchman_thread);
-	os_thread_helper_destroy(&d->mainboard_thread);
+	// Stop getting reports, no callbacks are running once these return.
+	os_hid_reactor_remove(d->reactor, &d->sensors_reactor_id);
+	os_hid_reactor_remove(d->reactor, &d->watchman_reactor_id);
+	os_hid_reactor_remove(d->reactor, &d->mainboard_reactor_id);
+	os_hid_reactor_put_shared(&d->reactor);
 
-	// Now that the thread is not running we can destroy the lock.
+	// Now that no callbacks are running we can destroy the lock.
 	os_mutex_destroy(&d->lock);
 
 	m_imu_3dof_close(&d->fusion);
+	m_relation_history_destroy(&d->relation_hist);
 
 	if (d->mainboard_dev != NULL) {
 		os_hid_destroy(d->mainboard_dev);
@@ -89,25 +91,6 @@ vive_device_update_inputs(struct xrt_device *xdev)
 	VIVE_TRACE(d, "ENTER!");
 }
 
-static void
-predict_pose(struct vive_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
-{
-	timepoint_ns prediction_ns = at_timestamp_ns - d->imu.ts_received_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
-	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
-	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns), predicting %ldns", d->base.str,
-	           monotonic_now_ns, remaining_ns, at_timestamp_ns, prediction_ns);
-
-	//! @todo integrate position here
-	struct xrt_space_relation relation = {0};
-	relation.pose.orientation = d->rot_filtered;
-	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
-
-	m_predict_relation(&relation, prediction_s, out_relation);
-}
-
 static void
 vive_device_get_tracked_pose(struct xrt_device *xdev,
                              enum xrt_input_name name,
@@ -124,12 +107,8 @@ vive_device_get_tracked_pose(struct xrt_device *xdev,
 	// Clear out the relation.
 	U_ZERO(out_relation);
 
-	//! @todo Use this properly.
-	(void)at_timestamp_ns;
-
-	os_mutex_lock(&d->lock);
-	predict_pose(d, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&d->lock);
+	//! @todo integrate position here
+	m_relation_history_get(d->relation_hist, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -277,6 +256,12 @@ update_imu(struct vive_device *d, const void *buffer)
 	d->imu.ts_received_ns = os_monotonic_get_ns();
 	int i, j;
 
+	// New samples, fed to the fusion together.
+	uint64_t timestamps_ns[3];
+	struct xrt_vec3 accels[3];
+	struct xrt_vec3 gyros[3];
+	size_t num = 0;
+
 	/*
 	 * The three samples are updated round-robin. New messages
 	 * can contain already seen samples in any place, but the
@@ -374,37 +359,51 @@ update_imu(struct vive_device *d, const void *buffer)
 		d->imu.time_ns += dt_ns;
 		d->imu.sequence = seq;
 
-		m_imu_3dof_update(&d->fusion, d->imu.time_ns, &acceleration, &angular_velocity);
+		timestamps_ns[num] = d->imu.time_ns;
+		accels[num] = acceleration;
+		gyros[num] = angular_velocity;
+		num++;
+	}
 
-		d->rot_filtered = d->fusion.rot;
+	if (num == 0) {
+		return;
 	}
+
+	m_imu_3dof_update_batch(&d->fusion, timestamps_ns, accels, gyros, num);
+
+	d->rot_filtered = d->fusion.rot;
+
+	// The newest sample is the one that just arrived, the gyro is in body space.
+	struct xrt_space_relation relation = {0};
+	relation.pose.orientation = d->rot_filtered;
+	math_quat_rotate_derivative(&d->rot_filtered, &d->fusion.last.gyro, &relation.angular_velocity);
+	relation.relation_flags =
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+
+	m_relation_history_push(d->relation_hist, &relation, d->imu.ts_received_ns);
 }
 
 
 /*
  *
- * Mainboard thread
+ * Mainboard reports.
  *
  */
 
 static bool
-vive_mainboard_read_one_msg(struct vive_device *d)
+vive_mainboard_handle_report(void *ptr, const uint8_t *buffer, int size)
 {
-	uint8_t buffer[64];
+	struct vive_device *d = (struct vive_device *)ptr;
 
-	int ret = os_hid_read(d->mainboard_dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
-		// Time out
-		return true;
-	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read device '%i'!", ret);
+	if (size < 0) {
+		VIVE_ERROR(d, "Failed to read device '%i'!", size);
 		return false;
 	}
 
 	switch (buffer[0]) {
 	case VIVE_MAINBOARD_STATUS_REPORT_ID:
-		if (ret != sizeof(struct vive_mainboard_status_report)) {
+		if (size != sizeof(struct vive_mainboard_status_report)) {
 			VIVE_ERROR(d, "Mainboard status report has invalid size.");
 			return false;
 		}
@@ -416,30 +415,10 @@ vive_mainboard_read_one_msg(struct vive_device *d)
 	return true;
 }
 
-static void *
-vive_mainboard_run_thread(void *ptr)
-{
-	struct vive_device *d = (struct vive_device *)ptr;
-
-	os_thread_helper_lock(&d->mainboard_thread);
-	while (os_thread_helper_is_running_locked(&d->mainboard_thread)) {
-		os_thread_helper_unlock(&d->mainboard_thread);
-
-		if (!vive_mainboard_read_one_msg(d)) {
-			return NULL;
-		}
-
-		// Just keep swimming.
-		os_thread_helper_lock(&d->mainboard_thread);
-	}
-
-	return NULL;
-}
-
 
 /*
  *
- * Sensor thread.
+ * Sensor reports.
  *
  */
 
@@ -543,37 +522,28 @@ _is_report_size_valid(struct vive_device *d, int size, int report_size, int repo
 }
 
 static bool
-vive_sensors_read_one_msg(struct vive_device *d,
-                          struct os_hid_device *dev,
-                          uint32_t report_id,
-                          int report_size,
-                          void (*process_cb)(struct vive_device *d, const void *buffer))
+vive_sensors_handle_report(void *ptr, const uint8_t *buffer, int size)
 {
-	uint8_t buffer[64];
+	struct vive_device *d = (struct vive_device *)ptr;
 
-	int ret = os_hid_read(dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
-		VIVE_ERROR(d, "Device %p timeout.", (void *)dev);
-		// Time out
-		return true;
-	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read device %p: %i.", (void *)dev, ret);
+	if (size < 0) {
+		VIVE_ERROR(d, "Failed to read sensors device: %i.", size);
 		return false;
 	}
 
-	if (buffer[0] == report_id) {
-		if (!_is_report_size_valid(d, ret, report_size, report_id))
+	if (buffer[0] == VIVE_IMU_REPORT_ID) {
+		if (!_is_report_size_valid(d, size, 52, VIVE_IMU_REPORT_ID))
 			return false;
 
 		os_mutex_lock(&d->lock);
-		process_cb(d, buffer);
+		update_imu(d, buffer);
 		os_mutex_unlock(&d->lock);
 
 	} else {
 		VIVE_ERROR(d, "Unexpected sensor report type %s (0x%x).", _sensors_get_report_string(buffer[0]),
 		           buffer[0]);
-		VIVE_ERROR(d, "Expected %s (0x%x).", _sensors_get_report_string(report_id), report_id);
+		VIVE_ERROR(d, "Expected %s (0x%x).", _sensors_get_report_string(VIVE_IMU_REPORT_ID),
+		           VIVE_IMU_REPORT_ID);
 	}
 
 	return true;
@@ -632,25 +602,19 @@ _print_pulse_report_v2(struct vive_device *d, const void *buffer)
 }
 
 static bool
-vive_sensors_read_lighthouse_msg(struct vive_device *d)
+vive_watchman_handle_report(void *ptr, const uint8_t *buffer, int size)
 {
-	uint8_t buffer[64];
+	struct vive_device *d = (struct vive_device *)ptr;
 
-	int ret = os_hid_read(d->watchman_dev, buffer, sizeof(buffer), 1000);
-	if (ret == 0) {
-		// basestations not present/powered off
-		VIVE_TRACE(d, "Watchman device timed out.");
-		return true;
-	}
-	if (ret < 0) {
-		VIVE_ERROR(d, "Failed to read Watchman device: %i.", ret);
+	if (size < 0) {
+		VIVE_ERROR(d, "Failed to read Watchman device: %i.", size);
 		return false;
 	}
-	if (ret > 64) {
+	if (size > 64) {
 		VIVE_ERROR(d,
 		           "Buffer too big from Watchman device: %i."
 		           " Max size is 64",
-		           ret);
+		           size);
 		return false;
 	}
 
@@ -659,69 +623,29 @@ vive_sensors_read_lighthouse_msg(struct vive_device *d)
 	switch (buffer[0]) {
 	case VIVE_HEADSET_LIGHTHOUSE_PULSE_REPORT_ID:
 		expected = sizeof(struct vive_headset_lighthouse_pulse_report);
-		if (!_is_report_size_valid(d, ret, expected, buffer[0]))
+		if (!_is_report_size_valid(d, size, expected, buffer[0]))
 			return false;
 		_decode_pulse_report(d, buffer);
 		break;
 	case VIVE_CONTROLLER_LIGHTHOUSE_PULSE_REPORT_ID:
 		expected = sizeof(struct vive_controller_report1);
 		// Vive pro gives unexpected size here with V2.
-		_is_report_size_valid(d, ret, expected, buffer[0]);
+		_is_report_size_valid(d, size, expected, buffer[0]);
 		break;
 	case VIVE_HEADSET_LIGHTHOUSE_V2_PULSE_REPORT_ID:
-		if (!_is_report_size_valid(d, ret, 59, buffer[0]))
+		if (!_is_report_size_valid(d, size, 59, buffer[0]))
 			return false;
 		if (!_print_pulse_report_v2(d, buffer))
 			return false;
 		break;
 	default:
 		VIVE_ERROR(d, "Unexpected sensor report type %s (0x%x). %d bytes.",
-		           _sensors_get_report_string(buffer[0]), buffer[0], ret);
+		           _sensors_get_report_string(buffer[0]), buffer[0], size);
 	}
 
 	return true;
 }
 
-static void *
-vive_watchman_run_thread(void *ptr)
-{
-	struct vive_device *d = (struct vive_device *)ptr;
-
-	os_thread_helper_lock(&d->watchman_thread);
-	while (os_thread_helper_is_running_locked(&d->watchman_thread)) {
-		os_thread_helper_unlock(&d->watchman_thread);
-
-		if (d->watchman_dev)
-			if (!vive_sensors_read_lighthouse_msg(d))
-				return NULL;
-
-		// Just keep swimming.
-		os_thread_helper_lock(&d->watchman_thread);
-	}
-
-	return NULL;
-}
-
-static void *
-vive_sensors_run_thread(void *ptr)
-{
-	struct vive_device *d = (struct vive_device *)ptr;
-
-	os_thread_helper_lock(&d->sensors_thread);
-	while (os_thread_helper_is_running_locked(&d->sensors_thread)) {
-		os_thread_helper_unlock(&d->sensors_thread);
-
-		if (!vive_sensors_read_one_msg(d, d->sensors_dev, VIVE_IMU_REPORT_ID, 52, update_imu)) {
-			return NULL;
-		}
-
-		// Just keep swimming.
-		os_thread_helper_lock(&d->sensors_thread);
-	}
-
-	return NULL;
-}
-
 static bool
 compute_distortion(struct xrt_device *xdev, int view, float u, float v, struct xrt_uv_triplet *result)
 {
@@ -850,6 +774,7 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 
 	// Init here.
 	m_imu_3dof_init(&d->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_relation_history_create(&d->relation_hist);
 
 	u_var_add_root(d, "Vive Device", true);
 	u_var_add_gui_header(d, &d->gui.fusion, "3DoF Fusion");
@@ -872,10 +797,18 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 		}
 	}
 
+	d->reactor = os_hid_reactor_get_shared();
+	if (d->reactor == NULL) {
+		VIVE_ERROR(d, "Failed to get hid reactor!");
+		vive_device_destroy((struct xrt_device *)d);
+		return NULL;
+	}
+
 	if (d->mainboard_dev) {
-		ret = os_thread_helper_start(&d->mainboard_thread, vive_mainboard_run_thread, d);
+		ret = os_hid_reactor_add(d->reactor, d->mainboard_dev, vive_mainboard_handle_report, d,
+		                         &d->mainboard_reactor_id);
 		if (ret != 0) {
-			VIVE_ERROR(d, "Failed to start mainboard thread!");
+			VIVE_ERROR(d, "Failed to add mainboard device to reactor!");
 			vive_device_destroy((struct xrt_device *)d);
 			return NULL;
 		}
@@ -893,7 +826,7 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	}
 	snprintf(d->base.serial, XRT_DEVICE_NAME_LEN, "%s", d->config.firmware.device_serial_number);
 
-	// Mutex before thread.
+	// Mutex before reports.
 	ret = os_mutex_init(&d->lock);
 	if (ret != 0) {
 		VIVE_ERROR(d, "Failed to init mutex!");
@@ -901,18 +834,21 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 		return NULL;
 	}
 
-	ret = os_thread_helper_start(&d->sensors_thread, vive_sensors_run_thread, d);
+	ret = os_hid_reactor_add(d->reactor, d->sensors_dev, vive_sensors_handle_report, d, &d->sensors_reactor_id);
 	if (ret != 0) {
-		VIVE_ERROR(d, "Failed to start sensors thread!");
+		VIVE_ERROR(d, "Failed to add sensors device to reactor!");
 		vive_device_destroy((struct xrt_device *)d);
 		return NULL;
 	}
 
-	ret = os_thread_helper_start(&d->watchman_thread, vive_watchman_run_thread, d);
-	if (ret != 0) {
-		VIVE_ERROR(d, "Failed to start watchman thread!");
-		vive_device_destroy((struct xrt_device *)d);
-		return NULL;
+	if (d->watchman_dev) {
+		ret = os_hid_reactor_add(d->reactor, d->watchman_dev, vive_watchman_handle_report, d,
+		                         &d->watchman_reactor_id);
+		if (ret != 0) {
+			VIVE_ERROR(d, "Failed to add Watchman device to reactor!");
+			vive_device_destroy((struct xrt_device *)d);
+			return NULL;
+		}
 	}
 
 	return d;
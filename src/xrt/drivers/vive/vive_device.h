@@ -12,6 +12,7 @@
 #include "xrt/xrt_device.h"
 #include "math/m_imu_3dof.h"
 #include "os/os_threading.h"
+#include "os/os_hid_reactor.h"
 #include "util/u_logging.h"
 #include "util/u_distortion_mesh.h"
 #include "vive/vive_config.h"
@@ -34,9 +35,11 @@ struct vive_device
 
 	struct lighthouse_watchman watchman;
 
-	struct os_thread_helper sensors_thread;
-	struct os_thread_helper watchman_thread;
-	struct os_thread_helper mainboard_thread;
+	//! Reads and dispatches the reports from all three hid devices.
+	struct os_hid_reactor *reactor;
+	uint32_t sensors_reactor_id;
+	uint32_t watchman_reactor_id;
+	uint32_t mainboard_reactor_id;
 
 	//! Lock for last and fusion.
 	struct os_mutex lock;
@@ -51,6 +54,9 @@ struct vive_device
 
 	struct m_imu_3dof fusion;
 
+	//! Timestamped fusion output, written from the sensors reports, read without a lock.
+	struct m_relation_history *relation_hist;
+
 	struct
 	{
 		uint16_t ipd;
@@ -20,7 +20,7 @@
 #include "math/m_mathinclude.h"
 #include "math/m_api.h"
 #include "math/m_vec2.h"
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -137,25 +137,17 @@ hololens_sensors_decode_packet(struct wmr_hmd *wh,
 }
 
 static bool
-hololens_sensors_read_packets(struct wmr_hmd *wh)
+hololens_sensors_handle_packet(void *ptr, const uint8_t *buffer, int size)
 {
-	WMR_TRACE(wh, " ");
-
-	unsigned char buffer[WMR_FEATURE_BUFFER_SIZE];
-
-	// Block for 100ms
-	int size = os_hid_read(wh->hid_hololens_sensors_dev, buffer, sizeof(buffer), 100);
+	struct wmr_hmd *wh = (struct wmr_hmd *)ptr;
 
 	if (size < 0) {
 		WMR_ERROR(wh, "Error reading from device");
 		return false;
-	} else if (size == 0) {
-		WMR_TRACE(wh, "No more data to read");
-		return true; // No more messages, return.
-	} else {
-		WMR_TRACE(wh, "Read %u bytes", size);
 	}
 
+	WMR_TRACE(wh, "Read %u bytes", size);
+
 	switch (buffer[0]) {
 	case WMR_MS_HOLOLENS_MSG_SENSORS: {
 		// Get the timing as close to reading the packet as possible.
@@ -175,16 +167,31 @@ hololens_sensors_read_packets(struct wmr_hmd *wh)
 			math_quat_rotate_vec3(&wh->accel_to_centerline.orientation, &sample, &raw_accel[i]);
 		}
 
-		os_mutex_lock(&wh->fusion.mutex);
+		uint64_t timestamps_ns[4];
 		for (int i = 0; i < 4; i++) {
-			m_imu_3dof_update(                                              //
-			    &wh->fusion.i3dof,                                          //
-			    wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK, //
-			    &raw_accel[i],                                              //
-			    &raw_gyro[i]);                                              //
+			timestamps_ns[i] = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
 		}
-		wh->fusion.last_imu_timestamp_ns = now_ns;
-		wh->fusion.last_angular_velocity = raw_gyro[3];
+
+		os_mutex_lock(&wh->fusion.mutex);
+		m_imu_3dof_update_batch(&wh->fusion.i3dof, timestamps_ns, raw_accel, raw_gyro, 4);
+
+		/*
+		 * The last sample arrived now. Only the orientation at the end
+		 * of the report is pushed, the history slerps between pushes.
+		 * Reports are a few milliseconds apart, over which slerping
+		 * instead of integrating each sample is off by thousandths of a
+		 * degree for head motion. It also lets the history cover four
+		 * times as long.
+		 */
+		struct xrt_space_relation relation = {0};
+		relation.relation_flags = (enum xrt_space_relation_flags)( //
+		    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT |        //
+		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |             //
+		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+		relation.pose.orientation = wh->fusion.i3dof.rot;
+		math_quat_rotate_derivative(&relation.pose.orientation, &raw_gyro[3], &relation.angular_velocity);
+
+		m_relation_history_push(wh->fusion.relation_hist, &relation, now_ns);
 		os_mutex_unlock(&wh->fusion.mutex);
 
 		break;
@@ -236,23 +243,17 @@ control_ipd_value_decode(struct wmr_hmd *wh, const unsigned char *buffer, int si
 }
 
 static bool
-control_read_packets(struct wmr_hmd *wh)
+control_handle_packet(void *ptr, const uint8_t *buffer, int size)
 {
-	unsigned char buffer[WMR_FEATURE_BUFFER_SIZE];
-
-	// Do not block
-	int size = os_hid_read(wh->hid_control_dev, buffer, sizeof(buffer), 0);
+	struct wmr_hmd *wh = (struct wmr_hmd *)ptr;
 
 	if (size < 0) {
 		WMR_ERROR(wh, "Error reading from device");
 		return false;
-	} else if (size == 0) {
-		WMR_TRACE(wh, "No more data to read");
-		return true; // No more messages, return.
-	} else {
-		WMR_TRACE(wh, "Read %u bytes", size);
 	}
 
+	WMR_TRACE(wh, "Read %u bytes", size);
+
 	switch (buffer[0]) {
 	case WMR_CONTROL_MSG_IPD_VALUE: //
 		control_ipd_value_decode(wh, buffer, size);
@@ -274,31 +275,6 @@ control_read_packets(struct wmr_hmd *wh)
  *
  */
 
-static void *
-wmr_run_thread(void *ptr)
-{
-	struct wmr_hmd *wh = (struct wmr_hmd *)ptr;
-
-	os_thread_helper_lock(&wh->oth);
-	while (os_thread_helper_is_running_locked(&wh->oth)) {
-		os_thread_helper_unlock(&wh->oth);
-
-		// Does not block.
-		if (!control_read_packets(wh)) {
-			break;
-		}
-
-		// Does block for a bit.
-		if (!hololens_sensors_read_packets(wh)) {
-			break;
-		}
-	}
-
-	WMR_DEBUG(wh, "Exiting reading thread.");
-
-	return NULL;
-}
-
 static void
 hololens_sensors_enable_imu(struct wmr_hmd *wh)
 {
@@ -571,31 +547,7 @@ wmr_hmd_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	// Variables needed for prediction.
-	uint64_t last_imu_timestamp_ns = 0;
-	struct xrt_space_relation relation = {0};
-	relation.relation_flags = (enum xrt_space_relation_flags)( //
-	    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT |        //
-	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |             //
-	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
-
-	// Get data while holding the lock.
-	os_mutex_lock(&wh->fusion.mutex);
-	relation.pose.orientation = wh->fusion.i3dof.rot;
-	relation.angular_velocity = wh->fusion.last_angular_velocity;
-	last_imu_timestamp_ns = wh->fusion.last_imu_timestamp_ns;
-	os_mutex_unlock(&wh->fusion.mutex);
-
-	// No prediction needed.
-	if (at_timestamp_ns < last_imu_timestamp_ns) {
-		*out_relation = relation;
-		return;
-	}
-
-	uint64_t prediction_ns = at_timestamp_ns - last_imu_timestamp_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	m_predict_relation(&relation, prediction_s, out_relation);
+	m_relation_history_get(wh->fusion.relation_hist, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -613,8 +565,10 @@ wmr_hmd_destroy(struct xrt_device *xdev)
 {
 	struct wmr_hmd *wh = wmr_hmd(xdev);
 
-	// Destroy the thread object.
-	os_thread_helper_destroy(&wh->oth);
+	// Stop getting packets, no callbacks are running once these return.
+	os_hid_reactor_remove(wh->reactor, &wh->hololens_sensors_reactor_id);
+	os_hid_reactor_remove(wh->reactor, &wh->control_reactor_id);
+	os_hid_reactor_put_shared(&wh->reactor);
 
 	if (wh->hid_hololens_sensors_dev != NULL) {
 		os_hid_destroy(wh->hid_hololens_sensors_dev);
@@ -632,6 +586,7 @@ wmr_hmd_destroy(struct xrt_device *xdev)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&wh->fusion.i3dof);
+	m_relation_history_destroy(&wh->fusion.relation_hist);
 
 	os_mutex_destroy(&wh->fusion.mutex);
 
@@ -803,7 +758,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	wh->hid_hololens_sensors_dev = hid_holo;
 	wh->hid_control_dev = hid_ctrl;
 
-	// Mutex before thread.
+	// Mutex before packets.
 	ret = os_mutex_init(&wh->fusion.mutex);
 	if (ret != 0) {
 		WMR_ERROR(wh, "Failed to init mutex!");
@@ -812,15 +767,6 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 		return NULL;
 	}
 
-	// Thread and other state.
-	ret = os_thread_helper_init(&wh->oth);
-	if (ret != 0) {
-		WMR_ERROR(wh, "Failed to init threading!");
-		wmr_hmd_destroy(&wh->base);
-		wh = NULL;
-		return NULL;
-	}
-
 	// Setup input.
 	wh->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
 
@@ -856,6 +802,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	WMR_INFO(wh, "Found WMR headset type: %s", wh->hmd_desc->debug_name);
 
 	m_imu_3dof_init(&wh->fusion.i3dof, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_relation_history_create(&wh->fusion.relation_hist);
 
 	// Setup variable tracker.
 	u_var_add_root(wh, "WMR HMD", true);
@@ -949,14 +896,34 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	hololens_sensors_enable_imu(wh);
 
 
-	// Hand over hololens sensor device to reading thread.
-	ret = os_thread_helper_start(&wh->oth, wmr_run_thread, wh);
+	// Hand over the devices to the reactor.
+	wh->reactor = os_hid_reactor_get_shared();
+	if (wh->reactor == NULL) {
+		WMR_ERROR(wh, "Failed to get hid reactor!");
+		wmr_hmd_destroy(&wh->base);
+		wh = NULL;
+		return NULL;
+	}
+
+	ret = os_hid_reactor_add(wh->reactor, wh->hid_hololens_sensors_dev, hololens_sensors_handle_packet, wh,
+	                         &wh->hololens_sensors_reactor_id);
 	if (ret != 0) {
-		WMR_ERROR(wh, "Failed to start thread!");
+		WMR_ERROR(wh, "Failed to add hololens sensors device to reactor!");
 		wmr_hmd_destroy(&wh->base);
 		wh = NULL;
 		return NULL;
 	}
 
+	if (wh->hid_control_dev != NULL) {
+		ret = os_hid_reactor_add(wh->reactor, wh->hid_control_dev, control_handle_packet, wh,
+		                         &wh->control_reactor_id);
+		if (ret != 0) {
+			WMR_ERROR(wh, "Failed to add control device to reactor!");
+			wmr_hmd_destroy(&wh->base);
+			wh = NULL;
+			return NULL;
+		}
+	}
+
 	return &wh->base;
 }
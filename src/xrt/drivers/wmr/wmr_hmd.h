@@ -16,6 +16,7 @@
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_prober.h"
 #include "os/os_threading.h"
+#include "os/os_hid_reactor.h"
 #include "math/m_imu_3dof.h"
 #include "util/u_logging.h"
 #include "util/u_distortion_mesh.h"
@@ -93,8 +94,10 @@ struct wmr_hmd
 	/* Config data parsed from the firmware JSON */
 	struct wmr_hmd_config config;
 
-	//! Packet reading thread.
-	struct os_thread_helper oth;
+	//! Reads and dispatches the packets from both hid devices.
+	struct os_hid_reactor *reactor;
+	uint32_t hololens_sensors_reactor_id;
+	uint32_t control_reactor_id;
 
 	enum u_logging_level log_level;
 
@@ -103,8 +106,8 @@ struct wmr_hmd
 	 * IMU data and read the config from.
 	 *
 	 * During start it is owned by the thread creating the device, after
-	 * init it is owned by the reading thread, there is no mutex protecting
-	 * this field as it's only used by the reading thread in @p oth.
+	 * init its packets are read by @p reactor, there is no mutex protecting
+	 * this field as it's only used by the reactor callbacks.
 	 */
 	struct os_hid_device *hid_hololens_sensors_dev;
 	struct os_hid_device *hid_control_dev;
@@ -132,11 +135,8 @@ struct wmr_hmd
 		//! Main fusion calculator.
 		struct m_imu_3dof i3dof;
 
-		//! The last angular velocity from the IMU, for prediction.
-		struct xrt_vec3 last_angular_velocity;
-
-		//! When did we get the last IMU sample, in CPU time.
-		uint64_t last_imu_timestamp_ns;
+		//! Fusion output for every IMU sample, in CPU time, read without the mutex.
+		struct m_relation_history *relation_hist;
 	} fusion;
 
 	struct
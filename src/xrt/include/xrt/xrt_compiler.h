@@ -129,6 +129,66 @@ xrt_atomic_s32_cmpxchg(xrt_atomic_s32_t *p, int32_t old_, int32_t new_)
 #endif
 }
 
+/*!
+ * Relaxed load, for flags that other threads only need to see eventually.
+ */
+static inline int32_t
+xrt_atomic_s32_load(const xrt_atomic_s32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	return InterlockedCompareExchange((volatile LONG *)p, 0, 0);
+#else
+#error "compiler not supported"
+#endif
+}
+
+//! Relaxed store, see @ref xrt_atomic_s32_load.
+static inline void
+xrt_atomic_s32_store(xrt_atomic_s32_t *p, int32_t value)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, value, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	InterlockedExchange((volatile LONG *)p, value);
+#else
+#error "compiler not supported"
+#endif
+}
+
+typedef volatile uint64_t xrt_atomic_u64_t;
+
+/*!
+ * Load with acquire ordering, reads after this can't be moved before it.
+ */
+static inline uint64_t
+xrt_atomic_u64_load_acquire(const xrt_atomic_u64_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, 0, 0);
+#else
+#error "compiler not supported"
+#endif
+}
+
+/*!
+ * Store with release ordering, writes before this can't be moved after it.
+ */
+static inline void
+xrt_atomic_u64_store_release(xrt_atomic_u64_t *p, uint64_t value)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	InterlockedExchange64((volatile LONG64 *)p, (LONG64)value);
+#else
+#error "compiler not supported"
+#endif
+}
+
 #ifdef _MSC_VER
 typedef intptr_t ssize_t;
 #define _SSIZE_T_
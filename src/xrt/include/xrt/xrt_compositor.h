@@ -478,6 +478,20 @@ xrt_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	return xsc->release_image(xsc, index);
 }
 
+/*!
+ * A single layer given to @ref xrt_compositor::layers.
+ */
+struct xrt_layer_entry
+{
+	/*!
+	 * The swapchains the matching layer_* function takes, in the same
+	 * order, the ones not used by the layer type are NULL.
+	 */
+	struct xrt_swapchain *xscs[4];
+
+	struct xrt_layer_data data;
+};
+
 
 /*
  *
@@ -870,6 +884,21 @@ struct xrt_compositor
 	                                struct xrt_swapchain *xsc,
 	                                const struct xrt_layer_data *data);
 
+	/*!
+	 * Optional, adds all of the layers for submission in one call, the same
+	 * as calling the matching layer_* function for each entry in order.
+	 * When NULL @ref xrt_comp_layers does exactly that.
+	 *
+	 * @param xc          Self pointer
+	 * @param xdev        The device the layers are relative to.
+	 * @param entries     The layers.
+	 * @param num_entries Number of layers.
+	 */
+	xrt_result_t (*layers)(struct xrt_compositor *xc,
+	                       struct xrt_device *xdev,
+	                       const struct xrt_layer_entry *entries,
+	                       uint32_t num_entries);
+
 	/*!
 	 * Commits all of the submitted layers, it's from this on that the
 	 * compositor will use the layers.
@@ -1188,6 +1217,51 @@ xrt_comp_layer_equirect2(struct xrt_compositor *xc,
 	return xc->layer_equirect2(xc, xdev, xsc, data);
 }
 
+/*!
+ * @copydoc xrt_compositor::layers
+ *
+ * Helper for calling through the function pointer: calls the layer_* function
+ * for each entry if the compositor doesn't implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline xrt_result_t
+xrt_comp_layers(struct xrt_compositor *xc,
+                struct xrt_device *xdev,
+                const struct xrt_layer_entry *entries,
+                uint32_t num_entries)
+{
+	if (xc->layers != NULL) {
+		return xc->layers(xc, xdev, entries, num_entries);
+	}
+
+	for (uint32_t i = 0; i < num_entries; i++) {
+		struct xrt_swapchain *const *xscs = entries[i].xscs;
+		const struct xrt_layer_data *data = &entries[i].data;
+		xrt_result_t ret = XRT_SUCCESS;
+
+		switch (data->type) {
+		case XRT_LAYER_STEREO_PROJECTION:
+			ret = xc->layer_stereo_projection(xc, xdev, xscs[0], xscs[1], data);
+			break;
+		case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+			ret = xc->layer_stereo_projection_depth(xc, xdev, xscs[0], xscs[1], xscs[2], xscs[3], data);
+			break;
+		case XRT_LAYER_QUAD: ret = xc->layer_quad(xc, xdev, xscs[0], data); break;
+		case XRT_LAYER_CUBE: ret = xc->layer_cube(xc, xdev, xscs[0], data); break;
+		case XRT_LAYER_CYLINDER: ret = xc->layer_cylinder(xc, xdev, xscs[0], data); break;
+		case XRT_LAYER_EQUIRECT1: ret = xc->layer_equirect1(xc, xdev, xscs[0], data); break;
+		case XRT_LAYER_EQUIRECT2: ret = xc->layer_equirect2(xc, xdev, xscs[0], data); break;
+		}
+
+		if (ret != XRT_SUCCESS) {
+			return ret;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 /*!
  * @copydoc xrt_compositor::layer_commit
  *
@@ -0,0 +1,96 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Experimental Monado OpenXR extensions, not yet in the registry.
+ * @ingroup xrt_iface
+ */
+
+#pragma once
+
+#include "openxr/openxr.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ *
+ * XR_MNDX_locate_spaces
+ *
+ * Locate many spaces relative to one base space at a single time with one
+ * call, modelled on xrLocateSpace. The structure type values are not from a
+ * registered extension number and may change until the extension is
+ * registered.
+ *
+ */
+
+#ifndef XR_MNDX_locate_spaces
+
+#define XR_MNDX_locate_spaces 1
+#define XR_MNDX_locate_spaces_SPEC_VERSION 1
+#define XR_MNDX_LOCATE_SPACES_EXTENSION_NAME "XR_MNDX_locate_spaces"
+
+#define XR_TYPE_SPACES_LOCATE_INFO_MNDX ((XrStructureType)1000999000U)
+#define XR_TYPE_SPACE_LOCATIONS_MNDX ((XrStructureType)1000999001U)
+#define XR_TYPE_SPACE_VELOCITIES_MNDX ((XrStructureType)1000999002U)
+
+typedef struct XrSpacesLocateInfoMNDX
+{
+	XrStructureType type;
+	const void *XR_MAY_ALIAS next;
+	XrSpace baseSpace;
+	XrTime time;
+	uint32_t spaceCount;
+	const XrSpace *spaces;
+} XrSpacesLocateInfoMNDX;
+
+typedef struct XrSpaceLocationDataMNDX
+{
+	XrSpaceLocationFlags locationFlags;
+	XrPosef pose;
+} XrSpaceLocationDataMNDX;
+
+typedef struct XrSpaceLocationsMNDX
+{
+	XrStructureType type;
+	void *XR_MAY_ALIAS next;
+	uint32_t locationCount;
+	XrSpaceLocationDataMNDX *locations;
+} XrSpaceLocationsMNDX;
+
+// May be chained to XrSpaceLocationsMNDX.
+typedef struct XrSpaceVelocityDataMNDX
+{
+	XrSpaceVelocityFlags velocityFlags;
+	XrVector3f linearVelocity;
+	XrVector3f angularVelocity;
+} XrSpaceVelocityDataMNDX;
+
+typedef struct XrSpaceVelocitiesMNDX
+{
+	XrStructureType type;
+	void *XR_MAY_ALIAS next;
+	uint32_t velocityCount;
+	XrSpaceVelocityDataMNDX *velocities;
+} XrSpaceVelocitiesMNDX;
+
+typedef XrResult(XRAPI_PTR *PFN_xrLocateSpacesMNDX)(XrSession session,
+                                                    const XrSpacesLocateInfoMNDX *locateInfo,
+                                                    XrSpaceLocationsMNDX *spaceLocations);
+
+#ifndef XR_NO_PROTOTYPES
+#ifdef XR_EXTENSION_PROTOTYPES
+XRAPI_ATTR XrResult XRAPI_CALL
+xrLocateSpacesMNDX(XrSession session, const XrSpacesLocateInfoMNDX *locateInfo, XrSpaceLocationsMNDX *spaceLocations);
+#endif /* XR_EXTENSION_PROTOTYPES */
+#endif /* !XR_NO_PROTOTYPES */
+
+#endif // XR_MNDX_locate_spaces
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -45,3 +45,5 @@ typedef __eglMustCastToProperFunctionPointerType (*PFNEGLGETPROCADDRESSPROC)(con
 #include "openxr/openxr.h"
 #include "openxr/openxr_platform.h"
 #include "openxr/loader_interfaces.h"
+
+#include "xrt/xrt_openxr_experimental.h"
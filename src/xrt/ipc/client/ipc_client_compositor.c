@@ -13,6 +13,8 @@
 #include "xrt/xrt_defines.h"
 
 #include "util/u_misc.h"
+#include "util/u_var.h"
+#include "util/u_deadline.h"
 #include "util/u_trace_marker.h"
 
 #include "os/os_time.h"
@@ -70,6 +72,9 @@ struct ipc_client_compositor
 	//! Has the native compositor been created, only supports one for now.
 	bool compositor_created;
 
+	//! Sleeps in wait frame until the wake up time the service gave us.
+	struct u_deadline_sleeper sleeper;
+
 #ifdef IPC_USE_LOOPBACK_IMAGE_ALLOCATOR
 	//! To test image allocator.
 	struct xrt_image_native_allocator loopback_xina;
@@ -405,44 +410,11 @@ ipc_compositor_wait_frame(struct xrt_compositor *xc,
 	                                               out_predicted_display_time,     // Display time
 	                                               out_predicted_display_period)); // Current period
 
-	uint64_t now_ns = os_monotonic_get_ns();
-
-	// Lets hope its not to late.
-	if (wake_up_time_ns <= now_ns) {
-		res = ipc_call_compositor_wait_woke(icc->ipc_c, *out_frame_id);
-		return res;
-	}
-
-	const uint64_t _1ms_in_ns = 1000 * 1000;
-	const uint64_t measured_scheduler_latency_ns = 50 * 1000;
-
-	// Within one ms, just release the app right now.
-	if (wake_up_time_ns - _1ms_in_ns <= now_ns) {
-		res = ipc_call_compositor_wait_woke(icc->ipc_c, *out_frame_id);
-		return res;
-	}
-
-	// This is how much we should sleep.
-	uint64_t diff_ns = wake_up_time_ns - now_ns;
-
-	// A minor tweak that helps hit the time better.
-	diff_ns -= measured_scheduler_latency_ns;
-
-	os_nanosleep(diff_ns);
+	// Sleeps on our side so the service doesn't need a thread per client, returns right away if late.
+	u_deadline_sleeper_sleep_until(&icc->sleeper, wake_up_time_ns);
 
 	res = ipc_call_compositor_wait_woke(icc->ipc_c, *out_frame_id);
 
-#if 0
-	uint64_t then_ns = now_ns;
-	now_ns = os_monotonic_get_ns();
-
-	diff_ns = now_ns - then_ns;
-	uint64_t ms100 = diff_ns / (1000 * 10);
-
-	U_LOG_D("%s: Slept %i.%02ims", __func__, (int)ms100 / 100,
-	        (int)ms100 % 100);
-#endif
-
 	return res;
 }
 
@@ -611,6 +583,35 @@ ipc_compositor_layer_equirect2(struct xrt_compositor *xc,
 	return handle_layer(xc, xdev, xsc, data, XRT_LAYER_EQUIRECT2);
 }
 
+static xrt_result_t
+ipc_compositor_layers(struct xrt_compositor *xc,
+                      struct xrt_device *xdev,
+                      const struct xrt_layer_entry *entries,
+                      uint32_t num_entries)
+{
+	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+
+	struct ipc_shared_memory *ism = icc->ipc_c->ism;
+	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+
+	assert(icc->layers.num_layers + num_entries <= IPC_MAX_LAYERS);
+
+	// Write straight into the shared memory, the server reads it on commit.
+	struct ipc_layer_entry *layer = &slot->layers[icc->layers.num_layers];
+	for (uint32_t i = 0; i < num_entries; i++, layer++) {
+		layer->xdev_id = 0; //! @todo Real id.
+		for (uint32_t k = 0; k < ARRAY_SIZE(layer->swapchain_ids); k++) {
+			struct xrt_swapchain *xsc = entries[i].xscs[k];
+			layer->swapchain_ids[k] = xsc != NULL ? ipc_client_swapchain(xsc)->id : -1;
+		}
+		layer->data = entries[i].data;
+	}
+
+	icc->layers.num_layers += num_entries;
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 ipc_compositor_layer_commit(struct xrt_compositor *xc, int64_t frame_id, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -665,6 +666,9 @@ ipc_compositor_destroy(struct xrt_compositor *xc)
 
 	assert(icc->compositor_created);
 
+	u_var_remove_root(icc);
+	u_deadline_sleeper_deinit(&icc->sleeper);
+
 	IPC_CALL_CHK(ipc_call_session_destroy(icc->ipc_c));
 
 	icc->compositor_created = false;
@@ -688,6 +692,7 @@ ipc_compositor_init(struct ipc_client_compositor *icc, struct xrt_compositor_nat
 	icc->base.base.layer_cylinder = ipc_compositor_layer_cylinder;
 	icc->base.base.layer_equirect1 = ipc_compositor_layer_equirect1;
 	icc->base.base.layer_equirect2 = ipc_compositor_layer_equirect2;
+	icc->base.base.layers = ipc_compositor_layers;
 	icc->base.base.layer_commit = ipc_compositor_layer_commit;
 	icc->base.base.destroy = ipc_compositor_destroy;
 	icc->base.base.poll_events = ipc_compositor_poll_events;
@@ -695,6 +700,11 @@ ipc_compositor_init(struct ipc_client_compositor *icc, struct xrt_compositor_nat
 	// Fetch info from the compositor, among it the format format list.
 	get_info(&(icc->base.base), &icc->base.base.info);
 
+	u_deadline_sleeper_init(&icc->sleeper);
+
+	u_var_add_root(icc, "Compositor (IPC client)", false);
+	u_deadline_sleeper_add_vars(&icc->sleeper, icc);
+
 	*out_xcn = &icc->base;
 }
 
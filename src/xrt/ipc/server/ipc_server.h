@@ -13,9 +13,11 @@
 
 #include "xrt/xrt_compiler.h"
 
+#include "util/u_var.h"
 #include "util/u_logging.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_utils.h"
@@ -306,6 +308,15 @@ struct ipc_server
 
 		struct os_mutex lock;
 	} global_state;
+
+	//! Copy of the thread registry shown in the debug gui.
+	struct
+	{
+		struct os_thread_role_entry entries[OS_THREAD_ROLE_MAX_THREADS];
+
+		//! Copies the registry again, runs on the gui thread that reads the copy.
+		struct u_var_button refresh_btn;
+	} thread_roles;
 };
 
 
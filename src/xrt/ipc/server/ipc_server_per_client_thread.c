@@ -10,6 +10,8 @@
 
 #include "xrt/xrt_gfx_native.h"
 
+#include "os/os_thread_role.h"
+
 #include "util/u_misc.h"
 
 #include "server/ipc_server.h"
@@ -174,6 +176,8 @@ ipc_server_client_thread(void *_ics)
 {
 	volatile struct ipc_client_state *ics = _ics;
 
+	os_thread_role_set(OS_THREAD_ROLE_IPC, "ipc_client");
+
 	client_loop(ics);
 
 	return NULL;
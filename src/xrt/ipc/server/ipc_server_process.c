@@ -16,6 +16,7 @@
 #include "xrt/xrt_config_os.h"
 
 #include "os/os_time.h"
+#include "os/os_thread_role.h"
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -100,6 +101,7 @@ static void
 teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
+	u_var_remove_root(&s->thread_roles);
 
 	xrt_syscomp_destroy(&s->xsysc);
 
@@ -397,6 +399,14 @@ ipc_server_start_client_listener_thread(struct ipc_server *vs, int fd)
 	os_mutex_unlock(&vs->global_state.lock);
 }
 
+static void
+refresh_thread_roles(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+
+	os_thread_role_copy_entries(s->thread_roles.entries);
+}
+
 static int
 init_all(struct ipc_server *s)
 {
@@ -478,6 +488,18 @@ init_all(struct ipc_server *s)
 	u_var_add_bool(s, &s->exit_on_disconnect, "exit_on_disconnect");
 	u_var_add_bool(s, (void *)&s->running, "running");
 
+	// The gui shows a copy of the registry, the threads keep writing to it.
+	os_thread_role_copy_entries(s->thread_roles.entries);
+	s->thread_roles.refresh_btn.cb = refresh_thread_roles;
+	s->thread_roles.refresh_btn.ptr = s;
+	u_var_add_root(&s->thread_roles, "Threads", false);
+	u_var_add_button(&s->thread_roles, &s->thread_roles.refresh_btn, "Refresh");
+	for (int i = 0; i < OS_THREAD_ROLE_MAX_THREADS; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "#%i", i);
+		u_var_add_ro_text(&s->thread_roles, s->thread_roles.entries[i].info, name);
+	}
+
 	return 0;
 }
 
@@ -326,6 +326,14 @@ oxr_xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo *
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation *location);
 
+#ifdef OXR_HAVE_MNDX_locate_spaces
+//! OpenXR API function @ep{xrLocateSpacesMNDX}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrLocateSpacesMNDX(XrSession session,
+                       const XrSpacesLocateInfoMNDX *locateInfo,
+                       XrSpaceLocationsMNDX *spaceLocations);
+#endif // OXR_HAVE_MNDX_locate_spaces
+
 //! OpenXR API function @ep{xrDestroySpace}
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySpace(XrSpace space);
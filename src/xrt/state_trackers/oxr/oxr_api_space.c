@@ -17,6 +17,7 @@
 #include "oxr_objects.h"
 #include "oxr_logger.h"
 #include "oxr_two_call.h"
+#include "oxr_chain.h"
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
@@ -146,6 +147,126 @@ oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation
 	return oxr_space_locate(&log, spc, baseSpc, time, location);
 }
 
+#ifdef OXR_HAVE_MNDX_locate_spaces
+
+//! How many spaces are located at the same time, keeps everything on the stack.
+#define OXR_LOCATE_SPACES_BATCH_SIZE 64
+
+static void
+copy_relation_to_location(const struct xrt_space_relation *rel,
+                          XrSpaceLocationDataMNDX *location,
+                          XrSpaceVelocityDataMNDX *velocity)
+{
+	union {
+		struct xrt_pose xrt;
+		XrPosef oxr;
+	} safe_copy = {0};
+	safe_copy.xrt = rel->pose;
+
+	location->pose = safe_copy.oxr;
+	location->locationFlags = xrt_to_xr_space_location_flags(rel->relation_flags);
+
+	if (velocity == NULL) {
+		return;
+	}
+
+	velocity->velocityFlags = location->locationFlags & (XR_SPACE_VELOCITY_LINEAR_VALID_BIT | //
+	                                                     XR_SPACE_VELOCITY_ANGULAR_VALID_BIT);
+	velocity->linearVelocity.x = rel->linear_velocity.x;
+	velocity->linearVelocity.y = rel->linear_velocity.y;
+	velocity->linearVelocity.z = rel->linear_velocity.z;
+	velocity->angularVelocity.x = rel->angular_velocity.x;
+	velocity->angularVelocity.y = rel->angular_velocity.y;
+	velocity->angularVelocity.z = rel->angular_velocity.z;
+}
+
+XrResult
+oxr_xrLocateSpacesMNDX(XrSession session,
+                       const XrSpacesLocateInfoMNDX *locateInfo,
+                       XrSpaceLocationsMNDX *spaceLocations)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_space *baseSpc;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrLocateSpacesMNDX");
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, MNDX_locate_spaces);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, locateInfo, XR_TYPE_SPACES_LOCATE_INFO_MNDX);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, spaceLocations, XR_TYPE_SPACE_LOCATIONS_MNDX);
+	OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->baseSpace, baseSpc);
+	OXR_VERIFY_ARG_NOT_ZERO(&log, locateInfo->spaceCount);
+	OXR_VERIFY_ARG_NOT_NULL(&log, locateInfo->spaces);
+	OXR_VERIFY_ARG_NOT_NULL(&log, spaceLocations->locations);
+
+	if (baseSpc->sess != sess) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(locateInfo->baseSpace) does not belong to this session");
+	}
+
+	if (locateInfo->time <= (XrTime)0) {
+		return oxr_error(&log, XR_ERROR_TIME_INVALID, "(time == %" PRIi64 ") is not a valid time.",
+		                 locateInfo->time);
+	}
+
+	if (spaceLocations->locationCount != locateInfo->spaceCount) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(spaceLocations->locationCount == %u) must equal (locateInfo->spaceCount == %u)",
+		                 spaceLocations->locationCount, locateInfo->spaceCount);
+	}
+
+	XrSpaceVelocitiesMNDX *velocities =
+	    OXR_GET_OUTPUT_FROM_CHAIN(spaceLocations, XR_TYPE_SPACE_VELOCITIES_MNDX, XrSpaceVelocitiesMNDX);
+	if (velocities != NULL) {
+		OXR_VERIFY_ARG_NOT_NULL(&log, velocities->velocities);
+
+		if (velocities->velocityCount != locateInfo->spaceCount) {
+			return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+			                 "(velocities->velocityCount == %u) must equal (locateInfo->spaceCount == %u)",
+			                 velocities->velocityCount, locateInfo->spaceCount);
+		}
+	}
+
+	struct oxr_space *spaces[OXR_LOCATE_SPACES_BATCH_SIZE];
+	struct xrt_space_relation relations[OXR_LOCATE_SPACES_BATCH_SIZE];
+	XrResult result = oxr_session_success_result(sess);
+
+	for (uint32_t start = 0; start < locateInfo->spaceCount; start += OXR_LOCATE_SPACES_BATCH_SIZE) {
+		uint32_t count = locateInfo->spaceCount - start;
+		if (count > OXR_LOCATE_SPACES_BATCH_SIZE) {
+			count = OXR_LOCATE_SPACES_BATCH_SIZE;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->spaces[start + i], spaces[i]);
+
+			if (spaces[i]->sess != sess) {
+				return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+				                 "(locateInfo->spaces[%u]) does not belong to this session", start + i);
+			}
+		}
+
+		XrResult ret = oxr_space_locate_many(&log, baseSpc, locateInfo->time, count, spaces, relations);
+		if (XR_FAILED(ret)) {
+			return ret;
+		}
+
+		// Success codes like XR_SESSION_LOSS_PENDING still locate every batch.
+		if (ret != XR_SUCCESS) {
+			result = ret;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			XrSpaceVelocityDataMNDX *vel = velocities != NULL ? &velocities->velocities[start + i] : NULL;
+			copy_relation_to_location(&relations[i], &spaceLocations->locations[start + i], vel);
+		}
+	}
+
+	return result;
+}
+
+#endif // OXR_HAVE_MNDX_locate_spaces
+
 XrResult
 oxr_xrDestroySpace(XrSpace space)
 {
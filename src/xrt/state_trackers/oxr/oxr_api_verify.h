@@ -14,31 +14,25 @@ extern "C" {
 #endif
 
 
-#define _OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_thing, THING, name, lookup)                            \
+/*!
+ * The handle table lookup is the fast path, a single load and compare that
+ * also catches destroyed handles. Nothing is formatted unless it fails.
+ */
+#define _OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_thing, THING, name)                                    \
 	do {                                                                                                           \
 		oxr_log_init(log, name);                                                                               \
-		if (thing == XR_NULL_HANDLE) {                                                                         \
-			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #thing " == NULL)");                        \
-		}                                                                                                      \
-		new_thing = (struct oxr_thing *)((uintptr_t)thing);                                                    \
-		if (new_thing->handle.debug != OXR_XR_DEBUG_##THING) {                                                 \
-			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #thing " == %p)", (void *)new_thing);       \
+		new_thing = (struct oxr_thing *)oxr_handle_table_lookup((uint64_t)(thing));                            \
+		if (new_thing == NULL || new_thing->handle.debug != OXR_XR_DEBUG_##THING) {                            \
+			return oxr_handle_error_invalid(log, #thing, (uint64_t)(thing), OXR_XR_DEBUG_##THING);         \
 		}                                                                                                      \
-		if (new_thing->handle.state != OXR_HANDLE_STATE_LIVE) {                                                \
-			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #thing " == %p) state == %s",               \
-			                 (void *)new_thing, oxr_handle_state_to_string(new_thing->handle.state));      \
-		}                                                                                                      \
-		oxr_log_set_instance(log, lookup);                                                                     \
+		oxr_log_set_handle(log, &new_thing->handle);                                                           \
 	} while (0)
 
 #define _OXR_VERIFY_SET(log, arg, new_arg, oxr_thing, THING)                                                           \
 	do {                                                                                                           \
-		if (arg == XR_NULL_HANDLE) {                                                                           \
-			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #arg " == NULL)");                          \
-		}                                                                                                      \
-		new_arg = (struct oxr_thing *)((uintptr_t)arg);                                                        \
-		if (new_arg->handle.debug != OXR_XR_DEBUG_##THING) {                                                   \
-			return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(" #arg " == %p)", (void *)new_arg);           \
+		new_arg = (struct oxr_thing *)oxr_handle_table_lookup((uint64_t)(arg));                                \
+		if (new_arg == NULL || new_arg->handle.debug != OXR_XR_DEBUG_##THING) {                                \
+			return oxr_handle_error_invalid(log, #arg, (uint64_t)(arg), OXR_XR_DEBUG_##THING);             \
 		}                                                                                                      \
 	} while (0)
 
@@ -50,21 +44,21 @@ extern "C" {
 
 // clang-format off
 #define OXR_VERIFY_INSTANCE_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_instance, INSTANCE, name, new_thing)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_instance, INSTANCE, name)
 #define OXR_VERIFY_MESSENGER_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_messenger, MESSENGER, name, new_thing->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_messenger, MESSENGER, name)
 #define OXR_VERIFY_SESSION_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_session, SESSION, name, new_thing->sys->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_session, SESSION, name)
 #define OXR_VERIFY_SPACE_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_space, SPACE, name, new_thing->sess->sys->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_space, SPACE, name)
 #define OXR_VERIFY_ACTION_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_action, ACTION, name, new_thing->act_set->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_action, ACTION, name)
 #define OXR_VERIFY_SWAPCHAIN_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_swapchain, SWAPCHAIN, name, new_thing->sess->sys->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_swapchain, SWAPCHAIN, name)
 #define OXR_VERIFY_ACTIONSET_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_action_set, ACTIONSET, name, new_thing->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_action_set, ACTIONSET, name)
 #define OXR_VERIFY_HAND_TRACKER_AND_INIT_LOG(log, thing, new_thing, name) \
-	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_hand_tracker, HTRACKER, name, new_thing->sess->sys->inst)
+	_OXR_VERIFY_AND_SET_AND_INIT(log, thing, new_thing, oxr_hand_tracker, HTRACKER, name)
 // clang-format on
 
 #define OXR_VERIFY_INSTANCE_NOT_NULL(log, arg, new_arg) _OXR_VERIFY_SET(log, arg, new_arg, oxr_instance, INSTANCE);
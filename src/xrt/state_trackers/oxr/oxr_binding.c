@@ -452,7 +452,7 @@ oxr_action_suggest_interaction_profile_bindings(struct oxr_logger *log,
 
 	for (size_t i = 0; i < suggestedBindings->countSuggestedBindings; i++) {
 		const XrActionSuggestedBinding *s = &suggestedBindings->suggestedBindings[i];
-		struct oxr_action *act = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_action *, s->action);
+		struct oxr_action *act = OXR_HANDLE_TO_PTR(struct oxr_action *, s->action);
 
 		add_key_to_matching_bindings(bindings, num_bindings, s->binding, act->act_key);
 	}
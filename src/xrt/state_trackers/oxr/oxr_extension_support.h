@@ -246,6 +246,17 @@
 #endif
 
 
+/*
+ * XR_MNDX_locate_spaces
+ */
+#if defined(XR_MNDX_locate_spaces)
+#define OXR_HAVE_MNDX_locate_spaces
+#define OXR_EXTENSION_SUPPORT_MNDX_locate_spaces(_) _(MNDX_locate_spaces, MNDX_LOCATE_SPACES)
+#else
+#define OXR_EXTENSION_SUPPORT_MNDX_locate_spaces(_)
+#endif
+
+
 /*
  * XR_EXT_hand_tracking
  */
@@ -300,5 +311,6 @@
     OXR_EXTENSION_SUPPORT_EXTX_overlay(_) \
     OXR_EXTENSION_SUPPORT_MNDX_egl_enable(_) \
     OXR_EXTENSION_SUPPORT_MNDX_ball_on_a_stick_controller(_) \
+    OXR_EXTENSION_SUPPORT_MNDX_locate_spaces(_) \
     OXR_EXTENSION_SUPPORT_EXT_hand_tracking(_)
 // clang-format on
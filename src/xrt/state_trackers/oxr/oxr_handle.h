@@ -90,6 +90,91 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 		}                                                                                                      \
 	} while (0)
 
+/*!
+ * Allocate memory for a handle from a pool, and initialize it as a handle.
+ *
+ * Mainly for internal use - use OXR_ALLOCATE_HANDLE_FROM_POOL instead which
+ * wraps this. The pool must have been initialized for objects of at least
+ * the handle's size, and the handle must be freed with @ref oxr_handle_free.
+ *
+ * @relates oxr_handle_base
+ */
+XrResult
+oxr_handle_allocate_from_pool_and_init(struct oxr_logger *log,
+                                       struct oxr_handle_pool *pool,
+                                       uint64_t debug,
+                                       oxr_handle_destroyer destroy,
+                                       struct oxr_handle_base *parent,
+                                       void **out);
+
+/*!
+ * Frees the memory of a handle, returning it to its pool if it came from
+ * one. Called by handle destructors instead of free.
+ *
+ * @relates oxr_handle_base
+ */
+void
+oxr_handle_free(struct oxr_handle_base *hb);
+
+/*!
+ * Init a pool for handles of @p object_size bytes.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_init(struct oxr_handle_pool *pool, size_t object_size);
+
+/*!
+ * Add the statistics of the pool to the given u_var root.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_add_vars(struct oxr_handle_pool *pool, void *root, const char *prefix);
+
+/*!
+ * Frees all slabs of the pool, all handles must have been freed already.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_destroy(struct oxr_handle_pool *pool);
+
+/*!
+ * Allocates memory for a handle from a pool and evaluates to an XrResult.
+ *
+ * @param LOG pointer to struct oxr_logger
+ * @param OUT the pointer to handle struct type you already created.
+ * @param DEBUG Magic per-type debugging constant
+ * @param DESTROY Handle destructor function
+ * @param PARENT a parent handle, if any
+ * @param POOL pointer to struct oxr_handle_pool, owned by the parent
+ *
+ * @relates oxr_handle_base
+ */
+#define OXR_ALLOCATE_HANDLE_FROM_POOL(LOG, OUT, DEBUG, DESTROY, PARENT, POOL)                                          \
+	oxr_handle_allocate_from_pool_and_init(LOG, POOL, DEBUG, DESTROY, PARENT, (void **)&OUT)
+
+/*!
+ * Allocate memory for a handle from a pool, returning in case of failure.
+ *
+ * @param LOG pointer to struct oxr_logger
+ * @param OUT the pointer to handle struct type you already created.
+ * @param DEBUG Magic per-type debugging constant
+ * @param DESTROY Handle destructor function
+ * @param PARENT a parent handle, if any
+ * @param POOL pointer to struct oxr_handle_pool, owned by the parent
+ *
+ * @relates oxr_handle_base
+ */
+#define OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(LOG, OUT, DEBUG, DESTROY, PARENT, POOL)                                \
+	do {                                                                                                           \
+		XrResult allocResult = OXR_ALLOCATE_HANDLE_FROM_POOL(LOG, OUT, DEBUG, DESTROY, PARENT, POOL);          \
+		if (allocResult != XR_SUCCESS) {                                                                       \
+			return allocResult;                                                                            \
+		}                                                                                                      \
+	} while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,17 +10,20 @@
 
 #include "util/u_debug.h"
 #include "util/u_misc.h"
+#include "util/u_var.h"
 
 #include "oxr_objects.h"
 #include "oxr_logger.h"
 
 #include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 
 #define HANDLE_LIFECYCLE_LOG(log, ...)                                                                                 \
-	if (log->inst != NULL && log->inst->lifecycle_verbose) {                                                       \
+	if (oxr_log_get_instance(log) != NULL && log->inst->lifecycle_verbose) {                                       \
 		oxr_log(log, " Handle Lifecycle: " __VA_ARGS__);                                                       \
 	}
 
@@ -28,7 +31,7 @@
 // potentially free the instance (in which logger info is stored).
 #define HANDLE_LIFECYCLE_LOG_SCOPED_BEGIN(log)                                                                         \
 	{                                                                                                              \
-		const bool _log_lifecycle_verbose = log->inst != NULL && log->inst->lifecycle_verbose;
+		const bool _log_lifecycle_verbose = oxr_log_get_instance(log) != NULL && log->inst->lifecycle_verbose;
 #define HANDLE_LIFECYCLE_LOG_SCOPED_END                                                                                \
 	}                                                                                                              \
 	(void)0
@@ -38,6 +41,126 @@
 	}
 
 
+/*
+ *
+ * Handle table.
+ *
+ */
+
+/*!
+ * Static so looking up a handle doesn't need to chase a pointer first, pages
+ * of it that are never used are never touched.
+ */
+struct oxr_handle_table_slot oxr_handle_table[OXR_HANDLE_TABLE_SIZE];
+
+//! Indices of freed slots, reused before any new slots are used.
+static uint32_t table_free[OXR_HANDLE_TABLE_SIZE];
+static uint32_t table_num_free;
+
+//! Number of slots that have been used at least once.
+static uint32_t table_num_used;
+
+//! Handles are rarely created or destroyed, so a spinlock is enough.
+static xrt_atomic_s32_t table_lock;
+
+static void
+table_lock_acquire(void)
+{
+	while (xrt_atomic_s32_cmpxchg(&table_lock, 0, 1) != 0) {
+	}
+}
+
+static void
+table_lock_release(void)
+{
+	xrt_atomic_s32_cmpxchg(&table_lock, 1, 0);
+}
+
+/*!
+ * Gives the handle a slot, returns the value of the OpenXR handle or zero if
+ * the table is full.
+ */
+static uint64_t
+table_add(struct oxr_handle_base *hb)
+{
+	uint32_t index;
+
+	table_lock_acquire();
+
+	if (table_num_free > 0) {
+		index = table_free[--table_num_free];
+	} else if (table_num_used < OXR_HANDLE_TABLE_SIZE) {
+		index = table_num_used++;
+	} else {
+		table_lock_release();
+		return 0;
+	}
+
+	struct oxr_handle_table_slot *slot = &oxr_handle_table[index];
+	uint64_t generation = (slot->value >> 32) + 1;
+	uint64_t value = (generation << 32) | (index + 1);
+
+	// Lookups don't take the lock, hb has to be visible before value is.
+	slot->hb = hb;
+	xrt_atomic_u64_store_release(&slot->value, value);
+
+	table_lock_release();
+
+	return value;
+}
+
+static void
+table_remove(uint64_t value)
+{
+	uint32_t index = (uint32_t)value - 1;
+	struct oxr_handle_table_slot *slot = &oxr_handle_table[index];
+
+	table_lock_acquire();
+
+	assert(slot->value == value);
+
+	/*
+	 * Keep the generation so the next handle in this slot gets a new one.
+	 * The stale hb is left alone, it's only read while value matches.
+	 */
+	xrt_atomic_u64_store_release(&slot->value, value & ~(uint64_t)0xffffffff);
+	table_free[table_num_free++] = index;
+
+	table_lock_release();
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+uint64_t
+oxr_handle_get_value(const struct oxr_handle_base *hb)
+{
+	return hb->value;
+}
+
+XrResult
+oxr_handle_error_invalid(struct oxr_logger *log, const char *name, uint64_t value, uint64_t debug)
+{
+	if (value == 0) {
+		return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(%s == NULL)", name);
+	}
+
+	struct oxr_handle_base *hb = oxr_handle_table_lookup(value);
+	if (hb == NULL) {
+		return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(%s == 0x%016" PRIx64 ") not a live handle", name,
+		                 value);
+	}
+
+	// The only other reason the verify macros fail.
+	assert(hb->debug != debug);
+
+	return oxr_error(log, XR_ERROR_HANDLE_INVALID, "(%s == 0x%016" PRIx64 ") wrong type of handle", name, value);
+}
+
 const char *
 oxr_handle_state_to_string(enum oxr_handle_state state)
 {
@@ -67,12 +190,17 @@ oxr_handle_init(struct oxr_logger *log,
 
 	hb->state = OXR_HANDLE_STATE_UNINITIALIZED;
 
+	if (parent != NULL && parent->state != OXR_HANDLE_STATE_LIVE) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Handle %p given parent %p in invalid state: %s",
+		                 (void *)parent, (void *)hb, oxr_handle_state_to_string(parent->state));
+	}
+
+	uint64_t value = table_add(hb);
+	if (value == 0) {
+		return oxr_error(log, XR_ERROR_LIMIT_REACHED, "Handle table has no more room for handles");
+	}
+
 	if (parent != NULL) {
-		if (parent->state != OXR_HANDLE_STATE_LIVE) {
-			return oxr_error(log, XR_ERROR_RUNTIME_FAILURE,
-			                 "Handle %p given parent %p in invalid state: %s", (void *)parent, (void *)hb,
-			                 oxr_handle_state_to_string(parent->state));
-		}
 
 		bool placed = false;
 		for (int i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
@@ -87,6 +215,7 @@ oxr_handle_init(struct oxr_logger *log,
 			}
 		}
 		if (!placed) {
+			table_remove(value);
 			return oxr_error(log, XR_ERROR_LIMIT_REACHED,
 			                 "Parent handle has no more room for "
 			                 "child handles");
@@ -97,6 +226,7 @@ oxr_handle_init(struct oxr_logger *log,
 	hb->parent = parent;
 	hb->state = OXR_HANDLE_STATE_LIVE;
 	hb->destroy = destroy;
+	hb->value = value;
 	return XR_SUCCESS;
 }
 
@@ -122,6 +252,159 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 	return result;
 }
 
+
+
+/*
+ *
+ * Pools.
+ *
+ */
+
+//! All objects and the slab header are aligned to this.
+#define POOL_ALIGNMENT 16
+
+#define POOL_ALIGN(size) (((size) + (POOL_ALIGNMENT - 1)) & ~(size_t)(POOL_ALIGNMENT - 1))
+
+/*!
+ * Header of a slab, followed by @ref OXR_HANDLE_POOL_SLAB_SIZE objects.
+ */
+struct oxr_handle_pool_slab
+{
+	struct oxr_handle_pool_slab *next;
+};
+
+static void *
+pool_alloc(struct oxr_handle_pool *pool)
+{
+	os_mutex_lock(&pool->mutex);
+
+	if (pool->free_list == NULL) {
+		size_t header_size = POOL_ALIGN(sizeof(struct oxr_handle_pool_slab));
+		size_t size = header_size + pool->object_size * OXR_HANDLE_POOL_SLAB_SIZE;
+
+		struct oxr_handle_pool_slab *slab = (struct oxr_handle_pool_slab *)malloc(size);
+		if (slab == NULL) {
+			os_mutex_unlock(&pool->mutex);
+			return NULL;
+		}
+
+		slab->next = pool->slabs;
+		pool->slabs = slab;
+		pool->num_slabs++;
+
+		// Push in reverse so objects are handed out in address order.
+		uint8_t *objects = (uint8_t *)slab + header_size;
+		for (int i = OXR_HANDLE_POOL_SLAB_SIZE - 1; i >= 0; i--) {
+			void *obj = objects + pool->object_size * i;
+			*(void **)obj = pool->free_list;
+			pool->free_list = obj;
+		}
+	}
+
+	void *obj = pool->free_list;
+	pool->free_list = *(void **)obj;
+	pool->num_live++;
+	pool->num_allocs++;
+
+	os_mutex_unlock(&pool->mutex);
+
+	// Same as the calloc in oxr_handle_allocate_and_init.
+	memset(obj, 0, pool->object_size);
+
+	return obj;
+}
+
+static void
+pool_free(struct oxr_handle_pool *pool, void *obj)
+{
+	os_mutex_lock(&pool->mutex);
+
+	*(void **)obj = pool->free_list;
+	pool->free_list = obj;
+	pool->num_live--;
+
+	os_mutex_unlock(&pool->mutex);
+}
+
+void
+oxr_handle_pool_init(struct oxr_handle_pool *pool, size_t object_size)
+{
+	assert(object_size >= sizeof(struct oxr_handle_base));
+
+	U_ZERO(pool);
+	os_mutex_init(&pool->mutex);
+	pool->object_size = POOL_ALIGN(object_size);
+}
+
+void
+oxr_handle_pool_add_vars(struct oxr_handle_pool *pool, void *root, const char *prefix)
+{
+	char tmp[128];
+
+	snprintf(tmp, sizeof(tmp), "%s pool slabs", prefix);
+	u_var_add_ro_u64(root, &pool->num_slabs, tmp);
+	snprintf(tmp, sizeof(tmp), "%s pool live", prefix);
+	u_var_add_ro_u64(root, &pool->num_live, tmp);
+	snprintf(tmp, sizeof(tmp), "%s pool allocs", prefix);
+	u_var_add_ro_u64(root, &pool->num_allocs, tmp);
+}
+
+void
+oxr_handle_pool_destroy(struct oxr_handle_pool *pool)
+{
+	// All handles are children of the owner, so already destroyed.
+	assert(pool->num_live == 0);
+
+	struct oxr_handle_pool_slab *slab = pool->slabs;
+	while (slab != NULL) {
+		struct oxr_handle_pool_slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	pool->slabs = NULL;
+	pool->free_list = NULL;
+	pool->num_slabs = 0;
+
+	os_mutex_destroy(&pool->mutex);
+}
+
+XrResult
+oxr_handle_allocate_from_pool_and_init(struct oxr_logger *log,
+                                       struct oxr_handle_pool *pool,
+                                       uint64_t debug,
+                                       oxr_handle_destroyer destroy,
+                                       struct oxr_handle_base *parent,
+                                       void **out)
+{
+	struct oxr_handle_base *hb = (struct oxr_handle_base *)pool_alloc(pool);
+	if (hb == NULL) {
+		return oxr_error(log, XR_ERROR_OUT_OF_MEMORY, "Failed to allocate handle from pool");
+	}
+
+	XrResult result = oxr_handle_init(log, hb, debug, destroy, parent);
+	if (result != XR_SUCCESS) {
+		pool_free(pool, hb);
+		return result;
+	}
+
+	// Set after init as that zeroes the handle base.
+	hb->pool = pool;
+
+	*out = (void *)hb;
+	return result;
+}
+
+void
+oxr_handle_free(struct oxr_handle_base *hb)
+{
+	if (hb->pool != NULL) {
+		pool_free(hb->pool, hb);
+	} else {
+		free(hb);
+	}
+}
+
 /*!
  * This is the actual recursive call that destroys handles.
  *
@@ -182,6 +465,7 @@ oxr_handle_do_destroy(struct oxr_logger *log, struct oxr_handle_base *hb, int le
 		HANDLE_LIFECYCLE_LOG_SCOPED(log, "[%d: destroying %p] Calling handle object destructor", level,
 		                            (void *)hb);
 		hb->state = OXR_HANDLE_STATE_DESTROYED;
+		table_remove(hb->value);
 		XrResult result = hb->destroy(log, hb);
 		if (result != XR_SUCCESS) {
 			return result;
@@ -227,7 +227,7 @@ oxr_action_set_destroy_cb(struct oxr_logger *log, struct oxr_handle_base *hb)
 		act_set->loc_item = NULL;
 	}
 
-	free(act_set);
+	oxr_handle_free(&act_set->handle);
 
 	return XR_SUCCESS;
 }
@@ -243,7 +243,8 @@ oxr_action_set_create(struct oxr_logger *log,
 	int h_ret;
 
 	struct oxr_action_set *act_set = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, act_set, OXR_XR_DEBUG_ACTIONSET, oxr_action_set_destroy_cb, &inst->handle);
+	OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(log, act_set, OXR_XR_DEBUG_ACTIONSET, oxr_action_set_destroy_cb,
+	                                        &inst->handle, &inst->pools.action_sets);
 
 	struct oxr_action_set_ref *act_set_ref = U_TYPED_CALLOC(struct oxr_action_set_ref);
 	act_set_ref->base.destroy = oxr_action_set_ref_destroy_cb;
@@ -313,7 +314,7 @@ oxr_action_destroy_cb(struct oxr_logger *log, struct oxr_handle_base *hb)
 		act->loc_item = NULL;
 	}
 
-	free(act);
+	oxr_handle_free(&act->handle);
 
 	return XR_SUCCESS;
 }
@@ -336,7 +337,8 @@ oxr_action_create(struct oxr_logger *log,
 	}
 
 	struct oxr_action *act = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, act, OXR_XR_DEBUG_ACTION, oxr_action_destroy_cb, &act_set->handle);
+	OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(log, act, OXR_XR_DEBUG_ACTION, oxr_action_destroy_cb, &act_set->handle,
+	                                        &inst->pools.actions);
 
 
 	struct oxr_action_ref *act_ref = U_TYPED_CALLOC(struct oxr_action_ref);
@@ -1325,7 +1327,7 @@ oxr_session_get_action_set_attachment(struct oxr_session *sess,
                                       struct oxr_action_set **act_set)
 {
 	void *ptr = NULL;
-	*act_set = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_action_set *, actionSet);
+	*act_set = OXR_HANDLE_TO_PTR(struct oxr_action_set *, actionSet);
 	*act_set_attached = NULL;
 
 	// In case no action_sets have been attached.
@@ -1390,7 +1392,7 @@ oxr_session_attach_action_sets(struct oxr_logger *log,
 	// Set up the per-session data for these action sets.
 	for (uint32_t i = 0; i < sess->num_action_set_attachments; i++) {
 		struct oxr_action_set *act_set =
-		    XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_action_set *, bindInfo->actionSets[i]);
+		    OXR_HANDLE_TO_PTR(struct oxr_action_set *, bindInfo->actionSets[i]);
 		struct oxr_action_set_ref *act_set_ref = act_set->data;
 		act_set_ref->ever_attached = true;
 		struct oxr_action_set_attachment *act_set_attached = &sess->act_set_attachments[i];
@@ -1454,6 +1456,9 @@ oxr_action_sync_data(struct oxr_logger *log,
 		oxr_xdev_update(sess->sys->xdevs[i]);
 	}
 
+	// Devices have been updated, cached relations are now stale.
+	oxr_session_invalidate_relation_cache(sess);
+
 	// Reset all action set attachments.
 	for (size_t i = 0; i < sess->num_action_set_attachments; ++i) {
 		act_set_attached = &sess->act_set_attachments[i];
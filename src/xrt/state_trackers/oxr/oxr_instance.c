@@ -99,6 +99,10 @@ oxr_instance_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	// Does null checking and sets to null.
 	time_state_destroy(&inst->timekeeping);
 
+	// All action sets and actions are children, so already destroyed.
+	oxr_handle_pool_destroy(&inst->pools.action_sets);
+	oxr_handle_pool_destroy(&inst->pools.actions);
+
 	// Mutex goes last.
 	os_mutex_destroy(&inst->event.mutex);
 
@@ -187,6 +191,9 @@ oxr_instance_create(struct oxr_logger *log, const XrInstanceCreateInfo *createIn
 	inst->debug_views = debug_get_bool_option_debug_views();
 	inst->debug_bindings = debug_get_bool_option_debug_bindings();
 
+	oxr_handle_pool_init(&inst->pools.action_sets, sizeof(struct oxr_action_set));
+	oxr_handle_pool_init(&inst->pools.actions, sizeof(struct oxr_action));
+
 	m_ret = os_mutex_init(&inst->event.mutex);
 	if (m_ret < 0) {
 		ret = oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to init mutex");
@@ -382,6 +389,8 @@ oxr_instance_create(struct oxr_logger *log, const XrInstanceCreateInfo *createIn
 	apply_quirks(log, inst);
 
 	u_var_add_root((void *)inst, "XrInstance", true);
+	oxr_handle_pool_add_vars(&inst->pools.action_sets, (void *)inst, "Action set");
+	oxr_handle_pool_add_vars(&inst->pools.actions, (void *)inst, "Action");
 
 	/* ---- HACK ---- */
 	oxr_sdl2_hack_start(inst->hack, inst->xinst, sys->xdevs);
@@ -81,15 +81,17 @@ print_prefix(struct oxr_logger *logger, const char *fmt, const char *prefix)
  *
  */
 
+bool oxr_log_entrypoints = true;
+
 void
-oxr_log_init(struct oxr_logger *logger, const char *api_func_name)
+oxr_log_entrypoint(const char *api_func_name)
 {
-	if (debug_get_bool_option_entrypoints()) {
-		fprintf(stderr, "%s\n", api_func_name);
+	if (!debug_get_bool_option_entrypoints()) {
+		oxr_log_entrypoints = false;
+		return;
 	}
 
-	logger->inst = NULL;
-	logger->api_func_name = api_func_name;
+	fprintf(stderr, "%s\n", api_func_name);
 }
 
 void
@@ -98,6 +100,26 @@ oxr_log_set_instance(struct oxr_logger *logger, struct oxr_instance *inst)
 	logger->inst = inst;
 }
 
+struct oxr_instance *
+oxr_log_get_instance(struct oxr_logger *logger)
+{
+	if (logger->inst != NULL || logger->handle == NULL) {
+		return logger->inst;
+	}
+
+	// The instance is always the root of the handle tree.
+	struct oxr_handle_base *hb = logger->handle;
+	while (hb->parent != NULL) {
+		hb = hb->parent;
+	}
+
+	if (hb->debug == OXR_XR_DEBUG_INSTANCE) {
+		logger->inst = (struct oxr_instance *)hb;
+	}
+
+	return logger->inst;
+}
+
 void
 oxr_log(struct oxr_logger *logger, const char *fmt, ...)
 {
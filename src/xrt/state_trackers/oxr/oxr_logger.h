@@ -9,10 +9,15 @@
 
 #pragma once
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct oxr_instance;
+struct oxr_handle_base;
+
 
 /*!
  * Helper macro to log a warning just once.
@@ -35,7 +40,13 @@ extern "C" {
  */
 struct oxr_logger
 {
+	/*!
+	 * Instance, resolved from @ref handle on first use, only needed for
+	 * lifecycle logging so not looked up on every call.
+	 */
 	struct oxr_instance *inst;
+	//! Handle the call was made on, if any.
+	struct oxr_handle_base *handle;
 	const char *api_func_name;
 };
 
@@ -45,10 +56,54 @@ struct oxr_logger
  * @{
  */
 
+/*!
+ * Cleared by @ref oxr_log_entrypoint the first time it finds that
+ * OXR_DEBUG_ENTRYPOINTS isn't set.
+ */
+extern bool oxr_log_entrypoints;
+
+/*!
+ * Prints the name of the entry point if OXR_DEBUG_ENTRYPOINTS is set.
+ */
 void
-oxr_log_init(struct oxr_logger *logger, const char *api_func_name);
+oxr_log_entrypoint(const char *api_func_name);
+
+/*!
+ * Called at the start of every entry point, inline so the handle verify fast
+ * path doesn't call out of the entry point, see @ref oxr_handle_table_lookup.
+ */
+static inline void
+oxr_log_init(struct oxr_logger *logger, const char *api_func_name)
+{
+	if (oxr_log_entrypoints) {
+		oxr_log_entrypoint(api_func_name);
+	}
+
+	logger->inst = NULL;
+	logger->handle = NULL;
+	logger->api_func_name = api_func_name;
+}
+
 void
 oxr_log_set_instance(struct oxr_logger *logger, struct oxr_instance *inst);
+
+/*!
+ * Set the handle the call was made on, the instance is looked up from it
+ * lazily by @ref oxr_log_get_instance. Called on every verified entry point.
+ */
+static inline void
+oxr_log_set_handle(struct oxr_logger *logger, struct oxr_handle_base *handle)
+{
+	logger->handle = handle;
+}
+
+/*!
+ * Returns the instance of the logger, walking the parent chain of the handle
+ * set with @ref oxr_log_set_handle the first time it is called. The result is
+ * cached, so call this before destroying any handles that the walk would need.
+ */
+struct oxr_instance *
+oxr_log_get_instance(struct oxr_logger *logger);
 void
 oxr_log(struct oxr_logger *logger, const char *fmt, ...) XRT_PRINTF_FORMAT(2, 3);
 void
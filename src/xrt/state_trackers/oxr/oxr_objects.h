@@ -40,26 +40,22 @@ extern "C" {
  */
 
 /*!
- * @brief Cast a pointer to an OpenXR handle in such a way as to avoid warnings.
+ * @brief Get the OpenXR handle given to the application for an object.
  *
- * Avoids -Wpointer-to-int-cast by first casting to the same size int, then
- * promoting to the 64-bit int, then casting to the handle type. That's a lot of
- * no-ops on 64-bit, but a widening conversion on 32-bit.
+ * Handles are not pointers but values in the handle table, see
+ * @ref oxr_handle_table_lookup. On 32-bit the handle types are 64-bit ints.
  *
  * @ingroup oxr
  */
-#define XRT_CAST_PTR_TO_OXR_HANDLE(HANDLE_TYPE, PTR) ((HANDLE_TYPE)(uint64_t)(uintptr_t)(PTR))
+#define OXR_PTR_TO_HANDLE(HANDLE_TYPE, PTR) ((HANDLE_TYPE)oxr_handle_get_value((struct oxr_handle_base *)(PTR)))
 
 /*!
- * @brief Cast an OpenXR handle to a pointer in such a way as to avoid warnings.
- *
- * Avoids -Wint-to-pointer-cast by first casting to a 64-bit int, then to a
- * pointer-sized int, then to the desired pointer type. That's a lot of no-ops
- * on 64-bit, but a narrowing (!) conversion on 32-bit.
+ * @brief Get the object an OpenXR handle refers to, NULL if the handle isn't
+ * live. Does not check the type of the handle.
  *
  * @ingroup oxr
  */
-#define XRT_CAST_OXR_HANDLE_TO_PTR(PTR_TYPE, HANDLE) ((PTR_TYPE)(uintptr_t)(uint64_t)(HANDLE))
+#define OXR_HANDLE_TO_PTR(PTR_TYPE, HANDLE) ((PTR_TYPE)oxr_handle_table_lookup((uint64_t)(HANDLE)))
 
 /*!
  * @defgroup oxr_main OpenXR main code
@@ -105,6 +101,8 @@ struct oxr_action_set;
 struct oxr_action;
 struct oxr_debug_messenger;
 struct oxr_handle_base;
+struct oxr_handle_pool;
+struct oxr_handle_pool_slab;
 struct oxr_subaction_paths;
 struct oxr_action_attachment;
 struct oxr_action_set_attachment;
@@ -119,6 +117,10 @@ struct oxr_hand_tracker;
 #define XRT_MAX_HANDLE_CHILDREN 256
 #define OXR_MAX_SWAPCHAIN_IMAGES 8
 #define OXR_MAX_BINDINGS_PER_ACTION 16
+#define OXR_MAX_CACHED_RELATIONS 64
+#define OXR_MAX_LAYERS 16
+#define OXR_HANDLE_POOL_SLAB_SIZE 32
+#define OXR_HANDLE_TABLE_SIZE (1 << 16)
 
 struct time_state;
 
@@ -174,6 +176,73 @@ enum oxr_image_state
  *
  */
 
+/*!
+ * A slot in the global handle table, every live handle over all instances has
+ * one, see @ref oxr_handle_table_lookup.
+ *
+ * @relates oxr_handle_base
+ */
+struct oxr_handle_table_slot
+{
+	/*!
+	 * Value of the OpenXR handle for this slot: the index plus one in the
+	 * low 32 bits and the generation in the high 32 bits. The generation is
+	 * bumped every time the slot is reused and the low bits are zero while
+	 * it is free, so a destroyed handle never matches again. Stored with
+	 * release after @ref hb and loaded with acquire before it.
+	 */
+	xrt_atomic_u64_t value;
+
+	//! The handle, only valid while @ref value matches.
+	struct oxr_handle_base *hb;
+};
+
+extern struct oxr_handle_table_slot oxr_handle_table[OXR_HANDLE_TABLE_SIZE];
+
+/*!
+ * Get the handle an OpenXR handle value refers to, the fast path of verifying
+ * handles: a single load and compare of the slot value, the handle is only
+ * dereferenced once it is known to be live. Returns NULL for XR_NULL_HANDLE,
+ * destroyed handles and values that were never given out.
+ *
+ * @relates oxr_handle_base
+ */
+static inline struct oxr_handle_base *
+oxr_handle_table_lookup(uint64_t value)
+{
+	// XR_NULL_HANDLE wraps around and is out of range.
+	uint64_t index = (value & 0xffffffff) - 1;
+	if (index >= OXR_HANDLE_TABLE_SIZE) {
+		return NULL;
+	}
+
+	// Pairs with the release in the table, so hb is the one stored with value.
+	const struct oxr_handle_table_slot *slot = &oxr_handle_table[index];
+	if (xrt_atomic_u64_load_acquire(&slot->value) != value) {
+		return NULL;
+	}
+
+	return slot->hb;
+}
+
+/*!
+ * Returns the value of the OpenXR handle given to the application for this
+ * handle, see @ref OXR_PTR_TO_HANDLE.
+ *
+ * @public @memberof oxr_handle_base
+ */
+uint64_t
+oxr_handle_get_value(const struct oxr_handle_base *hb);
+
+/*!
+ * Slow path of the handle verification macros, reports why @p value isn't a
+ * live handle of the type @p debug and returns XR_ERROR_HANDLE_INVALID.
+ *
+ * @relates oxr_handle_base
+ */
+XrResult
+oxr_handle_error_invalid(struct oxr_logger *log, const char *name, uint64_t value, uint64_t debug);
+
 /*!
  * Destroy the handle's object, as well as all child handles recursively.
  *
@@ -207,7 +276,7 @@ oxr_handle_state_to_string(enum oxr_handle_state state);
 static inline XrInstance
 oxr_instance_to_openxr(struct oxr_instance *inst)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrInstance, inst);
+	return OXR_PTR_TO_HANDLE(XrInstance, inst);
 }
 
 /*!
@@ -326,7 +395,7 @@ oxr_path_destroy(struct oxr_logger *log, struct oxr_instance *inst);
 static inline XrActionSet
 oxr_action_set_to_openxr(struct oxr_action_set *act_set)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrActionSet, act_set);
+	return OXR_PTR_TO_HANDLE(XrActionSet, act_set);
 }
 
 /*!
@@ -337,7 +406,7 @@ oxr_action_set_to_openxr(struct oxr_action_set *act_set)
 static inline XrHandTrackerEXT
 oxr_hand_tracker_to_openxr(struct oxr_hand_tracker *hand_tracker)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrHandTrackerEXT, hand_tracker);
+	return OXR_PTR_TO_HANDLE(XrHandTrackerEXT, hand_tracker);
 }
 
 /*!
@@ -348,7 +417,7 @@ oxr_hand_tracker_to_openxr(struct oxr_hand_tracker *hand_tracker)
 static inline XrAction
 oxr_action_to_openxr(struct oxr_action *act)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrAction, act);
+	return OXR_PTR_TO_HANDLE(XrAction, act);
 }
 
 
@@ -596,7 +665,7 @@ oxr_action_get_input_source_localized_name(struct oxr_logger *log,
 static inline XrSession
 oxr_session_to_openxr(struct oxr_session *sess)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrSession, sess);
+	return OXR_PTR_TO_HANDLE(XrSession, sess);
 }
 
 XrResult
@@ -640,6 +709,31 @@ oxr_session_get_view_relation_at(struct oxr_logger *,
                                  XrTime at_time,
                                  struct xrt_space_relation *out_relation);
 
+/*!
+ * Get the relation of the named input on the device at the given time, with
+ * the tracking origin offset applied. The result is cached on the session so
+ * that locating many spaces driven by the same input at the same time only
+ * queries the device once, see @ref oxr_relation_cache.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_session_get_xdev_relation_at(struct oxr_logger *log,
+                                 struct oxr_session *sess,
+                                 struct xrt_device *xdev,
+                                 enum xrt_input_name name,
+                                 XrTime at_time,
+                                 struct xrt_space_relation *out_relation);
+
+/*!
+ * Throw away all cached device relations, called from xrWaitFrame and
+ * xrSyncActions.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_session_invalidate_relation_cache(struct oxr_session *sess);
+
 XrResult
 oxr_session_locate_views(struct oxr_logger *log,
                          struct oxr_session *sess,
@@ -676,7 +770,7 @@ oxr_session_hand_joints(struct oxr_logger *log,
 static inline XrSpace
 oxr_space_to_openxr(struct oxr_space *spc)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrSpace, spc);
+	return OXR_PTR_TO_HANDLE(XrSpace, spc);
 }
 
 XrResult
@@ -696,6 +790,26 @@ XrResult
 oxr_space_locate(
     struct oxr_logger *log, struct oxr_space *spc, struct oxr_space *baseSpc, XrTime time, XrSpaceLocation *location);
 
+/*!
+ * Locate many spaces relative to one base space at the same time, the part of
+ * the space graph that comes from the base space is only computed once and
+ * device queries are shared between spaces on the same input.
+ *
+ * @param log           Logger.
+ * @param baseSpc       Space to locate all other spaces in.
+ * @param time          Time to locate the spaces at.
+ * @param num_spaces    Number of elements in @p spaces and @p out_relations.
+ * @param spaces        Spaces to locate, must belong to the same session.
+ * @param out_relations Resulting relations, one per space.
+ */
+XrResult
+oxr_space_locate_many(struct oxr_logger *log,
+                      struct oxr_space *baseSpc,
+                      XrTime time,
+                      uint32_t num_spaces,
+                      struct oxr_space **spaces,
+                      struct xrt_space_relation *out_relations);
+
 XrResult
 oxr_space_ref_relation(struct oxr_logger *log,
                        struct oxr_session *sess,
@@ -725,7 +839,7 @@ global_to_local_space(struct oxr_session *sess, struct xrt_space_relation *rel);
 static inline XrSwapchain
 oxr_swapchain_to_openxr(struct oxr_swapchain *sc)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrSwapchain, sc);
+	return OXR_PTR_TO_HANDLE(XrSwapchain, sc);
 }
 
 XrResult
@@ -747,7 +861,7 @@ oxr_create_swapchain(struct oxr_logger *,
 static inline XrDebugUtilsMessengerEXT
 oxr_messenger_to_openxr(struct oxr_debug_messenger *mssngr)
 {
-	return XRT_CAST_PTR_TO_OXR_HANDLE(XrDebugUtilsMessengerEXT, mssngr);
+	return OXR_PTR_TO_HANDLE(XrDebugUtilsMessengerEXT, mssngr);
 }
 
 XrResult
@@ -1057,6 +1171,52 @@ struct oxr_handle_base
 	 * Destroy the object this handle refers to.
 	 */
 	oxr_handle_destroyer destroy;
+
+	/*!
+	 * Pool this handle was allocated from, NULL if it was allocated on the
+	 * heap, see @ref oxr_handle_free.
+	 */
+	struct oxr_handle_pool *pool;
+
+	/*!
+	 * Value of the OpenXR handle given to the application, the index of the
+	 * slot in the handle table and its generation.
+	 */
+	uint64_t value;
+};
+
+/*!
+ * Slab allocator for handles of a single type, owned by the instance or
+ * session that is the parent of all of the handles allocated from it.
+ *
+ * Handles are carved out of slabs of @ref OXR_HANDLE_POOL_SLAB_SIZE objects
+ * and returned to a free list when destroyed, so creating and destroying
+ * many short lived handles doesn't fragment the heap. All slabs are freed at
+ * once when the pool is destroyed together with its owner.
+ *
+ * @see oxr_handle_allocate_from_pool_and_init
+ */
+struct oxr_handle_pool
+{
+	struct os_mutex mutex;
+
+	//! Size of each object, rounded up to keep objects aligned.
+	size_t object_size;
+
+	//! Singly linked list of all slabs.
+	struct oxr_handle_pool_slab *slabs;
+
+	//! Singly linked list of free objects, stored in the objects themselves.
+	void *free_list;
+
+	//! Number of slabs allocated, for the debug gui.
+	uint64_t num_slabs;
+
+	//! Number of objects currently handed out, for the debug gui.
+	uint64_t num_live;
+
+	//! Total number of allocations made, for the debug gui.
+	uint64_t num_allocs;
 };
 
 /*!
@@ -1176,6 +1336,13 @@ struct oxr_instance
 
 	struct oxr_session *sessions;
 
+	//! Pools for handles that are created often, children of the instance.
+	struct
+	{
+		struct oxr_handle_pool action_sets;
+		struct oxr_handle_pool actions;
+	} pools;
+
 	struct
 	{
 
@@ -1227,6 +1394,50 @@ struct oxr_instance
 	bool debug_bindings;
 };
 
+/*!
+ * A single cached device relation, keyed on device, input and time.
+ *
+ * @relates oxr_relation_cache
+ */
+struct oxr_relation_cache_entry
+{
+	struct xrt_device *xdev;
+	enum xrt_input_name name;
+	XrTime at_time;
+
+	//! Relation with the tracking origin offset applied.
+	struct xrt_space_relation relation;
+};
+
+/*!
+ * Per session cache of device relations, reused by all locate calls between
+ * two xrWaitFrame/xrSyncActions calls.
+ *
+ * @see oxr_session_get_xdev_relation_at
+ */
+struct oxr_relation_cache
+{
+	struct os_mutex mutex;
+
+	//! Turned off with the OXR_RELATION_CACHE env variable.
+	bool enabled;
+
+	struct oxr_relation_cache_entry entries[OXR_MAX_CACHED_RELATIONS];
+	uint32_t num_entries;
+
+	//! Next entry to replace once the cache is full.
+	uint32_t next_replace;
+
+	//! Bumped on invalidation, so queries started before it are not inserted.
+	uint64_t generation;
+
+	uint64_t hits;
+	uint64_t misses;
+
+	//! Hit rate since session creation, in percent, updated each frame.
+	float hit_rate;
+};
+
 /*!
  * Object that client program interact with.
  *
@@ -1347,6 +1558,22 @@ struct oxr_session
 	/*! initial relation of head in "global" space.
 	 * Used as reference for local space.  */
 	struct xrt_space_relation initial_head_relation;
+
+	//! Cached device relations for the current frame.
+	struct oxr_relation_cache relation_cache;
+
+	/*!
+	 * Scratch space that xrEndFrame converts layers into before handing
+	 * them all to the compositor, only used by xrEndFrame so no locking.
+	 */
+	struct xrt_layer_entry layer_scratch[OXR_MAX_LAYERS];
+
+	//! Pools for handles that are created often, children of the session.
+	struct
+	{
+		struct oxr_handle_pool spaces;
+		struct oxr_handle_pool swapchains;
+	} pools;
 };
 
 /*!
@@ -25,6 +25,7 @@
 #include "util/u_debug.h"
 #include "util/u_misc.h"
 #include "util/u_time.h"
+#include "util/u_var.h"
 #include "util/u_verify.h"
 
 #include "math/m_api.h"
@@ -48,6 +49,7 @@
 DEBUG_GET_ONCE_NUM_OPTION(ipd, "OXR_DEBUG_IPD_MM", 63)
 DEBUG_GET_ONCE_NUM_OPTION(wait_frame_sleep, "OXR_DEBUG_WAIT_FRAME_EXTRA_SLEEP_MS", 0)
 DEBUG_GET_ONCE_BOOL_OPTION(frame_timing_spew, "OXR_FRAME_TIMING_SPEW", false)
+DEBUG_GET_ONCE_BOOL_OPTION(relation_cache, "OXR_RELATION_CACHE", true)
 
 #define CALL_CHK(call)                                                                                                 \
 	if ((call) == XRT_ERROR_IPC_FAILURE) {                                                                         \
@@ -262,6 +264,121 @@ oxr_session_poll(struct oxr_logger *log, struct oxr_session *sess)
 	}
 }
 
+static void
+relation_cache_init(struct oxr_session *sess)
+{
+	struct oxr_relation_cache *cache = &sess->relation_cache;
+
+	os_mutex_init(&cache->mutex);
+	cache->enabled = debug_get_bool_option_relation_cache();
+
+	u_var_add_bool(sess, &cache->enabled, "Relation cache enabled");
+	u_var_add_ro_u64(sess, &cache->hits, "Relation cache hits");
+	u_var_add_ro_u64(sess, &cache->misses, "Relation cache misses");
+	u_var_add_ro_f32(sess, &cache->hit_rate, "Relation cache hit rate (%)");
+}
+
+static void
+relation_cache_destroy(struct oxr_session *sess)
+{
+	os_mutex_destroy(&sess->relation_cache.mutex);
+}
+
+static struct oxr_relation_cache_entry *
+relation_cache_find_locked(struct oxr_relation_cache *cache,
+                           struct xrt_device *xdev,
+                           enum xrt_input_name name,
+                           XrTime at_time)
+{
+	for (uint32_t i = 0; i < cache->num_entries; i++) {
+		struct oxr_relation_cache_entry *e = &cache->entries[i];
+		if (e->xdev == xdev && e->name == name && e->at_time == at_time) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+void
+oxr_session_invalidate_relation_cache(struct oxr_session *sess)
+{
+	struct oxr_relation_cache *cache = &sess->relation_cache;
+
+	os_mutex_lock(&cache->mutex);
+
+	uint64_t total = cache->hits + cache->misses;
+	if (total > 0) {
+		cache->hit_rate = (float)((double)cache->hits * 100.0 / (double)total);
+	}
+
+	cache->num_entries = 0;
+	cache->next_replace = 0;
+	cache->generation++;
+
+	os_mutex_unlock(&cache->mutex);
+}
+
+void
+oxr_session_get_xdev_relation_at(struct oxr_logger *log,
+                                 struct oxr_session *sess,
+                                 struct xrt_device *xdev,
+                                 enum xrt_input_name name,
+                                 XrTime at_time,
+                                 struct xrt_space_relation *out_relation)
+{
+	struct oxr_relation_cache *cache = &sess->relation_cache;
+
+	if (!cache->enabled) {
+		oxr_xdev_get_space_relation(log, sess->sys->inst, xdev, name, at_time, out_relation);
+		return;
+	}
+
+	os_mutex_lock(&cache->mutex);
+
+	struct oxr_relation_cache_entry *e = relation_cache_find_locked(cache, xdev, name, at_time);
+	if (e != NULL) {
+		*out_relation = e->relation;
+		cache->hits++;
+
+		os_mutex_unlock(&cache->mutex);
+		return;
+	}
+
+	cache->misses++;
+	uint64_t generation = cache->generation;
+
+	os_mutex_unlock(&cache->mutex);
+
+	// The device or IPC call is made without the lock, so other locates are not serialised behind it.
+	struct xrt_space_relation relation;
+	oxr_xdev_get_space_relation(log, sess->sys->inst, xdev, name, at_time, &relation);
+
+	*out_relation = relation;
+
+	os_mutex_lock(&cache->mutex);
+
+	// Drop it if the cache was invalidated meanwhile, or another thread got there first.
+	if (cache->generation != generation || relation_cache_find_locked(cache, xdev, name, at_time) != NULL) {
+		os_mutex_unlock(&cache->mutex);
+		return;
+	}
+
+	if (cache->num_entries < OXR_MAX_CACHED_RELATIONS) {
+		e = &cache->entries[cache->num_entries++];
+	} else {
+		e = &cache->entries[cache->next_replace];
+		cache->next_replace = (cache->next_replace + 1) % OXR_MAX_CACHED_RELATIONS;
+	}
+
+	e->xdev = xdev;
+	e->name = name;
+	e->at_time = at_time;
+	e->relation = relation;
+
+	os_mutex_unlock(&cache->mutex);
+}
+
 XrResult
 oxr_session_get_view_relation_at(struct oxr_logger *log,
                                  struct oxr_session *sess,
@@ -281,9 +398,7 @@ oxr_session_get_view_relation_at(struct oxr_logger *log,
 	struct xrt_device *xdev = GET_XDEV_BY_ROLE(sess->sys, head);
 
 	// Applies the offset in the function.
-	struct xrt_space_graph xsg = {0};
-	oxr_xdev_get_space_graph(log, sess->sys->inst, xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_time, &xsg);
-	m_space_graph_resolve(&xsg, out_relation);
+	oxr_session_get_xdev_relation_at(log, sess, xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_time, out_relation);
 
 	return oxr_session_success_result(sess);
 }
@@ -339,7 +454,7 @@ oxr_session_locate_views(struct oxr_logger *log,
                          XrView *views)
 {
 	struct xrt_device *xdev = GET_XDEV_BY_ROLE(sess->sys, head);
-	struct oxr_space *baseSpc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, viewLocateInfo->space);
+	struct oxr_space *baseSpc = OXR_HANDLE_TO_PTR(struct oxr_space *, viewLocateInfo->space);
 	uint32_t num_views = 2;
 
 	// Does this apply for all calls?
@@ -468,6 +583,9 @@ oxr_session_frame_wait(struct oxr_logger *log, struct oxr_session *sess, XrFrame
 	//! more than one session per instance.
 	XRT_MAYBE_UNUSED timepoint_ns now = time_state_get_now_and_update(sess->sys->inst->timekeeping);
 
+	// New predictions are coming in, don't hand out old ones.
+	oxr_session_invalidate_relation_cache(sess);
+
 	struct xrt_compositor *xc = sess->compositor;
 	if (xc == NULL) {
 		frameState->shouldRender = XR_FALSE;
@@ -601,6 +719,13 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	os_semaphore_destroy(&sess->sem);
 	os_mutex_destroy(&sess->active_wait_frames_lock);
 
+	relation_cache_destroy(sess);
+	u_var_remove_root(sess);
+
+	// All spaces and swapchains are children, so already destroyed.
+	oxr_handle_pool_destroy(&sess->pools.spaces);
+	oxr_handle_pool_destroy(&sess->pools.swapchains);
+
 	free(sess);
 
 	return ret;
@@ -779,6 +904,16 @@ oxr_session_create(struct oxr_logger *log,
 	sess->active_wait_frames = 0;
 	os_mutex_init(&sess->active_wait_frames_lock);
 
+	oxr_handle_pool_init(&sess->pools.spaces, sizeof(struct oxr_space));
+	oxr_handle_pool_init(&sess->pools.swapchains, sizeof(struct oxr_swapchain));
+
+	u_var_add_root(sess, "XrSession", true);
+
+	relation_cache_init(sess);
+
+	oxr_handle_pool_add_vars(&sess->pools.spaces, sess, "Space");
+	oxr_handle_pool_add_vars(&sess->pools.swapchains, sess, "Swapchain");
+
 	sess->ipd_meters = debug_get_num_option_ipd() / 1000.0f;
 	sess->frame_timing_spew = debug_get_bool_option_frame_timing_spew();
 	sess->frame_timing_wait_sleep_ms = debug_get_num_option_wait_frame_sleep();
@@ -813,7 +948,7 @@ oxr_session_hand_joints(struct oxr_logger *log,
                         const XrHandJointsLocateInfoEXT *locateInfo,
                         XrHandJointLocationsEXT *locations)
 {
-	struct oxr_space *baseSpc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, locateInfo->baseSpace);
+	struct oxr_space *baseSpc = OXR_HANDLE_TO_PTR(struct oxr_space *, locateInfo->baseSpace);
 
 	struct oxr_session *sess = hand_tracker->sess;
 
@@ -835,100 +970,116 @@ oxr_session_hand_joints(struct oxr_logger *log,
 
 	oxr_xdev_get_hand_tracking_at(log, sess->sys->inst, xdev, name, at_time, &value);
 
-	for (uint32_t i = 0; i < locations->jointCount; i++) {
-		locations->jointLocations[i].locationFlags =
-		    xrt_to_xr_space_location_flags(value.values.hand_joint_set_default[i].relation.relation_flags);
-		locations->jointLocations[i].radius = value.values.hand_joint_set_default[i].radius;
+	/*
+	 * All joints share the chain from the hand to the base space, build
+	 * and resolve it once and then apply it to all of the joints.
+	 */
+	struct xrt_space_graph graph = {0};
 
-		struct xrt_space_relation r = value.values.hand_joint_set_default[i].relation;
+	if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_STAGE) {
 
-		struct xrt_space_relation result;
-		struct xrt_space_graph graph = {0};
-		m_space_graph_add_relation(&graph, &r);
+		m_space_graph_add_relation(&graph, &value.hand_pose);
+		m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
 
+	} else if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL) {
 
-		if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_STAGE) {
+		// for local space, first do stage space and transform
+		// result to local @todo: improve local space
+		m_space_graph_add_relation(&graph, &value.hand_pose);
+		m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
 
-			m_space_graph_add_relation(&graph, &value.hand_pose);
-			m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
+	} else if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
+		/*! @todo: testing, relating to view space unsupported
+		 * in other parts of monado */
 
-		} else if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL) {
+		struct xrt_device *head_xdev = GET_XDEV_BY_ROLE(sess->sys, head);
 
-			// for local space, first do stage space and transform
-			// result to local @todo: improve local space
-			m_space_graph_add_relation(&graph, &value.hand_pose);
-			m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
+		struct xrt_space_relation view_relation;
+		oxr_session_get_view_relation_at(log, sess, at_time, &view_relation);
 
-		} else if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
-			/*! @todo: testing, relating to view space unsupported
-			 * in other parts of monado */
+		m_space_graph_add_relation(&graph, &value.hand_pose);
+		m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
 
-			struct xrt_device *head_xdev = GET_XDEV_BY_ROLE(sess->sys, head);
+		m_space_graph_add_inverted_relation(&graph, &view_relation);
+		m_space_graph_add_inverted_pose_if_not_identity(&graph, &head_xdev->tracking_origin->offset);
 
-			struct xrt_space_relation view_relation;
-			oxr_session_get_view_relation_at(log, sess, at_time, &view_relation);
+	} else if (!baseSpc->is_reference) {
+		// action space
 
-			m_space_graph_add_relation(&graph, &value.hand_pose);
-			m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
+		struct oxr_action_input *input = NULL;
+		oxr_action_get_pose_input(log, sess, baseSpc->act_key, &baseSpc->subaction_paths, &input);
 
-			m_space_graph_add_inverted_relation(&graph, &view_relation);
-			m_space_graph_add_inverted_pose_if_not_identity(&graph, &head_xdev->tracking_origin->offset);
+		// If the input isn't active.
+		if (input == NULL) {
+			locations->isActive = false;
+			return XR_SUCCESS;
+		}
 
-		} else if (!baseSpc->is_reference) {
-			// action space
+		struct xrt_space_relation act_space_relation;
 
-			struct oxr_action_input *input = NULL;
-			oxr_action_get_pose_input(log, sess, baseSpc->act_key, &baseSpc->subaction_paths, &input);
+		oxr_session_get_xdev_relation_at(log, sess, input->xdev, input->input->name, at_time,
+		                                 &act_space_relation);
 
-			// If the input isn't active.
-			if (input == NULL) {
-				locations->isActive = false;
-				return XR_SUCCESS;
-			}
 
-			struct xrt_space_relation act_space_relation;
+		m_space_graph_add_relation(&graph, &value.hand_pose);
+		m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
 
-			oxr_xdev_get_space_relation(log, sess->sys->inst, input->xdev, input->input->name, at_time,
-			                            &act_space_relation);
+		m_space_graph_add_inverted_relation(&graph, &act_space_relation);
+		m_space_graph_add_inverted_pose_if_not_identity(&graph, &input->xdev->tracking_origin->offset);
+	}
 
+	m_space_graph_add_inverted_pose_if_not_identity(&graph, &baseSpc->pose);
 
-			m_space_graph_add_relation(&graph, &value.hand_pose);
-			m_space_graph_add_pose_if_not_identity(&graph, tracking_origin_offset);
+	// Checked to be XR_HAND_JOINT_COUNT_EXT in the API function.
+	uint32_t joint_count = locations->jointCount;
+	assert(joint_count <= XRT_HAND_JOINT_COUNT);
+	struct xrt_space_relation results[XRT_HAND_JOINT_COUNT];
 
-			m_space_graph_add_inverted_relation(&graph, &act_space_relation);
-			m_space_graph_add_inverted_pose_if_not_identity(&graph, &input->xdev->tracking_origin->offset);
-		}
+	for (uint32_t i = 0; i < joint_count; i++) {
+		results[i] = value.values.hand_joint_set_default[i].relation;
+	}
 
-		m_space_graph_add_inverted_pose_if_not_identity(&graph, &baseSpc->pose);
-		m_space_graph_resolve(&graph, &result);
+	if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL) {
+		struct xrt_space_relation base;
+		m_space_graph_resolve(&graph, &base);
 
-		if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL) {
-			if (!global_to_local_space(sess, &result)) {
-				locations->isActive = false;
-				return XR_SUCCESS;
-			}
+		if (!global_to_local_space(sess, &base)) {
+			locations->isActive = false;
+			return XR_SUCCESS;
 		}
 
-		xrt_to_xr_pose(&result.pose, &locations->jointLocations[i].pose);
+		m_space_relation_apply_many(&base, results, results, joint_count);
+	} else {
+		m_space_graph_resolve_many(&graph, results, results, joint_count);
+	}
+
+	for (uint32_t i = 0; i < joint_count; i++) {
+		locations->jointLocations[i].locationFlags =
+		    xrt_to_xr_space_location_flags(value.values.hand_joint_set_default[i].relation.relation_flags);
+		locations->jointLocations[i].radius = value.values.hand_joint_set_default[i].radius;
+
+		struct xrt_space_relation *result = &results[i];
+
+		xrt_to_xr_pose(&result->pose, &locations->jointLocations[i].pose);
 
 		if (vel) {
 			XrHandJointVelocityEXT *v = &vel->jointVelocities[i];
 
 			v->velocityFlags = 0;
-			if ((result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
+			if ((result->relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
 				v->velocityFlags |= XR_SPACE_VELOCITY_LINEAR_VALID_BIT;
 			}
-			if ((result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
+			if ((result->relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
 				v->velocityFlags |= XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
 			}
 
-			v->linearVelocity.x = result.linear_velocity.x;
-			v->linearVelocity.y = result.linear_velocity.y;
-			v->linearVelocity.z = result.linear_velocity.z;
+			v->linearVelocity.x = result->linear_velocity.x;
+			v->linearVelocity.y = result->linear_velocity.y;
+			v->linearVelocity.z = result->linear_velocity.z;
 
-			v->angularVelocity.x = result.angular_velocity.x;
-			v->angularVelocity.y = result.angular_velocity.y;
-			v->angularVelocity.z = result.angular_velocity.z;
+			v->angularVelocity.x = result->angular_velocity.x;
+			v->angularVelocity.y = result->angular_velocity.y;
+			v->angularVelocity.z = result->angular_velocity.z;
 		}
 	}
 
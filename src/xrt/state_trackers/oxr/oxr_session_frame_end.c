@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <inttypes.h>
 
@@ -183,7 +184,7 @@ verify_quad_layer(struct xrt_compositor *xc,
                   struct xrt_device *head,
                   uint64_t timestamp)
 {
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, quad->subImage.swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, quad->subImage.swapchain);
 
 	if (sc == NULL) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -261,7 +262,7 @@ verify_depth_layer(struct xrt_compositor *xc,
 		                 layer_index, i);
 	}
 
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, depth->subImage.swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, depth->subImage.swapchain);
 
 	if (!sc->released.yes) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -384,7 +385,7 @@ verify_projection_layer(struct xrt_compositor *xc,
 			                 layer_index, i);
 		}
 
-		struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, view->subImage.swapchain);
+		struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, view->subImage.swapchain);
 
 		if (!sc->released.yes) {
 			return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -467,7 +468,7 @@ verify_cube_layer(struct xrt_compositor *xc,
 	                 "XrCompositionLayerCubeKHR not supported",
 	                 layer_index);
 #else
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cube->swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cube->swapchain);
 
 	if (sc == NULL) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -522,7 +523,7 @@ verify_cylinder_layer(struct xrt_compositor *xc,
 	                 "XrCompositionLayerCylinderKHR not supported",
 	                 layer_index);
 #else
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cylinder->subImage.swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cylinder->subImage.swapchain);
 
 	if (sc == NULL) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -619,7 +620,7 @@ verify_equirect1_layer(struct xrt_compositor *xc,
 	                 "XrCompositionLayerEquirectKHR not supported",
 	                 layer_index);
 #else
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
 
 	if (sc == NULL) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -703,7 +704,7 @@ verify_equirect2_layer(struct xrt_compositor *xc,
 	                 "(frameEndInfo->layers[%u]->type) layer type XrCompositionLayerEquirect2KHR not supported",
 	                 layer_index);
 #else
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
 
 	if (sc == NULL) {
 		return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -857,17 +858,16 @@ handle_space(struct oxr_logger *log,
 	return true;
 }
 
-static XrResult
-submit_quad_layer(struct oxr_session *sess,
-                  struct xrt_compositor *xc,
-                  struct oxr_logger *log,
-                  XrCompositionLayerQuad *quad,
-                  struct xrt_device *head,
-                  struct xrt_pose *inv_offset,
-                  uint64_t timestamp)
+static bool
+convert_quad_layer(struct oxr_session *sess,
+                   struct oxr_logger *log,
+                   XrCompositionLayerQuad *quad,
+                   struct xrt_pose *inv_offset,
+                   uint64_t timestamp,
+                   struct xrt_layer_entry *entry)
 {
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, quad->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, quad->space);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, quad->subImage.swapchain);
+	struct oxr_space *spc = OXR_HANDLE_TO_PTR(struct oxr_space *, quad->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(quad->layerFlags);
 
@@ -875,42 +875,41 @@ submit_quad_layer(struct oxr_session *sess,
 
 	struct xrt_pose pose;
 	if (!handle_space(log, sess, spc, pose_ptr, inv_offset, timestamp, &pose)) {
-		return XR_SUCCESS;
+		return false;
 	}
 
 	if (spc->is_reference && spc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_QUAD;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = timestamp;
-	data.flags = flags;
+	struct xrt_layer_data *data = &entry->data;
+	U_ZERO(data);
+	data->type = XRT_LAYER_QUAD;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = timestamp;
+	data->flags = flags;
 
 	struct xrt_vec2 *size = (struct xrt_vec2 *)&quad->size;
 
-	data.quad.visibility = convert_eye_visibility(quad->eyeVisibility);
-	data.quad.pose = pose;
-	data.quad.size = *size;
-	fill_in_sub_image(sc, &quad->subImage, &data.quad.sub);
+	data->quad.visibility = convert_eye_visibility(quad->eyeVisibility);
+	data->quad.pose = pose;
+	data->quad.size = *size;
+	fill_in_sub_image(sc, &quad->subImage, &data->quad.sub);
 
-	CALL_CHK(xrt_comp_layer_quad(xc, head, sc->swapchain, &data));
+	entry->xscs[0] = sc->swapchain;
 
-	return XR_SUCCESS;
+	return true;
 }
 
-static XrResult
-submit_projection_layer(struct oxr_session *sess,
-                        struct xrt_compositor *xc,
-                        struct oxr_logger *log,
-                        XrCompositionLayerProjection *proj,
-                        struct xrt_device *head,
-                        struct xrt_pose *inv_offset,
-                        uint64_t timestamp)
+static bool
+convert_projection_layer(struct oxr_session *sess,
+                         struct oxr_logger *log,
+                         XrCompositionLayerProjection *proj,
+                         struct xrt_pose *inv_offset,
+                         uint64_t timestamp,
+                         struct xrt_layer_entry *entry)
 {
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, proj->space);
+	struct oxr_space *spc = OXR_HANDLE_TO_PTR(struct oxr_space *, proj->space);
 	struct oxr_swapchain *d_scs[2] = {NULL, NULL};
 	struct oxr_swapchain *scs[2];
 	struct xrt_pose *pose_ptr;
@@ -920,11 +919,11 @@ submit_projection_layer(struct oxr_session *sess,
 
 	uint32_t num_chains = ARRAY_SIZE(scs);
 	for (uint32_t i = 0; i < num_chains; i++) {
-		scs[i] = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, proj->views[i].subImage.swapchain);
+		scs[i] = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, proj->views[i].subImage.swapchain);
 		pose_ptr = (struct xrt_pose *)&proj->views[i].pose;
 
 		if (!handle_space(log, sess, spc, pose_ptr, inv_offset, timestamp, &pose[i])) {
-			return XR_SUCCESS;
+			return false;
 		}
 	}
 
@@ -935,32 +934,32 @@ submit_projection_layer(struct oxr_session *sess,
 	struct xrt_fov *l_fov = (struct xrt_fov *)&proj->views[0].fov;
 	struct xrt_fov *r_fov = (struct xrt_fov *)&proj->views[1].fov;
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_STEREO_PROJECTION;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = timestamp;
-	data.flags = flags;
-	data.stereo.l.fov = *l_fov;
-	data.stereo.l.pose = pose[0];
-	data.stereo.r.fov = *r_fov;
-	data.stereo.r.pose = pose[1];
-	fill_in_sub_image(scs[0], &proj->views[0].subImage, &data.stereo.l.sub);
-	fill_in_sub_image(scs[1], &proj->views[1].subImage, &data.stereo.r.sub);
+	struct xrt_layer_data *data = &entry->data;
+	U_ZERO(data);
+	data->type = XRT_LAYER_STEREO_PROJECTION;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = timestamp;
+	data->flags = flags;
+	data->stereo.l.fov = *l_fov;
+	data->stereo.l.pose = pose[0];
+	data->stereo.r.fov = *r_fov;
+	data->stereo.r.pose = pose[1];
+	fill_in_sub_image(scs[0], &proj->views[0].subImage, &data->stereo.l.sub);
+	fill_in_sub_image(scs[1], &proj->views[1].subImage, &data->stereo.r.sub);
 
 
 #ifdef XRT_FEATURE_OPENXR_LAYER_DEPTH
 	const XrCompositionLayerDepthInfoKHR *d_l = OXR_GET_INPUT_FROM_CHAIN(
 	    &proj->views[0], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
 	if (d_l) {
-		data.stereo_depth.l_d.far_z = d_l->farZ;
-		data.stereo_depth.l_d.near_z = d_l->nearZ;
-		data.stereo_depth.l_d.max_depth = d_l->maxDepth;
-		data.stereo_depth.l_d.min_depth = d_l->minDepth;
+		data->stereo_depth.l_d.far_z = d_l->farZ;
+		data->stereo_depth.l_d.near_z = d_l->nearZ;
+		data->stereo_depth.l_d.max_depth = d_l->maxDepth;
+		data->stereo_depth.l_d.min_depth = d_l->minDepth;
 
-		struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_l->subImage.swapchain);
+		struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_l->subImage.swapchain);
 
-		fill_in_sub_image(sc, &d_l->subImage, &data.stereo_depth.l_d.sub);
+		fill_in_sub_image(sc, &d_l->subImage, &data->stereo_depth.l_d.sub);
 
 		// Need to pass this in.
 		d_scs[0] = sc;
@@ -970,65 +969,58 @@ submit_projection_layer(struct oxr_session *sess,
 	    &proj->views[1], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
 
 	if (d_r) {
-		data.stereo_depth.r_d.far_z = d_r->farZ;
-		data.stereo_depth.r_d.near_z = d_r->nearZ;
-		data.stereo_depth.r_d.max_depth = d_r->maxDepth;
-		data.stereo_depth.r_d.min_depth = d_r->minDepth;
+		data->stereo_depth.r_d.far_z = d_r->farZ;
+		data->stereo_depth.r_d.near_z = d_r->nearZ;
+		data->stereo_depth.r_d.max_depth = d_r->maxDepth;
+		data->stereo_depth.r_d.min_depth = d_r->minDepth;
 
-		struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_r->subImage.swapchain);
+		struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, d_r->subImage.swapchain);
 
-		fill_in_sub_image(sc, &d_r->subImage, &data.stereo_depth.r_d.sub);
+		fill_in_sub_image(sc, &d_r->subImage, &data->stereo_depth.r_d.sub);
 
 		// Need to pass this in.
 		d_scs[1] = sc;
 	}
 #endif // XRT_FEATURE_OPENXR_LAYER_DEPTH
 
+	entry->xscs[0] = scs[0]->swapchain; // Left
+	entry->xscs[1] = scs[1]->swapchain; // Right
+
 	if (d_scs[0] != NULL && d_scs[1] != NULL) {
 #ifdef XRT_FEATURE_OPENXR_LAYER_DEPTH
-		data.type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
-		CALL_CHK(xrt_comp_layer_stereo_projection_depth(xc, head,
-		                                                scs[0]->swapchain,   // Left
-		                                                scs[1]->swapchain,   // Right
-		                                                d_scs[0]->swapchain, // Left
-		                                                d_scs[1]->swapchain, // Right
-		                                                &data));
+		data->type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
+		entry->xscs[2] = d_scs[0]->swapchain; // Left
+		entry->xscs[3] = d_scs[1]->swapchain; // Right
 #else
 		assert(false && "Should not get here");
 #endif // XRT_FEATURE_OPENXR_LAYER_DEPTH
-	} else {
-		CALL_CHK(xrt_comp_layer_stereo_projection(xc, head,
-		                                          scs[0]->swapchain, // Left
-		                                          scs[1]->swapchain, // Right
-		                                          &data));
 	}
 
-	return XR_SUCCESS;
+	return true;
 }
 
-static void
-submit_cube_layer(struct oxr_session *sess,
-                  struct xrt_compositor *xc,
-                  struct oxr_logger *log,
-                  const XrCompositionLayerCubeKHR *cube,
-                  struct xrt_device *head,
-                  struct xrt_pose *inv_offset,
-                  uint64_t timestamp)
+static bool
+convert_cube_layer(struct oxr_session *sess,
+                   struct oxr_logger *log,
+                   const XrCompositionLayerCubeKHR *cube,
+                   struct xrt_pose *inv_offset,
+                   uint64_t timestamp,
+                   struct xrt_layer_entry *entry)
 {
 	// Not implemented
+	return false;
 }
 
-static XrResult
-submit_cylinder_layer(struct oxr_session *sess,
-                      struct xrt_compositor *xc,
-                      struct oxr_logger *log,
-                      const XrCompositionLayerCylinderKHR *cylinder,
-                      struct xrt_device *head,
-                      struct xrt_pose *inv_offset,
-                      uint64_t timestamp)
+static bool
+convert_cylinder_layer(struct oxr_session *sess,
+                       struct oxr_logger *log,
+                       const XrCompositionLayerCylinderKHR *cylinder,
+                       struct xrt_pose *inv_offset,
+                       uint64_t timestamp,
+                       struct xrt_layer_entry *entry)
 {
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cylinder->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, cylinder->space);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, cylinder->subImage.swapchain);
+	struct oxr_space *spc = OXR_HANDLE_TO_PTR(struct oxr_space *, cylinder->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(cylinder->layerFlags);
 	enum xrt_layer_eye_visibility visibility = convert_eye_visibility(cylinder->eyeVisibility);
@@ -1037,43 +1029,42 @@ submit_cylinder_layer(struct oxr_session *sess,
 
 	struct xrt_pose pose;
 	if (!handle_space(log, sess, spc, pose_ptr, inv_offset, timestamp, &pose)) {
-		return XR_SUCCESS;
+		return false;
 	}
 
 	if (spc->is_reference && spc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_CYLINDER;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = timestamp;
-	data.flags = flags;
+	struct xrt_layer_data *data = &entry->data;
+	U_ZERO(data);
+	data->type = XRT_LAYER_CYLINDER;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = timestamp;
+	data->flags = flags;
 
-	data.cylinder.visibility = visibility;
-	data.cylinder.pose = pose;
-	data.cylinder.radius = cylinder->radius;
-	data.cylinder.central_angle = cylinder->centralAngle;
-	data.cylinder.aspect_ratio = cylinder->aspectRatio;
-	fill_in_sub_image(sc, &cylinder->subImage, &data.cylinder.sub);
+	data->cylinder.visibility = visibility;
+	data->cylinder.pose = pose;
+	data->cylinder.radius = cylinder->radius;
+	data->cylinder.central_angle = cylinder->centralAngle;
+	data->cylinder.aspect_ratio = cylinder->aspectRatio;
+	fill_in_sub_image(sc, &cylinder->subImage, &data->cylinder.sub);
 
-	CALL_CHK(xrt_comp_layer_cylinder(xc, head, sc->swapchain, &data));
+	entry->xscs[0] = sc->swapchain;
 
-	return XR_SUCCESS;
+	return true;
 }
 
-static XrResult
-submit_equirect1_layer(struct oxr_session *sess,
-                       struct xrt_compositor *xc,
-                       struct oxr_logger *log,
-                       const XrCompositionLayerEquirectKHR *equirect,
-                       struct xrt_device *head,
-                       struct xrt_pose *inv_offset,
-                       uint64_t timestamp)
+static bool
+convert_equirect1_layer(struct oxr_session *sess,
+                        struct oxr_logger *log,
+                        const XrCompositionLayerEquirectKHR *equirect,
+                        struct xrt_pose *inv_offset,
+                        uint64_t timestamp,
+                        struct xrt_layer_entry *entry)
 {
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
+	struct oxr_space *spc = OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(equirect->layerFlags);
 
@@ -1081,34 +1072,34 @@ submit_equirect1_layer(struct oxr_session *sess,
 
 	struct xrt_pose pose;
 	if (!handle_space(log, sess, spc, pose_ptr, inv_offset, timestamp, &pose)) {
-		return XR_SUCCESS;
+		return false;
 	}
 
 	if (spc->is_reference && spc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_EQUIRECT1;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = timestamp;
-	data.flags = flags;
-	data.equirect1.visibility = convert_eye_visibility(equirect->eyeVisibility);
-	data.equirect1.pose = pose;
-	data.equirect1.radius = equirect->radius;
-	fill_in_sub_image(sc, &equirect->subImage, &data.equirect1.sub);
+	struct xrt_layer_data *data = &entry->data;
+	U_ZERO(data);
+	data->type = XRT_LAYER_EQUIRECT1;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = timestamp;
+	data->flags = flags;
+	data->equirect1.visibility = convert_eye_visibility(equirect->eyeVisibility);
+	data->equirect1.pose = pose;
+	data->equirect1.radius = equirect->radius;
+	fill_in_sub_image(sc, &equirect->subImage, &data->equirect1.sub);
 
 
 	struct xrt_vec2 *scale = (struct xrt_vec2 *)&equirect->scale;
 	struct xrt_vec2 *bias = (struct xrt_vec2 *)&equirect->bias;
 
-	data.equirect1.scale = *scale;
-	data.equirect1.bias = *bias;
+	data->equirect1.scale = *scale;
+	data->equirect1.bias = *bias;
 
-	CALL_CHK(xrt_comp_layer_equirect1(xc, head, sc->swapchain, &data));
+	entry->xscs[0] = sc->swapchain;
 
-	return XR_SUCCESS;
+	return true;
 }
 
 static void
@@ -1120,17 +1111,16 @@ do_synchronize_state_change(struct oxr_logger *log, struct oxr_session *sess)
 	}
 }
 
-static XrResult
-submit_equirect2_layer(struct oxr_session *sess,
-                       struct xrt_compositor *xc,
-                       struct oxr_logger *log,
-                       const XrCompositionLayerEquirect2KHR *equirect,
-                       struct xrt_device *head,
-                       struct xrt_pose *inv_offset,
-                       uint64_t timestamp)
+static bool
+convert_equirect2_layer(struct oxr_session *sess,
+                        struct oxr_logger *log,
+                        const XrCompositionLayerEquirect2KHR *equirect,
+                        struct xrt_pose *inv_offset,
+                        uint64_t timestamp,
+                        struct xrt_layer_entry *entry)
 {
-	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
-	struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
+	struct oxr_swapchain *sc = OXR_HANDLE_TO_PTR(struct oxr_swapchain *, equirect->subImage.swapchain);
+	struct oxr_space *spc = OXR_HANDLE_TO_PTR(struct oxr_space *, equirect->space);
 
 	enum xrt_layer_composition_flags flags = convert_layer_flags(equirect->layerFlags);
 
@@ -1138,30 +1128,30 @@ submit_equirect2_layer(struct oxr_session *sess,
 
 	struct xrt_pose pose;
 	if (!handle_space(log, sess, spc, pose_ptr, inv_offset, timestamp, &pose)) {
-		return XR_SUCCESS;
+		return false;
 	}
 
 	if (spc->is_reference && spc->type == XR_REFERENCE_SPACE_TYPE_VIEW) {
 		flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
 	}
 
-	struct xrt_layer_data data;
-	U_ZERO(&data);
-	data.type = XRT_LAYER_EQUIRECT2;
-	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
-	data.timestamp = timestamp;
-	data.flags = flags;
-	data.equirect2.visibility = convert_eye_visibility(equirect->eyeVisibility);
-	data.equirect2.pose = pose;
-	data.equirect2.radius = equirect->radius;
-	data.equirect2.central_horizontal_angle = equirect->centralHorizontalAngle;
-	data.equirect2.upper_vertical_angle = equirect->upperVerticalAngle;
-	data.equirect2.lower_vertical_angle = equirect->lowerVerticalAngle;
-	fill_in_sub_image(sc, &equirect->subImage, &data.equirect2.sub);
+	struct xrt_layer_data *data = &entry->data;
+	U_ZERO(data);
+	data->type = XRT_LAYER_EQUIRECT2;
+	data->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	data->timestamp = timestamp;
+	data->flags = flags;
+	data->equirect2.visibility = convert_eye_visibility(equirect->eyeVisibility);
+	data->equirect2.pose = pose;
+	data->equirect2.radius = equirect->radius;
+	data->equirect2.central_horizontal_angle = equirect->centralHorizontalAngle;
+	data->equirect2.upper_vertical_angle = equirect->upperVerticalAngle;
+	data->equirect2.lower_vertical_angle = equirect->lowerVerticalAngle;
+	fill_in_sub_image(sc, &equirect->subImage, &data->equirect2.sub);
 
-	CALL_CHK(xrt_comp_layer_equirect2(xc, head, sc->swapchain, &data));
+	entry->xscs[0] = sc->swapchain;
 
-	return XR_SUCCESS;
+	return true;
 }
 
 XrResult
@@ -1186,6 +1176,9 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 		                 frameEndInfo->displayTime);
 	}
 
+	// Used to measure the CPU time spent in this function.
+	uint64_t start_ns = os_monotonic_get_ns();
+
 	int64_t display_time_ns =
 	    time_state_ts_to_monotonic_ns(sess->sys->inst->timekeeping, frameEndInfo->displayTime);
 	if (sess->frame_timing_spew) {
@@ -1261,6 +1254,11 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 		return oxr_error(log, XR_ERROR_LAYER_INVALID, "(frameEndInfo->layers == NULL)");
 	}
 
+	if (frameEndInfo->layerCount > OXR_MAX_LAYERS) {
+		return oxr_error(log, XR_ERROR_LAYER_LIMIT_EXCEEDED, "(frameEndInfo->layerCount == %u) max is %u",
+		                 frameEndInfo->layerCount, OXR_MAX_LAYERS);
+	}
+
 	for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
 		const XrCompositionLayerBaseHeader *layer = frameEndInfo->layers[i];
 		if (layer == NULL) {
@@ -1317,43 +1315,61 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 	struct xrt_pose inv_offset = {0};
 	math_pose_invert(&xdev->tracking_origin->offset, &inv_offset);
 
-	CALL_CHK(xrt_comp_layer_begin(xc, sess->frame_id.begun, display_time_ns, blend_mode));
+	/*
+	 * Convert all layers into the per session scratch array first, layers
+	 * with inactive spaces are dropped here.
+	 */
+	struct xrt_layer_entry *entries = sess->layer_scratch;
+	uint32_t num_entries = 0;
 
 	for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
 		const XrCompositionLayerBaseHeader *layer = frameEndInfo->layers[i];
 		assert(layer != NULL);
 
-		int64_t timestamp =
-		    time_state_ts_to_monotonic_ns(sess->sys->inst->timekeeping, frameEndInfo->displayTime);
+		struct xrt_layer_entry *e = &entries[num_entries];
+		bool has_layer = false;
+
+		// The entry is reused, only the swapchains the layer uses get set.
+		memset(e->xscs, 0, sizeof(e->xscs));
 
 		switch (layer->type) {
 		case XR_TYPE_COMPOSITION_LAYER_PROJECTION:
-			submit_projection_layer(sess, xc, log, (XrCompositionLayerProjection *)layer, xdev, &inv_offset,
-			                        timestamp);
+			has_layer = convert_projection_layer(sess, log, (XrCompositionLayerProjection *)layer,
+			                                     &inv_offset, display_time_ns, e);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_QUAD:
-			submit_quad_layer(sess, xc, log, (XrCompositionLayerQuad *)layer, xdev, &inv_offset, timestamp);
+			has_layer = convert_quad_layer(sess, log, (XrCompositionLayerQuad *)layer, &inv_offset,
+			                               display_time_ns, e);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR:
-			submit_cube_layer(sess, xc, log, (XrCompositionLayerCubeKHR *)layer, xdev, &inv_offset,
-			                  timestamp);
+			has_layer = convert_cube_layer(sess, log, (XrCompositionLayerCubeKHR *)layer, &inv_offset,
+			                               display_time_ns, e);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
-			submit_cylinder_layer(sess, xc, log, (XrCompositionLayerCylinderKHR *)layer, xdev, &inv_offset,
-			                      timestamp);
+			has_layer = convert_cylinder_layer(sess, log, (XrCompositionLayerCylinderKHR *)layer,
+			                                   &inv_offset, display_time_ns, e);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
-			submit_equirect1_layer(sess, xc, log, (XrCompositionLayerEquirectKHR *)layer, xdev, &inv_offset,
-			                       timestamp);
+			has_layer = convert_equirect1_layer(sess, log, (XrCompositionLayerEquirectKHR *)layer,
+			                                    &inv_offset, display_time_ns, e);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
-			submit_equirect2_layer(sess, xc, log, (XrCompositionLayerEquirect2KHR *)layer, xdev,
-			                       &inv_offset, timestamp);
+			has_layer = convert_equirect2_layer(sess, log, (XrCompositionLayerEquirect2KHR *)layer,
+			                                    &inv_offset, display_time_ns, e);
 			break;
 		default: assert(false && "invalid layer type");
 		}
+
+		if (has_layer) {
+			num_entries++;
+		}
 	}
 
+	// Then hand them all over to the compositor.
+	CALL_CHK(xrt_comp_layer_begin(xc, sess->frame_id.begun, display_time_ns, blend_mode));
+
+	CALL_CHK(xrt_comp_layers(xc, xdev, entries, num_entries));
+
 	CALL_CHK(xrt_comp_layer_commit(xc, sess->frame_id.begun, XRT_GRAPHICS_SYNC_HANDLE_INVALID));
 	sess->frame_id.begun = -1;
 
@@ -1363,5 +1379,10 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 	sess->active_wait_frames--;
 	os_mutex_unlock(&sess->active_wait_frames_lock);
 
+	if (sess->frame_timing_spew) {
+		uint64_t now_ns = os_monotonic_get_ns();
+		oxr_log(log, "Submitted %u layers in %8.3fms", num_entries, ns_to_ms(now_ns - start_ns));
+	}
+
 	return oxr_session_success_result(sess);
 }
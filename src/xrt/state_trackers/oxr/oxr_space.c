@@ -48,7 +48,7 @@ static XrResult
 oxr_space_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_space *spc = (struct oxr_space *)hb;
-	free(spc);
+	oxr_handle_free(&spc->handle);
 	return XR_SUCCESS;
 }
 
@@ -63,7 +63,8 @@ oxr_space_action_create(struct oxr_logger *log,
 	struct oxr_subaction_paths subaction_paths = {0};
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle,
+	                                        &sess->pools.spaces);
 
 	oxr_classify_sub_action_paths(log, inst, 1, &createInfo->subactionPath, &subaction_paths);
 
@@ -96,7 +97,8 @@ oxr_space_reference_create(struct oxr_logger *log,
 	}
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle,
+	                                        &sess->pools.spaces);
 	spc->sess = sess;
 	spc->is_reference = true;
 	spc->type = createInfo->referenceSpaceType;
@@ -310,7 +312,7 @@ oxr_space_action_relation(struct oxr_logger *log,
 		return XR_SUCCESS;
 	}
 
-	oxr_xdev_get_space_relation(log, sess->sys->inst, input->xdev, input->input->name, at_time, out_relation);
+	oxr_session_get_xdev_relation_at(log, sess, input->xdev, input->input->name, at_time, out_relation);
 
 	if (baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL) {
 		global_to_local_space(sess, out_relation);
@@ -485,3 +487,86 @@ oxr_space_locate(
 
 	return oxr_session_success_result(spc->sess);
 }
+
+XrResult
+oxr_space_locate_many(struct oxr_logger *log,
+                      struct oxr_space *baseSpc,
+                      XrTime time,
+                      uint32_t num_spaces,
+                      struct oxr_space **spaces,
+                      struct xrt_space_relation *out_relations)
+{
+	if (baseSpc->sess->sys->inst->debug_spaces) {
+		U_LOG_D("%s %u", __func__, num_spaces);
+	}
+	print_space("baseSpace", baseSpc);
+
+	struct oxr_session *sess = baseSpc->sess;
+
+	/*
+	 * The base space end of the chain is shared, resolve it once. Action
+	 * spaces relative to a reference space only need their device relation
+	 * on top of it, the rest goes through get_pure_space_relation.
+	 */
+	bool fast_action = baseSpc->is_reference && baseSpc->type != XR_REFERENCE_SPACE_TYPE_VIEW;
+
+	struct xrt_space_graph base_chain = {0};
+	if (fast_action && baseSpc->type == XR_REFERENCE_SPACE_TYPE_LOCAL && initial_head_relation_valid(sess)) {
+		m_space_graph_add_inverted_pose_if_not_identity(&base_chain, &sess->initial_head_relation.pose);
+	}
+	struct xrt_space_relation base_chain_relation;
+	m_space_graph_resolve(&base_chain, &base_chain_relation);
+
+	bool has_base_pose = !m_pose_is_identity(&baseSpc->pose);
+	struct xrt_space_relation base_inverted;
+	if (has_base_pose) {
+		struct xrt_pose invert;
+		math_pose_invert(&baseSpc->pose, &invert);
+		m_space_relation_from_pose(&invert, &base_inverted);
+	}
+
+	for (uint32_t i = 0; i < num_spaces; i++) {
+		struct oxr_space *spc = spaces[i];
+		struct xrt_space_graph graph = {0};
+		m_space_graph_add_pose_if_not_identity(&graph, &spc->pose);
+
+		if (fast_action && !spc->is_reference) {
+			struct oxr_action_input *input = NULL;
+			oxr_action_get_pose_input(log, sess, spc->act_key, &spc->subaction_paths, &input);
+
+			struct xrt_space_relation relation;
+			m_space_relation_ident(&relation);
+
+			if (input == NULL) {
+				// If the input isn't active.
+				relation.relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
+			} else {
+				// Spaces on the same input share the query through the session relation cache.
+				struct xrt_device *xdev = input->xdev;
+				oxr_session_get_xdev_relation_at(log, sess, xdev, input->input->name, time, &relation);
+			}
+
+			m_space_graph_add_relation(&graph, &relation);
+			if (base_chain.num_steps > 0) {
+				m_space_graph_add_relation(&graph, &base_chain_relation);
+			}
+		} else {
+			struct xrt_space_relation pure;
+			XrResult ret = get_pure_space_relation(log, spc, baseSpc, time, &pure);
+			if (ret != XR_SUCCESS) {
+				return ret;
+			}
+
+			m_space_graph_add_relation(&graph, &pure);
+		}
+
+		if (has_base_pose) {
+			m_space_graph_add_relation(&graph, &base_inverted);
+		}
+		m_space_graph_resolve(&graph, &out_relations[i]);
+
+		print_pose(sess, "\trelation->pose", &out_relations[i].pose);
+	}
+
+	return oxr_session_success_result(baseSpc->sess);
+}
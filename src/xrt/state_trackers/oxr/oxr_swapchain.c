@@ -134,7 +134,7 @@ oxr_swapchain_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	struct oxr_swapchain *sc = (struct oxr_swapchain *)hb;
 
 	XrResult ret = sc->destroy(log, sc);
-	free(sc);
+	oxr_handle_free(&sc->handle);
 	return ret;
 }
 
@@ -222,7 +222,8 @@ oxr_create_swapchain(struct oxr_logger *log,
 	assert(xsc != NULL);
 
 	struct oxr_swapchain *sc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, sc, OXR_XR_DEBUG_SWAPCHAIN, oxr_swapchain_destroy, &sess->handle);
+	OXR_ALLOCATE_HANDLE_FROM_POOL_OR_RETURN(log, sc, OXR_XR_DEBUG_SWAPCHAIN, oxr_swapchain_destroy, &sess->handle,
+	                                        &sess->pools.swapchains);
 	sc->sess = sess;
 	sc->swapchain = xsc;
 	sc->width = createInfo->width;
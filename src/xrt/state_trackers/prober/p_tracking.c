@@ -20,6 +20,7 @@
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
+#include "util/u_debug.h"
 #include "util/u_config_json.h"
 #include "p_prober.h"
 
@@ -27,10 +28,13 @@
 #include <string.h>
 
 #ifdef XRT_BUILD_DRIVER_EUROC
-#include "util/u_debug.h"
 DEBUG_GET_ONCE_OPTION(euroc_path, "EUROC_PATH", NULL)
 #endif
 
+#ifdef XRT_HAVE_OPENCV
+DEBUG_GET_ONCE_OPTION(record_path, "P_TRACKING_RECORD_PATH", NULL)
+#endif
+
 /*
  *
  * Structs and defines.
@@ -82,6 +86,9 @@ struct p_factory
 
 	//! Pre-created psvr trackers.
 	struct xrt_tracked_psvr *xtvr;
+
+	//! Records frames and IMU samples if @p P_TRACKING_RECORD_PATH is set.
+	struct t_dataset_recorder *rec;
 #endif
 
 	// Frameserver.
@@ -89,6 +96,35 @@ struct p_factory
 };
 
 
+#ifdef XRT_HAVE_OPENCV
+/*!
+ * Records the IMU samples pushed to a psmv tracker, forwards everything.
+ *
+ * @implements xrt_tracked_psmv
+ */
+struct p_recorded_psmv
+{
+	struct xrt_tracked_psmv base;
+	struct xrt_tracked_psmv *tracked;
+	struct t_dataset_recorder *rec;
+	uint32_t source;
+};
+
+/*!
+ * Records the IMU samples pushed to a psvr tracker, forwards everything.
+ *
+ * @implements xrt_tracked_psvr
+ */
+struct p_recorded_psvr
+{
+	struct xrt_tracked_psvr base;
+	struct xrt_tracked_psvr *tracked;
+	struct t_dataset_recorder *rec;
+	uint32_t source;
+};
+#endif
+
+
 /*
  *
  * Functions.
@@ -101,6 +137,90 @@ p_factory(struct xrt_tracking_factory *xfact)
 	return (struct p_factory *)xfact;
 }
 
+#ifdef XRT_HAVE_OPENCV
+static void
+p_recorded_psmv_push_imu(struct xrt_tracked_psmv *xtmv, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+	t_dataset_recorder_push_imu(r->rec, r->source, timestamp_ns, sample);
+	xrt_tracked_psmv_push_imu(r->tracked, timestamp_ns, sample);
+}
+
+static void
+p_recorded_psmv_get_tracked_pose(struct xrt_tracked_psmv *xtmv,
+                                 enum xrt_input_name name,
+                                 timepoint_ns when_ns,
+                                 struct xrt_space_relation *out_relation)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+	xrt_tracked_psmv_get_tracked_pose(r->tracked, name, when_ns, out_relation);
+}
+
+static void
+p_recorded_psmv_destroy(struct xrt_tracked_psmv *xtmv)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+	xrt_tracked_psmv_destroy(&r->tracked);
+	free(r);
+}
+
+static struct xrt_tracked_psmv *
+p_recorded_psmv_create(struct t_dataset_recorder *rec, uint32_t source, struct xrt_tracked_psmv *tracked)
+{
+	struct p_recorded_psmv *r = U_TYPED_CALLOC(struct p_recorded_psmv);
+	r->base.origin = tracked->origin;
+	r->base.colour = tracked->colour;
+	r->base.push_imu = p_recorded_psmv_push_imu;
+	r->base.get_tracked_pose = p_recorded_psmv_get_tracked_pose;
+	r->base.destroy = p_recorded_psmv_destroy;
+	r->tracked = tracked;
+	r->rec = rec;
+	r->source = source;
+
+	return &r->base;
+}
+
+static void
+p_recorded_psvr_push_imu(struct xrt_tracked_psvr *xtvr, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+	t_dataset_recorder_push_imu(r->rec, r->source, timestamp_ns, sample);
+	xrt_tracked_psvr_push_imu(r->tracked, timestamp_ns, sample);
+}
+
+static void
+p_recorded_psvr_get_tracked_pose(struct xrt_tracked_psvr *xtvr,
+                                 timepoint_ns when_ns,
+                                 struct xrt_space_relation *out_relation)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+	xrt_tracked_psvr_get_tracked_pose(r->tracked, when_ns, out_relation);
+}
+
+static void
+p_recorded_psvr_destroy(struct xrt_tracked_psvr *xtvr)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+	xrt_tracked_psvr_destroy(&r->tracked);
+	free(r);
+}
+
+static struct xrt_tracked_psvr *
+p_recorded_psvr_create(struct t_dataset_recorder *rec, uint32_t source, struct xrt_tracked_psvr *tracked)
+{
+	struct p_recorded_psvr *r = U_TYPED_CALLOC(struct p_recorded_psvr);
+	r->base.origin = tracked->origin;
+	r->base.push_imu = p_recorded_psvr_push_imu;
+	r->base.get_tracked_pose = p_recorded_psvr_get_tracked_pose;
+	r->base.destroy = p_recorded_psvr_destroy;
+	r->tracked = tracked;
+	r->rec = rec;
+	r->source = source;
+
+	return &r->base;
+}
+#endif
+
 #ifdef XRT_HAVE_OPENCV
 static void
 on_video_device(struct xrt_prober *xp,
@@ -166,16 +286,20 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 	fclose(file);
 
 	struct xrt_frame_sink *xsink = NULL;
-	struct xrt_frame_sink *xsinks[4] = {0};
+	struct xrt_frame_sink *xsinks[T_BLOB_MAX_CHANNELS] = {0};
+	struct t_blob_sink *blob_sinks[T_BLOB_MAX_CHANNELS] = {0};
 	struct xrt_colour_rgb_f32 rgb[2] = {{1.f, 0.f, 0.f}, {1.f, 0.f, 1.f}};
 
 	// We create the two psmv trackers up front, but don't start them.
 	// clang-format off
-	t_psmv_create(&fact->xfctx, &rgb[0], fact->data, &fact->xtmv[0], &xsinks[0]);
-	t_psmv_create(&fact->xfctx, &rgb[1], fact->data, &fact->xtmv[1], &xsinks[1]);
-	t_psvr_create(&fact->xfctx, fact->data, &fact->xtvr, &xsinks[2]);
+	t_psmv_create(&fact->xfctx, &rgb[0], fact->data, &fact->xtmv[0], &blob_sinks[0]);
+	t_psmv_create(&fact->xfctx, &rgb[1], fact->data, &fact->xtmv[1], &blob_sinks[1]);
+	t_psvr_create(&fact->xfctx, fact->data, &fact->xtvr, &blob_sinks[2]);
 	// clang-format on
 
+	// Rectification and blob detection for all trackers.
+	t_blob_preprocessor_create(&fact->xfctx, fact->data, blob_sinks, xsinks);
+
 	// Setup origin to the common one.
 	fact->xtvr->origin = &fact->origin;
 	fact->xtmv[0]->origin = &fact->origin;
@@ -223,6 +347,17 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 		break;
 	}
 
+	// Record the frames as the trackers see them, IMU samples are recorded
+	// when the trackers are handed out.
+	const char *record_path = debug_get_option_record_path();
+	if (record_path != NULL) {
+		struct xrt_frame_sink *rec_sink = NULL;
+		t_dataset_recorder_create(&fact->xfctx, record_path, fact->data, &fact->rec, &rec_sink);
+		if (rec_sink != NULL) {
+			u_sink_split_create(&fact->xfctx, xsink, rec_sink, &xsink);
+		}
+	}
+
 	u_sink_quirk_create(&fact->xfctx, xsink, &qp, &xsink);
 
 	// Start the stream now.
@@ -257,9 +392,14 @@ p_factory_create_tracked_psmv(struct xrt_tracking_factory *xfact,
 		return -1;
 	}
 
-	fact->num_xtmv++;
+	uint32_t source = (uint32_t)fact->num_xtmv++;
 
 	t_psmv_start(xtmv);
+
+	if (fact->rec != NULL) {
+		xtmv = p_recorded_psmv_create(fact->rec, source, xtmv);
+	}
+
 	*out_xtmv = xtmv;
 
 	return 0;
@@ -290,6 +430,12 @@ p_factory_create_tracked_psvr(struct xrt_tracking_factory *xfact,
 
 	fact->started_xtvr = true;
 	t_psvr_start(xtvr);
+
+	if (fact->rec != NULL) {
+		// After the two psmv trackers, same as the hsv channels.
+		xtvr = p_recorded_psvr_create(fact->rec, 2, xtvr);
+	}
+
 	*out_xtvr = xtvr;
 
 	return 0;
@@ -385,6 +531,7 @@ p_tracking_teardown(struct prober *p)
 	fact->xtmv[0] = NULL;
 	fact->xtmv[1] = NULL;
 	fact->xtvr = NULL;
+	fact->rec = NULL;
 #endif
 
 	// Take down the node graph.
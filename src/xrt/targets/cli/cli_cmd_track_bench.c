@@ -0,0 +1,738 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Replays a recorded tracking dataset through a tracker and reports
+ *         timings and pose error.
+ */
+
+#include "xrt/xrt_config_have.h"
+
+#include "cli_common.h"
+
+#ifdef XRT_HAVE_OPENCV
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_tracking.h"
+
+#include "tracking/t_tracking.h"
+
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_time.h"
+#include "util/u_hand_tracking.h"
+
+#include "os/os_time.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#endif
+
+#include <string.h>
+#include <stdio.h>
+
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+#ifdef XRT_HAVE_OPENCV
+
+//! How long to wait for the tracker to finish a single frame.
+#define BENCH_TRACKER_TIMEOUT_NS (5ULL * U_TIME_1S_IN_NS)
+
+//! Hand tracking gives two poses per frame.
+#define BENCH_MAX_POSES 2
+
+enum bench_tracker
+{
+	BENCH_TRACKER_PSMV,
+	BENCH_TRACKER_PSVR,
+	BENCH_TRACKER_HAND,
+};
+
+/*!
+ * Samples in nanoseconds for one stage of the pipeline.
+ */
+struct bench_stage
+{
+	const char *name;
+	uint64_t *samples;
+	size_t num;
+	size_t alloc;
+};
+
+/*!
+ * Times the part of the pipeline after it, which runs on the pushing thread.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct bench_timing_sink
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink *downstream;
+
+	uint64_t last_ns;
+};
+
+/*!
+ * Placed right in front of the tracker, keeps a reference to the frame given
+ * to it so we can tell when the tracker thread is done with it.
+ *
+ * @implements xrt_frame_sink
+ * @implements t_blob_sink
+ * @implements xrt_frame_node
+ */
+struct bench_tap
+{
+	struct xrt_frame_sink base;
+	struct t_blob_sink blob_base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink *frame_downstream;
+	struct t_blob_sink *blob_downstream;
+
+	struct xrt_frame *frame;
+	uint64_t pushed_ns;
+};
+
+/*!
+ * A single pose written to or read from a pose file.
+ */
+struct bench_pose
+{
+	int64_t timestamp;
+	uint32_t index;
+	struct xrt_space_relation rel;
+};
+
+struct bench_poses
+{
+	struct bench_pose *poses;
+	size_t num;
+	size_t alloc;
+};
+
+struct bench
+{
+	enum bench_tracker tracker;
+
+	struct xrt_frame_context xfctx;
+
+	//! Entry of the pipeline.
+	struct xrt_frame_sink *sink;
+
+	struct bench_timing_sink *pipeline_timing;
+	struct bench_timing_sink *preprocessor_timing;
+	struct bench_tap *tap;
+
+	struct xrt_tracked_psmv *xtmv;
+	struct xrt_tracked_psvr *xtvr;
+	struct xrt_tracked_hand *xth;
+
+	struct bench_stage pipeline;
+	struct bench_stage preprocessor;
+	struct bench_stage tracker_stage;
+	struct bench_stage total;
+
+	struct bench_poses poses;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+stage_add(struct bench_stage *stage, uint64_t ns)
+{
+	if (stage->num >= stage->alloc) {
+		stage->alloc = stage->alloc < 256 ? 256 : stage->alloc * 2;
+		U_ARRAY_REALLOC_OR_FREE(stage->samples, uint64_t, stage->alloc);
+	}
+
+	stage->samples[stage->num++] = ns;
+}
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t l = *(const uint64_t *)a;
+	uint64_t r = *(const uint64_t *)b;
+	return l < r ? -1 : l > r ? 1 : 0;
+}
+
+static double
+stage_percentile_ms(struct bench_stage *stage, double p)
+{
+	size_t i = (size_t)(p * (double)(stage->num - 1) + 0.5);
+	return (double)stage->samples[i] / (double)U_TIME_1MS_IN_NS;
+}
+
+static void
+stage_print(struct bench_stage *stage)
+{
+	if (stage->num == 0) {
+		return;
+	}
+
+	qsort(stage->samples, stage->num, sizeof(uint64_t), compare_u64);
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < stage->num; i++) {
+		sum += stage->samples[i];
+	}
+	double mean = (double)sum / (double)stage->num / (double)U_TIME_1MS_IN_NS;
+
+	P("\t%-18s mean %7.3fms p50 %7.3fms p95 %7.3fms p99 %7.3fms max %7.3fms\n", stage->name, mean,
+	  stage_percentile_ms(stage, 0.50), stage_percentile_ms(stage, 0.95), stage_percentile_ms(stage, 0.99),
+	  stage_percentile_ms(stage, 1.0));
+}
+
+static void
+poses_add(struct bench_poses *poses, const struct bench_pose *pose)
+{
+	if (poses->num >= poses->alloc) {
+		poses->alloc = poses->alloc < 256 ? 256 : poses->alloc * 2;
+		U_ARRAY_REALLOC_OR_FREE(poses->poses, struct bench_pose, poses->alloc);
+	}
+
+	poses->poses[poses->num++] = *pose;
+}
+
+static bool
+pose_is_tracked(const struct bench_pose *pose)
+{
+	return (pose->rel.relation_flags & XRT_SPACE_RELATION_POSITION_TRACKED_BIT) != 0;
+}
+
+
+/*
+ *
+ * Sinks.
+ *
+ */
+
+static void
+timing_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+{
+	struct bench_timing_sink *ts = container_of(xsink, struct bench_timing_sink, base);
+
+	uint64_t start = os_monotonic_get_ns();
+	xrt_sink_push_frame(ts->downstream, xf);
+	ts->last_ns = os_monotonic_get_ns() - start;
+}
+
+static void
+node_break_apart(struct xrt_frame_node *node)
+{
+	// Noop
+}
+
+static void
+timing_destroy(struct xrt_frame_node *node)
+{
+	free(container_of(node, struct bench_timing_sink, node));
+}
+
+static struct bench_timing_sink *
+timing_create(struct xrt_frame_context *xfctx, struct xrt_frame_sink *downstream)
+{
+	struct bench_timing_sink *ts = U_TYPED_CALLOC(struct bench_timing_sink);
+	ts->base.push_frame = timing_push_frame;
+	ts->node.break_apart = node_break_apart;
+	ts->node.destroy = timing_destroy;
+	ts->downstream = downstream;
+
+	xrt_frame_context_add(xfctx, &ts->node);
+
+	return ts;
+}
+
+static void
+tap_push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
+{
+	struct bench_tap *tap = container_of(xsink, struct bench_tap, base);
+
+	xrt_frame_reference(&tap->frame, xf);
+	tap->pushed_ns = os_monotonic_get_ns();
+	xrt_sink_push_frame(tap->frame_downstream, xf);
+}
+
+static bool
+tap_get_rois(struct t_blob_sink *sink, struct xrt_rect out_rois[2])
+{
+	struct bench_tap *tap = container_of(sink, struct bench_tap, blob_base);
+
+	if (tap->blob_downstream->get_rois == NULL) {
+		return false;
+	}
+
+	return tap->blob_downstream->get_rois(tap->blob_downstream, out_rois);
+}
+
+static void
+tap_push_blobs(struct t_blob_sink *sink, struct t_blob_observation *obs)
+{
+	struct bench_tap *tap = container_of(sink, struct bench_tap, blob_base);
+
+	xrt_frame_reference(&tap->frame, obs->frame);
+	tap->pushed_ns = os_monotonic_get_ns();
+	tap->blob_downstream->push_blobs(tap->blob_downstream, obs);
+}
+
+static void
+tap_destroy(struct xrt_frame_node *node)
+{
+	struct bench_tap *tap = container_of(node, struct bench_tap, node);
+
+	xrt_frame_reference(&tap->frame, NULL);
+	free(tap);
+}
+
+static struct bench_tap *
+tap_create(struct xrt_frame_context *xfctx,
+           struct xrt_frame_sink *frame_downstream,
+           struct t_blob_sink *blob_downstream)
+{
+	struct bench_tap *tap = U_TYPED_CALLOC(struct bench_tap);
+	tap->base.push_frame = tap_push_frame;
+	tap->node.break_apart = node_break_apart;
+	tap->node.destroy = tap_destroy;
+	tap->frame_downstream = frame_downstream;
+	tap->blob_downstream = blob_downstream;
+
+	if (blob_downstream != NULL) {
+		tap->blob_base = *blob_downstream;
+		tap->blob_base.get_rois = tap_get_rois;
+		tap->blob_base.push_blobs = tap_push_blobs;
+	}
+
+	xrt_frame_context_add(xfctx, &tap->node);
+
+	return tap;
+}
+
+/*!
+ * Wait for the tracker thread to drop its reference, returns the time it
+ * took from the push in nanoseconds or zero if nothing was pushed.
+ */
+static uint64_t
+tap_wait(struct bench_tap *tap)
+{
+	if (tap->frame == NULL) {
+		return 0;
+	}
+
+	uint64_t start = os_monotonic_get_ns();
+	while (tap->frame->reference.count > 1) {
+		if (os_monotonic_get_ns() - start > BENCH_TRACKER_TIMEOUT_NS) {
+			P("Timed out waiting for the tracker!\n");
+			break;
+		}
+		os_nanosleep(20 * 1000);
+	}
+
+	uint64_t ns = os_monotonic_get_ns() - tap->pushed_ns;
+	xrt_frame_reference(&tap->frame, NULL);
+
+	return ns;
+}
+
+
+/*
+ *
+ * Setup and replay.
+ *
+ */
+
+/*!
+ * Build the pipeline for the selected tracker and start it, on failure the
+ * nodes already created are left in the frame context for the caller.
+ */
+static int
+bench_setup(struct bench *b, struct t_stereo_camera_calibration *calib)
+{
+	struct xrt_frame_sink *xsink = NULL;
+	int ret;
+
+	if (b->tracker == BENCH_TRACKER_HAND) {
+		struct xrt_frame_sink *ht_sink = NULL;
+		ret = t_hand_create(&b->xfctx, calib, &b->xth, &ht_sink);
+		if (ret != 0) {
+			P("Failed to create the hand tracker!\n");
+			return ret;
+		}
+
+		b->tap = tap_create(&b->xfctx, ht_sink, NULL);
+		u_sink_create_to_r8g8b8_or_l8(&b->xfctx, &b->tap->base, &xsink);
+
+		b->pipeline_timing = timing_create(&b->xfctx, xsink);
+		b->sink = &b->pipeline_timing->base;
+
+		return t_hand_start(b->xth);
+	}
+
+	struct xrt_frame_sink *xsinks[T_BLOB_MAX_CHANNELS] = {0};
+	struct t_blob_sink *blob_sinks[T_BLOB_MAX_CHANNELS] = {0};
+	struct t_blob_sink *blob_sink = NULL;
+	int channel = 0;
+
+	if (b->tracker == BENCH_TRACKER_PSMV) {
+		// Same colour and channel as the first controller in the prober.
+		struct xrt_colour_rgb_f32 rgb = {1.f, 0.f, 0.f};
+		ret = t_psmv_create(&b->xfctx, &rgb, calib, &b->xtmv, &blob_sink);
+		channel = 0;
+	} else {
+		ret = t_psvr_create(&b->xfctx, calib, &b->xtvr, &blob_sink);
+		channel = 2;
+	}
+	if (ret != 0) {
+		P("Failed to create the tracker!\n");
+		return ret;
+	}
+
+	b->tap = tap_create(&b->xfctx, NULL, blob_sink);
+	blob_sinks[channel] = &b->tap->blob_base;
+
+	ret = t_blob_preprocessor_create(&b->xfctx, calib, blob_sinks, xsinks);
+	if (ret != 0) {
+		P("Failed to create the blob preprocessor!\n");
+		return ret;
+	}
+
+	b->preprocessor_timing = timing_create(&b->xfctx, xsinks[channel]);
+	xsinks[channel] = &b->preprocessor_timing->base;
+
+	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+	t_hsv_filter_create(&b->xfctx, &params, xsinks, &xsink);
+	u_sink_create_to_yuv_or_yuyv(&b->xfctx, xsink, &xsink);
+
+	b->pipeline_timing = timing_create(&b->xfctx, xsink);
+	b->sink = &b->pipeline_timing->base;
+
+	if (b->xtmv != NULL) {
+		return t_psmv_start(b->xtmv);
+	}
+
+	return t_psvr_start(b->xtvr);
+}
+
+static void
+bench_sample_poses(struct bench *b, int64_t timestamp)
+{
+	struct bench_pose pose = {.timestamp = timestamp};
+
+	switch (b->tracker) {
+	case BENCH_TRACKER_PSMV:
+		xrt_tracked_psmv_get_tracked_pose(b->xtmv, XRT_INPUT_PSMV_BALL_CENTER_POSE, timestamp, &pose.rel);
+		poses_add(&b->poses, &pose);
+		break;
+	case BENCH_TRACKER_PSVR:
+		xrt_tracked_psvr_get_tracked_pose(b->xtvr, timestamp, &pose.rel);
+		poses_add(&b->poses, &pose);
+		break;
+	case BENCH_TRACKER_HAND: {
+		enum xrt_input_name names[BENCH_MAX_POSES] = {
+		    XRT_INPUT_GENERIC_HAND_TRACKING_LEFT,
+		    XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT,
+		};
+		for (uint32_t i = 0; i < BENCH_MAX_POSES; i++) {
+			struct u_hand_joint_default_set joints;
+			pose.index = i;
+			xrt_tracked_hand_get_joints(b->xth, names[i], timestamp, &joints, &pose.rel);
+			poses_add(&b->poses, &pose);
+		}
+	} break;
+	}
+}
+
+static void
+bench_push_frame(struct bench *b, struct xrt_frame *xf)
+{
+	// Tracker may change what it wants between frames.
+	if (b->tap->blob_downstream != NULL) {
+		int32_t want = xrt_atomic_s32_load(&b->tap->blob_downstream->want_rectified_frame);
+		xrt_atomic_s32_store(&b->tap->blob_base.want_rectified_frame, want);
+	}
+
+	xrt_sink_push_frame(b->sink, xf);
+
+	uint64_t pipeline_ns = b->pipeline_timing->last_ns;
+	uint64_t tracker_ns = tap_wait(b->tap);
+
+	if (b->preprocessor_timing != NULL) {
+		uint64_t preprocessor_ns = b->preprocessor_timing->last_ns;
+		stage_add(&b->preprocessor, preprocessor_ns);
+		stage_add(&b->pipeline, pipeline_ns - preprocessor_ns);
+	} else {
+		stage_add(&b->pipeline, pipeline_ns);
+	}
+
+	stage_add(&b->tracker_stage, tracker_ns);
+	stage_add(&b->total, pipeline_ns + tracker_ns);
+
+	bench_sample_poses(b, (int64_t)xf->timestamp);
+}
+
+static void
+bench_push_imu(struct bench *b, struct t_dataset_record *rec)
+{
+	// Sources are numbered as in the prober, psmv first then psvr.
+	if (b->xtmv != NULL && rec->source == 0) {
+		xrt_tracked_psmv_push_imu(b->xtmv, rec->timestamp, &rec->imu);
+	} else if (b->xtvr != NULL && rec->source == 2) {
+		xrt_tracked_psvr_push_imu(b->xtvr, rec->timestamp, &rec->imu);
+	}
+}
+
+
+/*
+ *
+ * Pose files.
+ *
+ */
+
+static bool
+write_poses(const char *path, struct bench_poses *poses)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		P("Could not open '%s' for writing!\n", path);
+		return false;
+	}
+
+	fprintf(file, "# timestamp_ns,index,flags,px,py,pz,qx,qy,qz,qw\n");
+	for (size_t i = 0; i < poses->num; i++) {
+		const struct bench_pose *p = &poses->poses[i];
+		const struct xrt_pose *pose = &p->rel.pose;
+		fprintf(file, "%" PRId64 ",%u,%u,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", p->timestamp, p->index,
+		        (uint32_t)p->rel.relation_flags, pose->position.x, pose->position.y, pose->position.z,
+		        pose->orientation.x, pose->orientation.y, pose->orientation.z, pose->orientation.w);
+	}
+
+	fclose(file);
+	return true;
+}
+
+static bool
+read_poses(const char *path, struct bench_poses *poses)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		P("Could not open '%s'!\n", path);
+		return false;
+	}
+
+	char line[512];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (line[0] == '#') {
+			continue;
+		}
+
+		struct bench_pose p = {0};
+		struct xrt_pose *pose = &p.rel.pose;
+		uint32_t flags = 0;
+		int n = sscanf(line, "%" SCNd64 ",%u,%u,%f,%f,%f,%f,%f,%f,%f", &p.timestamp, &p.index, &flags,
+		               &pose->position.x, &pose->position.y, &pose->position.z, &pose->orientation.x,
+		               &pose->orientation.y, &pose->orientation.z, &pose->orientation.w);
+		if (n != 10) {
+			P("Malformed line in '%s': %s", path, line);
+			fclose(file);
+			return false;
+		}
+		p.rel.relation_flags = (enum xrt_space_relation_flags)flags;
+
+		poses_add(poses, &p);
+	}
+
+	fclose(file);
+	return true;
+}
+
+static void
+compare_poses(struct bench_poses *run, struct bench_poses *ref)
+{
+	size_t num = run->num < ref->num ? run->num : ref->num;
+	size_t compared = 0;
+	size_t tracking_differs = 0;
+	double sum_error = 0.0;
+	double max_error = 0.0;
+
+	for (size_t i = 0; i < num; i++) {
+		const struct bench_pose *a = &run->poses[i];
+		const struct bench_pose *b = &ref->poses[i];
+
+		if (a->timestamp != b->timestamp || a->index != b->index) {
+			P("Pose %zu does not match the reference, different datasets?\n", i);
+			return;
+		}
+
+		if (pose_is_tracked(a) != pose_is_tracked(b)) {
+			tracking_differs++;
+			continue;
+		}
+
+		if (!pose_is_tracked(a)) {
+			continue;
+		}
+
+		double dx = a->rel.pose.position.x - b->rel.pose.position.x;
+		double dy = a->rel.pose.position.y - b->rel.pose.position.y;
+		double dz = a->rel.pose.position.z - b->rel.pose.position.z;
+		double error = sqrt(dx * dx + dy * dy + dz * dz);
+
+		sum_error += error;
+		max_error = error > max_error ? error : max_error;
+		compared++;
+	}
+
+	P("Pose error against reference:\n");
+	P("\tposes compared     %zu of %zu (reference has %zu)\n", compared, run->num, ref->num);
+	P("\ttracked state diff %zu\n", tracking_differs);
+	if (compared > 0) {
+		P("\tposition error     mean %.3fmm max %.3fmm\n", sum_error / (double)compared * 1000.0,
+		  max_error * 1000.0);
+	}
+}
+
+static void
+print_help(const char *cmd)
+{
+	P("Usage: %s track-bench <dataset> <psmv|psvr|hand> [options]\n", cmd);
+	P("\n");
+	P("Replays a dataset recorded with P_TRACKING_RECORD_PATH through a tracker\n");
+	P("as fast as it can process it, reporting per stage timings.\n");
+	P("\n");
+	P("Options:\n");
+	P("  --write-reference <file>  Write the tracked poses to file.\n");
+	P("  --reference <file>        Compare the tracked poses to file.\n");
+}
+
+#endif // XRT_HAVE_OPENCV
+
+int
+cli_cmd_track_bench(int argc, const char **argv)
+{
+#ifdef XRT_HAVE_OPENCV
+	if (argc < 4) {
+		print_help(argv[0]);
+		return -1;
+	}
+
+	struct bench b = {0};
+	b.pipeline.name = "convert + hsv";
+	b.preprocessor.name = "blob preprocessor";
+	b.tracker_stage.name = "tracker";
+	b.total.name = "total";
+
+	if (strcmp(argv[3], "psmv") == 0) {
+		b.tracker = BENCH_TRACKER_PSMV;
+	} else if (strcmp(argv[3], "psvr") == 0) {
+		b.tracker = BENCH_TRACKER_PSVR;
+	} else if (strcmp(argv[3], "hand") == 0) {
+		b.tracker = BENCH_TRACKER_HAND;
+		b.pipeline.name = "convert";
+	} else {
+		print_help(argv[0]);
+		return -1;
+	}
+
+	const char *write_reference = NULL;
+	const char *reference = NULL;
+	for (int i = 4; i < argc; i++) {
+		if (strcmp(argv[i], "--write-reference") == 0 && i + 1 < argc) {
+			write_reference = argv[++i];
+		} else if (strcmp(argv[i], "--reference") == 0 && i + 1 < argc) {
+			reference = argv[++i];
+		} else {
+			print_help(argv[0]);
+			return -1;
+		}
+	}
+
+	struct t_dataset_reader *reader = NULL;
+	if (t_dataset_reader_open(argv[2], &reader) != 0) {
+		return -1;
+	}
+
+	// The calibration is always written first.
+	struct t_dataset_record rec = {0};
+	if (!t_dataset_reader_next(reader, &rec) || rec.type != T_DATASET_RECORD_CALIBRATION) {
+		P("Dataset has no calibration!\n");
+		t_dataset_record_clear(&rec);
+		t_dataset_reader_close(&reader);
+		return -1;
+	}
+
+	int ret = bench_setup(&b, rec.calib);
+	t_dataset_record_clear(&rec);
+	if (ret != 0) {
+		xrt_frame_context_destroy_nodes(&b.xfctx);
+		t_dataset_reader_close(&reader);
+		return -1;
+	}
+
+	uint64_t num_frames = 0;
+	uint64_t num_imu = 0;
+	uint64_t start = os_monotonic_get_ns();
+
+	while (t_dataset_reader_next(reader, &rec)) {
+		switch (rec.type) {
+		case T_DATASET_RECORD_FRAME:
+			bench_push_frame(&b, rec.frame);
+			num_frames++;
+			break;
+		case T_DATASET_RECORD_IMU:
+			bench_push_imu(&b, &rec);
+			num_imu++;
+			break;
+		default: break;
+		}
+
+		t_dataset_record_clear(&rec);
+	}
+
+	double seconds = (double)(os_monotonic_get_ns() - start) / (double)U_TIME_1S_IN_NS;
+
+	// Stops the tracker threads.
+	xrt_frame_context_destroy_nodes(&b.xfctx);
+	t_dataset_reader_close(&reader);
+
+	P("Replayed %" PRIu64 " frames and %" PRIu64 " IMU samples in %.3fs, %.1f frames per second.\n", num_frames,
+	  num_imu, seconds, seconds > 0.0 ? (double)num_frames / seconds : 0.0);
+	P("Per frame timings:\n");
+	stage_print(&b.pipeline);
+	stage_print(&b.preprocessor);
+	stage_print(&b.tracker_stage);
+	stage_print(&b.total);
+
+	if (write_reference != NULL && !write_poses(write_reference, &b.poses)) {
+		ret = -1;
+	}
+
+	if (reference != NULL) {
+		struct bench_poses ref = {0};
+		if (read_poses(reference, &ref)) {
+			compare_poses(&b.poses, &ref);
+		} else {
+			ret = -1;
+		}
+		free(ref.poses);
+	}
+
+	free(b.pipeline.samples);
+	free(b.preprocessor.samples);
+	free(b.tracker_stage.samples);
+	free(b.total.samples);
+	free(b.poses.poses);
+
+	return ret;
+#else
+	P("Command needs OpenCV support!\n");
+	return -1;
+#endif
+}
@@ -29,6 +29,9 @@ cli_cmd_test(int argc, const char **argv);
 int
 cli_cmd_trace(int argc, const char **argv);
 
+int
+cli_cmd_track_bench(int argc, const char **argv);
+
 
 #ifdef __cplusplus
 }
@@ -31,6 +31,7 @@ cli_print_help(int argc, const char **argv)
 	P("  probe      - Just probe and then exit.\n");
 	P("  lighthouse - Control the power of lighthouses [on|off].\n");
 	P("  calibrate  - Calibrate a camera and save config (not implemented yet).\n");
+	P("  track-bench - Replay a recorded tracking dataset and report timings.\n");
 
 	return 1;
 }
@@ -56,5 +57,8 @@ main(int argc, const char **argv)
 	if (strcmp(argv[1], "lighthouse") == 0) {
 		return cli_cmd_lighthouse(argc, argv);
 	}
+	if (strcmp(argv[1], "track-bench") == 0) {
+		return cli_cmd_track_bench(argc, argv);
+	}
 	return cli_print_help(argc, argv);
 }
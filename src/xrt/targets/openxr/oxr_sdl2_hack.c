@@ -15,6 +15,7 @@
 #include "util/u_debug.h"
 
 #include "os/os_threading.h"
+#include "os/os_thread_role.h"
 
 
 struct xrt_instance;
@@ -264,6 +265,8 @@ oxr_sdl2_hack_run_thread(void *ptr)
 {
 	struct sdl2_program *p = (struct sdl2_program *)ptr;
 
+	os_thread_role_set(OS_THREAD_ROLE_BACKGROUND, "sdl2_gui");
+
 	sdl2_window_init(p);
 
 	sdl2_loop(p);
@@ -0,0 +1,234 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Blob detector tests.
+ */
+
+#include "catch/catch.hpp"
+
+#include <tracking/t_tracking.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+struct Image
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> data;
+
+	Image(uint32_t w, uint32_t h) : width(w), height(h), data(w * h, 0) {}
+
+	void
+	fill(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t v = 255)
+	{
+		for (uint32_t iy = y; iy < y + h; iy++) {
+			for (uint32_t ix = x; ix < x + w; ix++) {
+				data[iy * width + ix] = v;
+			}
+		}
+	}
+};
+
+struct Detector
+{
+	struct t_blob_detector *det = nullptr;
+
+	Detector()
+	{
+		REQUIRE(t_blob_detector_create(&det) == 0);
+	}
+
+	~Detector()
+	{
+		t_blob_detector_destroy(&det);
+	}
+
+	std::vector<t_blob_detection>
+	detect(const Image &img,
+	       uint8_t threshold = 32,
+	       const struct xrt_rect *roi = nullptr,
+	       uint32_t min_area = 0,
+	       uint32_t max_area = UINT32_MAX)
+	{
+		const struct t_blob_detection *blobs = nullptr;
+		uint32_t num = t_blob_detector_detect_l8(det, img.data.data(), img.width, img.height, img.width,
+		                                         threshold, roi, min_area, max_area, &blobs);
+		std::vector<t_blob_detection> ret(blobs, blobs + num);
+		// Sort for stable comparisons.
+		std::sort(ret.begin(), ret.end(), [](const t_blob_detection &a, const t_blob_detection &b) {
+			return a.min_y != b.min_y ? a.min_y < b.min_y : a.min_x < b.min_x;
+		});
+		return ret;
+	}
+};
+
+//! Slow 8-connected flood fill to compare against.
+static std::vector<uint32_t>
+reference_areas(const Image &img, uint8_t threshold)
+{
+	std::vector<bool> seen(img.data.size(), false);
+	std::vector<uint32_t> areas;
+
+	for (uint32_t y = 0; y < img.height; y++) {
+		for (uint32_t x = 0; x < img.width; x++) {
+			uint32_t i = y * img.width + x;
+			if (seen[i] || img.data[i] < threshold) {
+				continue;
+			}
+
+			uint32_t area = 0;
+			std::vector<uint32_t> stack{i};
+			seen[i] = true;
+			while (!stack.empty()) {
+				uint32_t c = stack.back();
+				stack.pop_back();
+				area++;
+
+				int cx = c % img.width;
+				int cy = c / img.width;
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						int nx = cx + dx;
+						int ny = cy + dy;
+						if (nx < 0 || ny < 0 || nx >= (int)img.width || ny >= (int)img.height) {
+							continue;
+						}
+						uint32_t n = ny * img.width + nx;
+						if (!seen[n] && img.data[n] >= threshold) {
+							seen[n] = true;
+							stack.push_back(n);
+						}
+					}
+				}
+			}
+			areas.push_back(area);
+		}
+	}
+
+	std::sort(areas.begin(), areas.end());
+	return areas;
+}
+
+} // namespace
+
+
+TEST_CASE("t_blob_detect")
+{
+	Detector d;
+
+	SECTION("empty image")
+	{
+		Image img(64, 32);
+		CHECK(d.detect(img).empty());
+	}
+
+	SECTION("single square, centroid and bounding box")
+	{
+		Image img(64, 32);
+		img.fill(10, 4, 4, 6);
+
+		auto blobs = d.detect(img);
+		REQUIRE(blobs.size() == 1);
+		CHECK(blobs[0].area == 24);
+		CHECK(blobs[0].x == Approx(11.5f));
+		CHECK(blobs[0].y == Approx(6.5f));
+		CHECK(blobs[0].min_x == 10);
+		CHECK(blobs[0].max_x == 13);
+		CHECK(blobs[0].min_y == 4);
+		CHECK(blobs[0].max_y == 9);
+	}
+
+	SECTION("diagonal pixels are connected")
+	{
+		Image img(16, 16);
+		img.fill(3, 3, 1, 1);
+		img.fill(4, 4, 1, 1);
+		img.fill(5, 5, 1, 1);
+
+		auto blobs = d.detect(img);
+		REQUIRE(blobs.size() == 1);
+		CHECK(blobs[0].area == 3);
+	}
+
+	SECTION("u shape merges into one blob")
+	{
+		Image img(32, 16);
+		img.fill(2, 2, 2, 8);
+		img.fill(12, 2, 2, 8);
+		img.fill(2, 10, 12, 2);
+
+		auto blobs = d.detect(img);
+		REQUIRE(blobs.size() == 1);
+		CHECK(blobs[0].area == 2 * 8 + 2 * 8 + 12 * 2);
+		CHECK(blobs[0].min_x == 2);
+		CHECK(blobs[0].max_x == 13);
+	}
+
+	SECTION("threshold")
+	{
+		Image img(32, 8);
+		img.fill(1, 1, 2, 2, 31);
+		img.fill(8, 1, 2, 2, 32);
+		img.fill(16, 1, 2, 2, 200);
+
+		CHECK(d.detect(img, 32).size() == 2);
+		CHECK(d.detect(img, 201).empty());
+		CHECK(d.detect(img, 200).size() == 1);
+	}
+
+	SECTION("area filter")
+	{
+		Image img(32, 8);
+		img.fill(1, 1, 1, 1);
+		img.fill(8, 1, 3, 3);
+
+		CHECK(d.detect(img, 32, nullptr, 2, 100).size() == 1);
+		CHECK(d.detect(img, 32, nullptr, 0, 1).size() == 1);
+	}
+
+	SECTION("roi")
+	{
+		Image img(64, 32);
+		img.fill(4, 4, 2, 2);
+		img.fill(40, 20, 2, 2);
+
+		struct xrt_rect roi = {{32, 16}, {32, 16}};
+		auto blobs = d.detect(img, 32, &roi);
+		REQUIRE(blobs.size() == 1);
+		CHECK(blobs[0].x == Approx(40.5f));
+		CHECK(blobs[0].y == Approx(20.5f));
+
+		struct xrt_rect outside = {{100, 100}, {10, 10}};
+		CHECK(d.detect(img, 32, &outside).empty());
+	}
+
+	SECTION("matches flood fill on random images")
+	{
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<int> value(0, 255);
+
+		for (int i = 0; i < 20; i++) {
+			// Odd width to hit the non word sized tail.
+			Image img(61, 23);
+			for (auto &v : img.data) {
+				// Mostly dark, some bright.
+				v = value(rng) > 200 ? 255 : (uint8_t)(value(rng) / 16);
+			}
+
+			auto blobs = d.detect(img);
+			std::vector<uint32_t> areas;
+			for (const auto &b : blobs) {
+				areas.push_back(b.area);
+			}
+			std::sort(areas.begin(), areas.end());
+
+			CHECK(areas == reference_areas(img, 32));
+		}
+	}
+}
@@ -0,0 +1,210 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Layer submission tests, the bulk call against one call per layer.
+ */
+
+#include "catch/catch.hpp"
+
+#include <xrt/xrt_compositor.h>
+
+#include <chrono>
+#include <vector>
+
+
+namespace {
+
+/*!
+ * Records layers the way the IPC client and multi compositor do, into a fixed
+ * array of swapchains and layer data.
+ */
+struct FakeCompositor
+{
+	struct xrt_compositor base = {};
+
+	struct xrt_layer_entry layers[16] = {};
+	uint32_t num_layers = 0;
+	uint32_t num_calls = 0;
+};
+
+static FakeCompositor &
+fake(struct xrt_compositor *xc)
+{
+	return *reinterpret_cast<FakeCompositor *>(xc);
+}
+
+static xrt_result_t
+record(struct xrt_compositor *xc,
+       struct xrt_swapchain *a,
+       struct xrt_swapchain *b,
+       struct xrt_swapchain *c,
+       struct xrt_swapchain *d,
+       const struct xrt_layer_data *data)
+{
+	FakeCompositor &fc = fake(xc);
+	struct xrt_layer_entry &e = fc.layers[fc.num_layers++];
+	e.xscs[0] = a;
+	e.xscs[1] = b;
+	e.xscs[2] = c;
+	e.xscs[3] = d;
+	e.data = *data;
+	fc.num_calls++;
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+layer_stereo_projection(struct xrt_compositor *xc,
+                        struct xrt_device *xdev,
+                        struct xrt_swapchain *l_xsc,
+                        struct xrt_swapchain *r_xsc,
+                        const struct xrt_layer_data *data)
+{
+	return record(xc, l_xsc, r_xsc, nullptr, nullptr, data);
+}
+
+static xrt_result_t
+layer_stereo_projection_depth(struct xrt_compositor *xc,
+                              struct xrt_device *xdev,
+                              struct xrt_swapchain *l_xsc,
+                              struct xrt_swapchain *r_xsc,
+                              struct xrt_swapchain *l_d_xsc,
+                              struct xrt_swapchain *r_d_xsc,
+                              const struct xrt_layer_data *data)
+{
+	return record(xc, l_xsc, r_xsc, l_d_xsc, r_d_xsc, data);
+}
+
+static xrt_result_t
+layer_single(struct xrt_compositor *xc,
+             struct xrt_device *xdev,
+             struct xrt_swapchain *xsc,
+             const struct xrt_layer_data *data)
+{
+	return record(xc, xsc, nullptr, nullptr, nullptr, data);
+}
+
+static xrt_result_t
+layers(struct xrt_compositor *xc,
+       struct xrt_device *xdev,
+       const struct xrt_layer_entry *entries,
+       uint32_t num_entries)
+{
+	FakeCompositor &fc = fake(xc);
+	for (uint32_t i = 0; i < num_entries; i++) {
+		fc.layers[fc.num_layers++] = entries[i];
+	}
+	fc.num_calls++;
+	return XRT_SUCCESS;
+}
+
+static void
+init(FakeCompositor &fc, bool bulk)
+{
+	fc.base.layer_stereo_projection = layer_stereo_projection;
+	fc.base.layer_stereo_projection_depth = layer_stereo_projection_depth;
+	fc.base.layer_quad = layer_single;
+	fc.base.layer_cube = layer_single;
+	fc.base.layer_cylinder = layer_single;
+	fc.base.layer_equirect1 = layer_single;
+	fc.base.layer_equirect2 = layer_single;
+	fc.base.layers = bulk ? layers : nullptr;
+}
+
+//! Fake swapchain pointers, never dereferenced.
+static struct xrt_swapchain *
+swapchain(uintptr_t i)
+{
+	return reinterpret_cast<struct xrt_swapchain *>(0x1000 * (i + 1));
+}
+
+static std::vector<struct xrt_layer_entry>
+make_entries(uint32_t num, enum xrt_layer_type type)
+{
+	std::vector<struct xrt_layer_entry> entries(num);
+	for (uint32_t i = 0; i < num; i++) {
+		struct xrt_layer_entry &e = entries[i];
+		e = {};
+		e.data.type = type;
+		e.data.timestamp = i;
+		e.xscs[0] = swapchain(i * 4);
+		if (type == XRT_LAYER_STEREO_PROJECTION || type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+			e.xscs[1] = swapchain(i * 4 + 1);
+		}
+		if (type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+			e.xscs[2] = swapchain(i * 4 + 2);
+			e.xscs[3] = swapchain(i * 4 + 3);
+		}
+	}
+	return entries;
+}
+
+} // namespace
+
+
+TEST_CASE("xrt_comp_layers")
+{
+	auto type = GENERATE(XRT_LAYER_STEREO_PROJECTION, XRT_LAYER_STEREO_PROJECTION_DEPTH, XRT_LAYER_QUAD,
+	                     XRT_LAYER_CUBE, XRT_LAYER_CYLINDER, XRT_LAYER_EQUIRECT1, XRT_LAYER_EQUIRECT2);
+	CAPTURE(type);
+
+	std::vector<struct xrt_layer_entry> entries = make_entries(5, type);
+
+	FakeCompositor per_layer;
+	FakeCompositor bulk;
+	init(per_layer, false);
+	init(bulk, true);
+
+	REQUIRE(xrt_comp_layers(&per_layer.base, nullptr, entries.data(), 5) == XRT_SUCCESS);
+	REQUIRE(xrt_comp_layers(&bulk.base, nullptr, entries.data(), 5) == XRT_SUCCESS);
+
+	// Without the bulk function every layer is its own call, same result.
+	CHECK(per_layer.num_calls == 5);
+	CHECK(bulk.num_calls == 1);
+	REQUIRE(per_layer.num_layers == 5);
+	REQUIRE(bulk.num_layers == 5);
+
+	for (uint32_t i = 0; i < 5; i++) {
+		for (uint32_t k = 0; k < 4; k++) {
+			CHECK(per_layer.layers[i].xscs[k] == entries[i].xscs[k]);
+			CHECK(bulk.layers[i].xscs[k] == entries[i].xscs[k]);
+		}
+		CHECK(per_layer.layers[i].data.type == type);
+		CHECK(per_layer.layers[i].data.timestamp == i);
+		CHECK(bulk.layers[i].data.timestamp == i);
+	}
+}
+
+TEST_CASE("xrt_comp_layers speed", "[.benchmark]")
+{
+	const size_t num_frames = 200000;
+
+	for (uint32_t num : {1u, 4u, 16u}) {
+		std::vector<struct xrt_layer_entry> entries = make_entries(num, XRT_LAYER_QUAD);
+
+		auto time_ns = [&](bool use_bulk) {
+			FakeCompositor fc;
+			init(fc, use_bulk);
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t f = 0; f < num_frames; f++) {
+				fc.num_layers = 0;
+				xrt_comp_layers(&fc.base, nullptr, entries.data(), num);
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			CHECK(fc.num_layers == num);
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			return (double)ns / num_frames;
+		};
+
+		// Warm up first.
+		time_ns(true);
+
+		double per_layer_ns = time_ns(false);
+		double bulk_ns = time_ns(true);
+
+		WARN("Submitting " << num << " quad layers per frame, one call per layer " << per_layer_ns
+		                   << " ns, one call " << bulk_ns << " ns.");
+	}
+}
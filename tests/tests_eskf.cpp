@@ -0,0 +1,292 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Error-state Kalman filter tests, also times it against the other IMU fusers.
+ */
+
+#include "catch/catch.hpp"
+
+#include <tracking/t_eskf.hpp>
+#include <tracking/t_imu_fusion.hpp>
+#include <math/m_imu_3dof.h>
+#include <util/u_time.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+using namespace xrt::auxiliary::tracking;
+
+namespace {
+
+constexpr timepoint_ns kStepNs = U_TIME_1MS_IN_NS;
+constexpr int kCameraEvery = 16; // About 60Hz.
+
+using PositionFilter = eskf::Filter<64, eskf::PositionMeasurement, eskf::GravityMeasurement>;
+
+struct Truth
+{
+	timepoint_ns timestamp_ns;
+	Eigen::Vector3d position;
+	Eigen::Quaterniond orientation;
+};
+
+struct Sim
+{
+	std::vector<eskf::ImuSample> imu;
+	std::vector<Truth> truth;
+};
+
+static Eigen::Vector3d
+position_at(double t)
+{
+	return {0.3 * sin(t), 1.5 + 0.2 * sin(1.3 * t), 0.25 * cos(0.8 * t)};
+}
+
+static Eigen::Vector3d
+accel_at(double t)
+{
+	return {-0.3 * sin(t), -0.2 * 1.69 * sin(1.3 * t), -0.25 * 0.64 * cos(0.8 * t)};
+}
+
+static Eigen::Vector3d
+gyro_at(double t)
+{
+	return {0.8 * sin(t), 1.2 * cos(0.7 * t), 0.3 + 0.2 * sin(2.1 * t)};
+}
+
+/*!
+ * A device moving around in front of the user, sampled the way the filter
+ * integrates, each sample covers the step before it.
+ */
+static Sim
+make_sim(size_t num)
+{
+	Sim sim;
+	std::mt19937 rng(1234);
+	std::normal_distribution<double> gyro_noise(0, 2e-3 * sqrt(1000.0));
+	std::normal_distribution<double> accel_noise(0, 2e-2 * sqrt(1000.0));
+
+	double dt = time_ns_to_s(kStepNs);
+	Eigen::Quaterniond rot = Eigen::Quaterniond::Identity();
+	sim.truth.push_back({0, position_at(0), rot});
+
+	for (size_t i = 1; i <= num; i++) {
+		double t0 = (double)(i - 1) * dt;
+		double mid = t0 + dt * 0.5;
+
+		Eigen::Vector3d gyro = gyro_at(mid);
+		Eigen::Vector3d accel = rot.conjugate() * (accel_at(mid) - eskf::kGravity);
+		rot = (rot * eskf::rotvec_to_quat(gyro * dt)).normalized();
+
+		Eigen::Vector3d noisy_gyro = gyro + Eigen::Vector3d(gyro_noise(rng), gyro_noise(rng), gyro_noise(rng));
+		Eigen::Vector3d noisy_accel =
+		    accel + Eigen::Vector3d(accel_noise(rng), accel_noise(rng), accel_noise(rng));
+
+		timepoint_ns ts = (timepoint_ns)i * kStepNs;
+		sim.imu.push_back({ts, noisy_accel, noisy_gyro});
+		sim.truth.push_back({ts, position_at((double)i * dt), rot});
+	}
+
+	return sim;
+}
+
+static eskf::PositionMeasurement
+make_position(const Truth &truth, std::mt19937 &rng)
+{
+	std::normal_distribution<double> noise(0, 1e-3);
+	Eigen::Vector3d p = truth.position + Eigen::Vector3d(noise(rng), noise(rng), noise(rng));
+	return eskf::PositionMeasurement(p, Eigen::Vector3d::Constant(1e-6));
+}
+
+static void
+start(PositionFilter &filter, const Sim &sim)
+{
+	eskf::State s;
+	s.position = sim.truth[0].position;
+	s.velocity = {0.3, 0.2 * 1.3, 0};
+	s.orientation = sim.truth[0].orientation;
+
+	eskf::Covariance P = eskf::Covariance::Identity() * 1e-6;
+	P.block<3, 3>(eskf::kGyroBias, eskf::kGyroBias) *= 1e-2;
+	P.block<3, 3>(eskf::kAccelBias, eskf::kAccelBias) *= 1e-2;
+
+	filter.reset(s, P, 0);
+}
+
+static double
+angle_between(const Eigen::Quaterniond &a, const Eigen::Quaterniond &b)
+{
+	return a.angularDistance(b);
+}
+
+/*!
+ * Runs the simulation, camera measurements arrive @p latency samples late.
+ */
+static void
+run(PositionFilter &filter, const Sim &sim, size_t latency, size_t batch)
+{
+	std::mt19937 rng(4321);
+
+	for (size_t i = 0; i < sim.imu.size(); i += batch) {
+		size_t count = std::min(batch, sim.imu.size() - i);
+		filter.handleImu(&sim.imu[i], count);
+
+		for (size_t k = i; k < i + count; k++) {
+			// Sample k + 1 is the truth after imu sample k.
+			size_t now = k + 1;
+			if (now < latency || (now - latency) % kCameraEvery != 0) {
+				continue;
+			}
+			const Truth &truth = sim.truth[now - latency];
+			filter.handleMeasurement(truth.timestamp_ns, make_position(truth, rng));
+		}
+	}
+}
+
+} // namespace
+
+
+TEST_CASE("eskf")
+{
+	Sim sim = make_sim(5000);
+	const Truth &end = sim.truth.back();
+
+	SECTION("dead reckoning follows the IMU")
+	{
+		PositionFilter filter;
+		start(filter, sim);
+
+		// Only a short stretch, there is nothing to correct the drift.
+		for (size_t i = 0; i < 200; i++) {
+			REQUIRE(filter.handleImu(sim.imu[i]));
+		}
+
+		const Truth &truth = sim.truth[200];
+		CHECK(filter.getTimestamp() == truth.timestamp_ns);
+		CHECK(angle_between(filter.getState().orientation, truth.orientation) < 0.01);
+		CHECK((filter.getState().position - truth.position).norm() < 0.01);
+	}
+
+	SECTION("batched IMU matches single samples")
+	{
+		PositionFilter single;
+		PositionFilter batch;
+		start(single, sim);
+		start(batch, sim);
+
+		run(single, sim, 0, 1);
+		run(batch, sim, 0, 4);
+
+		CHECK((single.getState().position - batch.getState().position).norm() < 1e-3);
+		CHECK(angle_between(single.getState().orientation, batch.getState().orientation) < 1e-3);
+	}
+
+	SECTION("position corrects drift, also when late")
+	{
+		PositionFilter on_time;
+		PositionFilter late;
+		start(on_time, sim);
+		start(late, sim);
+
+		run(on_time, sim, 0, 1);
+		run(late, sim, 20, 1);
+
+		for (auto *f : {&on_time, &late}) {
+			CHECK((f->getState().position - end.position).norm() < 0.01);
+			CHECK(angle_between(f->getState().orientation, end.orientation) < 0.02);
+		}
+
+		// The late measurements were replayed into the same result.
+		CHECK((on_time.getState().position - late.getState().position).norm() < 0.01);
+	}
+
+	SECTION("gravity corrects the tilt of a resting device")
+	{
+		PositionFilter filter;
+
+		eskf::State s;
+		Eigen::Quaterniond tilt(Eigen::AngleAxisd(0.1, Eigen::Vector3d::UnitX()));
+		s.orientation = tilt;
+
+		eskf::Covariance P = eskf::Covariance::Identity() * 1e-6;
+		P.block<3, 3>(eskf::kRotation, eskf::kRotation) = Eigen::Matrix3d::Identity() * 1e-2;
+		filter.reset(s, P, 0);
+
+		Eigen::Vector3d accel = -eskf::kGravity;
+		for (timepoint_ns i = 1; i <= 1000; i++) {
+			filter.handleImu({i * kStepNs, accel, Eigen::Vector3d::Zero()});
+			if (i % 10 == 0) {
+				eskf::GravityMeasurement m(accel, Eigen::Vector3d::Constant(1e-2));
+				CHECK(filter.handleMeasurement(i * kStepNs, m));
+			}
+		}
+
+		Eigen::Vector3d up = filter.getState().orientation * Eigen::Vector3d::UnitY();
+		CHECK(std::acos(std::min(up.y(), 1.0)) < 0.01);
+	}
+
+	SECTION("measurements older than the history are dropped")
+	{
+		PositionFilter filter;
+		start(filter, sim);
+
+		for (size_t i = 0; i < 100; i++) {
+			filter.handleImu(sim.imu[i]);
+		}
+
+		std::mt19937 rng(1);
+		CHECK_FALSE(filter.handleMeasurement(sim.truth[10].timestamp_ns, make_position(sim.truth[10], rng)));
+		CHECK(filter.handleMeasurement(sim.truth[90].timestamp_ns, make_position(sim.truth[90], rng)));
+	}
+}
+
+TEST_CASE("eskf speed", "[.benchmark]")
+{
+	Sim big = make_sim(60000);
+	double num = (double)big.imu.size();
+
+	auto time_ns = [](auto &&func) {
+		auto start = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	};
+
+	PositionFilter single;
+	start(single, big);
+	double single_ns = time_ns([&] { run(single, big, 20, 1); });
+
+	PositionFilter batch;
+	start(batch, big);
+	double batch_ns = time_ns([&] { run(batch, big, 20, 4); });
+
+	SimpleIMUFusion simple;
+	double simple_ns = time_ns([&] {
+		for (const auto &s : big.imu) {
+			simple.handleGyro(s.gyro, s.timestamp_ns);
+			simple.handleAccel(s.accel, s.timestamp_ns);
+			simple.postCorrect();
+		}
+	});
+
+	struct m_imu_3dof imu_3dof;
+	m_imu_3dof_init(&imu_3dof, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	double imu_3dof_ns = time_ns([&] {
+		for (const auto &s : big.imu) {
+			struct xrt_vec3 accel = {(float)s.accel.x(), (float)s.accel.y(), (float)s.accel.z()};
+			struct xrt_vec3 gyro = {(float)s.gyro.x(), (float)s.gyro.y(), (float)s.gyro.z()};
+			m_imu_3dof_update(&imu_3dof, s.timestamp_ns, &accel, &gyro);
+		}
+	});
+	m_imu_3dof_close(&imu_3dof);
+
+	CHECK((batch.getState().position - big.truth.back().position).norm() < 0.01);
+
+	WARN("Per IMU sample at 1kHz with late 60Hz positions, eskf: "
+	     << single_ns / num << " ns, eskf batches of 4: " << batch_ns / num << " ns. Without positions, "
+	     << "SimpleIMUFusion: " << simple_ns / num << " ns, m_imu_3dof: " << imu_3dof_ns / num << " ns.");
+}
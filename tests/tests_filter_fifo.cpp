@@ -0,0 +1,204 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Filter fifo tests, compares the windowed stats with a plain walk of the samples.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_filter_fifo.h>
+#include <util/u_time.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+namespace {
+
+constexpr uint64_t kStepNs = U_TIME_1MS_IN_NS;
+
+struct Expected
+{
+	size_t count;
+	double mean[3];
+	double variance[3];
+};
+
+static struct xrt_vec3
+make_sample(size_t i)
+{
+	double t = (double)i;
+	return {(float)(9.8 + sin(t * 0.1)), (float)(0.01 * cos(t * 0.37)), (float)(1000.0 + 0.5 * sin(t))};
+}
+
+/*!
+ * Walks all pushed samples, used as the reference.
+ */
+static Expected
+brute_force(const std::vector<xrt_vec3> &samples,
+            const std::vector<uint64_t> &timestamps_ns,
+            uint64_t start_ns,
+            uint64_t stop_ns)
+{
+	Expected e = {};
+	double sum[3] = {}, sum_sq[3] = {};
+
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (timestamps_ns[i] < start_ns || timestamps_ns[i] > stop_ns) {
+			continue;
+		}
+		const double v[3] = {samples[i].x, samples[i].y, samples[i].z};
+		for (int k = 0; k < 3; k++) {
+			sum[k] += v[k];
+		}
+		e.count++;
+	}
+
+	if (e.count == 0) {
+		return e;
+	}
+
+	for (int k = 0; k < 3; k++) {
+		e.mean[k] = sum[k] / (double)e.count;
+	}
+
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (timestamps_ns[i] < start_ns || timestamps_ns[i] > stop_ns) {
+			continue;
+		}
+		const double v[3] = {samples[i].x, samples[i].y, samples[i].z};
+		for (int k = 0; k < 3; k++) {
+			sum_sq[k] += (v[k] - e.mean[k]) * (v[k] - e.mean[k]);
+		}
+	}
+
+	for (int k = 0; k < 3; k++) {
+		e.variance[k] = sum_sq[k] / (double)e.count;
+	}
+
+	return e;
+}
+
+} // namespace
+
+
+TEST_CASE("m_filter_fifo")
+{
+	SECTION("size is rounded up to a power of two")
+	{
+		struct m_ff_f64 *ff64 = NULL;
+		m_ff_f64_alloc(&ff64, 1000);
+		CHECK(m_ff_f64_get_num(ff64) == 1024);
+		m_ff_f64_free(&ff64);
+		CHECK(ff64 == NULL);
+	}
+
+	SECTION("get returns the latest samples first")
+	{
+		struct m_ff_f64 *ff = NULL;
+		m_ff_f64_alloc(&ff, 4);
+
+		for (size_t i = 1; i <= 6; i++) {
+			double v = (double)i;
+			m_ff_f64_push(ff, &v, i * kStepNs);
+		}
+
+		double v;
+		uint64_t ts;
+		CHECK(m_ff_f64_get(ff, 0, &v, &ts));
+		CHECK(v == 6.0);
+		CHECK(ts == 6 * kStepNs);
+		CHECK(m_ff_f64_get(ff, 3, &v, &ts));
+		CHECK(v == 3.0);
+		CHECK_FALSE(m_ff_f64_get(ff, 4, &v, &ts));
+
+		m_ff_f64_free(&ff);
+	}
+
+	SECTION("windowed stats match a walk of the samples")
+	{
+		constexpr size_t kNum = 256;
+		struct m_ff_vec3_f32 *ff = NULL;
+		m_ff_vec3_f32_alloc(&ff, kNum);
+
+		// The fifo starts filled with zeros at timepoint zero.
+		std::vector<xrt_vec3> samples(kNum, xrt_vec3{0, 0, 0});
+		std::vector<uint64_t> timestamps_ns(kNum, 0);
+
+		// Push a lot more than fits, so the running sums have grown large.
+		for (size_t i = 0; i < 100000; i++) {
+			struct xrt_vec3 s = make_sample(i);
+			uint64_t ts = (i + 1) * kStepNs;
+			m_ff_vec3_f32_push(ff, &s, ts);
+			samples.push_back(s);
+			timestamps_ns.push_back(ts);
+		}
+
+		// Only the last kNum samples are in the fifo.
+		samples.erase(samples.begin(), samples.end() - kNum);
+		timestamps_ns.erase(timestamps_ns.begin(), timestamps_ns.end() - kNum);
+
+		uint64_t last_ns = timestamps_ns.back();
+		const uint64_t windows[][2] = {
+		    {last_ns - 50 * kStepNs, last_ns},                     // Recent.
+		    {last_ns - 200 * kStepNs + 1, last_ns - 20 * kStepNs}, // Between samples.
+		    {0, last_ns},                                          // Everything.
+		    {last_ns, last_ns},                                    // Just one.
+		    {last_ns + 1, last_ns + kStepNs},                      // In the future.
+		    {last_ns, last_ns - kStepNs},                          // Backwards.
+		};
+
+		for (const auto &w : windows) {
+			Expected e = brute_force(samples, timestamps_ns, w[0], w[1]);
+
+			struct xrt_vec3 mean, variance;
+			size_t count = m_ff_vec3_f32_filter_stats(ff, w[0], w[1], &mean, &variance);
+			CHECK(count == e.count);
+
+			const float m[3] = {mean.x, mean.y, mean.z};
+			const float v[3] = {variance.x, variance.y, variance.z};
+			for (int k = 0; k < 3; k++) {
+				CHECK(m[k] == Approx(e.mean[k]).epsilon(1e-6).margin(1e-6));
+				CHECK(v[k] == Approx(e.variance[k]).epsilon(1e-3).margin(1e-5));
+			}
+
+			struct xrt_vec3 average;
+			CHECK(m_ff_vec3_f32_filter(ff, w[0], w[1], &average) == count);
+			CHECK(average.x == mean.x);
+		}
+
+		m_ff_vec3_f32_free(&ff);
+	}
+}
+
+TEST_CASE("m_filter_fifo filter_stats speed", "[.benchmark]")
+{
+	constexpr size_t kNum = 1024;
+	struct m_ff_vec3_f32 *ff = NULL;
+	m_ff_vec3_f32_alloc(&ff, kNum);
+
+	for (size_t i = 0; i < kNum; i++) {
+		struct xrt_vec3 s = make_sample(i);
+		m_ff_vec3_f32_push(ff, &s, (i + 1) * kStepNs);
+	}
+
+	constexpr size_t kRuns = 100000;
+	uint64_t last_ns = kNum * kStepNs;
+	struct xrt_vec3 mean, variance;
+	size_t total = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kRuns; i++) {
+		uint64_t start_ns = last_ns - (i % 1000) * kStepNs;
+		total += m_ff_vec3_f32_filter_stats(ff, start_ns, last_ns, &mean, &variance);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	CHECK(total > 0);
+	WARN("filter_stats over " << kNum << " samples: " << ns / kRuns << " ns per call.");
+
+	m_ff_vec3_f32_free(&ff);
+}
@@ -0,0 +1,199 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Handle table tests, and what verifying a handle costs.
+ */
+
+#include "catch/catch.hpp"
+
+#include <oxr/oxr_objects.h>
+#include <oxr/oxr_logger.h>
+#include <oxr/oxr_handle.h>
+#include <oxr/oxr_api_verify.h>
+
+#include <chrono>
+#include <vector>
+
+
+namespace {
+
+static XrResult
+destroy_handle(struct oxr_logger *log, struct oxr_handle_base *hb)
+{
+	oxr_handle_free(hb);
+	return XR_SUCCESS;
+}
+
+static struct oxr_handle_base *
+make_handle(struct oxr_logger *log, uint64_t debug, struct oxr_handle_base *parent)
+{
+	struct oxr_handle_base *hb = nullptr;
+	XrResult ret = oxr_handle_allocate_and_init(log, sizeof(struct oxr_space), debug, destroy_handle, parent,
+	                                            (void **)&hb);
+	REQUIRE(ret == XR_SUCCESS);
+	return hb;
+}
+
+static XRT_NO_INLINE XrResult
+verify_space(XrSpace space)
+{
+	struct oxr_logger log;
+	struct oxr_space *spc;
+	OXR_VERIFY_SPACE_AND_INIT_LOG(&log, space, spc, "xrTest");
+	(void)spc;
+	return XR_SUCCESS;
+}
+
+static XRT_NO_INLINE XrResult
+verify_session(XrSession session)
+{
+	struct oxr_logger log;
+	struct oxr_session *sess;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrTest");
+	(void)sess;
+	return XR_SUCCESS;
+}
+
+//! The logger used to be initialised out of line.
+static XRT_NO_INLINE void
+log_init_out_of_line(struct oxr_logger *log, const char *name)
+{
+	oxr_log_init(log, name);
+}
+
+/*!
+ * What verifying did when handles were pointers: check the object through
+ * the pointer, then walk to the instance for the logger.
+ */
+static XRT_NO_INLINE XrResult
+verify_space_pointer(struct oxr_handle_base *hb)
+{
+	struct oxr_logger log;
+	log_init_out_of_line(&log, "xrTest");
+	if (hb == nullptr) {
+		return oxr_error(&log, XR_ERROR_HANDLE_INVALID, "(space == NULL)");
+	}
+	if (hb->debug != OXR_XR_DEBUG_SPACE) {
+		return oxr_error(&log, XR_ERROR_HANDLE_INVALID, "(space == %p)", (void *)hb);
+	}
+	if (hb->state != OXR_HANDLE_STATE_LIVE) {
+		return oxr_error(&log, XR_ERROR_HANDLE_INVALID, "(space == %p) state == %s", (void *)hb,
+		                 oxr_handle_state_to_string(hb->state));
+	}
+	oxr_log_set_instance(&log, (struct oxr_instance *)hb->parent->parent);
+	return XR_SUCCESS;
+}
+
+} // namespace
+
+
+TEST_CASE("handle_table")
+{
+	struct oxr_logger log;
+	oxr_log_init(&log, "test");
+
+	struct oxr_handle_base *root = make_handle(&log, OXR_XR_DEBUG_SESSION, nullptr);
+	struct oxr_handle_base *hb = make_handle(&log, OXR_XR_DEBUG_SPACE, root);
+	XrSpace space = OXR_PTR_TO_HANDLE(XrSpace, hb);
+
+	SECTION("live handle")
+	{
+		CHECK(space != XR_NULL_HANDLE);
+		CHECK(OXR_HANDLE_TO_PTR(struct oxr_handle_base *, space) == hb);
+		CHECK(verify_space(space) == XR_SUCCESS);
+	}
+
+	SECTION("null handle")
+	{
+		CHECK(oxr_handle_table_lookup(0) == nullptr);
+		CHECK(verify_space(XR_NULL_HANDLE) == XR_ERROR_HANDLE_INVALID);
+	}
+
+	SECTION("wrong type")
+	{
+		CHECK(verify_session(OXR_PTR_TO_HANDLE(XrSession, hb)) == XR_ERROR_HANDLE_INVALID);
+		CHECK(verify_space(OXR_PTR_TO_HANDLE(XrSpace, root)) == XR_ERROR_HANDLE_INVALID);
+	}
+
+	SECTION("never given out")
+	{
+		uint64_t value = (uint64_t)space;
+		CHECK(oxr_handle_table_lookup(value + 1) == nullptr);
+		CHECK(oxr_handle_table_lookup(value + ((uint64_t)1 << 32)) == nullptr);
+		CHECK(oxr_handle_table_lookup(value & 0xffffffff) == nullptr);
+		CHECK(oxr_handle_table_lookup(OXR_HANDLE_TABLE_SIZE + 1) == nullptr);
+	}
+
+	SECTION("destroyed handle")
+	{
+		REQUIRE(oxr_handle_destroy(&log, hb) == XR_SUCCESS);
+		CHECK(oxr_handle_table_lookup((uint64_t)space) == nullptr);
+		CHECK(verify_space(space) == XR_ERROR_HANDLE_INVALID);
+
+		// The slot is reused with a new generation, the old handle stays dead.
+		struct oxr_handle_base *other = make_handle(&log, OXR_XR_DEBUG_SPACE, root);
+		XrSpace other_space = OXR_PTR_TO_HANDLE(XrSpace, other);
+		CHECK(other_space != space);
+		CHECK(verify_space(other_space) == XR_SUCCESS);
+		CHECK(verify_space(space) == XR_ERROR_HANDLE_INVALID);
+	}
+
+	SECTION("children destroyed with parent")
+	{
+		XrSession session = OXR_PTR_TO_HANDLE(XrSession, root);
+		REQUIRE(oxr_handle_destroy(&log, root) == XR_SUCCESS);
+		root = nullptr;
+		CHECK(verify_session(session) == XR_ERROR_HANDLE_INVALID);
+		CHECK(verify_space(space) == XR_ERROR_HANDLE_INVALID);
+	}
+
+	if (root != nullptr) {
+		CHECK(oxr_handle_destroy(&log, root) == XR_SUCCESS);
+	}
+}
+
+TEST_CASE("handle_table verify speed", "[.benchmark]")
+{
+	struct oxr_logger log;
+	oxr_log_init(&log, "test");
+
+	// About the number of actions a big application queries every frame.
+	const size_t num_handles = 200;
+	const size_t num_frames = 20000;
+
+	struct oxr_handle_base *inst = make_handle(&log, OXR_XR_DEBUG_INSTANCE, nullptr);
+	struct oxr_handle_base *sess = make_handle(&log, OXR_XR_DEBUG_SESSION, inst);
+
+	std::vector<struct oxr_handle_base *> pointers;
+	std::vector<XrSpace> spaces;
+	for (size_t i = 0; i < num_handles; i++) {
+		pointers.push_back(make_handle(&log, OXR_XR_DEBUG_SPACE, sess));
+		spaces.push_back(OXR_PTR_TO_HANDLE(XrSpace, pointers.back()));
+	}
+
+	auto time_ns = [&](auto &&verify) {
+		size_t num_failed = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t f = 0; f < num_frames; f++) {
+			for (size_t i = 0; i < num_handles; i++) {
+				num_failed += verify(i) != XR_SUCCESS;
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+		CHECK(num_failed == 0);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return (double)ns / (double)(num_frames * num_handles);
+	};
+
+	// Warm up the caches and the cpu clock first.
+	time_ns([&](size_t i) { return verify_space(spaces[i]); });
+
+	double pointer_ns = time_ns([&](size_t i) { return verify_space_pointer(pointers[i]); });
+	double table_ns = time_ns([&](size_t i) { return verify_space(spaces[i]); });
+
+	WARN("Verifying " << num_handles << " handles per frame, pointer " << pointer_ns << " ns, table "
+	                  << table_ns << " ns per call.");
+
+	CHECK(oxr_handle_destroy(&log, inst) == XR_SUCCESS);
+}
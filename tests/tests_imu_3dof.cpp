@@ -0,0 +1,181 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief 3dof IMU fusion tests, compares the batch update with the per sample one.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_imu_3dof.h>
+#include <util/u_time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+namespace {
+
+constexpr uint64_t kStepNs = U_TIME_1MS_IN_NS;
+constexpr size_t kBatch = 3;
+
+struct Samples
+{
+	std::vector<uint64_t> timestamps_ns;
+	std::vector<xrt_vec3> accels;
+	std::vector<xrt_vec3> gyros;
+
+	//! The true orientation after the last sample.
+	struct xrt_quat rot;
+};
+
+/*!
+ * A device tumbling around a slowly changing axis, with gravity rotated into
+ * body space and a few still periods to trigger the gravity correction.
+ */
+static Samples
+make_samples(size_t num)
+{
+	Samples s;
+	s.rot = XRT_QUAT_IDENTITY;
+	double dt = (double)kStepNs / U_TIME_1S_IN_NS;
+
+	for (size_t i = 0; i < num; i++) {
+		double t = (double)i * dt;
+		bool still = (i / 500) % 4 == 3;
+
+		struct xrt_vec3 gyro = {0, 0, 0};
+		if (!still) {
+			gyro = {(float)(0.8 * sin(t)), (float)(1.5 * cos(0.7 * t)), (float)(0.3 + 0.2 * sin(2.1 * t))};
+		}
+
+		// The first sample only sets the start time.
+		if (i > 0) {
+			math_quat_integrate_velocity(&s.rot, &gyro, (float)dt, &s.rot);
+		}
+
+		// Gravity is up in world space, rotate it into body space.
+		struct xrt_quat inv;
+		math_quat_invert(&s.rot, &inv);
+		struct xrt_vec3 up = {0, 9.82f, 0};
+		struct xrt_vec3 accel;
+		math_quat_rotate_vec3(&inv, &up, &accel);
+
+		s.timestamps_ns.push_back((i + 1) * kStepNs);
+		s.accels.push_back(accel);
+		s.gyros.push_back(gyro);
+	}
+
+	return s;
+}
+
+static float
+quat_angle_between(const struct xrt_quat &a, const struct xrt_quat &b)
+{
+	struct xrt_quat b_inv, diff;
+	math_quat_invert(&b, &b_inv);
+	math_quat_rotate(&a, &b_inv, &diff);
+
+	float v = sqrtf(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z);
+	return 2.f * atan2f(v, fabsf(diff.w));
+}
+
+struct Fusion
+{
+	struct m_imu_3dof f;
+
+	explicit Fusion(int flags)
+	{
+		m_imu_3dof_init(&f, flags);
+	}
+
+	~Fusion()
+	{
+		m_imu_3dof_close(&f);
+	}
+};
+
+static void
+run_single(struct m_imu_3dof *f, const Samples &s)
+{
+	for (size_t i = 0; i < s.timestamps_ns.size(); i++) {
+		m_imu_3dof_update(f, s.timestamps_ns[i], &s.accels[i], &s.gyros[i]);
+	}
+}
+
+static void
+run_batch(struct m_imu_3dof *f, const Samples &s)
+{
+	for (size_t i = 0; i < s.timestamps_ns.size(); i += kBatch) {
+		size_t count = std::min(kBatch, s.timestamps_ns.size() - i);
+		m_imu_3dof_update_batch(f, &s.timestamps_ns[i], &s.accels[i], &s.gyros[i], count);
+	}
+}
+
+} // namespace
+
+
+TEST_CASE("m_imu_3dof batch update")
+{
+	Samples s = make_samples(6000);
+
+	SECTION("matches the per sample update without gravity correction")
+	{
+		Fusion single(0);
+		Fusion batch(0);
+
+		run_single(&single.f, s);
+		run_batch(&batch.f, s);
+
+		CHECK(quat_angle_between(single.f.rot, batch.f.rot) < 1e-4f);
+		CHECK(quat_angle_between(batch.f.rot, s.rot) < 1e-4f);
+		CHECK(single.f.last.timestamp_ns == batch.f.last.timestamp_ns);
+		CHECK(batch.f.last.gyro.y == s.gyros.back().y);
+	}
+
+	SECTION("as accurate as the per sample update with gravity correction")
+	{
+		Fusion single(M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+		Fusion batch(M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+		// Start both off tilted so there is something to correct.
+		struct xrt_vec3 x = {1, 0, 0};
+		math_quat_from_angle_vector(0.3f, &x, &single.f.rot);
+		batch.f.rot = single.f.rot;
+
+		run_single(&single.f, s);
+		run_batch(&batch.f, s);
+
+		// The correction stops once the tilt is under 0.05 radians.
+		float single_error = quat_angle_between(single.f.rot, s.rot);
+		float batch_error = quat_angle_between(batch.f.rot, s.rot);
+		CHECK(single_error < 0.06f);
+		CHECK(batch_error < 0.06f);
+		CHECK(batch_error < single_error + 0.01f);
+	}
+}
+
+TEST_CASE("m_imu_3dof batch update speed", "[.benchmark]")
+{
+	Samples big = make_samples(300000);
+	Fusion single(M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	Fusion batch(M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	auto start = std::chrono::steady_clock::now();
+	run_single(&single.f, big);
+	auto mid = std::chrono::steady_clock::now();
+	run_batch(&batch.f, big);
+	auto end = std::chrono::steady_clock::now();
+
+	double single_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+	double batch_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+	double num = (double)big.timestamps_ns.size();
+
+	WARN("Per sample: " << single_ns / num << " ns per sample, "
+	                    << quat_angle_between(single.f.rot, big.rot) << " rad off. Batches of " << kBatch
+	                    << ": " << batch_ns / num << " ns per sample, "
+	                    << quat_angle_between(batch.f.rot, big.rot) << " rad off.");
+}
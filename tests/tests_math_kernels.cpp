@@ -0,0 +1,178 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Inline math kernel tests, compares them to and times them against the m_api.h functions.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_pose.h>
+#include <math/m_quat.h>
+#include <math/m_vec3.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+constexpr float kEpsilon = 1e-5f;
+
+static struct xrt_pose
+random_pose(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+	struct xrt_pose pose;
+	pose.orientation = {dist(rng), dist(rng), dist(rng), dist(rng)};
+	math_quat_normalize(&pose.orientation);
+	pose.position = {dist(rng), dist(rng), dist(rng)};
+	return pose;
+}
+
+static void
+check_vec3(const struct xrt_vec3 &a, const struct xrt_vec3 &b)
+{
+	CHECK(a.x == Approx(b.x).margin(kEpsilon));
+	CHECK(a.y == Approx(b.y).margin(kEpsilon));
+	CHECK(a.z == Approx(b.z).margin(kEpsilon));
+}
+
+static void
+check_pose(const struct xrt_pose &a, const struct xrt_pose &b)
+{
+	CHECK(a.orientation.x == Approx(b.orientation.x).margin(kEpsilon));
+	CHECK(a.orientation.y == Approx(b.orientation.y).margin(kEpsilon));
+	CHECK(a.orientation.z == Approx(b.orientation.z).margin(kEpsilon));
+	CHECK(a.orientation.w == Approx(b.orientation.w).margin(kEpsilon));
+	check_vec3(a.position, b.position);
+}
+
+template <typename F>
+static double
+time_ns(size_t runs, F &&func)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < runs; i++) {
+		func();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / runs;
+}
+
+} // namespace
+
+
+TEST_CASE("m_quat and m_pose")
+{
+	std::mt19937 rng(42);
+
+	SECTION("match the m_api.h functions")
+	{
+		for (int i = 0; i < 100; i++) {
+			struct xrt_pose a = random_pose(rng);
+			struct xrt_pose b = random_pose(rng);
+
+			struct xrt_quat q;
+			math_quat_rotate(&a.orientation, &b.orientation, &q);
+			struct xrt_quat q2 = m_quat_mul(a.orientation, b.orientation);
+			CHECK(q2.x == Approx(q.x).margin(kEpsilon));
+			CHECK(q2.w == Approx(q.w).margin(kEpsilon));
+
+			struct xrt_vec3 v;
+			math_quat_rotate_vec3(&a.orientation, &b.position, &v);
+			check_vec3(m_quat_rotate_vec3(a.orientation, b.position), v);
+
+			math_pose_transform_point(&a, &b.position, &v);
+			check_vec3(m_pose_transform_point(a, b.position), v);
+
+			struct xrt_pose p;
+			math_pose_transform(&a, &b, &p);
+			check_pose(m_pose_transform(a, b), p);
+
+			math_pose_invert(&a, &p);
+			check_pose(m_pose_invert(a), p);
+		}
+	}
+
+	SECTION("batch and chain match single transforms")
+	{
+		// Odd count so the scalar tail is also used.
+		constexpr size_t kCount = 26 + 3;
+		struct xrt_pose transform = random_pose(rng);
+		std::vector<struct xrt_pose> poses(kCount);
+		for (auto &p : poses) {
+			p = random_pose(rng);
+		}
+
+		std::vector<struct xrt_pose> out(kCount);
+		m_pose_transform_many(&transform, poses.data(), out.data(), kCount);
+		for (size_t i = 0; i < kCount; i++) {
+			struct xrt_pose expected;
+			math_pose_transform(&transform, &poses[i], &expected);
+			check_pose(out[i], expected);
+		}
+
+		// In place.
+		std::vector<struct xrt_pose> in_place = poses;
+		m_pose_transform_many(&transform, in_place.data(), in_place.data(), kCount);
+		for (size_t i = 0; i < kCount; i++) {
+			check_pose(in_place[i], out[i]);
+		}
+
+		m_pose_chain(&transform, poses.data(), out.data(), 5);
+		struct xrt_pose expected = transform;
+		for (size_t i = 0; i < 5; i++) {
+			math_pose_transform(&expected, &poses[i], &expected);
+			check_pose(out[i], expected);
+		}
+	}
+}
+
+TEST_CASE("m_quat and m_pose speed", "[.benchmark]")
+{
+	std::mt19937 rng(42);
+
+	// All of the joints of both hands.
+	constexpr size_t kCount = 52;
+	constexpr size_t kRuns = 20000;
+	struct xrt_pose transform = random_pose(rng);
+	std::vector<struct xrt_pose> poses(kCount);
+	for (auto &p : poses) {
+		p = random_pose(rng);
+	}
+	std::vector<struct xrt_pose> out(kCount);
+
+	double api_ns = time_ns(kRuns, [&] {
+		for (size_t i = 0; i < kCount; i++) {
+			math_pose_transform(&transform, &poses[i], &out[i]);
+		}
+	});
+	struct xrt_pose api_first = out[0];
+
+	double inline_ns = time_ns(kRuns, [&] {
+		for (size_t i = 0; i < kCount; i++) {
+			out[i] = m_pose_transform(transform, poses[i]);
+		}
+	});
+
+	double many_ns = time_ns(kRuns, [&] {
+		m_pose_transform_many(&transform, poses.data(), out.data(), kCount); //
+	});
+
+	struct xrt_vec3 v = poses[0].position;
+	const struct xrt_quat q = transform.orientation;
+	double api_rotate_ns = time_ns(kRuns * kCount, [&] { math_quat_rotate_vec3(&q, &v, &v); });
+	double inline_rotate_ns = time_ns(kRuns * kCount, [&] { v = m_quat_rotate_vec3(q, v); });
+
+	check_pose(out[0], api_first);
+	CHECK(m_vec3_len(v) < 10.f);
+
+	WARN("Transforming " << kCount << " poses, math_pose_transform: " << api_ns << " ns, m_pose_transform: "
+	                     << inline_ns << " ns, m_pose_transform_many: " << many_ns << " ns. "
+	                     << "Rotating a vec3, math_quat_rotate_vec3: " << api_rotate_ns
+	                     << " ns, m_quat_rotate_vec3: " << inline_rotate_ns << " ns.");
+}
@@ -0,0 +1,236 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Relation history tests.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_relation_history.h>
+#include <util/u_time.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+constexpr uint64_t kStepNs = U_TIME_1MS_IN_NS;
+
+//! Position (i, 2i, 3i) lets readers spot torn copies.
+static struct xrt_space_relation
+make_relation(uint64_t i)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+	rel.pose.position = {(float)i, 2.f * i, 3.f * i};
+	// One unit per step.
+	rel.linear_velocity = {1e9f / kStepNs, 2e9f / kStepNs, 3e9f / kStepNs};
+	return rel;
+}
+
+struct History
+{
+	struct m_relation_history *rh = nullptr;
+
+	History()
+	{
+		m_relation_history_create(&rh);
+	}
+
+	~History()
+	{
+		m_relation_history_destroy(&rh);
+	}
+};
+
+struct Race
+{
+	bool torn;
+	double ns;       //!< How long the readers took.
+	uint64_t pushed; //!< How many relations were pushed meanwhile.
+};
+
+//! Three readers query while a writer pushes as fast as it can.
+static Race
+race(uint64_t num_queries)
+{
+	History h;
+	std::atomic<uint64_t> pushed{0};
+	std::atomic<bool> done{false};
+	std::atomic<bool> torn{false};
+
+	// Push as fast as possible until the readers are done, so they always race it.
+	std::thread writer([&] {
+		for (uint64_t i = 1; !done.load(std::memory_order_acquire); i++) {
+			struct xrt_space_relation rel = make_relation(i);
+			m_relation_history_push(h.rh, &rel, i * kStepNs);
+			pushed.store(i, std::memory_order_release);
+		}
+	});
+
+	auto reader = [&](uint32_t seed) {
+		std::mt19937 rng(seed);
+		for (uint64_t q = 0; q < num_queries; q++) {
+			uint64_t newest = pushed.load(std::memory_order_acquire);
+
+			// Mostly inside the window, sometimes past either edge.
+			uint64_t lowest =
+			    newest > M_RELATION_HISTORY_CAPACITY ? newest - M_RELATION_HISTORY_CAPACITY : 1;
+			std::uniform_int_distribution<uint64_t> dist(lowest, newest + 2);
+			uint64_t at_ns = dist(rng) * kStepNs + kStepNs / 3;
+
+			struct xrt_space_relation out;
+			m_relation_history_get(h.rh, at_ns, &out);
+
+			float x = out.pose.position.x;
+			if (fabsf(out.pose.position.y - 2.f * x) > 1e-3f * x ||
+			    fabsf(out.pose.position.z - 3.f * x) > 1e-3f * x) {
+				torn = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> readers;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < 3; i++) {
+		readers.emplace_back(reader, i);
+	}
+	for (auto &t : readers) {
+		t.join();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	done = true;
+	writer.join();
+
+	Race r;
+	r.torn = torn;
+	r.ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	r.pushed = pushed.load();
+	return r;
+}
+
+} // namespace
+
+
+TEST_CASE("m_relation_history")
+{
+	History h;
+	struct xrt_space_relation out;
+
+	SECTION("empty")
+	{
+		CHECK(m_relation_history_get_size(h.rh) == 0);
+		CHECK(m_relation_history_get(h.rh, 1000, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+		CHECK(out.relation_flags == 0);
+		CHECK(out.pose.orientation.w == 1.f);
+
+		uint64_t ts;
+		CHECK_FALSE(m_relation_history_get_latest(h.rh, &ts, &out));
+	}
+
+	SECTION("exact, interpolated and predicted")
+	{
+		for (uint64_t i = 1; i <= 10; i++) {
+			struct xrt_space_relation rel = make_relation(i);
+			REQUIRE(m_relation_history_push(h.rh, &rel, i * kStepNs));
+		}
+		CHECK(m_relation_history_get_size(h.rh) == 10);
+
+		CHECK(m_relation_history_get(h.rh, 4 * kStepNs, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.pose.position.x == 4.f);
+
+		CHECK(m_relation_history_get(h.rh, 4 * kStepNs + kStepNs / 4, &out) ==
+		      M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out.pose.position.x == Approx(4.25f));
+		CHECK(out.pose.position.z == Approx(12.75f));
+
+		CHECK(m_relation_history_get(h.rh, 12 * kStepNs, &out) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(out.pose.position.x == Approx(12.f));
+
+		CHECK(m_relation_history_get(h.rh, kStepNs / 2, &out) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out.pose.position.x == Approx(0.5f));
+
+		uint64_t ts;
+		REQUIRE(m_relation_history_get_latest(h.rh, &ts, &out));
+		CHECK(ts == 10 * kStepNs);
+		CHECK(out.pose.position.x == 10.f);
+	}
+
+	SECTION("slerps orientation")
+	{
+		struct xrt_space_relation a = XRT_SPACE_RELATION_ZERO;
+		struct xrt_space_relation b = XRT_SPACE_RELATION_ZERO;
+		a.relation_flags = b.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+		struct xrt_vec3 up = {0, 1, 0};
+		math_quat_from_angle_vector((float)M_PI / 2.f, &up, &b.pose.orientation);
+
+		REQUIRE(m_relation_history_push(h.rh, &a, 100));
+		REQUIRE(m_relation_history_push(h.rh, &b, 200));
+
+		CHECK(m_relation_history_get(h.rh, 150, &out) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+
+		struct xrt_quat expected;
+		math_quat_from_angle_vector((float)M_PI / 4.f, &up, &expected);
+		CHECK(out.pose.orientation.y == Approx(expected.y));
+		CHECK(out.pose.orientation.w == Approx(expected.w));
+	}
+
+	SECTION("rejects old timestamps")
+	{
+		struct xrt_space_relation rel = make_relation(1);
+		REQUIRE(m_relation_history_push(h.rh, &rel, 100));
+		CHECK_FALSE(m_relation_history_push(h.rh, &rel, 100));
+		CHECK_FALSE(m_relation_history_push(h.rh, &rel, 50));
+		CHECK(m_relation_history_get_size(h.rh) == 1);
+	}
+
+	SECTION("wraps around and clears")
+	{
+		uint64_t num = M_RELATION_HISTORY_CAPACITY * 3 + 7;
+		for (uint64_t i = 1; i <= num; i++) {
+			struct xrt_space_relation rel = make_relation(i);
+			REQUIRE(m_relation_history_push(h.rh, &rel, i * kStepNs));
+		}
+		CHECK(m_relation_history_get_size(h.rh) == M_RELATION_HISTORY_CAPACITY - 1);
+
+		// Older than what is kept.
+		CHECK(m_relation_history_get(h.rh, 10 * kStepNs, &out) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+
+		CHECK(m_relation_history_get(h.rh, (num - 100) * kStepNs + kStepNs / 2, &out) ==
+		      M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out.pose.position.x == Approx(num - 100 + 0.5f));
+
+		m_relation_history_clear(h.rh);
+		CHECK(m_relation_history_get_size(h.rh) == 0);
+		CHECK(m_relation_history_get(h.rh, num * kStepNs, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+
+		// Anything goes after a clear.
+		struct xrt_space_relation rel = make_relation(1);
+		CHECK(m_relation_history_push(h.rh, &rel, kStepNs));
+	}
+}
+
+TEST_CASE("m_relation_history concurrent push and query")
+{
+	Race r = race(200000);
+	CHECK_FALSE(r.torn);
+}
+
+TEST_CASE("m_relation_history query speed", "[.benchmark]")
+{
+	const uint64_t num_queries = 200000;
+	Race r = race(num_queries);
+	CHECK_FALSE(r.torn);
+
+	WARN("3 readers did " << num_queries << " queries each at " << r.ns / num_queries << " ns per query, while "
+	                      << r.pushed << " relations were pushed");
+}
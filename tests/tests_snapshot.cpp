@@ -0,0 +1,232 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Snapshot tests, and how readers fare against a mutex held by a busy writer.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_snapshot.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+/*!
+ * About the size of the state a driver publishes, every field holds the same
+ * value so a torn read is easy to spot.
+ */
+struct State
+{
+	uint64_t values[16];
+};
+
+static State
+make_state(uint64_t v)
+{
+	State s;
+	for (auto &value : s.values) {
+		value = v;
+	}
+	return s;
+}
+
+static bool
+is_consistent(const State &s)
+{
+	return std::all_of(std::begin(s.values), std::end(s.values), [&](uint64_t v) { return v == s.values[0]; });
+}
+
+struct Snapshot
+{
+	struct u_snapshot *us = nullptr;
+
+	Snapshot()
+	{
+		u_snapshot_create(sizeof(State), &us);
+	}
+	~Snapshot()
+	{
+		u_snapshot_destroy(&us);
+	}
+};
+
+/*!
+ * Stand in for the sensor processing a driver does per report.
+ */
+static void
+busy_work(std::chrono::microseconds duration)
+{
+	auto end = std::chrono::steady_clock::now() + duration;
+	while (std::chrono::steady_clock::now() < end) {
+	}
+}
+
+static double
+percentile_ns(std::vector<int64_t> &samples, double p)
+{
+	std::sort(samples.begin(), samples.end());
+	return (double)samples[(size_t)((double)(samples.size() - 1) * p)];
+}
+
+} // namespace
+
+
+TEST_CASE("u_snapshot")
+{
+	Snapshot s;
+	State out = make_state(42);
+
+	SECTION("empty")
+	{
+		CHECK_FALSE(u_snapshot_read(s.us, &out));
+		CHECK(out.values[0] == 42);
+		CHECK(u_snapshot_get_count(s.us) == 0);
+	}
+
+	SECTION("latest wins")
+	{
+		for (uint64_t i = 1; i <= 5; i++) {
+			State in = make_state(i);
+			u_snapshot_publish(s.us, &in);
+		}
+
+		CHECK(u_snapshot_read(s.us, &out));
+		CHECK(out.values[0] == 5);
+		CHECK(is_consistent(out));
+		CHECK(u_snapshot_get_count(s.us) == 5);
+	}
+
+	SECTION("destroy")
+	{
+		u_snapshot_destroy(&s.us);
+		CHECK(s.us == nullptr);
+
+		// Does null checking.
+		u_snapshot_destroy(&s.us);
+	}
+}
+
+TEST_CASE("u_snapshot concurrent publish and read")
+{
+	Snapshot s;
+	const uint64_t num_reads = 200000;
+	std::atomic<bool> done{false};
+	std::atomic<bool> torn{false};
+	std::atomic<bool> went_back{false};
+
+	// Publish as fast as possible until the readers are done, so they always race it.
+	std::thread writer([&] {
+		for (uint64_t i = 1; !done.load(std::memory_order_acquire); i++) {
+			State in = make_state(i);
+			u_snapshot_publish(s.us, &in);
+		}
+	});
+
+	auto reader = [&] {
+		uint64_t last = 0;
+		for (uint64_t r = 0; r < num_reads; r++) {
+			State out = make_state(0);
+			if (!u_snapshot_read(s.us, &out)) {
+				continue;
+			}
+			if (!is_consistent(out)) {
+				torn = true;
+			}
+			if (out.values[0] < last) {
+				went_back = true;
+			}
+			last = out.values[0];
+		}
+	};
+
+	std::vector<std::thread> readers;
+	for (uint32_t i = 0; i < 3; i++) {
+		readers.emplace_back(reader);
+	}
+	for (auto &t : readers) {
+		t.join();
+	}
+
+	done = true;
+	writer.join();
+
+	CHECK_FALSE(torn);
+	CHECK_FALSE(went_back);
+}
+
+TEST_CASE("u_snapshot contention", "[.benchmark]")
+{
+	// The writer holds the lock for the whole batch, like the drivers did.
+	const auto work = std::chrono::microseconds(200);
+	const size_t num_reads = 2000;
+
+	auto run = [&](auto &&publish, auto &&read) {
+		std::atomic<bool> done{false};
+		std::thread writer([&] {
+			for (uint64_t i = 1; !done.load(std::memory_order_acquire); i++) {
+				publish(i);
+			}
+		});
+
+		std::vector<int64_t> samples;
+		samples.reserve(num_reads);
+		for (size_t r = 0; r < num_reads; r++) {
+			auto start = std::chrono::steady_clock::now();
+			State out = read();
+			auto end = std::chrono::steady_clock::now();
+
+			CHECK(is_consistent(out));
+			samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+			// Ask at about the rate a compositor and a few IPC clients would.
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+
+		done = true;
+		writer.join();
+
+		return samples;
+	};
+
+	std::mutex mutex;
+	State shared = make_state(0);
+	std::vector<int64_t> locked = run(
+	    [&](uint64_t i) {
+		    std::lock_guard<std::mutex> lock(mutex);
+		    busy_work(work);
+		    shared = make_state(i);
+	    },
+	    [&] {
+		    std::lock_guard<std::mutex> lock(mutex);
+		    return shared;
+	    });
+
+	Snapshot s;
+	State first = make_state(0);
+	u_snapshot_publish(s.us, &first);
+	std::vector<int64_t> snapshot = run(
+	    [&](uint64_t i) {
+		    busy_work(work);
+		    State in = make_state(i);
+		    u_snapshot_publish(s.us, &in);
+	    },
+	    [&] {
+		    State out;
+		    u_snapshot_read(s.us, &out);
+		    return out;
+	    });
+
+	WARN("Reading while the writer works " << work.count() << " us per batch, mutex p50 "
+	                                       << percentile_ns(locked, 0.5) << " ns p99 "
+	                                       << percentile_ns(locked, 0.99) << " ns, snapshot p50 "
+	                                       << percentile_ns(snapshot, 0.5) << " ns p99 "
+	                                       << percentile_ns(snapshot, 0.99) << " ns.");
+}
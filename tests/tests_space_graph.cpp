@@ -0,0 +1,200 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Space graph tests, compares the batched resolve to resolving one relation at a time.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_space.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+constexpr float kEpsilon = 1e-4f;
+
+/*!
+ * A relation with random flags, the fields that the flags say are not valid
+ * are left at zero like the drivers do.
+ */
+static struct xrt_space_relation
+random_relation(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::uniform_int_distribution<uint32_t> bits(0, 0x3f);
+
+	struct xrt_space_relation r = XRT_SPACE_RELATION_ZERO;
+	r.relation_flags = (enum xrt_space_relation_flags)bits(rng);
+
+	if (r.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) {
+		r.pose.orientation = {dist(rng), dist(rng), dist(rng), dist(rng)};
+		math_quat_normalize(&r.pose.orientation);
+	}
+	if (r.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) {
+		r.pose.position = {dist(rng), dist(rng), dist(rng)};
+	}
+	if (r.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) {
+		r.linear_velocity = {dist(rng), dist(rng), dist(rng)};
+	}
+	if (r.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) {
+		r.angular_velocity = {dist(rng), dist(rng), dist(rng)};
+	}
+
+	return r;
+}
+
+static void
+check_vec3(const struct xrt_vec3 &a, const struct xrt_vec3 &b)
+{
+	CHECK(a.x == Approx(b.x).margin(kEpsilon));
+	CHECK(a.y == Approx(b.y).margin(kEpsilon));
+	CHECK(a.z == Approx(b.z).margin(kEpsilon));
+}
+
+static void
+check_relation(const struct xrt_space_relation &a, const struct xrt_space_relation &b)
+{
+	CHECK(a.relation_flags == b.relation_flags);
+	CHECK(a.pose.orientation.x == Approx(b.pose.orientation.x).margin(kEpsilon));
+	CHECK(a.pose.orientation.y == Approx(b.pose.orientation.y).margin(kEpsilon));
+	CHECK(a.pose.orientation.z == Approx(b.pose.orientation.z).margin(kEpsilon));
+	CHECK(a.pose.orientation.w == Approx(b.pose.orientation.w).margin(kEpsilon));
+	check_vec3(a.pose.position, b.pose.position);
+	check_vec3(a.linear_velocity, b.linear_velocity);
+	check_vec3(a.angular_velocity, b.angular_velocity);
+}
+
+static struct xrt_space_graph
+random_chain(std::mt19937 &rng, uint32_t num_steps)
+{
+	struct xrt_space_graph xsg = {};
+	for (uint32_t i = 0; i < num_steps; i++) {
+		struct xrt_space_relation r = random_relation(rng);
+		if (i % 2 == 0) {
+			m_space_graph_add_relation(&xsg, &r);
+		} else {
+			m_space_graph_add_inverted_relation(&xsg, &r);
+		}
+	}
+	return xsg;
+}
+
+static void
+resolve_one_at_a_time(const struct xrt_space_graph &chain,
+                      const std::vector<struct xrt_space_relation> &relations,
+                      std::vector<struct xrt_space_relation> &out)
+{
+	for (size_t i = 0; i < relations.size(); i++) {
+		struct xrt_space_graph xsg = {};
+		m_space_graph_add_relation(&xsg, &relations[i]);
+		for (uint32_t k = 0; k < chain.num_steps; k++) {
+			m_space_graph_add_relation(&xsg, &chain.steps[k]);
+		}
+		m_space_graph_resolve(&xsg, &out[i]);
+	}
+}
+
+} // namespace
+
+
+TEST_CASE("m_space_graph_resolve_many")
+{
+	std::mt19937 rng(42);
+
+	// Both hands, more than one chunk.
+	constexpr size_t kCount = 52;
+	std::vector<struct xrt_space_relation> relations(kCount);
+	std::vector<struct xrt_space_relation> expected(kCount);
+	std::vector<struct xrt_space_relation> out(kCount);
+
+	SECTION("matches resolving one relation at a time")
+	{
+		for (uint32_t num_steps = 0; num_steps <= 4; num_steps++) {
+			for (int run = 0; run < 20; run++) {
+				struct xrt_space_graph chain = random_chain(rng, num_steps);
+				for (auto &r : relations) {
+					r = random_relation(rng);
+				}
+
+				resolve_one_at_a_time(chain, relations, expected);
+				m_space_graph_resolve_many(&chain, relations.data(), out.data(), kCount);
+
+				for (size_t i = 0; i < kCount; i++) {
+					check_relation(out[i], expected[i]);
+				}
+			}
+		}
+	}
+
+	SECTION("in place")
+	{
+		struct xrt_space_graph chain = random_chain(rng, 3);
+		for (auto &r : relations) {
+			r = random_relation(rng);
+		}
+
+		resolve_one_at_a_time(chain, relations, expected);
+		m_space_graph_resolve_many(&chain, relations.data(), relations.data(), kCount);
+
+		for (size_t i = 0; i < kCount; i++) {
+			check_relation(relations[i], expected[i]);
+		}
+	}
+
+	SECTION("a base without a pose gives no poses")
+	{
+		struct xrt_space_relation base = XRT_SPACE_RELATION_ZERO;
+		for (auto &r : relations) {
+			r = random_relation(rng);
+		}
+
+		m_space_relation_apply_many(&base, relations.data(), out.data(), kCount);
+
+		for (size_t i = 0; i < kCount; i++) {
+			CHECK(out[i].relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+		}
+	}
+}
+
+TEST_CASE("m_space_graph_resolve_many speed", "[.benchmark]")
+{
+	std::mt19937 rng(42);
+
+	constexpr size_t kCount = 52;
+	std::vector<struct xrt_space_relation> relations(kCount);
+	std::vector<struct xrt_space_relation> expected(kCount);
+	std::vector<struct xrt_space_relation> out(kCount);
+
+	constexpr size_t kRuns = 2000;
+	struct xrt_space_graph chain = random_chain(rng, 4);
+	for (auto &r : relations) {
+		r = random_relation(rng);
+	}
+
+	auto time_ns = [](auto &&func) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < kRuns; i++) {
+			func();
+		}
+		auto end = std::chrono::steady_clock::now();
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return (double)ns / kRuns;
+	};
+
+	double single_ns = time_ns([&] { resolve_one_at_a_time(chain, relations, expected); });
+	double many_ns = time_ns([&] {
+		m_space_graph_resolve_many(&chain, relations.data(), out.data(), kCount); //
+	});
+
+	check_relation(out[0], expected[0]);
+
+	WARN("Resolving " << kCount << " relations with a chain of " << chain.num_steps
+	                  << " steps, one at a time: " << single_ns
+	                  << " ns, m_space_graph_resolve_many: " << many_ns << " ns.");
+}
@@ -0,0 +1,81 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief PSVR tracker tests, between pixels and tracker space.
+ */
+
+#include "catch/catch.hpp"
+
+#include <tracking/t_tracker_psvr.hpp>
+
+using namespace xrt::auxiliary::tracking::psvr;
+
+
+namespace {
+
+/*!
+ * A rectified stereo pair, the right view is offset so that the disparity as
+ * the tracker computes it, right minus left, is positive.
+ */
+struct Rig
+{
+	const double f = 500.0;
+	const double cx = 320.0;
+	const double cy = 240.0;
+	const double baseline = 0.06;
+
+	cv::Matx34d left = {f, 0, cx, 0, 0, f, cy, 0, 0, 0, 1, 0};
+	cv::Matx34d right = {f, 0, cx, f * baseline, 0, f, cy, 0, 0, 0, 1, 0};
+	cv::Matx44d disparity_to_depth = {1, 0, 0, -cx, 0, 1, 0, -cy, 0, 0, 0, f, 0, 0, 1.0 / baseline, 0};
+};
+
+static cv::Point2f
+pixel(const cv::Matx34d &projection, const cv::Vec3d &camera)
+{
+	cv::Vec3d h = projection * cv::Vec4d(camera[0], camera[1], camera[2], 1.0);
+	return cv::Point2f(h[0] / h[2], h[1] / h[2]);
+}
+
+} // namespace
+
+
+TEST_CASE("t_tracker_psvr")
+{
+	Rig rig;
+
+	auto camera = GENERATE(cv::Vec3d(0.0, 0.0, 1.0), cv::Vec3d(0.2, -0.1, 0.8), cv::Vec3d(-0.3, 0.25, 2.5));
+	CAPTURE(camera[0], camera[1], camera[2]);
+
+	cv::Point2f l = pixel(rig.left, camera);
+	cv::Point2f r = pixel(rig.right, camera);
+
+	SECTION("triangulate inverts x")
+	{
+		cv::Point3f p = triangulate(rig.disparity_to_depth, l, r.x - l.x);
+		CHECK(p.x == Approx(-camera[0]).margin(1e-4));
+		CHECK(p.y == Approx(camera[1]).margin(1e-4));
+		CHECK(p.z == Approx(camera[2]).margin(1e-4));
+	}
+
+	SECTION("round trip")
+	{
+		cv::Point3f p = triangulate(rig.disparity_to_depth, l, r.x - l.x);
+
+		cv::Point2f px;
+		REQUIRE(project(rig.left, p, px));
+		CHECK(px.x == Approx(l.x).margin(1e-2));
+		CHECK(px.y == Approx(l.y).margin(1e-2));
+
+		REQUIRE(project(rig.right, p, px));
+		CHECK(px.x == Approx(r.x).margin(1e-2));
+		CHECK(px.y == Approx(r.y).margin(1e-2));
+	}
+
+	SECTION("behind the view")
+	{
+		cv::Point3f p(-(float)camera[0], (float)camera[1], -(float)camera[2]);
+		cv::Point2f px;
+		CHECK_FALSE(project(rig.left, p, px));
+	}
+}